@@ -0,0 +1,31 @@
+/*************************************************************************************************
+ * Database interface
+ *                                                               Copyright (C) 2009-2012 FAL Labs
+ * This file is part of Kyoto Cabinet.
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either version
+ * 3 of the License, or any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *************************************************************************************************/
+
+
+#include "kcdb.h"
+#include "myconf.h"
+
+namespace kyotocabinet {                 // common namespace
+
+
+/** Special pointer for no operation. */
+const char* const DB::Visitor::NOP = (const char*)0;
+
+/** Special pointer to remove the record. */
+const char* const DB::Visitor::REMOVE = (const char*)1;
+
+
+}                                        // common namespace
+
+// END OF FILE
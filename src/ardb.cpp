@@ -1,644 +1,1041 @@
- /*
- *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
- *All rights reserved.
- * 
- *Redistribution and use in source and binary forms, with or without
- *modification, are permitted provided that the following conditions are met:
- * 
- *  * Redistributions of source code must retain the above copyright notice,
- *    this list of conditions and the following disclaimer.
- *  * Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- *  * Neither the name of Redis nor the names of its contributors may be used
- *    to endorse or promote products derived from this software without
- *    specific prior written permission.
- * 
- *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
- *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
- *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
- *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
- *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
- *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
- *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
- *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
- *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
- *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
- *THE POSSIBILITY OF SUCH DAMAGE.
- */
-
-#include "ardb.hpp"
-#include <string.h>
-#include <sstream>
-#include "comparator.hpp"
-#include "util/thread/thread.hpp"
-
-#define  GET_KEY_TYPE(KEY, TYPE)   do{ \
-		Iterator* iter = FindValue(KEY, true);  \
-		if (NULL != iter && iter->Valid()) \
-		{                                  \
-			Slice tmp = iter->Key();       \
-			KeyObject* k = decode_key(tmp, &KEY); \
-			if(NULL != k && k->key.compare(KEY.key) == 0)\
-			{                                            \
-				TYPE = k->type;                          \
-	         }                                           \
-	    }\
-	    DELETE(iter);\
-}while(0)
-
-namespace ardb
-{
-	int ardb_compare_keys(const char* akbuf, size_t aksiz, const char* bkbuf,
-	        size_t bksiz)
-	{
-		Buffer ak_buf(const_cast<char*>(akbuf), 0, aksiz);
-		Buffer bk_buf(const_cast<char*>(bkbuf), 0, bksiz);
-		uint32 aheader, bheader;
-		bool found_a = BufferHelper::ReadFixUInt32(ak_buf, aheader);
-		bool found_b = BufferHelper::ReadFixUInt32(bk_buf, bheader);
-		COMPARE_EXIST(found_a, found_b);
-		uint32 adb = aheader >> 8;
-		uint32 bdb = bheader >> 8;
-		RETURN_NONEQ_RESULT(adb, bdb);
-		uint8 at = aheader & 0xFF;
-		uint8 bt = bheader & 0xFF;
-		RETURN_NONEQ_RESULT(at, bt);
-		uint32 akeysize, bkeysize;
-		found_a = BufferHelper::ReadVarUInt32(ak_buf, akeysize);
-		found_b = BufferHelper::ReadVarUInt32(bk_buf, bkeysize);
-		COMPARE_EXIST(found_a, found_b);
-		RETURN_NONEQ_RESULT(akeysize, bkeysize);
-
-		Slice akey(ak_buf.GetRawReadBuffer(), akeysize);
-		Slice bkey(bk_buf.GetRawReadBuffer(), bkeysize);
-		found_a = ak_buf.ReadableBytes() >= akeysize;
-		found_b = bk_buf.ReadableBytes() >= bkeysize;
-		COMPARE_EXIST(found_a, found_b);
-		ak_buf.SkipBytes(akeysize);
-		bk_buf.SkipBytes(bkeysize);
-		int ret = akey.compare(bkey);
-		if (ret != 0)
-		{
-			return ret;
-		}
-		switch (at)
-		{
-			case HASH_FIELD:
-			{
-				Slice af, bf;
-				found_a = BufferHelper::ReadVarSlice(ak_buf, af);
-				found_b = BufferHelper::ReadVarSlice(bk_buf, bf);
-				COMPARE_EXIST(found_a, found_b);
-				RETURN_NONEQ_RESULT(af.size(), bf.size());
-				ret = af.compare(bf);
-				break;
-			}
-			case LIST_ELEMENT:
-			{
-				float ascore, bscore;
-				found_a = BufferHelper::ReadFixFloat(ak_buf, ascore);
-				found_b = BufferHelper::ReadFixFloat(bk_buf, bscore);
-				COMPARE_EXIST(found_a, found_b);
-				ret = COMPARE_NUMBER(ascore, bscore);
-				break;
-			}
-			case ZSET_ELEMENT_SCORE:
-			case SET_ELEMENT:
-			{
-				ValueObject av, bv;
-				found_a = decode_value(ak_buf, av, false);
-				found_b = decode_value(bk_buf, bv, false);
-				COMPARE_EXIST(found_a, found_b);
-				ret = av.Compare(bv);
-				break;
-			}
-			case ZSET_ELEMENT:
-			{
-				double ascore, bscore;
-				found_a = BufferHelper::ReadFixDouble(ak_buf, ascore);
-				found_b = BufferHelper::ReadFixDouble(bk_buf, bscore);
-				ret = COMPARE_NUMBER(ascore, bscore);
-				if (ret == 0)
-				{
-					ValueObject av, bv;
-					found_a = decode_value(ak_buf, av);
-					found_b = decode_value(bk_buf, bv);
-					COMPARE_EXIST(found_a, found_b);
-					ret = av.Compare(bv);
-				}
-				break;
-			}
-			case TABLE_INDEX:
-			{
-				Slice af, bf;
-				found_a = BufferHelper::ReadVarSlice(ak_buf, af);
-				found_b = BufferHelper::ReadVarSlice(bk_buf, bf);
-				COMPARE_EXIST(found_a, found_b);
-				ret = af.compare(bf);
-				if (ret == 0)
-				{
-					ValueObject kav, kbv;
-					found_a = decode_value(ak_buf, kav);
-					found_b = decode_value(bk_buf, kbv);
-					COMPARE_EXIST(found_a, found_b);
-					ret = kav.Compare(kbv);
-					if (ret != 0)
-					{
-						break;
-					}
-					uint32 alen, blen;
-					found_a = BufferHelper::ReadVarUInt32(ak_buf, alen);
-					found_b = BufferHelper::ReadVarUInt32(bk_buf, blen);
-					COMPARE_EXIST(found_a, found_b);
-					ret = COMPARE_NUMBER(alen, blen);
-					if (ret == 0)
-					{
-						for (uint32 i = 0; i < alen; i++)
-						{
-							ValueObject av, bv;
-							found_a = decode_value(ak_buf, av);
-							found_b = decode_value(bk_buf, bv);
-							COMPARE_EXIST(found_a, found_b);
-							ret = av.Compare(bv);
-							if (ret != 0)
-							{
-								break;
-							}
-						}
-					}
-				}
-				break;
-			}
-			case TABLE_COL:
-			{
-				Slice af, bf;
-				found_a = BufferHelper::ReadVarSlice(ak_buf, af);
-				found_b = BufferHelper::ReadVarSlice(bk_buf, bf);
-				COMPARE_EXIST(found_a, found_b);
-				ret = COMPARE_NUMBER(af.size(), bf.size());
-				if (ret != 0)
-				{
-					return ret;
-				}
-				uint32 alen, blen;
-				found_a = BufferHelper::ReadVarUInt32(ak_buf, alen);
-				found_b = BufferHelper::ReadVarUInt32(bk_buf, blen);
-				COMPARE_EXIST(found_a, found_b);
-				ret = COMPARE_NUMBER(alen, blen);
-				if (ret == 0)
-				{
-					for (uint32 i = 0; i < alen; i++)
-					{
-						ValueObject av, bv;
-						found_a = decode_value(ak_buf, av);
-						found_b = decode_value(bk_buf, bv);
-						COMPARE_EXIST(found_a, found_b);
-						ret = av.Compare(bv);
-						if (ret != 0)
-						{
-							return ret;
-						}
-					}
-				}
-				break;
-			}
-			case BITSET_ELEMENT:
-			{
-				uint64 aindex, bindex;
-				found_a = BufferHelper::ReadVarUInt64(ak_buf, aindex);
-				found_b = BufferHelper::ReadVarUInt64(bk_buf, bindex);
-				COMPARE_EXIST(found_a, found_b);
-				ret = COMPARE_NUMBER(aindex, bindex);
-				break;
-			}
-			case SET_META:
-			case ZSET_META:
-			case LIST_META:
-			case TABLE_META:
-			case TABLE_SCHEMA:
-			case BITSET_META:
-			default:
-			{
-				break;
-			}
-		}
-		return ret;
-	}
-
-	size_t Ardb::RealPosition(Buffer* buf, int pos)
-	{
-		if (pos < 0)
-		{
-			pos = buf->ReadableBytes() + pos;
-		}
-		if (pos > 0 && (uint32) pos >= buf->ReadableBytes())
-		{
-			pos = buf->ReadableBytes() - 1;
-		}
-		if (pos < 0)
-		{
-			pos = 0;
-		}
-		return pos;
-	}
-
-	//static const char* REPO_NAME = "data";
-	Ardb::Ardb(KeyValueEngineFactory* engine, bool multi_thread) :
-			m_engine_factory(engine), m_engine(NULL), m_key_watcher(NULL), m_raw_key_listener(
-			        NULL)
-	{
-		m_key_locker.enable = multi_thread;
-	}
-
-	bool Ardb::Init()
-	{
-		if (NULL == m_engine)
-		{
-			INFO_LOG("Start init storage engine.");
-			m_engine = m_engine_factory->CreateDB(
-			        m_engine_factory->GetName().c_str());
-
-			KeyObject verkey(Slice(), KEY_END, 0xFFFFFF);
-			ValueObject ver;
-			if (0 == GetValue(verkey, &ver, NULL))
-			{
-				if (ver.v.int_v != ARDB_FORMAT_VERSION)
-				{
-					ERROR_LOG(
-					        "Incompatible data format version:%d in DB", ver.v.int_v);
-					return false;
-				}
-			}
-			else
-			{
-				ver.v.int_v = ARDB_FORMAT_VERSION;
-				ver.type = INTEGER;
-				SetValue(verkey, ver);
-			}
-			if (NULL != m_engine)
-			{
-				INFO_LOG("Init storage engine success.");
-			}
-		}
-		return m_engine != NULL;
-	}
-
-	Ardb::~Ardb()
-	{
-		if (NULL != m_engine)
-		{
-			m_engine_factory->CloseDB(m_engine);
-		}
-	}
-
-	void Ardb::Walk(KeyObject& key, bool reverse, WalkHandler* handler)
-	{
-		bool isFirstElement = true;
-		Iterator* iter = FindValue(key);
-		if (NULL != iter && !iter->Valid() && reverse)
-		{
-			iter->SeekToLast();
-			isFirstElement = false;
-		}
-		uint32 cursor = 0;
-		while (NULL != iter && iter->Valid())
-		{
-			Slice tmpkey = iter->Key();
-			KeyObject* kk = decode_key(tmpkey, &key);
-			if (NULL == kk || kk->type != key.type
-			        || kk->key.compare(key.key) != 0)
-			{
-				DELETE(kk);
-				if (reverse && isFirstElement)
-				{
-					iter->Prev();
-					isFirstElement = false;
-					continue;
-				}
-				break;
-			}
-			ValueObject v;
-			Buffer readbuf(const_cast<char*>(iter->Value().data()), 0,
-			        iter->Value().size());
-			decode_value(readbuf, v, false);
-			int ret = handler->OnKeyValue(kk, &v, cursor++);
-			DELETE(kk);
-			if (ret < 0)
-			{
-				break;
-			}
-			if (reverse)
-			{
-				iter->Prev();
-			}
-			else
-			{
-				iter->Next();
-			}
-		}
-		DELETE(iter);
-	}
-
-	KeyValueEngine* Ardb::GetEngine()
-	{
-		return m_engine;
-	}
-
-	int Ardb::RawSet(const Slice& key, const Slice& value)
-	{
-		int ret = GetEngine()->Put(key, value);
-		if (ret == 0 && NULL != m_raw_key_listener)
-		{
-			m_raw_key_listener->OnKeyUpdated(key, value);
-		}
-		return ret;
-	}
-	int Ardb::RawDel(const Slice& key)
-	{
-		int ret = GetEngine()->Del(key);
-		if (ret == 0 && NULL != m_raw_key_listener)
-		{
-			m_raw_key_listener->OnKeyDeleted(key);
-		}
-		return ret;
-	}
-
-	int Ardb::RawGet(const Slice& key, std::string* value)
-	{
-		return GetEngine()->Get(key, value);
-	}
-
-	int Ardb::Type(const DBID& db, const Slice& key)
-	{
-		if (Exists(db, key))
-		{
-			return KV;
-		}
-		int type = -1;
-		Slice empty;
-		SetKeyObject sk(key, empty, db);
-		GET_KEY_TYPE(sk, type);
-		if (type < 0)
-		{
-			ZSetScoreKeyObject zk(key, empty, db);
-			GET_KEY_TYPE( zk, type);
-			if (type < 0)
-			{
-				HashKeyObject hk(key, empty, db);
-				GET_KEY_TYPE( hk, type);
-				if (type < 0)
-				{
-					KeyObject lk(key, LIST_META, db);
-					GET_KEY_TYPE( lk, type);
-					if (type < 0)
-					{
-						KeyObject tk(key, TABLE_META, db);
-						GET_KEY_TYPE(tk, type);
-						if (type < 0)
-						{
-							KeyObject bk(key, BITSET_META, db);
-							GET_KEY_TYPE(bk, type);
-						}
-					}
-				}
-			}
-		}
-		return type;
-	}
-
-	void Ardb::VisitDB(const DBID& db, RawValueVisitor* visitor, Iterator* iter)
-	{
-		Iterator* current_iter = iter;
-		if (NULL == current_iter)
-		{
-			current_iter = NewIterator(db);
-		}
-		while (NULL != current_iter && current_iter->Valid())
-		{
-			DBID tmpdb;
-			KeyType t;
-			if (!peek_dbkey_header(current_iter->Key(), tmpdb, t)
-			        || tmpdb != db)
-			{
-				break;
-			}
-			int ret = visitor->OnRawKeyValue(current_iter->Key(),
-			        current_iter->Value());
-			current_iter->Next();
-			if (ret == -1)
-			{
-				break;
-			}
-		}
-		if (NULL == iter)
-		{
-			DELETE(current_iter);
-		}
-	}
-	void Ardb::VisitAllDB(RawValueVisitor* visitor, Iterator* iter)
-	{
-		Iterator* current_iter = iter;
-		if (NULL == current_iter)
-		{
-			current_iter = NewIterator();
-		}
-		while (NULL != current_iter && current_iter->Valid())
-		{
-			int ret = visitor->OnRawKeyValue(current_iter->Key(),
-			        current_iter->Value());
-			current_iter->Next();
-			if (ret == -1)
-			{
-				break;
-			}
-		}
-		if (NULL == iter)
-		{
-			DELETE(current_iter);
-		}
-	}
-
-	Iterator* Ardb::NewIterator()
-	{
-		Slice empty;
-		return GetEngine()->Find(empty, false);
-	}
-	Iterator* Ardb::NewIterator(const DBID& db)
-	{
-		KeyObject key(Slice(), KV, db);
-		return FindValue(key);
-	}
-
-	void Ardb::PrintDB(const DBID& db)
-	{
-		Slice empty;
-		KeyObject start(empty, KV, db);
-		Iterator* iter = FindValue(start);
-		while (NULL != iter && iter->Valid())
-		{
-			Slice tmpkey = iter->Key();
-			KeyObject* kk = decode_key(tmpkey, NULL);
-			if (kk->db != db)
-			{
-				DELETE(kk);
-				break;
-			}
-			ValueObject v;
-			Buffer readbuf(const_cast<char*>(iter->Value().data()), 0,
-			        iter->Value().size());
-			decode_value(readbuf, v, false);
-			if (NULL != kk)
-			{
-				std::string str;
-				DEBUG_LOG(
-				        "[%d]Key=%s, Value=%s", kk->type, kk->key.data(), v.ToString(str).c_str());
-			}
-			DELETE(kk);
-			iter->Next();
-		}
-		DELETE(iter);
-	}
-
-	int Ardb::CompactAll()
-	{
-		struct CompactTask: public Thread
-		{
-				Ardb* adb;
-				CompactTask(Ardb* db) :
-						adb(db)
-				{
-				}
-				void Run()
-				{
-					adb->GetEngine()->CompactRange(Slice(), Slice());
-					delete this;
-				}
-		};
-		/*
-		 * Start a background thread to compact kvs
-		 */
-		Thread* t = new CompactTask(this);
-		t->Start();
-		return 0;
-		return 0;
-	}
-
-	int Ardb::CompactDB(const DBID& db)
-	{
-		struct CompactTask: public Thread
-		{
-				Ardb* adb;
-				DBID dbid;
-				CompactTask(Ardb* db, DBID id) :
-						adb(db), dbid(id)
-				{
-				}
-				void Run()
-				{
-					KeyObject start(Slice(), KV, dbid);
-					KeyObject end(Slice(), KV, dbid + 1);
-					Buffer sbuf, ebuf;
-					encode_key(sbuf, start);
-					encode_key(ebuf, end);
-					adb->GetEngine()->CompactRange(sbuf.AsString(),
-					        ebuf.AsString());
-					delete this;
-				}
-		};
-		/*
-		 * Start a background thread to compact kvs
-		 */
-		Thread* t = new CompactTask(this, db);
-		t->Start();
-		return 0;
-	}
-
-	int Ardb::FlushDB(const DBID& db)
-	{
-		struct VisitorTask: public RawValueVisitor, public Thread
-		{
-				Ardb* adb;
-				DBID dbid;
-				uint32 count;
-				VisitorTask(Ardb* db, DBID id) :
-						adb(db), dbid(id), count(0)
-				{
-				}
-				int OnRawKeyValue(const Slice& key, const Slice& value)
-				{
-					if (count % 100 == 0)
-					{
-						if (count > 0)
-						{
-							adb->GetEngine()->CommitBatchWrite();
-						}
-						adb->GetEngine()->BeginBatchWrite();
-					}
-					count++;
-					adb->RawDel(key);
-					return 0;
-				}
-				void Run()
-				{
-					adb->VisitDB(dbid, this);
-					adb->GetEngine()->CommitBatchWrite();
-					KeyObject start(Slice(), KV, dbid);
-					KeyObject end(Slice(), KV, dbid + 1);
-					Buffer sbuf, ebuf;
-					encode_key(sbuf, start);
-					encode_key(ebuf, end);
-					adb->GetEngine()->CompactRange(sbuf.AsString(),
-					        ebuf.AsString());
-					delete this;
-				}
-		};
-		/*
-		 * Start a background thread to delete kvs
-		 */
-		Thread* t = new VisitorTask(this, db);
-		t->Start();
-		return 0;
-	}
-
-	int Ardb::FlushAll()
-	{
-		struct VisitorTask: public RawValueVisitor, public Thread
-		{
-				Ardb* db;
-				uint32 count;
-				VisitorTask(Ardb* adb) :
-						db(adb), count(0)
-				{
-				}
-				int OnRawKeyValue(const Slice& key, const Slice& value)
-				{
-					if (count % 100 == 0)
-					{
-						if (count > 0)
-						{
-							db->GetEngine()->CommitBatchWrite();
-						}
-						db->GetEngine()->BeginBatchWrite();
-					}
-					count++;
-					db->RawDel(key);
-					return 0;
-				}
-				void Run()
-				{
-					db->VisitAllDB(this);
-					db->GetEngine()->CommitBatchWrite();
-					db->GetEngine()->CompactRange(Slice(), Slice());
-					delete this;
-				}
-		};
-		/*
-		 * Start a background thread to delete kvs
-		 */
-		Thread* t = new VisitorTask(this);
-		t->Start();
-		return 0;
-	}
-}
-
+ /*
+ *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
+ *All rights reserved.
+ * 
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ * 
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Redis nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ * 
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+ *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ *THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ardb.hpp"
+#include <string.h>
+#include <sstream>
+#include "comparator.hpp"
+#include "util/thread/thread.hpp"
+
+namespace ardb
+{
+	/*
+	 * Keys are encoded with order preserving fields (see encode_key), so
+	 * comparing is a plain memcmp without any decoding.
+	 */
+	int ardb_compare_keys(const char* akbuf, size_t aksiz, const char* bkbuf,
+	        size_t bksiz)
+	{
+		size_t minsize = aksiz < bksiz ? aksiz : bksiz;
+		int ret = memcmp(akbuf, bkbuf, minsize);
+		if (ret != 0)
+		{
+			return ret;
+		}
+		return COMPARE_NUMBER(aksiz, bksiz);
+	}
+
+	int ardb_compare_legacy_keys(const char* akbuf, size_t aksiz,
+	        const char* bkbuf, size_t bksiz)
+	{
+		Buffer ak_buf(const_cast<char*>(akbuf), 0, aksiz);
+		Buffer bk_buf(const_cast<char*>(bkbuf), 0, bksiz);
+		uint32 aheader, bheader;
+		bool found_a = BufferHelper::ReadFixUInt32(ak_buf, aheader);
+		bool found_b = BufferHelper::ReadFixUInt32(bk_buf, bheader);
+		COMPARE_EXIST(found_a, found_b);
+		uint32 adb = aheader >> 8;
+		uint32 bdb = bheader >> 8;
+		RETURN_NONEQ_RESULT(adb, bdb);
+		uint8 at = aheader & 0xFF;
+		uint8 bt = bheader & 0xFF;
+		RETURN_NONEQ_RESULT(at, bt);
+		uint32 akeysize, bkeysize;
+		found_a = BufferHelper::ReadVarUInt32(ak_buf, akeysize);
+		found_b = BufferHelper::ReadVarUInt32(bk_buf, bkeysize);
+		COMPARE_EXIST(found_a, found_b);
+		RETURN_NONEQ_RESULT(akeysize, bkeysize);
+
+		Slice akey(ak_buf.GetRawReadBuffer(), akeysize);
+		Slice bkey(bk_buf.GetRawReadBuffer(), bkeysize);
+		found_a = ak_buf.ReadableBytes() >= akeysize;
+		found_b = bk_buf.ReadableBytes() >= bkeysize;
+		COMPARE_EXIST(found_a, found_b);
+		ak_buf.SkipBytes(akeysize);
+		bk_buf.SkipBytes(bkeysize);
+		int ret = akey.compare(bkey);
+		if (ret != 0)
+		{
+			return ret;
+		}
+		switch (at)
+		{
+			case HASH_FIELD:
+			{
+				Slice af, bf;
+				found_a = BufferHelper::ReadVarSlice(ak_buf, af);
+				found_b = BufferHelper::ReadVarSlice(bk_buf, bf);
+				COMPARE_EXIST(found_a, found_b);
+				RETURN_NONEQ_RESULT(af.size(), bf.size());
+				ret = af.compare(bf);
+				break;
+			}
+			case LIST_ELEMENT:
+			{
+				float ascore, bscore;
+				found_a = BufferHelper::ReadFixFloat(ak_buf, ascore);
+				found_b = BufferHelper::ReadFixFloat(bk_buf, bscore);
+				COMPARE_EXIST(found_a, found_b);
+				ret = COMPARE_NUMBER(ascore, bscore);
+				break;
+			}
+			case ZSET_ELEMENT_SCORE:
+			case SET_ELEMENT:
+			{
+				ValueObject av, bv;
+				found_a = decode_value(ak_buf, av, false);
+				found_b = decode_value(bk_buf, bv, false);
+				COMPARE_EXIST(found_a, found_b);
+				ret = av.Compare(bv);
+				break;
+			}
+			case ZSET_ELEMENT:
+			{
+				double ascore, bscore;
+				found_a = BufferHelper::ReadFixDouble(ak_buf, ascore);
+				found_b = BufferHelper::ReadFixDouble(bk_buf, bscore);
+				ret = COMPARE_NUMBER(ascore, bscore);
+				if (ret == 0)
+				{
+					ValueObject av, bv;
+					found_a = decode_value(ak_buf, av);
+					found_b = decode_value(bk_buf, bv);
+					COMPARE_EXIST(found_a, found_b);
+					ret = av.Compare(bv);
+				}
+				break;
+			}
+			case TABLE_INDEX:
+			{
+				Slice af, bf;
+				found_a = BufferHelper::ReadVarSlice(ak_buf, af);
+				found_b = BufferHelper::ReadVarSlice(bk_buf, bf);
+				COMPARE_EXIST(found_a, found_b);
+				ret = af.compare(bf);
+				if (ret == 0)
+				{
+					ValueObject kav, kbv;
+					found_a = decode_value(ak_buf, kav);
+					found_b = decode_value(bk_buf, kbv);
+					COMPARE_EXIST(found_a, found_b);
+					ret = kav.Compare(kbv);
+					if (ret != 0)
+					{
+						break;
+					}
+					uint32 alen, blen;
+					found_a = BufferHelper::ReadVarUInt32(ak_buf, alen);
+					found_b = BufferHelper::ReadVarUInt32(bk_buf, blen);
+					COMPARE_EXIST(found_a, found_b);
+					ret = COMPARE_NUMBER(alen, blen);
+					if (ret == 0)
+					{
+						for (uint32 i = 0; i < alen; i++)
+						{
+							ValueObject av, bv;
+							found_a = decode_value(ak_buf, av);
+							found_b = decode_value(bk_buf, bv);
+							COMPARE_EXIST(found_a, found_b);
+							ret = av.Compare(bv);
+							if (ret != 0)
+							{
+								break;
+							}
+						}
+					}
+				}
+				break;
+			}
+			case TABLE_COL:
+			{
+				Slice af, bf;
+				found_a = BufferHelper::ReadVarSlice(ak_buf, af);
+				found_b = BufferHelper::ReadVarSlice(bk_buf, bf);
+				COMPARE_EXIST(found_a, found_b);
+				ret = COMPARE_NUMBER(af.size(), bf.size());
+				if (ret != 0)
+				{
+					return ret;
+				}
+				uint32 alen, blen;
+				found_a = BufferHelper::ReadVarUInt32(ak_buf, alen);
+				found_b = BufferHelper::ReadVarUInt32(bk_buf, blen);
+				COMPARE_EXIST(found_a, found_b);
+				ret = COMPARE_NUMBER(alen, blen);
+				if (ret == 0)
+				{
+					for (uint32 i = 0; i < alen; i++)
+					{
+						ValueObject av, bv;
+						found_a = decode_value(ak_buf, av);
+						found_b = decode_value(bk_buf, bv);
+						COMPARE_EXIST(found_a, found_b);
+						ret = av.Compare(bv);
+						if (ret != 0)
+						{
+							return ret;
+						}
+					}
+				}
+				break;
+			}
+			case BITSET_ELEMENT:
+			{
+				uint64 aindex, bindex;
+				found_a = BufferHelper::ReadVarUInt64(ak_buf, aindex);
+				found_b = BufferHelper::ReadVarUInt64(bk_buf, bindex);
+				COMPARE_EXIST(found_a, found_b);
+				ret = COMPARE_NUMBER(aindex, bindex);
+				break;
+			}
+			case SET_META:
+			case ZSET_META:
+			case LIST_META:
+			case TABLE_META:
+			case TABLE_SCHEMA:
+			case BITSET_META:
+			default:
+			{
+				break;
+			}
+		}
+		return ret;
+	}
+
+	size_t Ardb::RealPosition(Buffer* buf, int pos)
+	{
+		if (pos < 0)
+		{
+			pos = buf->ReadableBytes() + pos;
+		}
+		if (pos > 0 && (uint32) pos >= buf->ReadableBytes())
+		{
+			pos = buf->ReadableBytes() - 1;
+		}
+		if (pos < 0)
+		{
+			pos = 0;
+		}
+		return pos;
+	}
+
+	static uint32 hash_lock_key(const DBID& db, const Slice& key)
+	{
+		uint32 h = 2166136261U ^ db;
+		for (size_t i = 0; i < key.size(); i++)
+		{
+			h ^= (unsigned char) key.data()[i];
+			h *= 16777619U;
+		}
+		return h;
+	}
+
+	bool Ardb::KeyLocker::TryAddLockKey(Stripe& stripe, const DBID& db,
+	        const Slice& key)
+	{
+		pthread_t self = pthread_self();
+		LockGuard<SpinMutexLock> guard(stripe.keys_lock);
+		std::pair<LockedKeyTable::iterator, bool> ret =
+		        stripe.locked_keys.insert(
+		                std::make_pair(DBItemKey(db, key), LockedKey()));
+		LockedKey& locked = ret.first->second;
+		if (ret.second)
+		{
+			locked.owner = self;
+			locked.depth = 1;
+			return true;
+		}
+		if (pthread_equal(locked.owner, self))
+		{
+			locked.depth++;
+			return true;
+		}
+		return false;
+	}
+
+	void Ardb::KeyLocker::AddLockKey(const DBID& db, const Slice& key)
+	{
+		if (!enable)
+		{
+			return;
+		}
+		Stripe& stripe = m_stripes[hash_lock_key(db, key) % kStripeCount];
+		__sync_add_and_fetch(&m_lock_count, 1);
+		if (TryAddLockKey(stripe, db, key))
+		{
+			return;
+		}
+		__sync_add_and_fetch(&m_contended_count, 1);
+		GroupLocks& group = m_group_local.GetValue();
+		if (!group.keys.empty())
+		{
+			/*
+			 * The owner may be waiting for one of our held keys.
+			 */
+			if (0 != adb->FlushGroupCommit())
+			{
+				group.failed = true;
+			}
+		}
+		LockGuard<ThreadMutexLock> guard(stripe.waitq);
+		/*
+		 * Register as waiter before checking again, so that the releasing
+		 * thread either sees the waiter or we see the released key.
+		 */
+		__sync_add_and_fetch(&stripe.waiters, 1);
+		while (!TryAddLockKey(stripe, db, key))
+		{
+			stripe.waitq.Wait();
+			__sync_add_and_fetch(&m_wakeup_count, 1);
+		}
+		__sync_sub_and_fetch(&stripe.waiters, 1);
+	}
+
+	void Ardb::KeyLocker::ClearLockKey(const DBID& db, const Slice& key)
+	{
+		if (!enable)
+		{
+			return;
+		}
+		Stripe& stripe = m_stripes[hash_lock_key(db, key) % kStripeCount];
+		{
+			LockGuard<SpinMutexLock> guard(stripe.keys_lock);
+			LockedKeyTable::iterator found = stripe.locked_keys.find(
+			        DBItemKey(db, key));
+			if (found == stripe.locked_keys.end()
+			        || --(found->second.depth) > 0 || found->second.held)
+			{
+				return;
+			}
+			GroupLocks& group = m_group_local.GetValue();
+			if (group.grouping)
+			{
+				group.keys.push_back(HeldKey(db, key));
+				LockedKey locked = found->second;
+				locked.held = true;
+				stripe.locked_keys.erase(found);
+				stripe.locked_keys.insert(
+				        std::make_pair(DBItemKey(db, group.keys.back().key),
+				                locked));
+				return;
+			}
+			stripe.locked_keys.erase(found);
+		}
+		NotifyWaiters(stripe);
+	}
+	void Ardb::KeyLocker::NotifyWaiters(Stripe& stripe)
+	{
+		if (__sync_add_and_fetch(&stripe.waiters, 0) > 0)
+		{
+			LockGuard<ThreadMutexLock> guard(stripe.waitq);
+			stripe.waitq.NotifyAll();
+		}
+	}
+	/*
+	 * Keys locked again by the running command stay held, their table
+	 * entries still point to our copy of the key.
+	 */
+	void Ardb::KeyLocker::ReleaseHeldKeys(GroupLocks& group)
+	{
+		HeldKeyList::iterator it = group.keys.begin();
+		while (it != group.keys.end())
+		{
+			Stripe& stripe = m_stripes[hash_lock_key(it->db, it->key)
+			        % kStripeCount];
+			{
+				LockGuard<SpinMutexLock> guard(stripe.keys_lock);
+				LockedKeyTable::iterator found = stripe.locked_keys.find(
+				        DBItemKey(it->db, it->key));
+				if (found != stripe.locked_keys.end()
+				        && found->second.depth > 0)
+				{
+					it++;
+					continue;
+				}
+				if (found != stripe.locked_keys.end())
+				{
+					stripe.locked_keys.erase(found);
+				}
+			}
+			NotifyWaiters(stripe);
+			it = group.keys.erase(it);
+		}
+	}
+
+	bool Ardb::BeginGroupCommit()
+	{
+		if (!GetEngine()->SupportGroupCommit())
+		{
+			return false;
+		}
+		GetEngine()->BeginBatchWrite();
+		KeyLocker::GroupLocks& group = m_key_locker.m_group_local.GetValue();
+		group.grouping = true;
+		group.failed = false;
+		return true;
+	}
+
+	int Ardb::FlushGroupCommit()
+	{
+		int ret = GetEngine()->FlushBatchWrite();
+		m_key_locker.ReleaseHeldKeys(m_key_locker.m_group_local.GetValue());
+		return ret;
+	}
+
+	/*
+	 * Only a thread with an open group has writes pending, engines without
+	 * group commit never open one.
+	 */
+	int Ardb::SyncGroupCommit()
+	{
+		KeyLocker::GroupLocks& group = m_key_locker.m_group_local.GetValue();
+		if (!group.grouping)
+		{
+			return 0;
+		}
+		if (0 != FlushGroupCommit())
+		{
+			group.failed = true;
+		}
+		return group.failed ? -1 : 0;
+	}
+
+	/*
+	 * Keys are released only after the batch is written, so no other thread
+	 * reads them before the group's writes are visible.
+	 */
+	int Ardb::EndGroupCommit()
+	{
+		int ret = GetEngine()->CommitBatchWrite();
+		KeyLocker::GroupLocks& group = m_key_locker.m_group_local.GetValue();
+		group.grouping = false;
+		m_key_locker.ReleaseHeldKeys(group);
+		if (group.failed)
+		{
+			ret = -1;
+		}
+		return ret;
+	}
+
+	const std::string Ardb::KeyLockStats()
+	{
+		char tmp[256];
+		sprintf(tmp,
+		        "keylock_acquired:%"PRIu64"\r\nkeylock_contended:%"PRIu64"\r\nkeylock_wakeups:%"PRIu64"\r\n",
+		        m_key_locker.m_lock_count, m_key_locker.m_contended_count,
+		        m_key_locker.m_wakeup_count);
+		return tmp;
+	}
+
+	//static const char* REPO_NAME = "data";
+	Ardb::Ardb(KeyValueEngineFactory* engine, bool multi_thread) :
+			m_engine_factory(engine), m_engine(NULL), m_key_watcher(NULL), m_raw_key_listener(
+			        NULL), m_listened_engine(NULL)
+	{
+		m_key_locker.enable = multi_thread;
+		m_key_locker.adb = this;
+	}
+
+	bool Ardb::Init()
+	{
+		if (NULL == m_engine)
+		{
+			INFO_LOG("Start init storage engine.");
+			m_engine = m_engine_factory->CreateDB(
+			        m_engine_factory->GetName().c_str());
+
+			KeyObject verkey(Slice(), KEY_END, ARDB_GLOBAL_DB);
+			ValueObject ver;
+			if (0 == GetValue(verkey, &ver, NULL))
+			{
+				/*
+				 * Versions 2 to 5 lack derived records, still key list
+				 * elements by score or keep uncompressed bitset chunks,
+				 * upgrade in place.
+				 */
+				if (ver.v.int_v >= 2 && ver.v.int_v < ARDB_FORMAT_VERSION)
+				{
+					INFO_LOG("Upgrading data format version %"PRId64" to %d.", ver.v.int_v, ARDB_FORMAT_VERSION);
+					UpgradeData(ver.v.int_v);
+					ver.v.int_v = ARDB_FORMAT_VERSION;
+					SetValue(verkey, ver);
+				}
+				if (ver.v.int_v != ARDB_FORMAT_VERSION)
+				{
+					ERROR_LOG(
+					        "Incompatible data format version:%d in DB, use ardb-migrate to convert it to version:%d", ver.v.int_v, ARDB_FORMAT_VERSION);
+					return false;
+				}
+			}
+			else
+			{
+				ver.v.int_v = ARDB_FORMAT_VERSION;
+				ver.type = INTEGER;
+				SetValue(verkey, ver);
+			}
+			if (NULL != m_engine)
+			{
+				INFO_LOG("Init storage engine success.");
+				RegisterRawKeyListener(m_raw_key_listener);
+			}
+		}
+		return m_engine != NULL;
+	}
+
+	Ardb::~Ardb()
+	{
+		DELETE(m_listened_engine);
+		if (NULL != m_engine)
+		{
+			m_engine_factory->CloseDB(m_engine);
+		}
+	}
+
+	/*
+	 * Write the KEY_DIRECTORY record of every non string key from the
+	 * records which used to tell a key's type.
+	 */
+	int Ardb::RebuildKeyDirectory()
+	{
+		static const uint32 kBatchSize = 1024;
+		DBID lastdb = 0;
+		KeyType lasttype = KEY_END;
+		std::string lastkey;
+		uint64 count = 0;
+		Iterator* iter = GetEngine()->Find(Slice(), false);
+		GetEngine()->BeginBatchWrite();
+		while (NULL != iter && iter->Valid())
+		{
+			DBID db;
+			KeyType type;
+			if (peek_dbkey_header(iter->Key(), db, type)
+			        && (type == SET_ELEMENT || type == ZSET_ELEMENT_SCORE
+			                || type == HASH_FIELD || type == LIST_META
+			                || type == TABLE_META || type == BITSET_META))
+			{
+				KeyObject* k = decode_key(iter->Key(), NULL);
+				if (NULL != k
+				        && (db != lastdb || type != lasttype
+				                || k->key.compare(lastkey) != 0))
+				{
+					SetKeyDirectory(db, k->key, type);
+					lastdb = db;
+					lasttype = type;
+					lastkey.assign(k->key.data(), k->key.size());
+					count++;
+					if (count % kBatchSize == 0)
+					{
+						GetEngine()->CommitBatchWrite();
+						GetEngine()->BeginBatchWrite();
+					}
+				}
+				DELETE(k);
+			}
+			iter->Next();
+		}
+		GetEngine()->CommitBatchWrite();
+		DELETE(iter);
+		INFO_LOG("Rebuilt %"PRIu64" key directory records.", count);
+		return 0;
+	}
+
+	/*
+	 * Write the records added after the given data format version.
+	 */
+	int Ardb::UpgradeData(int64 version)
+	{
+		if (version < 3)
+		{
+			RebuildKeyDirectory();
+		}
+		if (version < 4)
+		{
+			RebuildHashMeta();
+		}
+		if (version < 5)
+		{
+			RebuildListIndex();
+		}
+		if (version < 6)
+		{
+			RebuildBitSets();
+		}
+		return 0;
+	}
+
+	void Ardb::Walk(KeyObject& key, bool reverse, WalkHandler* handler)
+	{
+		bool isFirstElement = true;
+		Iterator* iter = FindValue(key);
+		if (NULL != iter && !iter->Valid() && reverse)
+		{
+			iter->SeekToLast();
+			isFirstElement = false;
+		}
+		uint32 cursor = 0;
+		while (NULL != iter && iter->Valid())
+		{
+			Slice tmpkey = iter->Key();
+			KeyObject* kk = decode_key(tmpkey, &key);
+			if (NULL == kk || kk->type != key.type
+			        || kk->key.compare(key.key) != 0)
+			{
+				DELETE(kk);
+				if (reverse && isFirstElement)
+				{
+					iter->Prev();
+					isFirstElement = false;
+					continue;
+				}
+				break;
+			}
+			ValueObject v;
+			Buffer readbuf(const_cast<char*>(iter->Value().data()), 0,
+			        iter->Value().size());
+			decode_value(readbuf, v, false);
+			int ret = handler->OnKeyValue(kk, &v, cursor++);
+			DELETE(kk);
+			if (ret < 0)
+			{
+				break;
+			}
+			if (reverse)
+			{
+				iter->Prev();
+			}
+			else
+			{
+				iter->Next();
+			}
+		}
+		DELETE(iter);
+	}
+
+	/*
+	 * Resumable walk over the elements of one key. The cursor is the hex
+	 * encoded engine key of the next element to visit, "0" starts from
+	 * 'start' and is returned once all elements have been visited.
+	 */
+	int Ardb::ScanElements(KeyObject& start, const std::string& cursor,
+	        uint32 limit, WalkHandler* handler, std::string& newcursor)
+	{
+		struct ScanWalk: public WalkHandler
+		{
+				uint32 z_limit;
+				WalkHandler* z_handler;
+				std::string& z_cursor;
+				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
+				{
+					if (cursor >= z_limit)
+					{
+						Buffer buf(k->key.size() + 16);
+						encode_key(buf, *k);
+						z_cursor = string_tohex(
+						        std::string(buf.GetRawReadBuffer(),
+						                buf.ReadableBytes()));
+						return -1;
+					}
+					return z_handler->OnKeyValue(k, v, cursor);
+				}
+				ScanWalk(uint32 limit, WalkHandler* h, std::string& c) :
+						z_limit(limit), z_handler(h), z_cursor(c)
+				{
+				}
+		} walk(limit, handler, newcursor);
+		std::string rawkey;
+		KeyObject* from = NULL;
+		if (cursor != "0")
+		{
+			if (!string_fromhex(cursor, rawkey)
+			        || NULL == (from = decode_key(rawkey, &start)))
+			{
+				return ERR_INVALID_ARGS;
+			}
+		}
+		newcursor = "0";
+		Walk(NULL != from ? *from : start, false, &walk);
+		DELETE(from);
+		return 0;
+	}
+
+	int RawKeyListenedEngine::BeginBatchWrite()
+	{
+		m_batch_depth.GetValue()++;
+		return m_engine->BeginBatchWrite();
+	}
+
+	int RawKeyListenedEngine::CommitBatchWrite()
+	{
+		uint32& depth = m_batch_depth.GetValue();
+		if (depth > 0)
+		{
+			depth--;
+		}
+		int ret = m_engine->CommitBatchWrite();
+		if (depth == 0)
+		{
+			if (0 == ret)
+			{
+				m_listener->OnBatchCommitted();
+			}
+			else
+			{
+				m_listener->OnBatchDiscarded();
+			}
+		}
+		return ret;
+	}
+
+	/*
+	 * The engine drops the thread's whole pending batch on a discard at any
+	 * depth, so does the listener.
+	 */
+	int RawKeyListenedEngine::DiscardBatchWrite()
+	{
+		uint32& depth = m_batch_depth.GetValue();
+		if (depth > 0)
+		{
+			depth--;
+		}
+		int ret = m_engine->DiscardBatchWrite();
+		m_listener->OnBatchDiscarded();
+		return ret;
+	}
+
+	int RawKeyListenedEngine::FlushBatchWrite()
+	{
+		int ret = m_engine->FlushBatchWrite();
+		if (0 == ret)
+		{
+			m_listener->OnBatchCommitted();
+		}
+		else
+		{
+			m_listener->OnBatchDiscarded();
+		}
+		return ret;
+	}
+
+	void Ardb::RegisterRawKeyListener(RawKeyListener* w)
+	{
+		m_raw_key_listener = w;
+		DELETE(m_listened_engine);
+		if (NULL != w && NULL != m_engine)
+		{
+			m_listened_engine = new RawKeyListenedEngine(m_engine, w);
+		}
+	}
+
+	KeyValueEngine* Ardb::GetEngine()
+	{
+		return NULL != m_listened_engine ? m_listened_engine : m_engine;
+	}
+
+	int Ardb::RawSet(const Slice& key, const Slice& value)
+	{
+		int ret = GetEngine()->Put(key, value);
+		if (ret == 0 && NULL != m_listened_engine)
+		{
+			m_raw_key_listener->OnKeyUpdated(key, value);
+			if (!m_listened_engine->InBatch())
+			{
+				m_raw_key_listener->OnBatchCommitted();
+			}
+		}
+		return ret;
+	}
+	int Ardb::RawDel(const Slice& key)
+	{
+		int ret = GetEngine()->Del(key);
+		if (ret == 0 && NULL != m_listened_engine)
+		{
+			m_raw_key_listener->OnKeyDeleted(key);
+			if (!m_listened_engine->InBatch())
+			{
+				m_raw_key_listener->OnBatchCommitted();
+			}
+		}
+		return ret;
+	}
+
+	int Ardb::RawGet(const Slice& key, std::string* value)
+	{
+		return GetEngine()->Get(key, value);
+	}
+
+	int Ardb::Type(const DBID& db, const Slice& key)
+	{
+		if (Exists(db, key))
+		{
+			return KV;
+		}
+		KeyObject dk(key, KEY_DIRECTORY, db);
+		ValueObject v;
+		if (0 == GetValue(dk, &v) && v.type == INTEGER)
+		{
+			return (int) v.v.int_v;
+		}
+		return -1;
+	}
+
+	void Ardb::VisitDB(const DBID& db, RawValueVisitor* visitor, Iterator* iter)
+	{
+		Iterator* current_iter = iter;
+		if (NULL == current_iter)
+		{
+			current_iter = NewIterator(db);
+		}
+		while (NULL != current_iter && current_iter->Valid())
+		{
+			DBID tmpdb;
+			KeyType t;
+			if (!peek_dbkey_header(current_iter->Key(), tmpdb, t)
+			        || tmpdb != db)
+			{
+				break;
+			}
+			int ret = visitor->OnRawKeyValue(current_iter->Key(),
+			        current_iter->Value());
+			current_iter->Next();
+			if (ret == -1)
+			{
+				break;
+			}
+		}
+		if (NULL == iter)
+		{
+			DELETE(current_iter);
+		}
+	}
+	void Ardb::VisitAllDB(RawValueVisitor* visitor, Iterator* iter)
+	{
+		Iterator* current_iter = iter;
+		if (NULL == current_iter)
+		{
+			current_iter = NewIterator();
+		}
+		while (NULL != current_iter && current_iter->Valid())
+		{
+			int ret = visitor->OnRawKeyValue(current_iter->Key(),
+			        current_iter->Value());
+			current_iter->Next();
+			if (ret == -1)
+			{
+				break;
+			}
+		}
+		if (NULL == iter)
+		{
+			DELETE(current_iter);
+		}
+	}
+
+	Iterator* Ardb::NewIterator()
+	{
+		Slice empty;
+		return GetEngine()->Find(empty, false);
+	}
+	Iterator* Ardb::NewIterator(const DBID& db)
+	{
+		KeyObject key(Slice(), KV, db);
+		return FindValue(key);
+	}
+
+	void Ardb::PrintDB(const DBID& db)
+	{
+		Slice empty;
+		KeyObject start(empty, KV, db);
+		Iterator* iter = FindValue(start);
+		while (NULL != iter && iter->Valid())
+		{
+			Slice tmpkey = iter->Key();
+			KeyObject* kk = decode_key(tmpkey, NULL);
+			if (kk->db != db)
+			{
+				DELETE(kk);
+				break;
+			}
+			ValueObject v;
+			Buffer readbuf(const_cast<char*>(iter->Value().data()), 0,
+			        iter->Value().size());
+			decode_value(readbuf, v, false);
+			if (NULL != kk)
+			{
+				std::string str;
+				DEBUG_LOG(
+				        "[%d]Key=%s, Value=%s", kk->type, kk->key.data(), v.ToString(str).c_str());
+			}
+			DELETE(kk);
+			iter->Next();
+		}
+		DELETE(iter);
+	}
+
+	int Ardb::CompactAll()
+	{
+		struct CompactTask: public Thread
+		{
+				Ardb* adb;
+				CompactTask(Ardb* db) :
+						adb(db)
+				{
+				}
+				void Run()
+				{
+					adb->GetEngine()->CompactRange(Slice(), Slice());
+					delete this;
+				}
+		};
+		/*
+		 * Start a background thread to compact kvs
+		 */
+		Thread* t = new CompactTask(this);
+		t->Start();
+		return 0;
+		return 0;
+	}
+
+	int Ardb::CompactDB(const DBID& db)
+	{
+		struct CompactTask: public Thread
+		{
+				Ardb* adb;
+				DBID dbid;
+				CompactTask(Ardb* db, DBID id) :
+						adb(db), dbid(id)
+				{
+				}
+				void Run()
+				{
+					KeyObject start(Slice(), KV, dbid);
+					KeyObject end(Slice(), KV, dbid + 1);
+					Buffer sbuf, ebuf;
+					encode_key(sbuf, start);
+					encode_key(ebuf, end);
+					adb->GetEngine()->CompactRange(sbuf.AsString(),
+					        ebuf.AsString());
+					delete this;
+				}
+		};
+		/*
+		 * Start a background thread to compact kvs
+		 */
+		Thread* t = new CompactTask(this, db);
+		t->Start();
+		return 0;
+	}
+
+	int Ardb::FlushDB(const DBID& db)
+	{
+		struct VisitorTask: public RawValueVisitor, public Thread
+		{
+				Ardb* adb;
+				DBID dbid;
+				uint32 count;
+				VisitorTask(Ardb* db, DBID id) :
+						adb(db), dbid(id), count(0)
+				{
+				}
+				int OnRawKeyValue(const Slice& key, const Slice& value)
+				{
+					if (count % 100 == 0)
+					{
+						if (count > 0)
+						{
+							adb->GetEngine()->CommitBatchWrite();
+						}
+						adb->GetEngine()->BeginBatchWrite();
+					}
+					count++;
+					adb->RawDel(key);
+					return 0;
+				}
+				void Run()
+				{
+					adb->VisitDB(dbid, this);
+					adb->GetEngine()->CommitBatchWrite();
+					KeyObject start(Slice(), KV, dbid);
+					KeyObject end(Slice(), KV, dbid + 1);
+					Buffer sbuf, ebuf;
+					encode_key(sbuf, start);
+					encode_key(ebuf, end);
+					adb->GetEngine()->CompactRange(sbuf.AsString(),
+					        ebuf.AsString());
+					delete this;
+				}
+		};
+		/*
+		 * Start a background thread to delete kvs
+		 */
+		Thread* t = new VisitorTask(this, db);
+		t->Start();
+		return 0;
+	}
+
+	int Ardb::FlushAll()
+	{
+		struct VisitorTask: public RawValueVisitor, public Thread
+		{
+				Ardb* db;
+				uint32 count;
+				VisitorTask(Ardb* adb) :
+						db(adb), count(0)
+				{
+				}
+				int OnRawKeyValue(const Slice& key, const Slice& value)
+				{
+					if (count % 100 == 0)
+					{
+						if (count > 0)
+						{
+							db->GetEngine()->CommitBatchWrite();
+						}
+						db->GetEngine()->BeginBatchWrite();
+					}
+					count++;
+					db->RawDel(key);
+					return 0;
+				}
+				void Run()
+				{
+					db->VisitAllDB(this);
+					db->GetEngine()->CommitBatchWrite();
+					db->GetEngine()->CompactRange(Slice(), Slice());
+					delete this;
+				}
+		};
+		/*
+		 * Start a background thread to delete kvs
+		 */
+		Thread* t = new VisitorTask(this);
+		t->Start();
+		return 0;
+	}
+}
+
@@ -1,583 +1,919 @@
- /*
- *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
- *All rights reserved.
- * 
- *Redistribution and use in source and binary forms, with or without
- *modification, are permitted provided that the following conditions are met:
- * 
- *  * Redistributions of source code must retain the above copyright notice,
- *    this list of conditions and the following disclaimer.
- *  * Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- *  * Neither the name of Redis nor the names of its contributors may be used
- *    to endorse or promote products derived from this software without
- *    specific prior written permission.
- * 
- *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
- *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
- *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
- *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
- *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
- *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
- *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
- *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
- *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
- *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
- *THE POSSIBILITY OF SUCH DAMAGE.
- */
-
-#ifndef ARDB_HPP_
-#define ARDB_HPP_
-#include <stdint.h>
-#include <float.h>
-#include <map>
-#include <vector>
-#include <list>
-#include <string>
-#include <deque>
-#include "common.hpp"
-#include "ardb_data.hpp"
-#include "slice.hpp"
-#include "util/helpers.hpp"
-#include "util/buffer_helper.hpp"
-#include "util/thread/thread_mutex.hpp"
-#include "util/thread/thread_mutex_lock.hpp"
-#include "util/thread/lock_guard.hpp"
-
-#define ARDB_OK 0
-#define ERR_INVALID_ARGS -3
-#define ERR_INVALID_OPERATION -4
-#define ERR_INVALID_STR -5
-#define ERR_DB_NOT_EXIST -6
-#define ERR_KEY_EXIST -7
-#define ERR_INVALID_TYPE -8
-#define ERR_OUTOFRANGE -9
-#define ERR_NOT_EXIST -10
-
-namespace ardb
-{
-
-	struct Iterator
-	{
-			virtual void Next() = 0;
-			virtual void Prev() = 0;
-			virtual Slice Key() const = 0;
-			virtual Slice Value() const = 0;
-			virtual bool Valid() = 0;
-			virtual void SeekToFirst() = 0;
-			virtual void SeekToLast() = 0;
-			virtual ~Iterator()
-			{
-			}
-	};
-
-	struct KeyValueEngine
-	{
-			virtual int Get(const Slice& key, std::string* value) = 0;
-			virtual int Put(const Slice& key, const Slice& value) = 0;
-			virtual int Del(const Slice& key) = 0;
-			virtual int BeginBatchWrite() = 0;
-			virtual int CommitBatchWrite() = 0;
-			virtual int DiscardBatchWrite() = 0;
-			virtual Iterator* Find(const Slice& findkey, bool cache) = 0;
-			virtual const std::string Stats()
-			{
-				return "";
-			}
-			virtual void CompactRange(const Slice& begin, const Slice& end)
-			{
-			}
-			virtual ~KeyValueEngine()
-			{
-			}
-	};
-
-	class BatchWriteGuard
-	{
-		private:
-			KeyValueEngine* m_engine;
-			bool m_success;
-		public:
-			BatchWriteGuard(KeyValueEngine* engine) :
-					m_engine(engine), m_success(true)
-			{
-				if (NULL != m_engine)
-				{
-					m_engine->BeginBatchWrite();
-				}
-			}
-			void MarkFailed()
-			{
-				m_success = false;
-			}
-			~BatchWriteGuard()
-			{
-				if (NULL != m_engine)
-				{
-					if (m_success)
-					{
-						m_engine->CommitBatchWrite();
-					}
-					else
-					{
-						m_engine->DiscardBatchWrite();
-					}
-				}
-			}
-	};
-
-	struct KeyValueEngineFactory
-	{
-			virtual const std::string GetName() = 0;
-			virtual KeyValueEngine* CreateDB(const std::string& name) = 0;
-			virtual void CloseDB(KeyValueEngine* engine) = 0;
-			virtual void DestroyDB(KeyValueEngine* engine) = 0;
-			virtual ~KeyValueEngineFactory()
-			{
-			}
-	};
-
-	struct KeyWatcher
-	{
-			virtual int OnKeyUpdated(const DBID& db, const Slice& key) = 0;
-			virtual int OnAllKeyDeleted(const DBID& dbid) = 0;
-			virtual ~KeyWatcher()
-			{
-			}
-	};
-
-	struct RawKeyListener
-	{
-			virtual int OnKeyUpdated(const Slice& key, const Slice& value) = 0;
-			virtual int OnKeyDeleted(const Slice& key) = 0;
-			virtual ~RawKeyListener()
-			{
-			}
-	};
-
-	struct RawValueVisitor
-	{
-			virtual int OnRawKeyValue(const Slice& key, const Slice& value) = 0;
-			virtual ~RawValueVisitor()
-			{
-			}
-	};
-
-	class Ardb
-	{
-		private:
-			static size_t RealPosition(Buffer* buf, int pos);
-
-			KeyValueEngineFactory* m_engine_factory;
-			KeyValueEngine* m_engine;
-			ThreadMutex m_mutex;
-			KeyWatcher* m_key_watcher;
-			RawKeyListener* m_raw_key_listener;
-
-			int SetExpiration(const DBID& db, const Slice& key,
-			        uint64_t expire);
-
-			int GetValueByPattern(const DBID& db, const Slice& pattern,
-			        ValueObject& subst, ValueObject& value);
-			int GetValue(const DBID& db, const Slice& key, ValueObject* value);
-			int GetValue(const KeyObject& key, ValueObject* v, uint64* expire =
-			        NULL);
-			int SetValue(KeyObject& key, ValueObject& value, uint64 expire = 0);
-			int DelValue(KeyObject& key);
-			Iterator* FindValue(KeyObject& key, bool cache = false);
-			int SetHashValue(const DBID& db, const Slice& key,
-			        const Slice& field, ValueObject& value);
-			int ListPush(const DBID& db, const Slice& key, const Slice& value,
-			        bool athead, bool onlyexist, float withscore = FLT_MAX);
-			int ListPop(const DBID& db, const Slice& key, bool athead,
-			        std::string& value);
-			int GetListMetaValue(const DBID& db, const Slice& key,
-			        ListMetaValue& meta);
-			void SetListMetaValue(const DBID& db, const Slice& key,
-			        ListMetaValue& meta);
-			int GetZSetMetaValue(const DBID& db, const Slice& key,
-			        ZSetMetaValue& meta);
-			void SetZSetMetaValue(const DBID& db, const Slice& key,
-			        ZSetMetaValue& meta);
-			int TryZAdd(const DBID& db, const Slice& key, ZSetMetaValue& meta,
-			        double score, const Slice& value);
-			int GetSetMetaValue(const DBID& db, const Slice& key,
-			        SetMetaValue& meta);
-			void SetSetMetaValue(const DBID& db, const Slice& key,
-			        SetMetaValue& meta);
-
-			int GetBitSetMetaValue(const DBID& db, const Slice& key,
-			        BitSetMetaValue& meta);
-			void SetBitSetMetaValue(const DBID& db, const Slice& key,
-			        BitSetMetaValue& meta);
-			int GetBitSetElementValue(BitSetKeyObject& key,
-			        BitSetElementValue& meta);
-			void SetBitSetElementValue(BitSetKeyObject& key,
-			        BitSetElementValue& meta);
-			int BitsAnd(const DBID& db, SliceArray& keys,
-			        BitSetElementValueMap*& result,
-			        BitSetElementValueMap*& tmp);
-			int BitsOr(const DBID& db, SliceArray& keys,
-			        BitSetElementValueMap*& result, bool isXor);
-			int BitsNot(const DBID& db, const Slice& key,
-			        BitSetElementValueMap*& result);
-			int BitOP(const DBID& db, const Slice& op, SliceArray& keys,
-			        BitSetElementValueMap*& result,
-			        BitSetElementValueMap*& tmp);
-
-			int GetTableMetaValue(const DBID& db, const Slice& key,
-			        TableMetaValue& meta);
-			void SetTableMetaValue(const DBID& db, const Slice& key,
-			        TableMetaValue& meta);
-			int GetTableSchemaValue(const DBID& db, const Slice& key,
-			        TableSchemaValue& meta);
-			void SetTableSchemaValue(const DBID& db, const Slice& key,
-			        TableSchemaValue& meta);
-			int HGetValue(const DBID& db, const Slice& key, const Slice& field,
-			        ValueObject* value);
-			int TInterRowKeys(const DBID& db, const Slice& tableName,
-			        TableSchemaValue& schema, Condition& cond,
-			        SliceSet& prefetch_keyset,
-			        TableKeyIndexValueTable& interset,
-			        TableKeyIndexValueTable& results);
-			int TUnionRowKeys(const DBID& db, const Slice& tableName,
-			        TableSchemaValue& schema, Condition& cond,
-			        SliceSet& prefetch_keyset,
-			        TableKeyIndexValueTable& results);
-			int TGetIndexs(const DBID& db, const Slice& tableName,
-			        TableSchemaValue& schema, Conditions& conds,
-			        SliceSet& prefetch_keyset, TableKeyIndexValueTable*& indexs,
-			        TableKeyIndexValueTable*& temp);
-			int TCol(const DBID& db, const Slice& tableName,
-			        TableSchemaValue& schema, const Slice& col,
-			        TableKeyIndexValueTable& rs);
-			bool TRowExists(const DBID& db, const Slice& tableName,
-			        TableSchemaValue& schema, ValueArray& rowkey);
-			struct WalkHandler
-			{
-					virtual int OnKeyValue(KeyObject* key, ValueObject* value,
-					        uint32 cursor) = 0;
-					virtual ~WalkHandler()
-					{
-					}
-			};
-			void Walk(KeyObject& key, bool reverse, WalkHandler* handler);
-			std::string m_err_cause;
-			void SetErrorCause(const std::string& cause)
-			{
-				m_err_cause = cause;
-			}
-
-			struct KeyLocker
-			{
-					typedef btree::btree_set<DBItemKey> DBItemKeySet;
-					DBItemKeySet m_locked_keys;
-					ThreadMutex m_keys_mutex;
-					ThreadMutexLock m_barrier;
-					bool enable;
-					KeyLocker() :
-							enable(true)
-					{
-					}
-					void AddLockKey(const DBID& db, const Slice& key)
-					{
-						if (!enable)
-						{
-							return;
-						}
-						while (true)
-						{
-							bool insert = false;
-							{
-								LockGuard<ThreadMutex> guard(m_keys_mutex);
-								insert = m_locked_keys.insert(
-								        DBItemKey(db, key)).second;
-							}
-							if (insert)
-							{
-								return;
-							}
-							else
-							{
-								LockGuard<ThreadMutexLock> guard(m_barrier);
-								m_barrier.Wait();
-							}
-						}
-					}
-					void ClearLockKey(const DBID& db, const Slice& key)
-					{
-						if (!enable)
-						{
-							return;
-						}
-						{
-							LockGuard<ThreadMutex> guard(m_keys_mutex);
-							m_locked_keys.erase(DBItemKey(db, key));
-						}
-						LockGuard<ThreadMutexLock> guard(m_barrier);
-						m_barrier.NotifyAll();
-					}
-			};
-
-			struct KeyLockerGuard
-			{
-					KeyLocker& locker;
-					const DBID& db;
-					const Slice& key;
-					KeyLockerGuard(KeyLocker& loc, const DBID& id,
-					        const Slice& k) :
-							locker(loc), db(id), key(k)
-					{
-						locker.AddLockKey(db, key);
-					}
-					~KeyLockerGuard()
-					{
-						locker.ClearLockKey(db, key);
-					}
-			};
-			KeyLocker m_key_locker;
-		public:
-			Ardb(KeyValueEngineFactory* factory, bool multi_thread = true);
-			~Ardb();
-
-			bool Init();
-
-			int RawSet(const Slice& key, const Slice& value);
-			int RawDel(const Slice& key);
-			int RawGet(const Slice& key, std::string* value);
-			/*
-			 * Key-Value operations
-			 */
-			int Set(const DBID& db, const Slice& key, const Slice& value);
-			int Set(const DBID& db, const Slice& key, const Slice& value,
-			        int ex, int px, int nxx);
-			int MSet(const DBID& db, SliceArray& keys, SliceArray& values);
-			int MSetNX(const DBID& db, SliceArray& keys, SliceArray& value);
-			int SetNX(const DBID& db, const Slice& key, const Slice& value);
-			int SetEx(const DBID& db, const Slice& key, const Slice& value,
-			        uint32_t secs);
-			int PSetEx(const DBID& db, const Slice& key, const Slice& value,
-			        uint32_t ms);
-			int Get(const DBID& db, const Slice& key, std::string* value);
-			int MGet(const DBID& db, SliceArray& keys, ValueArray& values);
-			int Del(const DBID& db, const Slice& key);
-			int Del(const DBID& db, const SliceArray& keys);
-			bool Exists(const DBID& db, const Slice& key);
-			int Expire(const DBID& db, const Slice& key, uint32_t secs);
-			int Expireat(const DBID& db, const Slice& key, uint32_t ts);
-			int64 TTL(const DBID& db, const Slice& key);
-			int64 PTTL(const DBID& db, const Slice& key);
-			int Persist(const DBID& db, const Slice& key);
-			int Pexpire(const DBID& db, const Slice& key, uint32_t ms);
-			int Pexpireat(const DBID& db, const Slice& key, uint64_t ms);
-			int Strlen(const DBID& db, const Slice& key);
-			int Rename(const DBID& db, const Slice& key1, const Slice& key2);
-			int RenameNX(const DBID& db, const Slice& key1, const Slice& key2);
-			int Keys(const DBID& db, const std::string& pattern,
-			        StringSet& ret);
-			int Move(DBID srcdb, const Slice& key, DBID dstdb);
-
-			int Append(const DBID& db, const Slice& key, const Slice& value);
-			int Decr(const DBID& db, const Slice& key, int64_t& value);
-			int Decrby(const DBID& db, const Slice& key, int64_t decrement,
-			        int64_t& value);
-			int Incr(const DBID& db, const Slice& key, int64_t& value);
-			int Incrby(const DBID& db, const Slice& key, int64_t increment,
-			        int64_t& value);
-			int IncrbyFloat(const DBID& db, const Slice& key, double increment,
-			        double& value);
-			int GetRange(const DBID& db, const Slice& key, int start, int end,
-			        std::string& valueobj);
-			int SetRange(const DBID& db, const Slice& key, int start,
-			        const Slice& value);
-			int GetSet(const DBID& db, const Slice& key, const Slice& value,
-			        std::string& valueobj);
-			int BitCount(const DBID& db, const Slice& key, int64 start,
-			        int64 end);
-			int GetBit(const DBID& db, const Slice& key, uint64 offset);
-			int SetBit(const DBID& db, const Slice& key, uint64 offset,
-			        uint8 value);
-			int BitOP(const DBID& db, const Slice& op, const Slice& dstkey,
-			        SliceArray& keys);
-			int64 BitOPCount(const DBID& db, const Slice& op, SliceArray& keys);
-			int BitClear(const DBID& db, const Slice& key);
-
-			/*
-			 * Hash operations
-			 */
-			int HSet(const DBID& db, const Slice& key, const Slice& field,
-			        const Slice& value);
-			int HSetNX(const DBID& db, const Slice& key, const Slice& field,
-			        const Slice& value);
-			int HDel(const DBID& db, const Slice& key, const Slice& field);
-			int HDel(const DBID& db, const Slice& key,
-			        const SliceArray& fields);
-			bool HExists(const DBID& db, const Slice& key, const Slice& field);
-			int HGet(const DBID& db, const Slice& key, const Slice& field,
-			        std::string* value);
-			int HIncrby(const DBID& db, const Slice& key, const Slice& field,
-			        int64_t increment, int64_t& value);
-			int HMIncrby(const DBID& db, const Slice& key,
-			        const SliceArray& fields, const Int64Array& increments,
-			        Int64Array& vs);
-			int HIncrbyFloat(const DBID& db, const Slice& key,
-			        const Slice& field, double increment, double& value);
-			int HMGet(const DBID& db, const Slice& key,
-			        const SliceArray& fields, ValueArray& values);
-			int HMSet(const DBID& db, const Slice& key,
-			        const SliceArray& fields, const SliceArray& values);
-			int HGetAll(const DBID& db, const Slice& key, StringArray& fields,
-			        ValueArray& values);
-			int HKeys(const DBID& db, const Slice& key, StringArray& fields);
-			int HVals(const DBID& db, const Slice& key, StringArray& values);
-			int HLen(const DBID& db, const Slice& key);
-			int HClear(const DBID& db, const Slice& key);
-
-			/*
-			 * List operations
-			 */
-			int LPush(const DBID& db, const Slice& key, const Slice& value);
-			int LPushx(const DBID& db, const Slice& key, const Slice& value);
-			int RPush(const DBID& db, const Slice& key, const Slice& value);
-			int RPushx(const DBID& db, const Slice& key, const Slice& value);
-			int LPop(const DBID& db, const Slice& key, std::string& v);
-			int RPop(const DBID& db, const Slice& key, std::string& v);
-			int LIndex(const DBID& db, const Slice& key, int index,
-			        std::string& v);
-			int LInsert(const DBID& db, const Slice& key, const Slice& op,
-			        const Slice& pivot, const Slice& value);
-			int LRange(const DBID& db, const Slice& key, int start, int end,
-			        ValueArray& values);
-			int LRem(const DBID& db, const Slice& key, int count,
-			        const Slice& value);
-			int LSet(const DBID& db, const Slice& key, int index,
-			        const Slice& value);
-			int LTrim(const DBID& db, const Slice& key, int start, int stop);
-			int RPopLPush(const DBID& db, const Slice& key1, const Slice& key2,
-			        std::string& v);
-			int LClear(const DBID& db, const Slice& key);
-			int LLen(const DBID& db, const Slice& key);
-
-			/*
-			 * Sorted Set operations
-			 */
-			int ZAdd(const DBID& db, const Slice& key, double score,
-			        const Slice& value);
-			int ZAdd(const DBID& db, const Slice& key, DoubleArray& scores,
-			        const SliceArray& svs);
-			int ZAddLimit(const DBID& db, const Slice& key, DoubleArray& scores,
-			        const SliceArray& svs, int setlimit, ValueArray& pops);
-			int ZCard(const DBID& db, const Slice& key);
-			int ZScore(const DBID& db, const Slice& key, const Slice& value,
-			        double& score);
-			int ZRem(const DBID& db, const Slice& key, const Slice& value);
-			int ZPop(const DBID& db, const Slice& key, bool reverse, uint32 num,
-			        ValueArray& pops);
-			int ZCount(const DBID& db, const Slice& key, const std::string& min,
-			        const std::string& max);
-			int ZIncrby(const DBID& db, const Slice& key, double increment,
-			        const Slice& value, double& score);
-			int ZRank(const DBID& db, const Slice& key, const Slice& member);
-			int ZRevRank(const DBID& db, const Slice& key, const Slice& member);
-			int ZRemRangeByRank(const DBID& db, const Slice& key, int start,
-			        int stop);
-			int ZRemRangeByScore(const DBID& db, const Slice& key,
-			        const std::string& min, const std::string& max);
-			int ZRange(const DBID& db, const Slice& key, int start, int stop,
-			        ValueArray& values, QueryOptions& options);
-			int ZRangeByScore(const DBID& db, const Slice& key,
-			        const std::string& min, const std::string& max,
-			        ValueArray& values, QueryOptions& options);
-			int ZRevRange(const DBID& db, const Slice& key, int start, int stop,
-			        ValueArray& values, QueryOptions& options);
-			int ZRevRangeByScore(const DBID& db, const Slice& key,
-			        const std::string& max, const std::string& min,
-			        ValueArray& values, QueryOptions& options);
-			int ZUnionStore(const DBID& db, const Slice& dst, SliceArray& keys,
-			        WeightArray& weights, AggregateType type = AGGREGATE_SUM);
-			int ZInterStore(const DBID& db, const Slice& dst, SliceArray& keys,
-			        WeightArray& weights, AggregateType type = AGGREGATE_SUM);
-			int ZClear(const DBID& db, const Slice& key);
-
-			/*
-			 * Set operations
-			 */
-			int SAdd(const DBID& db, const Slice& key, const Slice& value);
-			int SAdd(const DBID& db, const Slice& key,
-			        const SliceArray& values);
-			int SCard(const DBID& db, const Slice& key);
-			int SMembers(const DBID& db, const Slice& key, ValueArray& values);
-			int SDiff(const DBID& db, SliceArray& keys, ValueSet& values);
-			int SDiffCount(const DBID& db, SliceArray& keys, uint32& count);
-			int SDiffStore(const DBID& db, const Slice& dst, SliceArray& keys);
-			int SInter(const DBID& db, SliceArray& keys, ValueSet& values);
-			int SInterCount(const DBID& db, SliceArray& keys, uint32& count);
-			int SInterStore(const DBID& db, const Slice& dst, SliceArray& keys);
-			bool SIsMember(const DBID& db, const Slice& key,
-			        const Slice& value);
-			int SRem(const DBID& db, const Slice& key, const Slice& value);
-			int SRem(const DBID& db, const Slice& key,
-			        const SliceArray& values);
-			int SMove(const DBID& db, const Slice& src, const Slice& dst,
-			        const Slice& value);
-			int SPop(const DBID& db, const Slice& key, std::string& value);
-			int SRandMember(const DBID& db, const Slice& key,
-			        ValueArray& values, int count = 1);
-			int SUnionCount(const DBID& db, SliceArray& keys, uint32& count);
-			int SUnion(const DBID& db, SliceArray& keys, ValueSet& values);
-			int SUnionStore(const DBID& db, const Slice& dst, SliceArray& keys);
-			int SClear(const DBID& db, const Slice& key);
-
-			/*
-			 * Table operations
-			 */
-			int TCreate(const DBID& db, const Slice& tableName,
-			        SliceArray& keys);
-			int TGet(const DBID& db, const Slice& tableName,
-			        TableQueryOptions& options, ValueArray& values,
-			        std::string& err);
-			int TGetAll(const DBID& db, const Slice& tableName,
-			        ValueArray& values);
-			int TUpdate(const DBID& db, const Slice& tableName,
-			        TableUpdateOptions& options);
-			int TInsert(const DBID& db, const Slice& tableName,
-			        TableInsertOptions& options, bool replace,
-			        std::string& err);
-			int TDel(const DBID& db, const Slice& tableName,
-			        TableDeleteOptions& conds, std::string& err);
-			int TDelCol(const DBID& db, const Slice& tableName,
-			        const Slice& col);
-			int TCreateIndex(const DBID& db, const Slice& tableName,
-			        const Slice& col);
-			int TClear(const DBID& db, const Slice& tableName);
-			int TCount(const DBID& db, const Slice& tableName);
-			int TDesc(const DBID& db, const Slice& tableName, std::string& str);
-
-			int Type(const DBID& db, const Slice& key);
-			int Sort(const DBID& db, const Slice& key, const StringArray& args,
-			        ValueArray& values);
-			int FlushDB(const DBID& db);
-			int FlushAll();
-			int CompactDB(const DBID& db);
-			int CompactAll();
-
-			void PrintDB(const DBID& db);
-			void VisitDB(const DBID& db, RawValueVisitor* visitor, Iterator* iter = NULL);
-			void VisitAllDB(RawValueVisitor* visitor, Iterator* iter = NULL);
-			Iterator* NewIterator();
-			Iterator* NewIterator(const DBID& db);
-
-			KeyValueEngine* GetEngine();
-			void RegisterKeyWatcher(KeyWatcher* w)
-			{
-				m_key_watcher = w;
-			}
-			void RegisterRawKeyListener(RawKeyListener* w)
-			{
-				m_raw_key_listener = w;
-			}
-	};
-}
-
-#endif /* RRDB_HPP_ */
+ /*
+ *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
+ *All rights reserved.
+ * 
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ * 
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Redis nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ * 
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+ *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ *THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ARDB_HPP_
+#define ARDB_HPP_
+#include <stdint.h>
+#include <float.h>
+#include <map>
+#include <vector>
+#include <list>
+#include <string>
+#include <deque>
+#include "common.hpp"
+#include "ardb_data.hpp"
+#include "slice.hpp"
+#include "util/helpers.hpp"
+#include "util/buffer_helper.hpp"
+#include "util/thread/thread_mutex.hpp"
+#include "util/thread/thread_mutex_lock.hpp"
+#include "util/thread/lock_guard.hpp"
+#include "util/thread/spin_mutex_lock.hpp"
+#include "util/thread/thread_local.hpp"
+
+#define ARDB_OK 0
+#define ERR_INVALID_ARGS -3
+#define ERR_INVALID_OPERATION -4
+#define ERR_INVALID_STR -5
+#define ERR_DB_NOT_EXIST -6
+#define ERR_KEY_EXIST -7
+#define ERR_INVALID_TYPE -8
+#define ERR_OUTOFRANGE -9
+#define ERR_NOT_EXIST -10
+
+namespace ardb
+{
+
+	struct Iterator
+	{
+			virtual void Next() = 0;
+			virtual void Prev() = 0;
+			virtual Slice Key() const = 0;
+			virtual Slice Value() const = 0;
+			virtual bool Valid() = 0;
+			virtual void SeekToFirst() = 0;
+			virtual void SeekToLast() = 0;
+			virtual ~Iterator()
+			{
+			}
+	};
+
+	struct KeyValueEngine
+	{
+			virtual int Get(const Slice& key, std::string* value) = 0;
+			virtual int Put(const Slice& key, const Slice& value) = 0;
+			virtual int Del(const Slice& key) = 0;
+			virtual int BeginBatchWrite() = 0;
+			virtual int CommitBatchWrite() = 0;
+			virtual int DiscardBatchWrite() = 0;
+			/*
+			 * Group commit runs many commands in one batch, which needs
+			 * reads to see the thread's pending batch writes.
+			 */
+			virtual bool SupportGroupCommit()
+			{
+				return false;
+			}
+			/*
+			 * Commit the writes of the thread's batch so far and keep the
+			 * batch open.
+			 */
+			virtual int FlushBatchWrite()
+			{
+				return -1;
+			}
+			virtual Iterator* Find(const Slice& findkey, bool cache) = 0;
+			/*
+			 * Pin the engine's current state for the calling thread, Get
+			 * and Find read from it until the matching ReleaseSnapshot.
+			 * Nested calls share the outermost snapshot. Writes made
+			 * outside a batch while it is held are not seen.
+			 */
+			virtual int NewSnapshot()
+			{
+				return -1;
+			}
+			virtual int ReleaseSnapshot()
+			{
+				return -1;
+			}
+			/*
+			 * Look up all 'keys' from one consistent view, 'values' and
+			 * 'errs' get one entry per key in the order of 'keys'.
+			 */
+			virtual void MultiGet(const SliceArray& keys, StringArray& values,
+			        std::vector<int>& errs)
+			{
+				values.resize(keys.size());
+				errs.resize(keys.size());
+				bool pinned = 0 == NewSnapshot();
+				for (uint32 i = 0; i < keys.size(); i++)
+				{
+					errs[i] = Get(keys[i], &values[i]);
+				}
+				if (pinned)
+				{
+					ReleaseSnapshot();
+				}
+			}
+			virtual const std::string Stats()
+			{
+				return "";
+			}
+			virtual void CompactRange(const Slice& begin, const Slice& end)
+			{
+			}
+			/*
+			 * Approximate bytes stored for the keys in [begin, end), an
+			 * empty 'end' is the end of the keyspace. 0 if the engine can
+			 * not tell.
+			 */
+			virtual uint64 EstimateSize(const Slice& begin, const Slice& end)
+			{
+				return 0;
+			}
+			/*
+			 * Write a consistent copy of the engine's files into the
+			 * directory 'dir' without blocking writers.
+			 */
+			virtual int Checkpoint(const std::string& dir)
+			{
+				return -1;
+			}
+			virtual ~KeyValueEngine()
+			{
+			}
+	};
+
+	class BatchWriteGuard
+	{
+		private:
+			KeyValueEngine* m_engine;
+			bool m_success;
+		public:
+			BatchWriteGuard(KeyValueEngine* engine) :
+					m_engine(engine), m_success(true)
+			{
+				if (NULL != m_engine)
+				{
+					m_engine->BeginBatchWrite();
+				}
+			}
+			void MarkFailed()
+			{
+				m_success = false;
+			}
+			~BatchWriteGuard()
+			{
+				if (NULL != m_engine)
+				{
+					if (m_success)
+					{
+						m_engine->CommitBatchWrite();
+					}
+					else
+					{
+						m_engine->DiscardBatchWrite();
+					}
+				}
+			}
+	};
+
+	class SnapshotGuard
+	{
+		private:
+			KeyValueEngine* m_engine;
+			bool m_pinned;
+		public:
+			SnapshotGuard(KeyValueEngine* engine) :
+					m_engine(engine), m_pinned(false)
+			{
+				if (NULL != m_engine)
+				{
+					m_pinned = 0 == m_engine->NewSnapshot();
+				}
+			}
+			/*
+			 * Give up the snapshot before the guard goes out of scope,
+			 * e.g. before writing the result of a multi-key read.
+			 */
+			void Release()
+			{
+				if (m_pinned)
+				{
+					m_engine->ReleaseSnapshot();
+					m_pinned = false;
+				}
+			}
+			~SnapshotGuard()
+			{
+				Release();
+			}
+	};
+
+	struct KeyValueEngineFactory
+	{
+			virtual const std::string GetName() = 0;
+			virtual KeyValueEngine* CreateDB(const std::string& name) = 0;
+			virtual void CloseDB(KeyValueEngine* engine) = 0;
+			virtual void DestroyDB(KeyValueEngine* engine) = 0;
+			virtual ~KeyValueEngineFactory()
+			{
+			}
+	};
+
+	struct KeyWatcher
+	{
+			virtual int OnKeyUpdated(const DBID& db, const Slice& key) = 0;
+			virtual int OnAllKeyDeleted(const DBID& dbid) = 0;
+			virtual ~KeyWatcher()
+			{
+			}
+	};
+
+	struct RawKeyListener
+	{
+			virtual int OnKeyUpdated(const Slice& key, const Slice& value) = 0;
+			virtual int OnKeyDeleted(const Slice& key) = 0;
+			/*
+			 * The raw writes the calling thread reported since the last
+			 * call are now in the engine, or were thrown away.
+			 */
+			virtual void OnBatchCommitted()
+			{
+			}
+			virtual void OnBatchDiscarded()
+			{
+			}
+			virtual ~RawKeyListener()
+			{
+			}
+	};
+
+	/*
+	 * Put in front of the engine while a raw key listener is registered, so
+	 * the listener hears when the thread's outermost batch is written.
+	 */
+	class RawKeyListenedEngine: public KeyValueEngine
+	{
+		private:
+			KeyValueEngine* m_engine;
+			RawKeyListener* m_listener;
+			ThreadLocal<uint32> m_batch_depth;
+		public:
+			RawKeyListenedEngine(KeyValueEngine* engine,
+			        RawKeyListener* listener) :
+					m_engine(engine), m_listener(listener)
+			{
+			}
+			bool InBatch()
+			{
+				return m_batch_depth.GetValue() > 0;
+			}
+			int Get(const Slice& key, std::string* value)
+			{
+				return m_engine->Get(key, value);
+			}
+			int Put(const Slice& key, const Slice& value)
+			{
+				return m_engine->Put(key, value);
+			}
+			int Del(const Slice& key)
+			{
+				return m_engine->Del(key);
+			}
+			int BeginBatchWrite();
+			int CommitBatchWrite();
+			int DiscardBatchWrite();
+			bool SupportGroupCommit()
+			{
+				return m_engine->SupportGroupCommit();
+			}
+			int FlushBatchWrite();
+			Iterator* Find(const Slice& findkey, bool cache)
+			{
+				return m_engine->Find(findkey, cache);
+			}
+			int NewSnapshot()
+			{
+				return m_engine->NewSnapshot();
+			}
+			int ReleaseSnapshot()
+			{
+				return m_engine->ReleaseSnapshot();
+			}
+			void MultiGet(const SliceArray& keys, StringArray& values,
+			        std::vector<int>& errs)
+			{
+				m_engine->MultiGet(keys, values, errs);
+			}
+			const std::string Stats()
+			{
+				return m_engine->Stats();
+			}
+			void CompactRange(const Slice& begin, const Slice& end)
+			{
+				m_engine->CompactRange(begin, end);
+			}
+			uint64 EstimateSize(const Slice& begin, const Slice& end)
+			{
+				return m_engine->EstimateSize(begin, end);
+			}
+			int Checkpoint(const std::string& dir)
+			{
+				return m_engine->Checkpoint(dir);
+			}
+	};
+
+	struct RawValueVisitor
+	{
+			virtual int OnRawKeyValue(const Slice& key, const Slice& value) = 0;
+			virtual ~RawValueVisitor()
+			{
+			}
+	};
+
+	class Ardb
+	{
+		private:
+			static size_t RealPosition(Buffer* buf, int pos);
+
+			KeyValueEngineFactory* m_engine_factory;
+			KeyValueEngine* m_engine;
+			ThreadMutex m_mutex;
+			KeyWatcher* m_key_watcher;
+			RawKeyListener* m_raw_key_listener;
+			RawKeyListenedEngine* m_listened_engine;
+
+			int SetExpiration(const DBID& db, const Slice& key,
+			        uint64_t expire);
+			int GetExpiration(const DBID& db, const Slice& key,
+			        uint64& expire);
+			int AddExpireIndex(const DBID& db, const Slice& key,
+			        uint64 expire);
+			int SetKeyDirectory(const DBID& db, const Slice& key,
+			        KeyType type);
+			struct ExpireStat
+			{
+					uint64 expired_keys;
+					uint64 expired_per_sec;
+					uint64 sweeps;
+					uint64 last_sweep_micros;
+					uint64 total_sweep_micros;
+					uint64 max_sweep_micros;
+					uint64 sample_time;
+					uint64 sample_expired_keys;
+					ExpireStat() :
+							expired_keys(0), expired_per_sec(0), sweeps(0), last_sweep_micros(
+							        0), total_sweep_micros(0), max_sweep_micros(
+							        0), sample_time(0), sample_expired_keys(0)
+					{
+					}
+			};
+			ExpireStat m_expire_stat;
+
+			int GetValueByPattern(const DBID& db, const Slice& pattern,
+			        ValueObject& subst, ValueObject& value);
+			int GetValue(const DBID& db, const Slice& key, ValueObject* value);
+			int DecodeRawValue(const Slice& k, const std::string& value,
+			        ValueObject* v, uint64* expire);
+			int GetValue(const KeyObject& key, ValueObject* v, uint64* expire =
+			        NULL);
+			int SetValue(KeyObject& key, ValueObject& value, uint64 expire = 0);
+			int DelValue(KeyObject& key);
+			Iterator* FindValue(KeyObject& key, bool cache = false);
+			int SetHashValue(const DBID& db, const Slice& key,
+			        const Slice& field, ValueObject& value, bool* created =
+			                NULL);
+			int GetHashMetaValue(const DBID& db, const Slice& key,
+			        HashMetaValue& meta);
+			void SetHashMetaValue(const DBID& db, const Slice& key,
+			        HashMetaValue& meta);
+			int RebuildHashMeta();
+			int ListPush(const DBID& db, const Slice& key, const Slice& value,
+			        bool athead, bool onlyexist);
+			void ListShift(const DBID& db, const Slice& key, int64 from,
+			        int64 to, int64 delta);
+			int RebuildListIndex();
+			int ListPop(const DBID& db, const Slice& key, bool athead,
+			        std::string& value);
+			int GetListMetaValue(const DBID& db, const Slice& key,
+			        ListMetaValue& meta);
+			void SetListMetaValue(const DBID& db, const Slice& key,
+			        ListMetaValue& meta);
+			int GetZSetMetaValue(const DBID& db, const Slice& key,
+			        ZSetMetaValue& meta);
+			void SetZSetMetaValue(const DBID& db, const Slice& key,
+			        ZSetMetaValue& meta);
+			int TryZAdd(const DBID& db, const Slice& key, ZSetMetaValue& meta,
+			        double score, const Slice& value);
+			int GetZSetRankNode(const DBID& db, const Slice& key, uint32 level,
+			        const Slice& pos, ZSetRankNode& node);
+			void SetZSetRankNode(const DBID& db, const Slice& key,
+			        uint32 level, const Slice& pos, ZSetRankNode& node,
+			        bool created = false);
+			void DelZSetRankNode(const DBID& db, const Slice& key,
+			        uint32 level, const Slice& pos);
+			int ZSetRankPath(const DBID& db, const Slice& key,
+			        ZSetMetaValue& meta, const Slice& pos, StringArray& path);
+			void ZSetRankClear(const DBID& db, const Slice& key,
+			        ZSetMetaValue& meta);
+			void ZSetRankBuild(const DBID& db, const Slice& key,
+			        ZSetMetaValue& meta);
+			void ZSetRankSplit(const DBID& db, const Slice& key,
+			        ZSetMetaValue& meta, StringArray& path, uint32 level,
+			        ZSetRankNode& node);
+			void ZSetRankInsert(const DBID& db, const Slice& key,
+			        ZSetMetaValue& meta, const Slice& pos);
+			void ZSetRankRemove(const DBID& db, const Slice& key,
+			        ZSetMetaValue& meta, const Slice& pos);
+			int ZSetRankOf(const DBID& db, const Slice& key,
+			        ZSetMetaValue& meta, const Slice& pos, uint32& rank);
+			int ZSetElementAt(const DBID& db, const Slice& key,
+			        ZSetMetaValue& meta, uint32 rank, std::string& element);
+			int GetSetMetaValue(const DBID& db, const Slice& key,
+			        SetMetaValue& meta);
+			void SetSetMetaValue(const DBID& db, const Slice& key,
+			        SetMetaValue& meta);
+
+			int GetBitSetMetaValue(const DBID& db, const Slice& key,
+			        BitSetMetaValue& meta);
+			void SetBitSetMetaValue(const DBID& db, const Slice& key,
+			        BitSetMetaValue& meta);
+			int GetBitSetElementValue(BitSetKeyObject& key,
+			        BitSetElementValue& meta);
+			void SetBitSetElementValue(BitSetKeyObject& key,
+			        BitSetElementValue& meta);
+			/*
+			 * Receives the non empty chunks of a BITOP result in index
+			 * order.
+			 */
+			struct BitSetElementHandler
+			{
+					virtual int OnBitSetElement(uint64 index,
+					        BitSetElementValue& element) = 0;
+					/*
+					 * Handlers which only want the number of bits in each
+					 * result chunk get OnBitSetCount instead.
+					 */
+					virtual bool CountOnly()
+					{
+						return false;
+					}
+					virtual int OnBitSetCount(uint64 index, uint32 count)
+					{
+						return 0;
+					}
+					virtual ~BitSetElementHandler()
+					{
+					}
+			};
+			int ParseBitOP(const Slice& opstr, uint32 keycount,
+			        unsigned long& op);
+			int BitOP(const DBID& db, const Slice& op, SliceArray& keys,
+			        BitSetElementHandler* handler);
+			int RebuildBitSets();
+
+			int GetTableMetaValue(const DBID& db, const Slice& key,
+			        TableMetaValue& meta);
+			void SetTableMetaValue(const DBID& db, const Slice& key,
+			        TableMetaValue& meta);
+			int GetTableSchemaValue(const DBID& db, const Slice& key,
+			        TableSchemaValue& meta);
+			void SetTableSchemaValue(const DBID& db, const Slice& key,
+			        TableSchemaValue& meta);
+			int HGetValue(const DBID& db, const Slice& key, const Slice& field,
+			        ValueObject* value);
+			int TInterRowKeys(const DBID& db, const Slice& tableName,
+			        TableSchemaValue& schema, Condition& cond,
+			        SliceSet& prefetch_keyset,
+			        TableKeyIndexValueTable& interset,
+			        TableKeyIndexValueTable& results);
+			int TUnionRowKeys(const DBID& db, const Slice& tableName,
+			        TableSchemaValue& schema, Condition& cond,
+			        SliceSet& prefetch_keyset,
+			        TableKeyIndexValueTable& results);
+			int TGetIndexs(const DBID& db, const Slice& tableName,
+			        TableSchemaValue& schema, Conditions& conds,
+			        SliceSet& prefetch_keyset, TableKeyIndexValueTable*& indexs,
+			        TableKeyIndexValueTable*& temp);
+			bool TRowExists(const DBID& db, const Slice& tableName,
+			        TableSchemaValue& schema, ValueArray& rowkey);
+			struct WalkHandler
+			{
+					virtual int OnKeyValue(KeyObject* key, ValueObject* value,
+					        uint32 cursor) = 0;
+					virtual ~WalkHandler()
+					{
+					}
+			};
+			void Walk(KeyObject& key, bool reverse, WalkHandler* handler);
+			int ScanElements(KeyObject& start, const std::string& cursor,
+			        uint32 limit, WalkHandler* handler, std::string& newcursor);
+			bool TPlanQuery(TableSchemaValue& schema,
+			        TableQueryOptions& options, int sort_idx,
+			        TableScanPlan& plan);
+			void TScan(const DBID& db, const Slice& tableName,
+			        TableScanPlan& plan, WalkHandler* handler);
+			void TScanComposite(const DBID& db, const Slice& tableName,
+			        TableScanPlan& plan, WalkHandler* handler);
+			void TReadIndexedColumns(const DBID& db, const Slice& tableName,
+			        TableSchemaValue& schema, const ValueArray& rowkey,
+			        NameValueTable& row, TableIndexDef* def = NULL);
+			void TSetCompositeIndexes(const DBID& db, const Slice& tableName,
+			        TableSchemaValue& schema, const ValueArray& rowkey,
+			        NameValueTable& row, bool remove, TableIndexDef* def = NULL);
+			std::string m_err_cause;
+			void SetErrorCause(const std::string& cause)
+			{
+				m_err_cause = cause;
+			}
+
+			/*
+			 * Per key lock table. Keys are hashed into stripes, every stripe
+			 * has its own spin locked key table and its own wait queue, so
+			 * unrelated keys never share a lock and releasing a key only
+			 * wakes the waiters of its stripe. The lock is reentrant for
+			 * the thread holding it.
+			 *
+			 * During a group commit keys are not released when the command
+			 * is done but held until the group is committed, the table then
+			 * refers to the thread's own copy of the key. A thread never
+			 * waits for a key while holding such keys, it commits its group
+			 * first.
+			 */
+			struct KeyLocker
+			{
+					struct LockedKey
+					{
+							pthread_t owner;
+							uint32 depth;
+							bool held;
+							LockedKey() :
+									depth(0), held(false)
+							{
+							}
+					};
+					struct HeldKey
+					{
+							DBID db;
+							std::string key;
+							HeldKey(const DBID& id, const Slice& k) :
+									db(id), key(k.data(), k.size())
+							{
+							}
+					};
+					typedef std::list<HeldKey> HeldKeyList;
+					struct GroupLocks
+					{
+							bool grouping;
+							bool failed;
+							HeldKeyList keys;
+							GroupLocks() :
+									grouping(false), failed(false)
+							{
+							}
+					};
+					typedef btree::btree_map<DBItemKey, LockedKey> LockedKeyTable;
+					struct Stripe
+					{
+							SpinMutexLock keys_lock;
+							LockedKeyTable locked_keys;
+							ThreadMutexLock waitq;
+							volatile uint32 waiters;
+							Stripe() :
+									waiters(0)
+							{
+							}
+					};
+					static const uint32 kStripeCount = 256;
+					Stripe m_stripes[kStripeCount];
+					volatile uint64 m_lock_count;
+					volatile uint64 m_contended_count;
+					volatile uint64 m_wakeup_count;
+					ThreadLocal<GroupLocks> m_group_local;
+					Ardb* adb;
+					bool enable;
+					KeyLocker() :
+							m_lock_count(0), m_contended_count(0), m_wakeup_count(
+							        0), adb(NULL), enable(true)
+					{
+					}
+					void NotifyWaiters(Stripe& stripe);
+					void ReleaseHeldKeys(GroupLocks& group);
+					bool TryAddLockKey(Stripe& stripe, const DBID& db,
+					        const Slice& key);
+					void AddLockKey(const DBID& db, const Slice& key);
+					void ClearLockKey(const DBID& db, const Slice& key);
+			};
+
+			struct KeyLockerGuard
+			{
+					KeyLocker& locker;
+					DBID db;
+					Slice key;
+					KeyLockerGuard(KeyLocker& loc, const DBID& id,
+					        const Slice& k) :
+							locker(loc), db(id), key(k)
+					{
+						locker.AddLockKey(db, key);
+					}
+					~KeyLockerGuard()
+					{
+						locker.ClearLockKey(db, key);
+					}
+			};
+			KeyLocker m_key_locker;
+			int FlushGroupCommit();
+		public:
+			Ardb(KeyValueEngineFactory* factory, bool multi_thread = true);
+			~Ardb();
+
+			bool Init();
+			int RebuildKeyDirectory();
+			int UpgradeData(int64 version);
+
+			int RawSet(const Slice& key, const Slice& value);
+			int RawDel(const Slice& key);
+			int RawGet(const Slice& key, std::string* value);
+			/*
+			 * Key-Value operations
+			 */
+			int Set(const DBID& db, const Slice& key, const Slice& value);
+			int Set(const DBID& db, const Slice& key, const Slice& value,
+			        int ex, int px, int nxx);
+			int MSet(const DBID& db, SliceArray& keys, SliceArray& values);
+			int MSetNX(const DBID& db, SliceArray& keys, SliceArray& value);
+			int SetNX(const DBID& db, const Slice& key, const Slice& value);
+			int SetEx(const DBID& db, const Slice& key, const Slice& value,
+			        uint32_t secs);
+			int PSetEx(const DBID& db, const Slice& key, const Slice& value,
+			        uint32_t ms);
+			int Get(const DBID& db, const Slice& key, std::string* value);
+			int MGet(const DBID& db, SliceArray& keys, ValueArray& values);
+			int Del(const DBID& db, const Slice& key);
+			int Del(const DBID& db, const SliceArray& keys);
+			bool Exists(const DBID& db, const Slice& key);
+			int Expire(const DBID& db, const Slice& key, uint32_t secs);
+			int Expireat(const DBID& db, const Slice& key, uint32_t ts);
+			int64 TTL(const DBID& db, const Slice& key);
+			int64 PTTL(const DBID& db, const Slice& key);
+			int Persist(const DBID& db, const Slice& key);
+			int Pexpire(const DBID& db, const Slice& key, uint32_t ms);
+			int Pexpireat(const DBID& db, const Slice& key, uint64_t ms);
+			int Strlen(const DBID& db, const Slice& key);
+			int Rename(const DBID& db, const Slice& key1, const Slice& key2);
+			int RenameNX(const DBID& db, const Slice& key1, const Slice& key2);
+			int Keys(const DBID& db, const std::string& pattern,
+			        StringSet& ret);
+			int Scan(const DBID& db, const std::string& cursor,
+			        const std::string& pattern, uint32 limit, int type,
+			        StringArray& keys, std::string& newcursor);
+			int Move(DBID srcdb, const Slice& key, DBID dstdb);
+
+			int Append(const DBID& db, const Slice& key, const Slice& value);
+			int Decr(const DBID& db, const Slice& key, int64_t& value);
+			int Decrby(const DBID& db, const Slice& key, int64_t decrement,
+			        int64_t& value);
+			int Incr(const DBID& db, const Slice& key, int64_t& value);
+			int Incrby(const DBID& db, const Slice& key, int64_t increment,
+			        int64_t& value);
+			int IncrbyFloat(const DBID& db, const Slice& key, double increment,
+			        double& value);
+			int GetRange(const DBID& db, const Slice& key, int start, int end,
+			        std::string& valueobj);
+			int SetRange(const DBID& db, const Slice& key, int start,
+			        const Slice& value);
+			int GetSet(const DBID& db, const Slice& key, const Slice& value,
+			        std::string& valueobj);
+			int BitCount(const DBID& db, const Slice& key, int64 start,
+			        int64 end);
+			int GetBit(const DBID& db, const Slice& key, uint64 offset);
+			int SetBit(const DBID& db, const Slice& key, uint64 offset,
+			        uint8 value);
+			int BitOP(const DBID& db, const Slice& op, const Slice& dstkey,
+			        SliceArray& keys);
+			int64 BitOPCount(const DBID& db, const Slice& op, SliceArray& keys);
+			int BitClear(const DBID& db, const Slice& key);
+
+			/*
+			 * Hash operations
+			 */
+			int HSet(const DBID& db, const Slice& key, const Slice& field,
+			        const Slice& value);
+			int HSetNX(const DBID& db, const Slice& key, const Slice& field,
+			        const Slice& value);
+			int HDel(const DBID& db, const Slice& key, const Slice& field);
+			int HDel(const DBID& db, const Slice& key,
+			        const SliceArray& fields);
+			bool HExists(const DBID& db, const Slice& key, const Slice& field);
+			int HGet(const DBID& db, const Slice& key, const Slice& field,
+			        std::string* value);
+			int HIncrby(const DBID& db, const Slice& key, const Slice& field,
+			        int64_t increment, int64_t& value);
+			int HMIncrby(const DBID& db, const Slice& key,
+			        const SliceArray& fields, const Int64Array& increments,
+			        Int64Array& vs);
+			int HIncrbyFloat(const DBID& db, const Slice& key,
+			        const Slice& field, double increment, double& value);
+			int HMGet(const DBID& db, const Slice& key,
+			        const SliceArray& fields, ValueArray& values);
+			int HMSet(const DBID& db, const Slice& key,
+			        const SliceArray& fields, const SliceArray& values);
+			int HGetAll(const DBID& db, const Slice& key, StringArray& fields,
+			        ValueArray& values);
+			int HKeys(const DBID& db, const Slice& key, StringArray& fields);
+			int HVals(const DBID& db, const Slice& key, StringArray& values);
+			int HLen(const DBID& db, const Slice& key);
+			int HClear(const DBID& db, const Slice& key);
+			int HScan(const DBID& db, const Slice& key,
+			        const std::string& cursor, const std::string& pattern,
+			        uint32 limit, ValueArray& vs, std::string& newcursor);
+
+			/*
+			 * List operations
+			 */
+			int LPush(const DBID& db, const Slice& key, const Slice& value);
+			int LPushx(const DBID& db, const Slice& key, const Slice& value);
+			int RPush(const DBID& db, const Slice& key, const Slice& value);
+			int RPushx(const DBID& db, const Slice& key, const Slice& value);
+			int LPop(const DBID& db, const Slice& key, std::string& v);
+			int RPop(const DBID& db, const Slice& key, std::string& v);
+			int LIndex(const DBID& db, const Slice& key, int index,
+			        std::string& v);
+			int LInsert(const DBID& db, const Slice& key, const Slice& op,
+			        const Slice& pivot, const Slice& value);
+			int LRange(const DBID& db, const Slice& key, int start, int end,
+			        ValueArray& values);
+			int LRem(const DBID& db, const Slice& key, int count,
+			        const Slice& value);
+			int LSet(const DBID& db, const Slice& key, int index,
+			        const Slice& value);
+			int LTrim(const DBID& db, const Slice& key, int start, int stop);
+			int RPopLPush(const DBID& db, const Slice& key1, const Slice& key2,
+			        std::string& v);
+			int LClear(const DBID& db, const Slice& key);
+			int LLen(const DBID& db, const Slice& key);
+
+			/*
+			 * Sorted Set operations
+			 */
+			int ZAdd(const DBID& db, const Slice& key, double score,
+			        const Slice& value);
+			int ZAdd(const DBID& db, const Slice& key, DoubleArray& scores,
+			        const SliceArray& svs);
+			int ZAddLimit(const DBID& db, const Slice& key, DoubleArray& scores,
+			        const SliceArray& svs, int setlimit, ValueArray& pops);
+			int ZCard(const DBID& db, const Slice& key);
+			int ZScore(const DBID& db, const Slice& key, const Slice& value,
+			        double& score);
+			int ZRem(const DBID& db, const Slice& key, const Slice& value);
+			int ZPop(const DBID& db, const Slice& key, bool reverse, uint32 num,
+			        ValueArray& pops);
+			int ZCount(const DBID& db, const Slice& key, const std::string& min,
+			        const std::string& max);
+			int ZIncrby(const DBID& db, const Slice& key, double increment,
+			        const Slice& value, double& score);
+			int ZRank(const DBID& db, const Slice& key, const Slice& member);
+			int ZRevRank(const DBID& db, const Slice& key, const Slice& member);
+			int ZRemRangeByRank(const DBID& db, const Slice& key, int start,
+			        int stop);
+			int ZRemRangeByScore(const DBID& db, const Slice& key,
+			        const std::string& min, const std::string& max);
+			int ZRange(const DBID& db, const Slice& key, int start, int stop,
+			        ValueArray& values, QueryOptions& options);
+			int ZRangeByScore(const DBID& db, const Slice& key,
+			        const std::string& min, const std::string& max,
+			        ValueArray& values, QueryOptions& options);
+			int ZRevRange(const DBID& db, const Slice& key, int start, int stop,
+			        ValueArray& values, QueryOptions& options);
+			int ZRevRangeByScore(const DBID& db, const Slice& key,
+			        const std::string& max, const std::string& min,
+			        ValueArray& values, QueryOptions& options);
+			int ZUnionStore(const DBID& db, const Slice& dst, SliceArray& keys,
+			        WeightArray& weights, AggregateType type = AGGREGATE_SUM);
+			int ZInterStore(const DBID& db, const Slice& dst, SliceArray& keys,
+			        WeightArray& weights, AggregateType type = AGGREGATE_SUM);
+			int ZClear(const DBID& db, const Slice& key);
+			int ZScan(const DBID& db, const Slice& key,
+			        const std::string& cursor, const std::string& pattern,
+			        uint32 limit, ValueArray& vs, std::string& newcursor);
+
+			/*
+			 * Set operations
+			 */
+			int SAdd(const DBID& db, const Slice& key, const Slice& value);
+			int SAdd(const DBID& db, const Slice& key,
+			        const SliceArray& values);
+			int SCard(const DBID& db, const Slice& key);
+			int SMembers(const DBID& db, const Slice& key, ValueArray& values);
+			int SScan(const DBID& db, const Slice& key,
+			        const std::string& cursor, const std::string& pattern,
+			        uint32 limit, ValueArray& vs, std::string& newcursor);
+			int SDiff(const DBID& db, SliceArray& keys, ValueSet& values);
+			int SDiffCount(const DBID& db, SliceArray& keys, uint32& count);
+			int SDiffStore(const DBID& db, const Slice& dst, SliceArray& keys);
+			int SInter(const DBID& db, SliceArray& keys, ValueSet& values);
+			int SInterCount(const DBID& db, SliceArray& keys, uint32& count);
+			int SInterStore(const DBID& db, const Slice& dst, SliceArray& keys);
+			bool SIsMember(const DBID& db, const Slice& key,
+			        const Slice& value);
+			int SRem(const DBID& db, const Slice& key, const Slice& value);
+			int SRem(const DBID& db, const Slice& key,
+			        const SliceArray& values);
+			int SMove(const DBID& db, const Slice& src, const Slice& dst,
+			        const Slice& value);
+			int SPop(const DBID& db, const Slice& key, std::string& value);
+			int SRandMember(const DBID& db, const Slice& key,
+			        ValueArray& values, int count = 1);
+			int SUnionCount(const DBID& db, SliceArray& keys, uint32& count);
+			int SUnion(const DBID& db, SliceArray& keys, ValueSet& values);
+			int SUnionStore(const DBID& db, const Slice& dst, SliceArray& keys);
+			int SClear(const DBID& db, const Slice& key);
+
+			/*
+			 * Table operations
+			 */
+			int TCreate(const DBID& db, const Slice& tableName,
+			        SliceArray& keys);
+			int TGet(const DBID& db, const Slice& tableName,
+			        TableQueryOptions& options, ValueArray& values,
+			        std::string& err);
+			int TGetAll(const DBID& db, const Slice& tableName,
+			        ValueArray& values);
+			int TUpdate(const DBID& db, const Slice& tableName,
+			        TableUpdateOptions& options);
+			int TInsert(const DBID& db, const Slice& tableName,
+			        TableInsertOptions& options, bool replace,
+			        std::string& err);
+			int TDel(const DBID& db, const Slice& tableName,
+			        TableDeleteOptions& conds, std::string& err);
+			int TDelCol(const DBID& db, const Slice& tableName,
+			        const Slice& col);
+			int TCreateIndex(const DBID& db, const Slice& tableName,
+			        const Slice& col);
+			int TCreateIndex(const DBID& db, const Slice& tableName,
+			        SliceArray& cols, SliceArray& covered);
+			int TClear(const DBID& db, const Slice& tableName);
+			int TCount(const DBID& db, const Slice& tableName);
+			int TDesc(const DBID& db, const Slice& tableName, std::string& str);
+
+			int Type(const DBID& db, const Slice& key);
+			int Sort(const DBID& db, const Slice& key, const StringArray& args,
+			        ValueArray& values);
+			int FlushDB(const DBID& db);
+			int FlushAll();
+			int CompactDB(const DBID& db);
+			int CompactAll();
+
+			void PrintDB(const DBID& db);
+			void VisitDB(const DBID& db, RawValueVisitor* visitor, Iterator* iter = NULL);
+			void VisitAllDB(RawValueVisitor* visitor, Iterator* iter = NULL);
+			Iterator* NewIterator();
+			Iterator* NewIterator(const DBID& db);
+
+			KeyValueEngine* GetEngine();
+			const std::string KeyLockStats();
+			/*
+			 * Run the writes of all commands the calling thread executes
+			 * until EndGroupCommit in one engine batch. Returns false if the
+			 * engine can not do it, the commands then commit one by one.
+			 */
+			bool BeginGroupCommit();
+			int EndGroupCommit();
+			/*
+			 * Commit the open group before a command that needs to see the
+			 * store as a whole.
+			 */
+			int SyncGroupCommit();
+			/*
+			 * Delete at most 'limit' keys whose expire time has passed,
+			 * return the number of deleted keys.
+			 */
+			int CheckExpiredKeys(uint32 limit);
+			const std::string ExpireStats();
+			void RegisterKeyWatcher(KeyWatcher* w)
+			{
+				m_key_watcher = w;
+			}
+			void RegisterRawKeyListener(RawKeyListener* w);
+	};
+}
+
+#endif /* RRDB_HPP_ */
@@ -1,585 +1,999 @@
- /*
- *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
- *All rights reserved.
- * 
- *Redistribution and use in source and binary forms, with or without
- *modification, are permitted provided that the following conditions are met:
- * 
- *  * Redistributions of source code must retain the above copyright notice,
- *    this list of conditions and the following disclaimer.
- *  * Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- *  * Neither the name of Redis nor the names of its contributors may be used
- *    to endorse or promote products derived from this software without
- *    specific prior written permission.
- * 
- *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
- *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
- *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
- *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
- *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
- *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
- *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
- *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
- *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
- *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
- *THE POSSIBILITY OF SUCH DAMAGE.
- */
-
-#include "ardb_data.hpp"
-#include "util/helpers.hpp"
-
-namespace ardb
-{
-	int compare_values(const ValueArray& a, const ValueArray& b)
-	{
-		uint32 minsize = a.size() > b.size() ? b.size() : a.size();
-		for (uint32 i = 0; i < minsize; i++)
-		{
-			int cmp = a[i].Compare(b[i]);
-			if (cmp != 0)
-			{
-				return cmp > 0 ? 1 : -1;
-			}
-		}
-		return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
-	}
-
-
-	Condition::Condition(const std::string& name, CompareOperator compareop,
-	        const Slice& value, LogicalOperator logic) :
-			keyname(name), cmp(compareop), logicop(logic)
-	{
-		smart_fill_value(value, keyvalue);
-	}
-
-	TableIndexKeyObject::TableIndexKeyObject(const Slice& tablename,
-	        const Slice& keyname, const Slice& v, DBID id) :
-			KeyObject(tablename, TABLE_INDEX, id), colname(keyname)
-	{
-		smart_fill_value(v, colvalue);
-	}
-
-	SetKeyObject::SetKeyObject(const Slice& k, const ValueObject& v, DBID id) :
-			KeyObject(k, SET_ELEMENT, id), value(v)
-	{
-
-	}
-	SetKeyObject::SetKeyObject(const Slice& k, const Slice& v, DBID id) :
-			KeyObject(k, SET_ELEMENT, id)
-	{
-		smart_fill_value(v, value);
-	}
-
-	ZSetKeyObject::ZSetKeyObject(const Slice& k, const ValueObject& v, double s,
-	        DBID id) :
-			KeyObject(k, ZSET_ELEMENT, id), value(v), score(s)
-	{
-
-	}
-
-	ZSetKeyObject::ZSetKeyObject(const Slice& k, const Slice& v, double s,
-	        DBID id) :
-			KeyObject(k, ZSET_ELEMENT, id), score(s)
-	{
-		smart_fill_value(v, value);
-	}
-
-	ZSetScoreKeyObject::ZSetScoreKeyObject(const Slice& k, const ValueObject& v,
-	        DBID id) :
-			KeyObject(k, ZSET_ELEMENT_SCORE, id), value(v)
-	{
-
-	}
-
-	ZSetScoreKeyObject::ZSetScoreKeyObject(const Slice& k, const Slice& v,
-	        DBID id) :
-			KeyObject(k, ZSET_ELEMENT_SCORE, id)
-	{
-		smart_fill_value(v, value);
-	}
-
-	void encode_key(Buffer& buf, const KeyObject& key)
-	{
-		uint32 header = (uint32) (key.db << 8) + key.type;
-		BufferHelper::WriteFixUInt32(buf, header);
-		BufferHelper::WriteVarSlice(buf, key.key);
-		switch (key.type)
-		{
-			case HASH_FIELD:
-			{
-				const HashKeyObject& hk = (const HashKeyObject&) key;
-				BufferHelper::WriteVarSlice(buf, hk.field);
-				break;
-			}
-			case LIST_ELEMENT:
-			{
-				const ListKeyObject& lk = (const ListKeyObject&) key;
-				BufferHelper::WriteFixFloat(buf, lk.score);
-				break;
-			}
-			case SET_ELEMENT:
-			{
-				const SetKeyObject& sk = (const SetKeyObject&) key;
-				encode_value(buf, sk.value);
-				break;
-			}
-			case ZSET_ELEMENT:
-			{
-				const ZSetKeyObject& sk = (const ZSetKeyObject&) key;
-				BufferHelper::WriteFixDouble(buf, sk.score);
-				encode_value(buf, sk.value);
-				break;
-			}
-			case ZSET_ELEMENT_SCORE:
-			{
-				const ZSetScoreKeyObject& zk = (const ZSetScoreKeyObject&) key;
-				encode_value(buf, zk.value);
-				break;
-			}
-			case TABLE_INDEX:
-			{
-				const TableIndexKeyObject& index =
-				        (const TableIndexKeyObject&) key;
-				BufferHelper::WriteVarSlice(buf, index.colname);
-				encode_value(buf, index.colvalue);
-				BufferHelper::WriteVarUInt32(buf, index.index.size());
-				ValueArray::const_iterator it = index.index.begin();
-				while (it != index.index.end())
-				{
-					encode_value(buf, *it);
-					it++;
-				}
-				break;
-			}
-			case TABLE_COL:
-			{
-				const TableColKeyObject& col = (const TableColKeyObject&) key;
-				BufferHelper::WriteVarSlice(buf, col.colname);
-				BufferHelper::WriteVarUInt32(buf, col.index.size());
-				ValueArray::const_iterator it = col.index.begin();
-				while (it != col.index.end())
-				{
-					encode_value(buf, *it);
-					it++;
-				}
-				break;
-			}
-			case BITSET_ELEMENT:
-			{
-				const BitSetKeyObject& bk = (const BitSetKeyObject&) key;
-				BufferHelper::WriteVarUInt64(buf, bk.index);
-				break;
-			}
-			case LIST_META:
-			case ZSET_META:
-			case SET_META:
-			case TABLE_META:
-			case TABLE_SCHEMA:
-			case BITSET_META:
-			default:
-			{
-				break;
-			}
-		}
-	}
-
-	bool peek_dbkey_header(const Slice& key, DBID& db, KeyType& type)
-	{
-		Buffer buf(const_cast<char*>(key.data()), 0, key.size());
-		uint32 header;
-		if (!BufferHelper::ReadFixUInt32(buf, header))
-		{
-			return false;
-		}
-		type = (KeyType) (header & 0xFF);
-		db = header >> 8;
-		return true;
-	}
-
-	KeyObject* decode_key(const Slice& key, KeyObject* expected)
-	{
-		Buffer buf(const_cast<char*>(key.data()), 0, key.size());
-		uint32 header;
-		if (!BufferHelper::ReadFixUInt32(buf, header))
-		{
-			return NULL;
-		}
-		uint8 type = header & 0xFF;
-		uint32 db = header >> 8;
-		if (NULL != expected)
-		{
-			if (type != expected->type || db != expected->db)
-			{
-				return NULL;
-			}
-		}
-		Slice keystr;
-		if (!BufferHelper::ReadVarSlice(buf, keystr))
-		{
-			return NULL;
-		}
-		if (NULL != expected)
-		{
-			if (keystr != expected->key)
-			{
-				return NULL;
-			}
-		}
-		switch (type)
-		{
-			case HASH_FIELD:
-			{
-				Slice field;
-				if (!BufferHelper::ReadVarSlice(buf, field))
-				{
-					return NULL;
-				}
-				return new HashKeyObject(keystr, field, db);
-			}
-			case LIST_ELEMENT:
-			{
-				float score;
-				if (!BufferHelper::ReadFixFloat(buf, score))
-				{
-					return NULL;
-				}
-				return new ListKeyObject(keystr, score, db);
-			}
-
-			case SET_ELEMENT:
-			{
-				SetKeyObject* sk = new SetKeyObject(keystr, Slice(), db);
-				if (!decode_value(buf, sk->value, false))
-				{
-					DELETE(sk);
-					return sk;
-				}
-				return sk;
-			}
-			case ZSET_ELEMENT:
-			{
-				ZSetKeyObject* zsk = new ZSetKeyObject(keystr, Slice(), 0, db);
-				double score;
-				if (!BufferHelper::ReadFixDouble(buf, score)
-				        || !decode_value(buf, zsk->value))
-				{
-					DELETE(zsk);
-					return NULL;
-				}
-				zsk->score = score;
-				return zsk;
-			}
-			case ZSET_ELEMENT_SCORE:
-			{
-				ZSetScoreKeyObject* zsk = new ZSetScoreKeyObject(keystr,
-				        Slice(), db);
-				if (!decode_value(buf, zsk->value))
-				{
-					DELETE(zsk);
-					return NULL;
-				}
-				return zsk;
-			}
-			case TABLE_INDEX:
-			{
-				Slice kname;
-				if (!BufferHelper::ReadVarSlice(buf, kname))
-				{
-					return NULL;
-				}
-				TableIndexKeyObject* ik = new TableIndexKeyObject(keystr, kname,
-				        ValueObject(), db);
-				if (!decode_value(buf, ik->colvalue))
-				{
-					DELETE(ik);
-					return NULL;
-				}
-				uint32 len;
-				if (!BufferHelper::ReadVarUInt32(buf, len))
-				{
-					DELETE(ik);
-					return NULL;
-				}
-				for (uint32 i = 0; i < len; i++)
-				{
-					ValueObject v;
-					if (!decode_value(buf, v))
-					{
-						DELETE(ik);
-						return NULL;
-					}
-					ik->index.push_back(v);
-				}
-				return ik;
-			}
-			case TABLE_COL:
-			{
-				TableColKeyObject* tk = new TableColKeyObject(keystr, Slice(),
-				        db);
-				Slice col;
-				if (!BufferHelper::ReadVarSlice(buf, col))
-				{
-					DELETE(tk);
-					return NULL;
-				}
-				tk->colname = col;
-				uint32 len;
-				if (!BufferHelper::ReadVarUInt32(buf, len))
-				{
-					DELETE(tk);
-					return NULL;
-				}
-				for (uint32 i = 0; i < len; i++)
-				{
-					ValueObject v;
-					if (!decode_value(buf, v))
-					{
-						DELETE(tk);
-						return NULL;
-					}
-					tk->index.push_back(v);
-				}
-				return tk;
-			}
-			case BITSET_ELEMENT:
-			{
-				uint64 index;
-				if (!BufferHelper::ReadVarUInt64(buf, index))
-				{
-					return NULL;
-				}
-				return new BitSetKeyObject(keystr, index, db);
-			}
-			case SET_META:
-			case ZSET_META:
-			case LIST_META:
-			case TABLE_META:
-			case TABLE_SCHEMA:
-			case BITSET_META:
-			case KV:
-			default:
-			{
-				return new KeyObject(keystr, (KeyType) type, db);
-			}
-		}
-	}
-
-	int value_convert_to_raw(ValueObject& v)
-	{
-		if (v.type == EMPTY)
-		{
-			return -1;
-		}
-		if (v.type != RAW)
-		{
-			int64_t iv = v.v.int_v;
-			double dv = v.v.double_v;
-			v.type = RAW;
-			v.v.raw = new Buffer(16);
-			if (v.type == INTEGER)
-			{
-				v.v.raw->Printf("%lld", iv);
-			}
-			else if (v.type == DOUBLE)
-			{
-				double min = -4503599627370495LL; /* (2^52)-1 */
-				double max = 4503599627370496LL; /* -(2^52) */
-				iv = (int64_t) dv;
-				if (dv > min && dv < max && dv == ((double) iv))
-				{
-					v.v.raw->Printf("%lld", iv);
-				}
-				else
-				{
-					v.v.raw->Printf("%.17g", dv);
-				}
-			}
-			return 0;
-		}
-		return -1;
-	}
-
-	int value_convert_to_number(ValueObject& v)
-	{
-		if (v.type == EMPTY)
-		{
-			return -1;
-		}
-		if (v.type != RAW)
-		{
-			return 0;
-		}
-		int64_t intv;
-		double dv;
-		if (raw_toint64(v.v.raw->GetRawReadBuffer(), v.v.raw->ReadableBytes(),
-		        intv))
-		{
-			v.Clear();
-			v.type = INTEGER;
-			v.v.int_v = intv;
-			return 1;
-		}
-		else if (raw_todouble(v.v.raw->GetRawReadBuffer(),
-		        v.v.raw->ReadableBytes(), dv))
-		{
-			v.Clear();
-			v.type = DOUBLE;
-			v.v.double_v = dv;
-			return 1;
-		}
-		return -1;
-	}
-
-	void encode_value(Buffer& buf, const ValueObject& value)
-	{
-		BufferHelper::WriteFixUInt8(buf, value.type);
-		switch (value.type)
-		{
-			case EMPTY:
-			{
-				break;
-			}
-			case INTEGER:
-			{
-				BufferHelper::WriteVarInt64(buf, value.v.int_v);
-				break;
-			}
-			case DOUBLE:
-			{
-				BufferHelper::WriteFixDouble(buf, value.v.double_v);
-				break;
-			}
-			default:
-			{
-				if (NULL != value.v.raw)
-				{
-					BufferHelper::WriteVarUInt32(buf,
-					        value.v.raw->ReadableBytes());
-					buf.Write(value.v.raw->GetRawReadBuffer(),
-					        value.v.raw->ReadableBytes());
-				}
-				else
-				{
-					BufferHelper::WriteVarInt64(buf, 0);
-				}
-				break;
-			}
-		}
-	}
-
-	bool decode_value(Buffer& buf, ValueObject& value, bool copyRawValue)
-	{
-		value.Clear();
-		if (!BufferHelper::ReadFixUInt8(buf, value.type))
-		{
-			return false;
-		}
-		switch (value.type)
-		{
-			case EMPTY:
-			{
-				break;
-			}
-			case INTEGER:
-			{
-				if (!BufferHelper::ReadVarInt64(buf, value.v.int_v))
-				{
-					return false;
-				}
-				break;
-			}
-			case DOUBLE:
-			{
-				if (!BufferHelper::ReadFixDouble(buf, value.v.double_v))
-				{
-					return false;
-				}
-				break;
-			}
-			default:
-			{
-				uint32_t len;
-				if (!BufferHelper::ReadVarUInt32(buf, len)
-				        || buf.ReadableBytes() < len)
-				{
-					return false;
-				}
-
-				if (copyRawValue)
-				{
-					value.v.raw = new Buffer(len);
-					buf.Read(value.v.raw, len);
-				}
-				else
-				{
-					const char* tmp = buf.GetRawReadBuffer();
-					value.v.raw = new Buffer(const_cast<char*>(tmp), 0, len);
-					buf.SkipBytes(len);
-				}
-				break;
-			}
-		}
-		return true;
-	}
-	void smart_fill_value(const Slice& value, ValueObject& valueobject)
-	{
-		if (value.empty())
-		{
-			valueobject.type = EMPTY;
-			return;
-		}
-		int64_t intv;
-		double doublev;
-		char first_char = value.data()[0];
-		if (first_char != '+' && value.data()[0] != '-'
-		        && (first_char < '0' || first_char > '9'))
-		{
-			valueobject.type = RAW;
-			char* v = const_cast<char*>(value.data());
-			valueobject.v.raw = new Buffer(v, 0, value.size());
-		}
-		else
-		{
-			if (raw_toint64(value.data(), value.size(), intv))
-			{
-				valueobject.type = INTEGER;
-				valueobject.v.int_v = intv;
-			}
-			else if (raw_todouble(value.data(), value.size(), doublev))
-			{
-				valueobject.type = DOUBLE;
-				valueobject.v.double_v = doublev;
-			}
-			else
-			{
-				valueobject.type = RAW;
-				char* v = const_cast<char*>(value.data());
-				valueobject.v.raw = new Buffer(v, 0, value.size());
-			}
-		}
-
-	}
-	void fill_raw_value(const Slice& value, ValueObject& valueobject)
-	{
-		valueobject.type = RAW;
-		char* v = const_cast<char*>(value.data());
-		valueobject.v.raw = new Buffer(v, 0, value.size());
-	}
-
-	void next_key(const Slice& key, std::string& next)
-	{
-		next.assign(key.data(), key.size());
-		for (uint32 i = next.size(); i > 0; i--)
-		{
-			if (next[i - 1] < 0x7F)
-			{
-				next[i - 1] = next[i - 1] + 1;
-				return;
-			}
-		}
-		next.append("\0", 1);
-	}
-}
-
+ /*
+ *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
+ *All rights reserved.
+ * 
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ * 
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Redis nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ * 
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+ *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ *THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ardb_data.hpp"
+#include "util/helpers.hpp"
+
+namespace ardb
+{
+	int compare_values(const ValueArray& a, const ValueArray& b)
+	{
+		uint32 minsize = a.size() > b.size() ? b.size() : a.size();
+		for (uint32 i = 0; i < minsize; i++)
+		{
+			int cmp = a[i].Compare(b[i]);
+			if (cmp != 0)
+			{
+				return cmp > 0 ? 1 : -1;
+			}
+		}
+		return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+	}
+
+
+	Condition::Condition(const std::string& name, CompareOperator compareop,
+	        const Slice& value, LogicalOperator logic) :
+			keyname(name), cmp(compareop), logicop(logic)
+	{
+		smart_fill_value(value, keyvalue);
+	}
+
+	TableIndexKeyObject::TableIndexKeyObject(const Slice& tablename,
+	        const Slice& keyname, const Slice& v, DBID id) :
+			KeyObject(tablename, TABLE_INDEX, id), colname(keyname)
+	{
+		smart_fill_value(v, colvalue);
+	}
+
+	SetKeyObject::SetKeyObject(const Slice& k, const ValueObject& v, DBID id) :
+			KeyObject(k, SET_ELEMENT, id), value(v)
+	{
+
+	}
+	SetKeyObject::SetKeyObject(const Slice& k, const Slice& v, DBID id) :
+			KeyObject(k, SET_ELEMENT, id)
+	{
+		smart_fill_value(v, value);
+	}
+
+	ZSetKeyObject::ZSetKeyObject(const Slice& k, const ValueObject& v, double s,
+	        DBID id) :
+			KeyObject(k, ZSET_ELEMENT, id), value(v), score(s)
+	{
+
+	}
+
+	ZSetKeyObject::ZSetKeyObject(const Slice& k, const Slice& v, double s,
+	        DBID id) :
+			KeyObject(k, ZSET_ELEMENT, id), score(s)
+	{
+		smart_fill_value(v, value);
+	}
+
+	ZSetRankKeyObject::ZSetRankKeyObject(const Slice& k, KeyType t, uint32 l,
+	        const Slice& p, DBID id) :
+			KeyObject(k, t, id), level(l), pos(p)
+	{
+	}
+
+	ZSetScoreKeyObject::ZSetScoreKeyObject(const Slice& k, const ValueObject& v,
+	        DBID id) :
+			KeyObject(k, ZSET_ELEMENT_SCORE, id), value(v)
+	{
+
+	}
+
+	ZSetScoreKeyObject::ZSetScoreKeyObject(const Slice& k, const Slice& v,
+	        DBID id) :
+			KeyObject(k, ZSET_ELEMENT_SCORE, id)
+	{
+		smart_fill_value(v, value);
+	}
+
+	/*
+	 * Values embedded in keys are written as a type tag followed by an order
+	 * preserving payload. A RAW value at the tail of the key is written as is,
+	 * anywhere else it is escaped so that following fields stay comparable.
+	 */
+	static void encode_key_value(Buffer& buf, const ValueObject& value,
+	        bool tail)
+	{
+		BufferHelper::WriteFixUInt8(buf, value.type);
+		switch (value.type)
+		{
+			case EMPTY:
+			{
+				break;
+			}
+			case INTEGER:
+			{
+				BufferHelper::WriteOrderedInt64(buf, value.v.int_v);
+				break;
+			}
+			case DOUBLE:
+			{
+				BufferHelper::WriteOrderedDouble(buf, value.v.double_v);
+				break;
+			}
+			default:
+			{
+				Slice raw;
+				if (NULL != value.v.raw)
+				{
+					raw = Slice(value.v.raw->GetRawReadBuffer(),
+					        value.v.raw->ReadableBytes());
+				}
+				if (tail)
+				{
+					buf.Write(raw.data(), raw.size());
+				}
+				else
+				{
+					BufferHelper::WriteEscapedSlice(buf, raw);
+				}
+				break;
+			}
+		}
+	}
+
+	static bool decode_key_value(Buffer& buf, ValueObject& value, bool tail,
+	        bool copyRawValue = true)
+	{
+		value.Clear();
+		if (!BufferHelper::ReadFixUInt8(buf, value.type))
+		{
+			return false;
+		}
+		switch (value.type)
+		{
+			case EMPTY:
+			{
+				return true;
+			}
+			case INTEGER:
+			{
+				return BufferHelper::ReadOrderedInt64(buf, value.v.int_v);
+			}
+			case DOUBLE:
+			{
+				return BufferHelper::ReadOrderedDouble(buf, value.v.double_v);
+			}
+			default:
+			{
+				Slice raw;
+				std::string unescaped;
+				if (tail)
+				{
+					raw = Slice(buf.GetRawReadBuffer(), buf.ReadableBytes());
+					buf.SkipBytes(raw.size());
+				}
+				else if (!BufferHelper::ReadEscapedSlice(buf, raw, unescaped))
+				{
+					value.type = EMPTY;
+					return false;
+				}
+				if (copyRawValue || raw.data() == unescaped.data())
+				{
+					value.v.raw = new Buffer(raw.size());
+					value.v.raw->Write(raw.data(), raw.size());
+				}
+				else
+				{
+					value.v.raw = new Buffer(const_cast<char*>(raw.data()), 0,
+					        raw.size());
+				}
+				return true;
+			}
+		}
+	}
+
+	static void encode_key_values(Buffer& buf, const ValueArray& values)
+	{
+		BufferHelper::WriteOrderedUInt32(buf, values.size());
+		ValueArray::const_iterator it = values.begin();
+		while (it != values.end())
+		{
+			encode_key_value(buf, *it, false);
+			it++;
+		}
+	}
+
+	static bool decode_key_values(Buffer& buf, ValueArray& values)
+	{
+		uint32 len;
+		if (!BufferHelper::ReadOrderedUInt32(buf, len))
+		{
+			return false;
+		}
+		for (uint32 i = 0; i < len; i++)
+		{
+			ValueObject v;
+			if (!decode_key_value(buf, v, false))
+			{
+				return false;
+			}
+			values.push_back(v);
+		}
+		return true;
+	}
+
+	/*
+	 * Every key field is written with an order preserving encoding, so the
+	 * plain byte order of encoded keys is the logical key order and
+	 * ardb_compare_keys is a memcmp.
+	 */
+	void encode_key(Buffer& buf, const KeyObject& key)
+	{
+		if (key.type == KEY_EXPIRATION_ELEMENT)
+		{
+			uint32 header = (uint32) (key.db << 8) + key.type;
+			BufferHelper::WriteFixUInt32(buf, header);
+			const ExpireKeyObject& ek = (const ExpireKeyObject&) key;
+			BufferHelper::WriteOrderedUInt64(buf, ek.expireat);
+			BufferHelper::WriteOrderedUInt32(buf, ek.keydb);
+			BufferHelper::WriteOrderedSlice(buf, key.key);
+			return;
+		}
+		encode_key_prefix(buf, key);
+		switch (key.type)
+		{
+			case HASH_FIELD:
+			{
+				const HashKeyObject& hk = (const HashKeyObject&) key;
+				BufferHelper::WriteOrderedSlice(buf, hk.field);
+				break;
+			}
+			case LIST_ELEMENT:
+			{
+				const ListKeyObject& lk = (const ListKeyObject&) key;
+				BufferHelper::WriteOrderedInt64(buf, lk.index);
+				break;
+			}
+			case SET_ELEMENT:
+			{
+				const SetKeyObject& sk = (const SetKeyObject&) key;
+				encode_key_value(buf, sk.value, true);
+				break;
+			}
+			case ZSET_ELEMENT:
+			{
+				const ZSetKeyObject& sk = (const ZSetKeyObject&) key;
+				BufferHelper::WriteOrderedDouble(buf, sk.score);
+				encode_key_value(buf, sk.value, true);
+				break;
+			}
+			case ZSET_ELEMENT_SCORE:
+			{
+				const ZSetScoreKeyObject& zk = (const ZSetScoreKeyObject&) key;
+				encode_key_value(buf, zk.value, true);
+				break;
+			}
+			case TABLE_INDEX:
+			{
+				const TableIndexKeyObject& index =
+				        (const TableIndexKeyObject&) key;
+				BufferHelper::WriteOrderedSlice(buf, index.colname);
+				encode_key_value(buf, index.colvalue, false);
+				encode_key_values(buf, index.index);
+				break;
+			}
+			case TABLE_COL:
+			{
+				const TableColKeyObject& col = (const TableColKeyObject&) key;
+				BufferHelper::WriteOrderedSlice(buf, col.colname);
+				encode_key_values(buf, col.index);
+				break;
+			}
+			case TABLE_COMPOSITE_INDEX:
+			{
+				const TableCompositeIndexKeyObject& ck =
+				        (const TableCompositeIndexKeyObject&) key;
+				BufferHelper::WriteOrderedSlice(buf, ck.indexname);
+				BufferHelper::WriteOrderedUInt32(buf, ck.width);
+				for (uint32 i = 0; i < ck.colvalues.size(); i++)
+				{
+					encode_key_value(buf, ck.colvalues[i], false);
+				}
+				if (!ck.index.empty())
+				{
+					encode_key_values(buf, ck.index);
+				}
+				break;
+			}
+			case ZSET_RANK_NODE:
+			case ZSET_RANK_COUNT:
+			{
+				const ZSetRankKeyObject& rk = (const ZSetRankKeyObject&) key;
+				BufferHelper::WriteOrderedUInt32(buf, rk.level);
+				BufferHelper::WriteFixUInt8(buf, rk.pos.empty() ? 0 : 1);
+				buf.Write(rk.pos.data(), rk.pos.size());
+				break;
+			}
+			case BITSET_ELEMENT:
+			{
+				const BitSetKeyObject& bk = (const BitSetKeyObject&) key;
+				BufferHelper::WriteOrderedUInt64(buf, bk.index);
+				break;
+			}
+			case LIST_META:
+			case ZSET_META:
+			case SET_META:
+			case HASH_META:
+			case TABLE_META:
+			case TABLE_SCHEMA:
+			case BITSET_META:
+			default:
+			{
+				break;
+			}
+		}
+	}
+
+	/*
+	 * The header and key name every key of the given key's type and name
+	 * starts with, so a memcmp against it tells whether an encoded key
+	 * belongs to the same key.
+	 */
+	void encode_key_prefix(Buffer& buf, const KeyObject& key)
+	{
+		uint32 header = (uint32) (key.db << 8) + key.type;
+		BufferHelper::WriteFixUInt32(buf, header);
+		BufferHelper::WriteOrderedSlice(buf, key.key);
+	}
+
+	bool peek_dbkey_header(const Slice& key, DBID& db, KeyType& type)
+	{
+		Buffer buf(const_cast<char*>(key.data()), 0, key.size());
+		uint32 header;
+		if (!BufferHelper::ReadFixUInt32(buf, header))
+		{
+			return false;
+		}
+		type = (KeyType) (header & 0xFF);
+		db = header >> 8;
+		return true;
+	}
+
+	/*
+	 * Data type kept in the KEY_DIRECTORY record of a non string key each
+	 * time a record of type 'type' is written for it, KEY_END if records of
+	 * that type don't mark the key's existence.
+	 */
+	KeyType directory_key_type(KeyType type)
+	{
+		switch (type)
+		{
+			case SET_META:
+			{
+				return SET_ELEMENT;
+			}
+			case ZSET_META:
+			{
+				return ZSET_ELEMENT_SCORE;
+			}
+			case HASH_META:
+			{
+				return HASH_FIELD;
+			}
+			case LIST_META:
+			case TABLE_META:
+			case BITSET_META:
+			{
+				return type;
+			}
+			default:
+			{
+				return KEY_END;
+			}
+		}
+	}
+
+	KeyObject* decode_key(const Slice& key, KeyObject* expected)
+	{
+		Buffer buf(const_cast<char*>(key.data()), 0, key.size());
+		uint32 header;
+		if (!BufferHelper::ReadFixUInt32(buf, header))
+		{
+			return NULL;
+		}
+		uint8 type = header & 0xFF;
+		uint32 db = header >> 8;
+		if (NULL != expected)
+		{
+			if (type != expected->type || db != expected->db)
+			{
+				return NULL;
+			}
+		}
+		if (type == KEY_EXPIRATION_ELEMENT)
+		{
+			uint64 expireat;
+			uint32 keydb;
+			Slice keystr;
+			if (!BufferHelper::ReadOrderedUInt64(buf, expireat)
+			        || !BufferHelper::ReadOrderedUInt32(buf, keydb)
+			        || !BufferHelper::ReadOrderedSlice(buf, keystr))
+			{
+				return NULL;
+			}
+			return new ExpireKeyObject(keystr, expireat, keydb);
+		}
+		Slice keystr;
+		if (!BufferHelper::ReadOrderedSlice(buf, keystr))
+		{
+			return NULL;
+		}
+		if (NULL != expected)
+		{
+			if (keystr != expected->key)
+			{
+				return NULL;
+			}
+		}
+		switch (type)
+		{
+			case HASH_FIELD:
+			{
+				Slice field;
+				if (!BufferHelper::ReadOrderedSlice(buf, field))
+				{
+					return NULL;
+				}
+				return new HashKeyObject(keystr, field, db);
+			}
+			case LIST_ELEMENT:
+			{
+				int64 index;
+				if (!BufferHelper::ReadOrderedInt64(buf, index))
+				{
+					return NULL;
+				}
+				return new ListKeyObject(keystr, index, db);
+			}
+			case SET_ELEMENT:
+			{
+				SetKeyObject* sk = new SetKeyObject(keystr, Slice(), db);
+				if (!decode_key_value(buf, sk->value, true, false))
+				{
+					DELETE(sk);
+					return NULL;
+				}
+				return sk;
+			}
+			case ZSET_ELEMENT:
+			{
+				ZSetKeyObject* zsk = new ZSetKeyObject(keystr, Slice(), 0, db);
+				double score;
+				if (!BufferHelper::ReadOrderedDouble(buf, score)
+				        || !decode_key_value(buf, zsk->value, true))
+				{
+					DELETE(zsk);
+					return NULL;
+				}
+				zsk->score = score;
+				return zsk;
+			}
+			case ZSET_ELEMENT_SCORE:
+			{
+				ZSetScoreKeyObject* zsk = new ZSetScoreKeyObject(keystr,
+				        Slice(), db);
+				if (!decode_key_value(buf, zsk->value, true))
+				{
+					DELETE(zsk);
+					return NULL;
+				}
+				return zsk;
+			}
+			case TABLE_INDEX:
+			{
+				Slice kname;
+				if (!BufferHelper::ReadOrderedSlice(buf, kname))
+				{
+					return NULL;
+				}
+				TableIndexKeyObject* ik = new TableIndexKeyObject(keystr, kname,
+				        ValueObject(), db);
+				if (!decode_key_value(buf, ik->colvalue, false)
+				        || !decode_key_values(buf, ik->index))
+				{
+					DELETE(ik);
+					return NULL;
+				}
+				return ik;
+			}
+			case TABLE_COL:
+			{
+				Slice col;
+				if (!BufferHelper::ReadOrderedSlice(buf, col))
+				{
+					return NULL;
+				}
+				TableColKeyObject* tk = new TableColKeyObject(keystr, col, db);
+				if (!decode_key_values(buf, tk->index))
+				{
+					DELETE(tk);
+					return NULL;
+				}
+				return tk;
+			}
+			case TABLE_COMPOSITE_INDEX:
+			{
+				Slice name;
+				uint32 width;
+				if (!BufferHelper::ReadOrderedSlice(buf, name)
+				        || !BufferHelper::ReadOrderedUInt32(buf, width))
+				{
+					return NULL;
+				}
+				TableCompositeIndexKeyObject* ck =
+				        new TableCompositeIndexKeyObject(keystr, name, width, db);
+				for (uint32 i = 0; i < width; i++)
+				{
+					ValueObject v;
+					if (!decode_key_value(buf, v, false))
+					{
+						DELETE(ck);
+						return NULL;
+					}
+					ck->colvalues.push_back(v);
+				}
+				if (!decode_key_values(buf, ck->index))
+				{
+					DELETE(ck);
+					return NULL;
+				}
+				return ck;
+			}
+			case BITSET_ELEMENT:
+			{
+				uint64 index;
+				if (!BufferHelper::ReadOrderedUInt64(buf, index))
+				{
+					return NULL;
+				}
+				return new BitSetKeyObject(keystr, index, db);
+			}
+			case ZSET_RANK_NODE:
+			case ZSET_RANK_COUNT:
+			{
+				uint32 level;
+				uint8 boundary;
+				if (!BufferHelper::ReadOrderedUInt32(buf, level)
+				        || !BufferHelper::ReadFixUInt8(buf, boundary))
+				{
+					return NULL;
+				}
+				Slice pos(buf.GetRawReadBuffer(), buf.ReadableBytes());
+				if ((boundary != 0) == pos.empty())
+				{
+					return NULL;
+				}
+				return new ZSetRankKeyObject(keystr, (KeyType) type, level, pos,
+				        db);
+			}
+			case SET_META:
+			case ZSET_META:
+			case HASH_META:
+			case LIST_META:
+			case TABLE_META:
+			case TABLE_SCHEMA:
+			case BITSET_META:
+			case KV:
+			default:
+			{
+				return new KeyObject(keystr, (KeyType) type, db);
+			}
+		}
+	}
+
+	/*
+	 * Decoder for keys written by data format version 1, only used to
+	 * migrate old data.
+	 */
+	KeyObject* decode_legacy_key(const Slice& key, KeyObject* expected)
+	{
+		Buffer buf(const_cast<char*>(key.data()), 0, key.size());
+		uint32 header;
+		if (!BufferHelper::ReadFixUInt32(buf, header))
+		{
+			return NULL;
+		}
+		uint8 type = header & 0xFF;
+		uint32 db = header >> 8;
+		if (NULL != expected)
+		{
+			if (type != expected->type || db != expected->db)
+			{
+				return NULL;
+			}
+		}
+		Slice keystr;
+		if (!BufferHelper::ReadVarSlice(buf, keystr))
+		{
+			return NULL;
+		}
+		if (NULL != expected)
+		{
+			if (keystr != expected->key)
+			{
+				return NULL;
+			}
+		}
+		switch (type)
+		{
+			case HASH_FIELD:
+			{
+				Slice field;
+				if (!BufferHelper::ReadVarSlice(buf, field))
+				{
+					return NULL;
+				}
+				return new HashKeyObject(keystr, field, db);
+			}
+			case LIST_ELEMENT:
+			{
+				float score;
+				if (!BufferHelper::ReadFixFloat(buf, score))
+				{
+					return NULL;
+				}
+				return new LegacyListKeyObject(keystr, score, db);
+			}
+
+			case SET_ELEMENT:
+			{
+				SetKeyObject* sk = new SetKeyObject(keystr, Slice(), db);
+				if (!decode_value(buf, sk->value, false))
+				{
+					DELETE(sk);
+					return sk;
+				}
+				return sk;
+			}
+			case ZSET_ELEMENT:
+			{
+				ZSetKeyObject* zsk = new ZSetKeyObject(keystr, Slice(), 0, db);
+				double score;
+				if (!BufferHelper::ReadFixDouble(buf, score)
+				        || !decode_value(buf, zsk->value))
+				{
+					DELETE(zsk);
+					return NULL;
+				}
+				zsk->score = score;
+				return zsk;
+			}
+			case ZSET_ELEMENT_SCORE:
+			{
+				ZSetScoreKeyObject* zsk = new ZSetScoreKeyObject(keystr,
+				        Slice(), db);
+				if (!decode_value(buf, zsk->value))
+				{
+					DELETE(zsk);
+					return NULL;
+				}
+				return zsk;
+			}
+			case TABLE_INDEX:
+			{
+				Slice kname;
+				if (!BufferHelper::ReadVarSlice(buf, kname))
+				{
+					return NULL;
+				}
+				TableIndexKeyObject* ik = new TableIndexKeyObject(keystr, kname,
+				        ValueObject(), db);
+				if (!decode_value(buf, ik->colvalue))
+				{
+					DELETE(ik);
+					return NULL;
+				}
+				uint32 len;
+				if (!BufferHelper::ReadVarUInt32(buf, len))
+				{
+					DELETE(ik);
+					return NULL;
+				}
+				for (uint32 i = 0; i < len; i++)
+				{
+					ValueObject v;
+					if (!decode_value(buf, v))
+					{
+						DELETE(ik);
+						return NULL;
+					}
+					ik->index.push_back(v);
+				}
+				return ik;
+			}
+			case TABLE_COL:
+			{
+				TableColKeyObject* tk = new TableColKeyObject(keystr, Slice(),
+				        db);
+				Slice col;
+				if (!BufferHelper::ReadVarSlice(buf, col))
+				{
+					DELETE(tk);
+					return NULL;
+				}
+				tk->colname = col;
+				uint32 len;
+				if (!BufferHelper::ReadVarUInt32(buf, len))
+				{
+					DELETE(tk);
+					return NULL;
+				}
+				for (uint32 i = 0; i < len; i++)
+				{
+					ValueObject v;
+					if (!decode_value(buf, v))
+					{
+						DELETE(tk);
+						return NULL;
+					}
+					tk->index.push_back(v);
+				}
+				return tk;
+			}
+			case BITSET_ELEMENT:
+			{
+				uint64 index;
+				if (!BufferHelper::ReadVarUInt64(buf, index))
+				{
+					return NULL;
+				}
+				return new BitSetKeyObject(keystr, index, db);
+			}
+			case SET_META:
+			case ZSET_META:
+			case LIST_META:
+			case TABLE_META:
+			case TABLE_SCHEMA:
+			case BITSET_META:
+			case KV:
+			default:
+			{
+				return new KeyObject(keystr, (KeyType) type, db);
+			}
+		}
+	}
+
+	int value_convert_to_raw(ValueObject& v)
+	{
+		if (v.type == EMPTY)
+		{
+			return -1;
+		}
+		if (v.type != RAW)
+		{
+			int64_t iv = v.v.int_v;
+			double dv = v.v.double_v;
+			uint8_t type = v.type;
+			v.type = RAW;
+			v.v.raw = new Buffer(16);
+			if (type == INTEGER)
+			{
+				v.v.raw->Printf("%lld", iv);
+			}
+			else if (type == DOUBLE)
+			{
+				double min = -4503599627370495LL; /* (2^52)-1 */
+				double max = 4503599627370496LL; /* -(2^52) */
+				iv = (int64_t) dv;
+				if (dv > min && dv < max && dv == ((double) iv))
+				{
+					v.v.raw->Printf("%lld", iv);
+				}
+				else
+				{
+					v.v.raw->Printf("%.17g", dv);
+				}
+			}
+			return 0;
+		}
+		return -1;
+	}
+
+	int value_convert_to_number(ValueObject& v)
+	{
+		if (v.type == EMPTY)
+		{
+			return -1;
+		}
+		if (v.type != RAW)
+		{
+			return 0;
+		}
+		int64_t intv;
+		double dv;
+		if (raw_toint64(v.v.raw->GetRawReadBuffer(), v.v.raw->ReadableBytes(),
+		        intv))
+		{
+			v.Clear();
+			v.type = INTEGER;
+			v.v.int_v = intv;
+			return 1;
+		}
+		else if (raw_todouble(v.v.raw->GetRawReadBuffer(),
+		        v.v.raw->ReadableBytes(), dv))
+		{
+			v.Clear();
+			v.type = DOUBLE;
+			v.v.double_v = dv;
+			return 1;
+		}
+		return -1;
+	}
+
+	void encode_value(Buffer& buf, const ValueObject& value)
+	{
+		BufferHelper::WriteFixUInt8(buf, value.type);
+		switch (value.type)
+		{
+			case EMPTY:
+			{
+				break;
+			}
+			case INTEGER:
+			{
+				BufferHelper::WriteVarInt64(buf, value.v.int_v);
+				break;
+			}
+			case DOUBLE:
+			{
+				BufferHelper::WriteFixDouble(buf, value.v.double_v);
+				break;
+			}
+			default:
+			{
+				if (NULL != value.v.raw)
+				{
+					BufferHelper::WriteVarUInt32(buf,
+					        value.v.raw->ReadableBytes());
+					buf.Write(value.v.raw->GetRawReadBuffer(),
+					        value.v.raw->ReadableBytes());
+				}
+				else
+				{
+					BufferHelper::WriteVarInt64(buf, 0);
+				}
+				break;
+			}
+		}
+	}
+
+	bool decode_value(Buffer& buf, ValueObject& value, bool copyRawValue)
+	{
+		value.Clear();
+		if (!BufferHelper::ReadFixUInt8(buf, value.type))
+		{
+			return false;
+		}
+		switch (value.type)
+		{
+			case EMPTY:
+			{
+				break;
+			}
+			case INTEGER:
+			{
+				if (!BufferHelper::ReadVarInt64(buf, value.v.int_v))
+				{
+					return false;
+				}
+				break;
+			}
+			case DOUBLE:
+			{
+				if (!BufferHelper::ReadFixDouble(buf, value.v.double_v))
+				{
+					return false;
+				}
+				break;
+			}
+			default:
+			{
+				uint32_t len;
+				if (!BufferHelper::ReadVarUInt32(buf, len)
+				        || buf.ReadableBytes() < len)
+				{
+					return false;
+				}
+
+				if (copyRawValue)
+				{
+					value.v.raw = new Buffer(len);
+					buf.Read(value.v.raw, len);
+				}
+				else
+				{
+					const char* tmp = buf.GetRawReadBuffer();
+					value.v.raw = new Buffer(const_cast<char*>(tmp), 0, len);
+					buf.SkipBytes(len);
+				}
+				break;
+			}
+		}
+		return true;
+	}
+	void smart_fill_value(const Slice& value, ValueObject& valueobject)
+	{
+		if (value.empty())
+		{
+			valueobject.type = EMPTY;
+			return;
+		}
+		int64_t intv;
+		double doublev;
+		char first_char = value.data()[0];
+		if (first_char != '+' && value.data()[0] != '-'
+		        && (first_char < '0' || first_char > '9'))
+		{
+			valueobject.type = RAW;
+			char* v = const_cast<char*>(value.data());
+			valueobject.v.raw = new Buffer(v, 0, value.size());
+		}
+		else
+		{
+			if (raw_toint64(value.data(), value.size(), intv))
+			{
+				valueobject.type = INTEGER;
+				valueobject.v.int_v = intv;
+			}
+			else if (raw_todouble(value.data(), value.size(), doublev))
+			{
+				valueobject.type = DOUBLE;
+				valueobject.v.double_v = doublev;
+			}
+			else
+			{
+				valueobject.type = RAW;
+				char* v = const_cast<char*>(value.data());
+				valueobject.v.raw = new Buffer(v, 0, value.size());
+			}
+		}
+
+	}
+	void fill_raw_value(const Slice& value, ValueObject& valueobject)
+	{
+		valueobject.type = RAW;
+		char* v = const_cast<char*>(value.data());
+		valueobject.v.raw = new Buffer(v, 0, value.size());
+	}
+
+	/*
+	 * Smallest key ordered after every key starting with 'key', empty if
+	 * 'key' is all 0xFF bytes.
+	 */
+	void next_key(const Slice& key, std::string& next)
+	{
+		next.assign(key.data(), key.size());
+		while (!next.empty())
+		{
+			unsigned char c = (unsigned char) next[next.size() - 1];
+			if (c < 0xFF)
+			{
+				next[next.size() - 1] = (char) (c + 1);
+				return;
+			}
+			next.resize(next.size() - 1);
+		}
+	}
+}
+
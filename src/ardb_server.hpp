@@ -64,6 +64,7 @@ namespace ardb
 			int64 repl_backlog_size;
 			int64 repl_syncstate_persist_period;
 			int64 repl_max_backup_logs;
+			int64 repl_bulk_sync_threads;
 
 			std::string master_host;
 			uint32 master_port;
@@ -74,14 +75,20 @@ namespace ardb
 			int64 worker_count;
 			std::string loglevel;
 			std::string logfile;
+
+			int64 expire_sweep_period;
+			int64 expire_sweep_batch;
+			bool group_commit;
 			ArdbServerConfig() :
 					daemonize(false), listen_port(0), unixsocketperm(755), max_clients(
 					        10000), tcp_keepalive(0), timeout(0), slowlog_log_slower_than(
 					        10000), slowlog_max_len(128), repl_data_dir(
 					        "./repl"), backup_dir("./backup"), repl_ping_slave_period(
 					        10), repl_timeout(60), repl_backlog_size(1000000), repl_syncstate_persist_period(
-					        1), repl_max_backup_logs(100), master_port(0), repl_log_enable(
-					        true), worker_count(1), loglevel("INFO")
+					        1), repl_max_backup_logs(100), repl_bulk_sync_threads(
+					        4), master_port(0), repl_log_enable(
+					        true), worker_count(1), loglevel("INFO"), expire_sweep_period(
+			        100), expire_sweep_batch(1000), group_commit(false)
 			{
 			}
 	};
@@ -124,13 +131,17 @@ namespace ardb
 			bool in_transaction;
 			bool fail_transc;
 			bool is_slave_conn;
+			/*
+			 * Set by a slave which can load a full sync as raw blocks.
+			 */
+			bool bulk_sync;
 			TransactionCommandQueue* transaction_cmds;
 			WatchKeySet* watch_key_set;
 			PubSubChannelSet* pubsub_channle_set;
 			PubSubChannelSet* pattern_pubsub_channle_set;
 			ArdbConnContext() :
 					currentDB(0), conn(NULL), in_transaction(false), fail_transc(
-					        false), is_slave_conn(false), transaction_cmds(
+					        false), is_slave_conn(false), bulk_sync(false), transaction_cmds(
 					        NULL), watch_key_set(NULL), pubsub_channle_set(
 					        NULL), pattern_pubsub_channle_set(NULL)
 			{
@@ -256,12 +267,29 @@ namespace ardb
 			        ChannelStateEvent& e);
 			void ChannelConnected(ChannelHandlerContext& ctx,
 			        ChannelStateEvent& e);
+			void ExceptionCaught(ChannelHandlerContext& ctx,
+			        ExceptionEvent& e);
 			RedisRequestHandler(ArdbServer* s) :
 					server(s)
 			{
 			}
 	};
 
+	/*
+	 * Runs all commands decoded from one read as one group commit, their
+	 * replies are held back until the group's writes are committed.
+	 */
+	struct RedisGroupCommitHandler: public ChannelUpstreamHandler<Buffer>
+	{
+			ArdbServer* server;
+			void MessageReceived(ChannelHandlerContext& ctx,
+			        MessageEvent<Buffer>& e);
+			RedisGroupCommitHandler(ArdbServer* s) :
+					server(s)
+			{
+			}
+	};
+
 	class ReplicationService;
 	class OpLogs;
 	class ArdbServer: public KeyWatcher
@@ -270,13 +298,33 @@ namespace ardb
 			typedef int (ArdbServer::*RedisCommandHandler)(ArdbConnContext&,
 			        RedisCommandFrame&);
 
+			enum RedisCommandFlag
+			{
+				ARDB_CMD_WRITE = 1, ARDB_CMD_READONLY = 2,
+				/*
+				 * Runs right away inside MULTI instead of being queued.
+				 */
+				ARDB_CMD_TRANSACTION = 4,
+				/*
+				 * Allowed on a connection in subscribe mode.
+				 */
+				ARDB_CMD_PUBSUB = 8,
+				/*
+				 * Works on the store as a whole, a pending group commit
+				 * is flushed before it runs.
+				 */
+				ARDB_CMD_BARRIER = 16
+			};
 			struct RedisCommandHandlerSetting
 			{
 					const char* name;
 					RedisCommandHandler handler;
 					int min_arity;
 					int max_arity;
-					int read_write_cmd; //0:read 1:write 2:unknown
+					int flags;
+					uint32 name_len;
+					volatile uint64 calls;
+					volatile uint64 microseconds;
 			};
 		private:
 			ArdbServerConfig m_cfg;
@@ -285,11 +333,17 @@ namespace ardb
 			Ardb* m_db;
 			KeyValueEngineFactory& m_engine;
 
-			typedef btree::btree_map<std::string, RedisCommandHandlerSetting> RedisCommandHandlerSettingTable;
 			typedef btree::btree_map<WatchKey, ContextSet> WatchKeyContextTable;
 			typedef btree::btree_map<std::string, ContextSet> PubSubContextTable;
 
-			RedisCommandHandlerSettingTable m_handler_table;
+			/*
+			 * Perfect hash over the command names, built once: the name
+			 * hash picks a bucket, the bucket's seed picks the slot. A
+			 * lookup is one case-folding hash and one compare.
+			 */
+			std::vector<RedisCommandHandlerSetting> m_handler_settings;
+			std::vector<uint32> m_handler_seeds;
+			std::vector<RedisCommandHandlerSetting*> m_handler_slots;
 			SlowLogHandler m_slowlog_handler;
 			ClientConnHolder m_clients_holder;
 			ReplicationService m_repli_serv;
@@ -303,8 +357,11 @@ namespace ardb
 			//ArdbConnContext* m_current_ctx;
 			ThreadLocal<ArdbConnContext*> m_ctx_local;
 
+			void BuildRedisCommandHandlerTable();
 			RedisCommandHandlerSetting* FindRedisCommandHandlerSetting(
 			        std::string& cmd);
+			const std::string CommandStats();
+			void ResetCommandStats();
 			int DoRedisCommand(ArdbConnContext& ctx,
 			        RedisCommandHandlerSetting* setting,
 			        RedisCommandFrame& cmd);
@@ -316,6 +373,7 @@ namespace ardb
 			friend class ReplicationService;
 			friend class OpLogs;
 			friend class RedisRequestHandler;
+			friend class RedisGroupCommitHandler;
 			friend class SlaveClient;
 
 			int OnKeyUpdated(const DBID& dbid, const Slice& key);
@@ -337,6 +395,7 @@ namespace ardb
 			int SlowLog(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int Client(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int Keys(ArdbConnContext& ctx, RedisCommandFrame& cmd);
+			int Scan(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 
 			int Multi(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int Discard(ArdbConnContext& ctx, RedisCommandFrame& cmd);
@@ -422,6 +481,7 @@ namespace ardb
 			int HSet(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int HSetNX(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int HVals(ArdbConnContext& ctx, RedisCommandFrame& cmd);
+			int HScan(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 
 			int SAdd(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int SCard(ArdbConnContext& ctx, RedisCommandFrame& cmd);
@@ -431,6 +491,7 @@ namespace ardb
 			int SInterStore(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int SIsMember(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int SMembers(ArdbConnContext& ctx, RedisCommandFrame& cmd);
+			int SScan(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int SMove(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int SPop(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int SRandMember(ArdbConnContext& ctx, RedisCommandFrame& cmd);
@@ -446,6 +507,7 @@ namespace ardb
 			int ZCount(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int ZIncrby(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int ZRange(ArdbConnContext& ctx, RedisCommandFrame& cmd);
+			int ZScan(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int ZRangeByScore(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int ZRank(ArdbConnContext& ctx, RedisCommandFrame& cmd);
 			int ZPop(ArdbConnContext& ctx, RedisCommandFrame& cmd);
@@ -28,6 +28,8 @@
  */
 
 #include "ardb.hpp"
+#include "util/bit_kernels.hpp"
+#include <algorithm>
 
 namespace ardb
 {
@@ -36,62 +38,374 @@ namespace ardb
 	static const unsigned long BITOP_XOR = 2;
 	static const unsigned long BITOP_NOT = 3;
 
-	static const uint32 BIT_SUBSET_SIZE = 4096;
-	static const uint32 BIT_SUBSET_BYTES_SIZE = BIT_SUBSET_SIZE >> 3;
-	//copy from redis
-	static long popcount(const void *s, long count)
-	{
-		long bits = 0;
-		unsigned char *p;
-		const uint32_t* p4 = (const uint32_t*) s;
-		static const unsigned char bitsinbyte[256] =
-			{ 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 1, 2, 2, 3, 2, 3,
-					3, 4, 2, 3, 3, 4, 3, 4, 4, 5, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3,
-					3, 4, 3, 4, 4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5,
-					5, 6, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5, 2, 3,
-					3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 2, 3, 3, 4, 3, 4,
-					4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5,
-					5, 6, 5, 6, 6, 7, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4,
-					4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 2, 3,
-					3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5,
-					5, 6, 4, 5, 5, 6, 5, 6, 6, 7, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4,
-					4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6,
-					6, 7, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7, 4, 5,
-					5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8 };
-
-		/* Count bits 16 bytes at a time */
-		while (count >= 16)
-		{
-			uint32_t aux1, aux2, aux3, aux4;
-
-			aux1 = *p4++;
-			aux2 = *p4++;
-			aux3 = *p4++;
-			aux4 = *p4++;
-			count -= 16;
-
-			aux1 = aux1 - ((aux1 >> 1) & 0x55555555);
-			aux1 = (aux1 & 0x33333333) + ((aux1 >> 2) & 0x33333333);
-			aux2 = aux2 - ((aux2 >> 1) & 0x55555555);
-			aux2 = (aux2 & 0x33333333) + ((aux2 >> 2) & 0x33333333);
-			aux3 = aux3 - ((aux3 >> 1) & 0x55555555);
-			aux3 = (aux3 & 0x33333333) + ((aux3 >> 2) & 0x33333333);
-			aux4 = aux4 - ((aux4 >> 1) & 0x55555555);
-			aux4 = (aux4 & 0x33333333) + ((aux4 >> 2) & 0x33333333);
-			bits +=
-					((((aux1 + (aux1 >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24)
-							+ ((((aux2 + (aux2 >> 4)) & 0x0F0F0F0F) * 0x01010101)
-									>> 24)
-							+ ((((aux3 + (aux3 >> 4)) & 0x0F0F0F0F) * 0x01010101)
-									>> 24)
-							+ ((((aux4 + (aux4 >> 4)) & 0x0F0F0F0F) * 0x01010101)
-									>> 24);
-		}
-		/* Count the remaining bytes */
-		p = (unsigned char*) p4;
-		while (count--)
-			bits += bitsinbyte[*p++];
-		return bits;
+	/*
+	 * 2 bytes per offset, an array chunk with more offsets would be
+	 * bigger than the bitmap.
+	 */
+	static const uint32 BITSET_ARRAY_MAX = BIT_SUBSET_SIZE >> 4;
+	static const uint32 BITSET_BITMAP_BYTES = BIT_SUBSET_SIZE >> 3;
+
+	/*
+	 * Mask of the bits 'first' to 'last' of one word.
+	 */
+	static inline uint64 word_mask(uint32 first, uint32 last)
+	{
+		return (~((uint64) 0) << first) & (~((uint64) 0) >> (63 - last));
+	}
+
+	static void set_bit_range(uint64* words, uint32 first, uint32 last)
+	{
+		uint32 fw = first >> 6;
+		uint32 lw = last >> 6;
+		if (fw == lw)
+		{
+			words[fw] |= word_mask(first & 63, last & 63);
+			return;
+		}
+		words[fw] |= word_mask(first & 63, 63);
+		for (uint32 i = fw + 1; i < lw; i++)
+		{
+			words[i] = ~((uint64) 0);
+		}
+		words[lw] |= word_mask(0, last & 63);
+	}
+
+	/*
+	 * Offset of the next bit from 'from' which is set (or clear), or
+	 * BIT_SUBSET_SIZE.
+	 */
+	static uint32 next_bit(const uint64* words, uint32 from, bool set)
+	{
+		while (from < BIT_SUBSET_SIZE)
+		{
+			uint64 w = set ? words[from >> 6] : ~words[from >> 6];
+			w &= ~((uint64) 0) << (from & 63);
+			if (0 != w)
+			{
+				return (from & ~63) + __builtin_ctzll(w);
+			}
+			from = (from & ~63) + 64;
+		}
+		return BIT_SUBSET_SIZE;
+	}
+
+	/*
+	 * Index of the run which starts at or before 'offset', or -1.
+	 */
+	static int32 find_run(const std::vector<uint16>& runs, uint32 offset)
+	{
+		int32 low = 0;
+		int32 high = (int32) (runs.size() / 2) - 1;
+		int32 found = -1;
+		while (low <= high)
+		{
+			int32 mid = (low + high) / 2;
+			if (runs[mid * 2] <= offset)
+			{
+				found = mid;
+				low = mid + 1;
+			}
+			else
+			{
+				high = mid - 1;
+			}
+		}
+		return found;
+	}
+
+	bool BitSetElementValue::Get(uint32 offset) const
+	{
+		switch (type)
+		{
+			case BITSET_BITMAP:
+			{
+				return (words[offset >> 6] >> (offset & 63)) & 1;
+			}
+			case BITSET_RUN:
+			{
+				int32 run = find_run(vals, offset);
+				return run >= 0 && offset <= vals[run * 2 + 1];
+			}
+			default:
+			{
+				return std::binary_search(vals.begin(), vals.end(),
+				        (uint16) offset);
+			}
+		}
+	}
+
+	bool BitSetElementValue::Set(uint32 offset, bool on)
+	{
+		bool old = Get(offset);
+		if (old == on)
+		{
+			return old;
+		}
+		if (type == BITSET_RUN
+		        || (type == BITSET_ARRAY && on && vals.size() >= BITSET_ARRAY_MAX))
+		{
+			uint64 tmp[BIT_SUBSET_WORDS];
+			ToBitmap(tmp);
+			words.assign(tmp, tmp + BIT_SUBSET_WORDS);
+			vals.clear();
+			type = BITSET_BITMAP;
+		}
+		if (type == BITSET_BITMAP)
+		{
+			words[offset >> 6] ^= ((uint64) 1) << (offset & 63);
+		}
+		else
+		{
+			std::vector<uint16>::iterator it = std::lower_bound(vals.begin(),
+			        vals.end(), (uint16) offset);
+			if (on)
+			{
+				vals.insert(it, (uint16) offset);
+			}
+			else
+			{
+				vals.erase(it);
+			}
+		}
+		if (on)
+		{
+			bitcount++;
+		}
+		else
+		{
+			bitcount--;
+		}
+		return old;
+	}
+
+	uint32 BitSetElementValue::Count(uint32 first, uint32 last) const
+	{
+		if (first == 0 && last >= BIT_SUBSET_SIZE - 1)
+		{
+			return bitcount;
+		}
+		switch (type)
+		{
+			case BITSET_BITMAP:
+			{
+				/*
+				 * The partial edge words go through the selected kernel
+				 * too, a bare builtin is a libgcc call without -mpopcnt.
+				 */
+				const BitKernels& kernels = bit_kernels();
+				uint32 fw = first >> 6;
+				uint32 lw = last >> 6;
+				uint64 edges[2];
+				if (fw == lw)
+				{
+					edges[0] = words[fw] & word_mask(first & 63, last & 63);
+					return kernels.popcount(edges, 1);
+				}
+				edges[0] = words[fw] & word_mask(first & 63, 63);
+				edges[1] = words[lw] & word_mask(0, last & 63);
+				uint32 count = kernels.popcount(edges, 2);
+				if (lw > fw + 1)
+				{
+					count += kernels.popcount(&words[fw + 1], lw - fw - 1);
+				}
+				return count;
+			}
+			case BITSET_RUN:
+			{
+				uint32 count = 0;
+				for (uint32 i = 0; i < vals.size(); i += 2)
+				{
+					uint32 s = vals[i] > first ? vals[i] : first;
+					uint32 e = vals[i + 1] < last ? vals[i + 1] : last;
+					if (s <= e)
+					{
+						count += e - s + 1;
+					}
+				}
+				return count;
+			}
+			default:
+			{
+				return std::upper_bound(vals.begin(), vals.end(), (uint16) last)
+				        - std::lower_bound(vals.begin(), vals.end(),
+				                (uint16) first);
+			}
+		}
+	}
+
+	int32 BitSetElementValue::Last() const
+	{
+		if (0 == bitcount)
+		{
+			return -1;
+		}
+		if (type == BITSET_BITMAP)
+		{
+			for (int32 i = BIT_SUBSET_WORDS - 1; i >= 0; i--)
+			{
+				if (0 != words[i])
+				{
+					return i * 64 + 63 - __builtin_clzll(words[i]);
+				}
+			}
+			return -1;
+		}
+		return vals.back();
+	}
+
+	void BitSetElementValue::ToBitmap(uint64* dst) const
+	{
+		if (type == BITSET_BITMAP)
+		{
+			memcpy(dst, &words[0], BITSET_BITMAP_BYTES);
+			return;
+		}
+		memset(dst, 0, BITSET_BITMAP_BYTES);
+		if (type == BITSET_RUN)
+		{
+			for (uint32 i = 0; i < vals.size(); i += 2)
+			{
+				set_bit_range(dst, vals[i], vals[i + 1]);
+			}
+			return;
+		}
+		for (uint32 i = 0; i < vals.size(); i++)
+		{
+			dst[vals[i] >> 6] |= ((uint64) 1) << (vals[i] & 63);
+		}
+	}
+
+	/*
+	 * An offset takes 2 bytes in an array chunk, a run 4 bytes in a run
+	 * chunk.
+	 */
+	void BitSetElementValue::FromBitmap(const uint64* src)
+	{
+		const BitKernels& kernels = bit_kernels();
+		uint32 count = kernels.popcount(src, BIT_SUBSET_WORDS);
+		uint32 runs = kernels.count_runs(src, BIT_SUBSET_WORDS);
+		bitcount = count;
+		vals.clear();
+		words.clear();
+		if (runs * 4 < count * 2 && runs * 4 < BITSET_BITMAP_BYTES)
+		{
+			type = BITSET_RUN;
+			vals.reserve(runs * 2);
+			uint32 first = next_bit(src, 0, true);
+			while (first < BIT_SUBSET_SIZE)
+			{
+				uint32 end = next_bit(src, first, false);
+				vals.push_back(first);
+				vals.push_back(end - 1);
+				first = next_bit(src, end, true);
+			}
+		}
+		else if (count <= BITSET_ARRAY_MAX)
+		{
+			type = BITSET_ARRAY;
+			vals.reserve(count);
+			for (uint32 i = 0; i < BIT_SUBSET_WORDS; i++)
+			{
+				uint64 w = src[i];
+				while (0 != w)
+				{
+					vals.push_back(i * 64 + __builtin_ctzll(w));
+					w &= w - 1;
+				}
+			}
+		}
+		else
+		{
+			type = BITSET_BITMAP;
+			words.assign(src, src + BIT_SUBSET_WORDS);
+		}
+	}
+
+	void BitSetElementValue::Optimize()
+	{
+		uint64 tmp[BIT_SUBSET_WORDS];
+		ToBitmap(tmp);
+		FromBitmap(tmp);
+	}
+
+	void BitSetElementValue::Encode(Buffer& buf) const
+	{
+		BufferHelper::WriteFixUInt8(buf, type);
+		BufferHelper::WriteVarUInt32(buf, bitcount);
+		if (type == BITSET_BITMAP)
+		{
+			for (uint32 i = 0; i < BIT_SUBSET_WORDS; i++)
+			{
+				BufferHelper::WriteFixUInt64(buf, words[i]);
+			}
+			return;
+		}
+		if (type == BITSET_RUN)
+		{
+			BufferHelper::WriteVarUInt32(buf, vals.size() / 2);
+		}
+		for (uint32 i = 0; i < vals.size(); i++)
+		{
+			BufferHelper::WriteFixUInt16(buf, vals[i]);
+		}
+	}
+
+	bool BitSetElementValue::Decode(Buffer& buf)
+	{
+		uint8 t;
+		if (!BufferHelper::ReadFixUInt8(buf, t)
+		        || !BufferHelper::ReadVarUInt32(buf, bitcount)
+		        || bitcount > BIT_SUBSET_SIZE)
+		{
+			return false;
+		}
+		type = t;
+		vals.clear();
+		words.clear();
+		uint32 size = 0;
+		switch (type)
+		{
+			case BITSET_BITMAP:
+			{
+				words.resize(BIT_SUBSET_WORDS);
+				for (uint32 i = 0; i < BIT_SUBSET_WORDS; i++)
+				{
+					if (!BufferHelper::ReadFixUInt64(buf, words[i]))
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+			case BITSET_RUN:
+			{
+				if (!BufferHelper::ReadVarUInt32(buf, size))
+				{
+					return false;
+				}
+				size *= 2;
+				break;
+			}
+			case BITSET_ARRAY:
+			{
+				size = bitcount;
+				break;
+			}
+			default:
+			{
+				return false;
+			}
+		}
+		if (buf.ReadableBytes() < size * 2)
+		{
+			return false;
+		}
+		vals.resize(size);
+		for (uint32 i = 0; i < size; i++)
+		{
+			BufferHelper::ReadFixUInt16(buf, vals[i]);
+		}
+		return true;
 	}
 
 	static bool DecodeSetMetaData(ValueObject& v, BitSetMetaValue& meta)
@@ -122,22 +436,151 @@ namespace ardb
 		{
 			return false;
 		}
-		return BufferHelper::ReadVarUInt32(*(v.v.raw), meta.bitcount)
-				&& BufferHelper::ReadVarUInt32(*(v.v.raw), meta.start)
-				&& BufferHelper::ReadVarUInt32(*(v.v.raw), meta.limit)
-				&& BufferHelper::ReadVarString(*(v.v.raw), meta.vals);
+		return meta.Decode(*(v.v.raw));
 	}
 	static void EncodeSetElementData(ValueObject& v, BitSetElementValue& meta)
 	{
 		v.type = RAW;
 		if (v.v.raw == NULL)
 		{
-			v.v.raw = new Buffer(BIT_SUBSET_SIZE + 8);
+			v.v.raw = new Buffer(16 + meta.vals.size() * 2);
 		}
-		BufferHelper::WriteVarUInt32(*(v.v.raw), meta.bitcount);
-		BufferHelper::WriteVarUInt32(*(v.v.raw), meta.start);
-		BufferHelper::WriteVarUInt32(*(v.v.raw), meta.limit);
-		BufferHelper::WriteVarString(*(v.v.raw), meta.vals);
+		meta.Encode(*(v.v.raw));
+	}
+
+	/*
+	 * Chunks written by data format version 5 and older hold the whole
+	 * BIT_SUBSET_SIZE bits, offset 0 being the highest bit of the first
+	 * byte.
+	 */
+	static bool DecodeLegacySetElementData(ValueObject& v,
+	        BitSetElementValue& element)
+	{
+		uint32 bitcount, start, limit;
+		std::string vals;
+		if (v.type != RAW || !BufferHelper::ReadVarUInt32(*(v.v.raw), bitcount)
+		        || !BufferHelper::ReadVarUInt32(*(v.v.raw), start)
+		        || !BufferHelper::ReadVarUInt32(*(v.v.raw), limit)
+		        || !BufferHelper::ReadVarString(*(v.v.raw), vals))
+		{
+			return false;
+		}
+		uint64 words[BIT_SUBSET_WORDS];
+		memset(words, 0, sizeof(words));
+		for (uint32 i = 0; i < vals.size() && i < BITSET_BITMAP_BYTES; i++)
+		{
+			uint8 byte = vals[i];
+			for (uint32 b = 0; b < 8; b++)
+			{
+				if (byte & (0x80 >> b))
+				{
+					uint32 offset = i * 8 + b;
+					words[offset >> 6] |= ((uint64) 1) << (offset & 63);
+				}
+			}
+		}
+		element.FromBitmap(words);
+		return true;
+	}
+
+	/*
+	 * Reads the chunks of one bitset in index order.
+	 */
+	struct BitSetChunkCursor
+	{
+			Iterator* iter;
+			BitSetKeyObject start;
+			uint64 index;
+			BitSetElementValue element;
+			bool valid;
+			BitSetChunkCursor(Iterator* it, const BitSetKeyObject& k) :
+					iter(it), start(k), index(0), valid(false)
+			{
+				Load();
+			}
+			void Load()
+			{
+				valid = false;
+				while (NULL != iter && iter->Valid())
+				{
+					KeyObject* k = decode_key(iter->Key(), &start);
+					if (NULL == k || k->type != BITSET_ELEMENT
+					        || k->key.compare(start.key) != 0)
+					{
+						DELETE(k);
+						return;
+					}
+					index = ((BitSetKeyObject*) k)->index;
+					DELETE(k);
+					ValueObject v;
+					Buffer readbuf(const_cast<char*>(iter->Value().data()), 0,
+					        iter->Value().size());
+					if (decode_value(readbuf, v, false)
+					        && DecodeSetElementData(v, element))
+					{
+						valid = true;
+						return;
+					}
+					iter->Next();
+				}
+			}
+			void Next()
+			{
+				iter->Next();
+				Load();
+			}
+			~BitSetChunkCursor()
+			{
+				DELETE(iter);
+			}
+	};
+
+	/*
+	 * Bits at the offsets 'start' to 'end' from the chunk of the cursor on.
+	 */
+	static uint64 CountBitRange(BitSetChunkCursor& cursor, uint64 start,
+	        uint64 end)
+	{
+		uint64 startIndex = (start / BIT_SUBSET_SIZE) + 1;
+		uint64 endIndex = (end / BIT_SUBSET_SIZE) + 1;
+		uint64 count = 0;
+		while (cursor.valid && cursor.index <= endIndex)
+		{
+			if (cursor.index >= startIndex)
+			{
+				uint32 first =
+				        cursor.index == startIndex ? start % BIT_SUBSET_SIZE : 0;
+				uint32 last =
+				        cursor.index == endIndex ?
+				                end % BIT_SUBSET_SIZE : BIT_SUBSET_SIZE - 1;
+				count += cursor.element.Count(first, last);
+			}
+			cursor.Next();
+		}
+		return count;
+	}
+
+	/*
+	 * Applies 'op' to the chunks of all cursors into 'acc'. With
+	 * 'count_only' the last step only counts the bits of the result and
+	 * 'acc' is left incomplete.
+	 */
+	static uint64 CombineChunks(uint32 op,
+	        std::vector<BitSetChunkCursor*>& parts, uint64* acc, uint64* tmp,
+	        bool count_only)
+	{
+		const BitKernels& kernels = bit_kernels();
+		parts[0]->element.ToBitmap(acc);
+		for (uint32 i = 1; i < parts.size(); i++)
+		{
+			parts[i]->element.ToBitmap(tmp);
+			if (count_only && i == parts.size() - 1)
+			{
+				return kernels.op_popcount(op, acc, tmp, BIT_SUBSET_WORDS);
+			}
+			kernels.op(op, acc, tmp, BIT_SUBSET_WORDS);
+		}
+		return count_only ? kernels.popcount(acc, BIT_SUBSET_WORDS) : 0;
 	}
 
 	int Ardb::GetBitSetMetaValue(const DBID& db, const Slice& key,
@@ -190,11 +633,8 @@ namespace ardb
 			uint8 value)
 	{
 		KeyLockerGuard keyguard(m_key_locker, db, key);
-		int byte, bit;
-		int byteval, bitval;
-		long on = value;
 		/* Bits can only be set or cleared... */
-		if (on & ~1)
+		if (value & ~1)
 		{
 			return -1;
 		}
@@ -216,479 +656,430 @@ namespace ardb
 			set_changed = true;
 		}
 
-		bitoffset = bitoffset % BIT_SUBSET_SIZE;
-		byte = bitoffset >> 3;
 		BitSetKeyObject k(key, index, db);
-		BitSetElementValue bitvalue;
-		bool element_changed = false;
-		GetBitSetElementValue(k, bitvalue);
-		if (bitvalue.vals.size() < BIT_SUBSET_BYTES_SIZE)
-		{
-			uint32 tmpsize = BIT_SUBSET_BYTES_SIZE - bitvalue.vals.size();
-			char tmp[tmpsize];
-			memset(tmp, 0, tmpsize);
-			bitvalue.vals.append(tmp, tmpsize);
-		}
-
-		if (bitvalue.limit < bitoffset)
-		{
-			bitvalue.limit = bitoffset + 1;
-			element_changed = true;
-		}
-		if (bitvalue.start > bitoffset || bitvalue.start == 0)
-		{
-			bitvalue.start = bitoffset + 1;
-			element_changed = true;
-		}
-		/* Get current values */
-		byteval = ((const uint8*) bitvalue.vals.data())[byte];
-		bit = 7 - (bitoffset & 0x7);
-		bitval = byteval & (1 << bit);
-
-		int tmp = byteval;
+		BitSetElementValue element;
+		GetBitSetElementValue(k, element);
+		bool on = value == 1;
+		bool old = element.Set(bitoffset % BIT_SUBSET_SIZE, on);
 
 		BatchWriteGuard guard(GetEngine());
-		/* Update byte with new bit value and return original value */
-		byteval &= ~(1 << bit);
-		byteval |= ((on & 0x1) << bit);
-		if (byteval != tmp)
+		if (old != on)
 		{
-			((uint8_t*) bitvalue.vals.data())[byte] = byteval;
-			if (on == 1)
+			if (on)
 			{
-				bitvalue.bitcount++;
 				meta.bitcount++;
-			} else
+			}
+			else
 			{
-				bitvalue.bitcount--;
 				meta.bitcount--;
 			}
 			set_changed = true;
-			element_changed = true;
+			if (element.bitcount > 0)
+			{
+				element.Optimize();
+				SetBitSetElementValue(k, element);
+			}
+			else
+			{
+				DelValue(k);
+			}
 		}
 		if (set_changed)
 		{
 			SetBitSetMetaValue(db, key, meta);
 		}
-		if (element_changed)
-		{
-			SetBitSetElementValue(k, bitvalue);
-		}
-		return bitval != 0 ? 1 : 0;
+		return old ? 1 : 0;
 	}
 
 	int Ardb::GetBit(const DBID& db, const Slice& key, uint64 bitoffset)
 	{
 		uint64 index = (bitoffset / BIT_SUBSET_SIZE) + 1;
 		BitSetKeyObject k(key, index, db);
-		BitSetElementValue bitvalue;
-		if (-1 == GetBitSetElementValue(k, bitvalue))
+		BitSetElementValue element;
+		if (0 != GetBitSetElementValue(k, element))
 		{
 			return 0;
 		}
-		size_t byte, bit;
-		size_t bitval = 0;
+		return element.Get(bitoffset % BIT_SUBSET_SIZE) ? 1 : 0;
+	}
+
+	/*
+	 * All input bitsets are read chunk by chunk in index order from one
+	 * snapshot, each result chunk goes to the handler as soon as it is
+	 * complete. A handler which only wants counts gets them without the
+	 * result chunks being built.
+	 */
+	int Ardb::ParseBitOP(const Slice& opstr, uint32 keycount,
+			unsigned long& op)
+	{
+		/* Parse the operation name. */
+		if (!strncasecmp(opstr.data(), "and", opstr.size()))
+			op = BITOP_AND;
+		else if (!strncasecmp(opstr.data(), "or", opstr.size()))
+			op = BITOP_OR;
+		else if (!strncasecmp(opstr.data(), "xor", opstr.size()))
+			op = BITOP_XOR;
+		else if (!strncasecmp(opstr.data(), "not", opstr.size()))
+			op = BITOP_NOT;
+		else
+		{
+			return ERR_INVALID_OPERATION;
+		}
 
-		bitoffset = bitoffset % BIT_SUBSET_SIZE;
-		byte = bitoffset >> 3;
-		if (byte >= bitvalue.vals.size() || (bitoffset + 1) < bitvalue.start
-				|| (bitoffset + 1) > bitvalue.limit)
+		/* Sanity check: NOT accepts only a single key argument. */
+		if (op == BITOP_NOT && keycount != 1)
 		{
-			return 0;
+			SetErrorCause("BITOP NOT must be called with a single source key.");
+			return ERR_INVALID_OPERATION;
 		}
-		int byteval = ((const uint8_t*) bitvalue.vals.c_str())[byte];
-		bit = 7 - (bitoffset & 0x7);
-		bitval = byteval & (1 << bit);
-		return bitval != 0 ? 1 : 0;
+		return 0;
 	}
 
-	static void BitSetElementOp(uint32 op, BitSetElementValue& v1,
-			BitSetElementValue& v2, BitSetElementValue& res)
+	int Ardb::BitOP(const DBID& db, const Slice& opstr, SliceArray& keys,
+			BitSetElementHandler* handler)
 	{
-		if (op != BITOP_NOT && (v1.vals.empty() || v2.vals.empty()))
+		unsigned long op;
+		int err = ParseBitOP(opstr, keys.size(), op);
+		if (0 != err)
+		{
+			return err;
+		}
+		bool count_only = handler->CountOnly();
+		SnapshotGuard snapshot(GetEngine());
+		std::vector<BitSetChunkCursor*> cursors;
+		for (uint32 i = 0; i < keys.size(); i++)
 		{
-			switch (op)
+			BitSetKeyObject k(keys[i], 1, db);
+			cursors.push_back(new BitSetChunkCursor(FindValue(k), k));
+		}
+		const BitKernels& kernels = bit_kernels();
+		uint64 acc[BIT_SUBSET_WORDS];
+		uint64 tmp[BIT_SUBSET_WORDS];
+		BitSetElementValue result;
+		if (op == BITOP_NOT)
+		{
+			/*
+			 * Like a string, the bitset is as long as the byte holding its
+			 * last set bit, and every bit up to there is flipped.
+			 */
+			BitSetChunkCursor* c = cursors[0];
+			BitSetElementValue full;
+			if (!count_only)
+			{
+				memset(tmp, 0xFF, sizeof(tmp));
+				full.FromBitmap(tmp);
+			}
+			BitSetElementValue last;
+			uint64 last_index = 0;
+			uint64 next_index = 1;
+			bool stop = false;
+			while (!stop && c->valid)
 			{
-				case BITOP_AND:
+				if (last_index > 0 && count_only)
 				{
-					return;
+					stop = handler->OnBitSetCount(last_index,
+					        BIT_SUBSET_SIZE - last.bitcount) < 0;
 				}
-				case BITOP_OR:
-				case BITOP_XOR:
+				else if (last_index > 0)
 				{
-					if (v1.vals.empty())
-					{
-						res = v2;
-					}
-					if (v2.vals.empty())
+					last.ToBitmap(acc);
+					kernels.negate(acc, BIT_SUBSET_WORDS);
+					result.FromBitmap(acc);
+					if (result.bitcount > 0
+					        && handler->OnBitSetElement(last_index, result) < 0)
 					{
-						res = v1;
+						stop = true;
 					}
-					return;
 				}
-				default:
+				for (; !stop && next_index < c->index; next_index++)
 				{
-					return;
+					stop = (count_only ?
+					        handler->OnBitSetCount(next_index, BIT_SUBSET_SIZE) :
+					        handler->OnBitSetElement(next_index, full)) < 0;
 				}
+				last = c->element;
+				last_index = c->index;
+				next_index = c->index + 1;
+				c->Next();
 			}
-		}
-
-		char dst[BIT_SUBSET_BYTES_SIZE];
-		memset(dst, 0, BIT_SUBSET_BYTES_SIZE);
-		uint32 bytestart = 0;
-		uint32 byteend = 0;
-		uint32 st = 0, et = 0;
-		switch (op)
-		{
-			case BITOP_AND:
+			int32 last_bit = last.Last();
+			if (!stop && last_index > 0 && last_bit >= 0)
 			{
-				uint32 maxstart = v1.start < v2.start ? v2.start : v1.start;
-				uint32 minend = v1.limit < v2.limit ? v1.limit : v2.limit;
-				if (minend < maxstart)
+				uint32 end = last_bit | 7;
+				if (count_only)
 				{
-					return;
+					handler->OnBitSetCount(last_index,
+					        end + 1 - last.Count(0, end));
+				}
+				else
+				{
+					last.ToBitmap(acc);
+					kernels.negate(acc, BIT_SUBSET_WORDS);
+					memset(tmp, 0, sizeof(tmp));
+					set_bit_range(tmp, 0, end);
+					kernels.op(BIT_KERNEL_AND, acc, tmp, BIT_SUBSET_WORDS);
+					result.FromBitmap(acc);
+					if (result.bitcount > 0)
+					{
+						handler->OnBitSetElement(last_index, result);
+					}
 				}
-				st = maxstart;
-				et = minend;
-				bytestart = (maxstart - 1) >> 3;
-				byteend = (minend - 1) >> 3;
-				break;
-			}
-			case BITOP_OR:
-			case BITOP_XOR:
-			{
-				uint32 minstart = v1.start < v2.start ? v1.start : v2.start;
-				uint32 maxend = v1.limit < v2.limit ? v2.limit : v1.limit;
-				bytestart = (minstart - 1) >> 3;
-				byteend = (maxend - 1) >> 3;
-				st = minstart;
-				et = maxend;
-				break;
-			}
-			case BITOP_NOT:
-			{
-				bytestart = ((v1.start - 1) >> 3);
-				byteend = ((v1.limit - 1) >> 3);
-				st = v1.start;
-				et = v1.limit;
-				break;
-			}
-			default:
-			{
-				return;
 			}
 		}
-
-		memcpy(dst + bytestart, v1.vals.c_str() + bytestart, byteend - bytestart + 1);
-		uint64* lres = (uint64*) dst;
-		const uint64* lp = (const uint64*) (v2.vals.c_str());
-		uint32 xst = bytestart >>3;
-		uint32 xet = byteend >> 3;
-		while(xst <= xet)
+		else if (op == BITOP_AND)
 		{
-			switch (op)
+			while (true)
 			{
-				case BITOP_AND:
+				uint64 target = 0;
+				bool done = false;
+				for (uint32 i = 0; i < cursors.size() && !done; i++)
 				{
-					lres[xst] &= lp[xst];
-					break;
+					done = !cursors[i]->valid;
+					if (cursors[i]->index > target)
+					{
+						target = cursors[i]->index;
+					}
 				}
-				case BITOP_OR:
+				bool aligned = true;
+				for (uint32 i = 0; i < cursors.size() && !done; i++)
 				{
-					lres[xst] |= lp[xst];
-					break;
+					while (cursors[i]->valid && cursors[i]->index < target)
+					{
+						cursors[i]->Next();
+					}
+					done = !cursors[i]->valid;
+					aligned = aligned && cursors[i]->index == target;
 				}
-				case BITOP_XOR:
+				if (done)
 				{
-					lres[xst] ^= lp[xst];
 					break;
 				}
-				case BITOP_NOT:
+				if (!aligned)
+				{
+					continue;
+				}
+				int ret = 0;
+				if (count_only)
+				{
+					uint64 count =
+					        1 == cursors.size() ?
+					                cursors[0]->element.bitcount :
+					                CombineChunks(BIT_KERNEL_AND, cursors, acc,
+					                        tmp, true);
+					ret = handler->OnBitSetCount(target, count);
+				}
+				else
+				{
+					CombineChunks(BIT_KERNEL_AND, cursors, acc, tmp, false);
+					result.FromBitmap(acc);
+					if (result.bitcount > 0)
+					{
+						ret = handler->OnBitSetElement(target, result);
+					}
+				}
+				if (ret < 0)
 				{
-					lres[xst] = ~lres[xst];
 					break;
 				}
-				default:
+				for (uint32 i = 0; i < cursors.size(); i++)
 				{
-					return;
+					cursors[i]->Next();
 				}
 			}
-			xst++;
 		}
-		res.vals.assign(dst, 0, BIT_SUBSET_BYTES_SIZE);
-		res.limit = et;
-		res.start = st;
-		res.bitcount = popcount(dst + bytestart, byteend - bytestart + 1);
-	}
-
-	int Ardb::BitsOr(const DBID& db, SliceArray& keys,
-			BitSetElementValueMap*& result, bool isXor)
-	{
-		struct BitSetOrWalk: public WalkHandler
+		else
 		{
-				Ardb* z_db;
-				bool isxor;
-				BitSetElementValueMap& res;
-				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
+			uint32 kop = op == BITOP_OR ? BIT_KERNEL_OR : BIT_KERNEL_XOR;
+			std::vector<BitSetChunkCursor*> parts;
+			while (true)
+			{
+				uint64 target = 0;
+				uint32 matched = 0;
+				BitSetChunkCursor* first = NULL;
+				for (uint32 i = 0; i < cursors.size(); i++)
 				{
-					BitSetKeyObject* bk = (BitSetKeyObject*) k;
-					BitSetElementValue element;
-					z_db->GetBitSetElementValue(*bk, element);
-					BitSetElementValueMap::iterator found = res.find(bk->index);
-					BitSetElementValue result;
-					if (found != res.end())
-					{
-						BitSetElementOp(isxor ? BITOP_XOR : BITOP_OR,
-								found->second, element, result);
-					} else
+					if (!cursors[i]->valid)
 					{
-						BitSetElementOp(isxor ? BITOP_XOR : BITOP_OR, result,
-								element, result);
+						continue;
 					}
-					if (result.bitcount > 0)
+					if (NULL == first || cursors[i]->index < target)
 					{
-						res[bk->index] = result;
-					} else
+						target = cursors[i]->index;
+						first = cursors[i];
+						matched = 1;
+					}
+					else if (cursors[i]->index == target)
 					{
-						res.erase(bk->index);
+						matched++;
 					}
-					return 0;
 				}
-				BitSetOrWalk(Ardb* db, bool flag, BitSetElementValueMap& r) :
-						z_db(db), isxor(flag), res(r)
+				if (NULL == first)
 				{
+					break;
 				}
-		};
-		for (uint32 i = 0; i < keys.size(); i++)
-		{
-			BitSetKeyObject setk(keys[i], 1, db);
-			BitSetOrWalk walk(this, isXor, *result);
-			Walk(setk, false, &walk);
-		}
-		return 0;
-	}
-
-	int Ardb::BitsAnd(const DBID& db, SliceArray& keys,
-			BitSetElementValueMap*& result, BitSetElementValueMap*& tmp)
-	{
-		/* Lookup keys, and store pointers to the string objects into an array. */
-		uint64 start_index = 0, end_index = 0;
-		for (uint32 j = 0; j < keys.size(); j++)
-		{
-			BitSetMetaValue meta;
-			GetBitSetMetaValue(db, keys[j], meta);
-			if (0 != GetBitSetMetaValue(db, keys[j], meta))
-			{
-				return 0;
-			}
-			if (start_index == 0 || start_index > meta.min)
-			{
-				start_index = meta.min;
-			}
-			if (end_index == 0 || end_index > meta.max)
-			{
-				end_index = meta.max;
-			}
-		}
-		if (start_index > end_index)
-		{
-			return 0;
-		}
-		struct BitSetAndWalk: public WalkHandler
-		{
-				Ardb* z_db;
-				uint64 limit_index;
-				BitSetElementValueMap& cmp;
-				BitSetElementValueMap& res;
-				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
+				int ret = 0;
+				if (1 == matched)
 				{
-					BitSetKeyObject* bk = (BitSetKeyObject*) k;
-					BitSetElementValue element;
-					z_db->GetBitSetElementValue(*bk, element);
-					if (&res == &cmp)
+					if (count_only)
 					{
-						cmp[bk->index] = element;
-						return 0;
+						ret = handler->OnBitSetCount(target,
+						        first->element.bitcount);
 					}
-					BitSetElementValueMap::iterator found = cmp.find(bk->index);
-					if (found != cmp.end())
+					else if (first->element.bitcount > 0)
 					{
-						BitSetElementValue result;
-						BitSetElementOp(BITOP_AND, found->second, element,
-								result);
-						res[bk->index] = result;
+						ret = handler->OnBitSetElement(target, first->element);
 					}
-					if (bk->index == limit_index)
+					first->Next();
+				}
+				else
+				{
+					parts.clear();
+					for (uint32 i = 0; i < cursors.size(); i++)
 					{
-						return -1;
+						if (cursors[i]->valid && cursors[i]->index == target)
+						{
+							parts.push_back(cursors[i]);
+						}
+					}
+					if (count_only)
+					{
+						ret = handler->OnBitSetCount(target,
+						        CombineChunks(kop, parts, acc, tmp, true));
+					}
+					else
+					{
+						CombineChunks(kop, parts, acc, tmp, false);
+						result.FromBitmap(acc);
+						if (result.bitcount > 0)
+						{
+							ret = handler->OnBitSetElement(target, result);
+						}
+					}
+					for (uint32 i = 0; i < parts.size(); i++)
+					{
+						parts[i]->Next();
 					}
-					return 0;
 				}
-				BitSetAndWalk(Ardb* db, uint64 l, BitSetElementValueMap& c,
-						BitSetElementValueMap& r) :
-						z_db(db), limit_index(l), cmp(c), res(r)
+				if (ret < 0)
 				{
+					break;
 				}
-		};
-
-		BitSetElementValueMap* tmpres = result;
-		BitSetElementValueMap* tmpcmp = tmp;
-		BitSetAndWalk firstWalk(this, end_index, *tmpcmp, *tmpcmp);
-		BitSetKeyObject sk(keys[0], start_index, db);
-		Walk(sk, false, &firstWalk);
-		for (uint32 i = 1; i < keys.size(); i++)
-		{
-			BitSetKeyObject setk(keys[i], start_index, db);
-			BitSetAndWalk walk(this, end_index, *tmpcmp, *tmpres);
-			Walk(setk, false, &walk);
-			if (i != keys.size() - 1)
-			{
-				BitSetElementValueMap* ptmp = tmpres;
-				tmpres = tmpcmp;
-				tmpcmp = ptmp;
-				tmpcmp->clear();
 			}
 		}
-		result = tmpres;
-		tmp->clear();
+		for (uint32 i = 0; i < cursors.size(); i++)
+		{
+			DELETE(cursors[i]);
+		}
 		return 0;
 	}
 
-	int Ardb::BitsNot(const DBID& db, const Slice& key,
-			BitSetElementValueMap*& result)
+	int Ardb::BitOP(const DBID& db, const Slice& opstr, const Slice& dstkey,
+			SliceArray& keys)
 	{
-		struct BitSetNotWalk: public WalkHandler
+		struct BitSetWriteHandler: public BitSetElementHandler
 		{
 				Ardb* z_db;
-				BitSetElementValueMap& res;
+				DBID z_dbid;
+				const Slice& z_key;
+				BitSetMetaValue meta;
+				std::vector<uint64> indexes;
+				int OnBitSetElement(uint64 index, BitSetElementValue& element)
+				{
+					BitSetKeyObject k(z_key, index, z_dbid);
+					z_db->SetBitSetElementValue(k, element);
+					meta.bitcount += element.bitcount;
+					if (meta.min == 0)
+					{
+						meta.min = index;
+					}
+					meta.max = index;
+					indexes.push_back(index);
+					return 0;
+				}
+				BitSetWriteHandler(Ardb* db, DBID id, const Slice& key) :
+						z_db(db), z_dbid(id), z_key(key)
+				{
+				}
+		} handler(this, db, dstkey);
+		/*
+		 * Chunks of the old value which are not overwritten are deleted
+		 * afterwards, so the destination may also be a source.
+		 */
+		struct BitSetStaleWalk: public WalkHandler
+		{
+				Ardb* z_db;
+				std::vector<uint64>& z_indexes;
 				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
 				{
 					BitSetKeyObject* bk = (BitSetKeyObject*) k;
-					BitSetElementValue element;
-					z_db->GetBitSetElementValue(*bk, element);
-					BitSetElementOp(BITOP_NOT, element, element, element);
-					if (element.bitcount > 0)
+					if (!std::binary_search(z_indexes.begin(), z_indexes.end(),
+					        bk->index))
 					{
-						res[bk->index] = element;
+						z_db->DelValue(*bk);
 					}
 					return 0;
 				}
-				BitSetNotWalk(Ardb* db, BitSetElementValueMap& r) :
-						z_db(db), res(r)
+				BitSetStaleWalk(Ardb* db, std::vector<uint64>& indexes) :
+						z_db(db), z_indexes(indexes)
 				{
 				}
 		};
-		BitSetKeyObject sk(key, 1, db);
-		BitSetNotWalk walk(this, *result);
-		Walk(sk, false, &walk);
-		return 0;
-	}
-	int Ardb::BitOP(const DBID& db, const Slice& opstr, SliceArray& keys,
-			BitSetElementValueMap*& res, BitSetElementValueMap*& tmp)
-	{
+		/*
+		 * Reject a bad operation before anything is written, discarding a
+		 * batch would also drop the writes of a group commit.
+		 */
 		unsigned long op;
-		/* Parse the operation name. */
-		if (!strncasecmp(opstr.data(), "and", opstr.size()))
-			op = BITOP_AND;
-		else if (!strncasecmp(opstr.data(), "or", opstr.size()))
-			op = BITOP_OR;
-		else if (!strncasecmp(opstr.data(), "xor", opstr.size()))
-			op = BITOP_XOR;
-		else if (!strncasecmp(opstr.data(), "not", opstr.size()))
-			op = BITOP_NOT;
-		else
+		if (0 != ParseBitOP(opstr, keys.size(), op))
 		{
-			return ERR_INVALID_OPERATION;
+			return -1;
 		}
-
-		/* Sanity check: NOT accepts only a single key argument. */
-		if (op == BITOP_NOT && keys.size() != 1)
+		KeyLockerGuard keyguard(m_key_locker, db, dstkey);
+		BatchWriteGuard guard(GetEngine());
+		BitOP(db, opstr, keys, &handler);
+		BitSetStaleWalk walk(this, handler.indexes);
+		BitSetKeyObject bk(dstkey, 1, db);
+		Walk(bk, false, &walk);
+		if (handler.meta.bitcount > 0)
 		{
-			SetErrorCause("BITOP NOT must be called with a single source key.");
-			return ERR_INVALID_OPERATION;
+			SetBitSetMetaValue(db, dstkey, handler.meta);
 		}
-		switch (op)
+		else
 		{
-			case BITOP_AND:
-			{
-				BitsAnd(db, keys, res, tmp);
-				break;
-			}
-			case BITOP_OR:
-			{
-				BitsOr(db, keys, res, false);
-				break;
-			}
-			case BITOP_XOR:
-			{
-				BitsOr(db, keys, res, true);
-				break;
-			}
-			case BITOP_NOT:
-			{
-				BitsNot(db, keys[0], res);
-				break;
-			}
-			default:
-			{
-				return -1;
-			}
+			KeyObject k(dstkey, BITSET_META, db);
+			DelValue(k);
 		}
-		return 0;
+		return handler.meta.bitcount;
 	}
 
-	int Ardb::BitOP(const DBID& db, const Slice& opstr, const Slice& dstkey,
-			SliceArray& keys)
+	int64 Ardb::BitOPCount(const DBID& db, const Slice& opstr, SliceArray& keys)
 	{
-		BitSetElementValueMap map1, map2;
-		BitSetElementValueMap* res = &map1;
-		BitSetElementValueMap* tmp = &map2;
-		if (0 != BitOP(db, opstr, keys, res, tmp))
-		{
-			return -1;
-		}
-		BitClear(db, dstkey);
-		KeyLockerGuard keyguard(m_key_locker, db, dstkey);
-		BitSetMetaValue meta;
-		if (!res->empty())
+		struct BitSetCountHandler: public BitSetElementHandler
 		{
-			BatchWriteGuard guard(GetEngine());
-
-			BitSetElementValueMap::iterator it = res->begin();
-			while (it != res->end())
-			{
-				BitSetKeyObject sk(dstkey, it->first, db);
-				SetBitSetElementValue(sk, it->second);
-				meta.bitcount += it->second.bitcount;
-				if (it == res->begin())
+				int64 count;
+				bool CountOnly()
 				{
-					meta.min = it->first;
+					return true;
 				}
-				meta.max = it->first;
-				it++;
-			}
-			SetBitSetMetaValue(db, dstkey, meta);
-		}
-		return meta.bitcount;
-	}
-
-	int64 Ardb::BitOPCount(const DBID& db, const Slice& opstr, SliceArray& keys)
-	{
-		BitSetElementValueMap map1, map2;
-		BitSetElementValueMap* res = &map1;
-		BitSetElementValueMap* tmp = &map2;
-		if (0 != BitOP(db, opstr, keys, res, tmp))
+				int OnBitSetElement(uint64 index, BitSetElementValue& element)
+				{
+					count += element.bitcount;
+					return 0;
+				}
+				int OnBitSetCount(uint64 index, uint32 n)
+				{
+					count += n;
+					return 0;
+				}
+				BitSetCountHandler() :
+						count(0)
+				{
+				}
+		} handler;
+		if (0 != BitOP(db, opstr, keys, &handler))
 		{
 			return 0;
 		}
-		int64 count = 0;
-		BitSetElementValueMap::iterator it = res->begin();
-		while (it != res->end())
-		{
-			count += it->second.bitcount;
-			it++;
-		}
-		return count;
+		return handler.count;
 	}
 
 	int Ardb::BitCount(const DBID& db, const Slice& key, int64 start, int64 end)
@@ -713,89 +1104,30 @@ namespace ardb
 		}
 		uint64 startIndex = (start / BIT_SUBSET_SIZE) + 1;
 		uint64 endIndex = (end / BIT_SUBSET_SIZE) + 1;
-		uint32 so = start % BIT_SUBSET_SIZE;
-		uint32 eo = end % BIT_SUBSET_SIZE;
+		uint64 inside = endIndex - startIndex + 1;
+		uint64 outside = (startIndex > meta.min ? startIndex - meta.min : 0)
+		        + (meta.max > endIndex ? meta.max - endIndex : 0) + 2;
+		if (outside < inside)
+		{
+			/*
+			 * Fewer chunks lie outside of the range, count those bits.
+			 */
+			uint64 before = 0;
+			if (start > 0)
+			{
+				BitSetKeyObject sk(key, meta.min, db);
+				BitSetChunkCursor cursor(FindValue(sk), sk);
+				before = CountBitRange(cursor, 0, start - 1);
+			}
+			BitSetKeyObject ek(key, endIndex, db);
+			BitSetChunkCursor cursor(FindValue(ek), ek);
+			uint64 after = CountBitRange(cursor, end + 1,
+			        meta.max * BIT_SUBSET_SIZE - 1);
+			return meta.bitcount - before - after;
+		}
 		BitSetKeyObject sk(key, startIndex, db);
-		struct BitSetWalk: public WalkHandler
-		{
-				Ardb* bdb;
-				uint32 count;
-				uint64 si;
-				uint64 ei;
-				uint32 so;
-				uint32 eo;
-				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
-				{
-					BitSetKeyObject* bk = (BitSetKeyObject*) k;
-					BitSetElementValue element;
-					bdb->GetBitSetElementValue(*bk, element);
-					if (bk->index > si && bk->index < ei)
-					{
-						count += element.bitcount;
-					} else
-					{
-						uint32 st = 0, et = 0;
-						if (si == ei)
-						{
-							st = so;
-							et = eo;
-						} else
-						{
-							if (bk->index == si)
-							{
-								st = so;
-								et = element.limit - 1;
-							} else
-							{
-								st = element.start - 1;
-								et = eo;
-							}
-						}
-						if (element.start >= (st + 1)
-								&& element.limit <= (et + 1))
-						{
-							count += element.bitcount;
-						} else if (element.limit < st + 1
-								|| element.start > (et + 1))
-						{
-							//do nothing
-						} else
-						{
-							while (st % 8 != 0 && st <= et)
-							{
-								count += bdb->GetBit(bk->db, bk->key, st);
-								st++;
-							}
-							if (st < et)
-							{
-								while (et % 8 != 0 && et > st)
-								{
-									count += bdb->GetBit(bk->db, bk->key, et);
-									et--;
-								}
-							}
-							if (et > st)
-							{
-								uint32 s = st >> 3;
-								uint32 e = et >> 3;
-								count += popcount(element.vals.c_str() + s,
-										e - s);
-							}
-						}
-					}
-					if (bk->index == ei)
-					{
-						return -1;
-					}
-					return 0;
-				}
-				BitSetWalk(Ardb* dbi, uint64 s, uint64 e, uint32 ss, uint32 ee) :
-						bdb(dbi), count(0), si(s), ei(e), so(ss), eo(ee)
-				{
-				}
-		} walk(this, startIndex, endIndex, so, eo);
-		Walk(sk, false, &walk);
-		return walk.count;
+		BitSetChunkCursor cursor(FindValue(sk), sk);
+		return CountBitRange(cursor, start, end);
 	}
 
 	int Ardb::BitClear(const DBID& db, const Slice& key)
@@ -827,5 +1159,57 @@ namespace ardb
 		DelValue(k);
 		return 0;
 	}
-}
 
+	/*
+	 * Rewrite the bitset chunks of data format version 5 and older in the
+	 * compressed form.
+	 */
+	int Ardb::RebuildBitSets()
+	{
+		static const uint32 kBatchSize = 1024;
+		uint64 count = 0, before = 0, after = 0;
+		Iterator* iter = GetEngine()->Find(Slice(), false);
+		GetEngine()->BeginBatchWrite();
+		while (NULL != iter && iter->Valid())
+		{
+			DBID db;
+			KeyType type;
+			ValueObject v;
+			BitSetElementValue element;
+			Buffer readbuf(const_cast<char*>(iter->Value().data()), 0,
+			        iter->Value().size());
+			if (peek_dbkey_header(iter->Key(), db, type)
+			        && type == BITSET_ELEMENT && decode_value(readbuf, v, false)
+			        && DecodeLegacySetElementData(v, element))
+			{
+				before += iter->Value().size();
+				if (element.bitcount > 0)
+				{
+					ValueObject nv;
+					EncodeSetElementData(nv, element);
+					Buffer valuebuf;
+					encode_value(valuebuf, nv);
+					RawSet(iter->Key(),
+					        Slice(valuebuf.GetRawReadBuffer(),
+					                valuebuf.ReadableBytes()));
+					after += valuebuf.ReadableBytes();
+				}
+				else
+				{
+					RawDel(iter->Key());
+				}
+				count++;
+				if (count % kBatchSize == 0)
+				{
+					GetEngine()->CommitBatchWrite();
+					GetEngine()->BeginBatchWrite();
+				}
+			}
+			iter->Next();
+		}
+		GetEngine()->CommitBatchWrite();
+		DELETE(iter);
+		INFO_LOG("Converted %"PRIu64" bitset chunks from %"PRIu64" to %"PRIu64" bytes.", count, before, after);
+		return 0;
+	}
+}
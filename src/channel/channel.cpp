@@ -28,6 +28,7 @@
  */
 
 #include "channel/all_includes.hpp"
+#include <limits.h>
 
 using namespace ardb;
 
@@ -58,7 +59,8 @@ Channel::Channel(Channel* parent, ChannelService& service) :
 		        &service), m_id(0), m_fd(-1), m_flush_timertask_id(-1), m_pipeline_initializor(
 		        NULL), m_pipeline_initailizor_user_data(NULL), m_pipeline_finallizer(
 		        NULL), m_pipeline_finallizer_user_data(NULL), m_detached(false), m_writable(
-		        true), m_close_after_write(false)
+		        true), m_close_after_write(false), m_corked(false), m_close_after_uncork(
+		        false)
 {
 
 	if (kChannelIDSeed == MAX_CHANNEL_ID)
@@ -279,6 +281,16 @@ int32 Channel::WriteNow(Buffer* buffer)
 	uint32 buf_len = NULL != buffer ? buffer->ReadableBytes() : 0;
 	//TRACE_LOG(
 	//        "Write %u bytes for channel:channel id %u & type:%u", buf_len, GetID(), GetID() & 0xf);
+	if (m_close_after_write || m_close_after_uncork)
+	{
+		//closing, nothing more goes out after what is already queued
+		return 0;
+	}
+	if (m_corked)
+	{
+		m_corkBuffer.Write(buffer, buf_len);
+		return buf_len;
+	}
 	if (m_outputBuffer.Readable())
 	{
 		if (m_options.max_write_buffer_size > 0) //write buffer size limit enable
@@ -346,6 +358,61 @@ int32 Channel::WriteNow(Buffer* buffer)
 	}
 }
 
+int32 Channel::WriteVector(const struct iovec* vec, int count)
+{
+	if (m_close_after_write || m_close_after_uncork)
+	{
+		//closing, nothing more goes out after what is already queued
+		return 0;
+	}
+	size_t total = 0;
+	for (int i = 0; i < count; i++)
+	{
+		total += vec[i].iov_len;
+	}
+	if (m_outputBuffer.Readable() || total < m_options.user_write_buffer_water_mark
+	        || !m_writable || m_corked)
+	{
+		Buffer buffer(total);
+		for (int i = 0; i < count; i++)
+		{
+			buffer.Write(vec[i].iov_base, vec[i].iov_len);
+		}
+		return WriteNow(&buffer);
+	}
+	ssize_t ret = ::writev(GetWriteFD(), vec, count > IOV_MAX ? IOV_MAX : count);
+	if (ret < 0)
+	{
+		int err = errno;
+		if (!IO_ERR_RW_RETRIABLE(err))
+		{
+			return HandleIOError(err);
+		}
+		ret = 0;
+	}
+	else if (ret == 0 && total > 0)
+	{
+		return HandleExceptionEvent(CHANNEL_EVENT_EOF);
+	}
+	size_t skip = ret;
+	for (int i = 0; i < count; i++)
+	{
+		if (skip >= vec[i].iov_len)
+		{
+			skip -= vec[i].iov_len;
+			continue;
+		}
+		m_outputBuffer.Write((const char*) vec[i].iov_base + skip,
+		        vec[i].iov_len - skip);
+		skip = 0;
+	}
+	if (m_outputBuffer.Readable())
+	{
+		EnableWriting();
+	}
+	return total;
+}
+
 bool Channel::DoConfigure(const ChannelOptions& options)
 {
 	if (options.user_write_buffer_water_mark > 0)
@@ -506,6 +573,31 @@ bool Channel::Connect(Address* remote)
 	return DoConnect(remote);
 }
 
+void Channel::Cork()
+{
+	m_corked = true;
+}
+
+void Channel::Uncork(bool discard)
+{
+	if (!m_corked)
+	{
+		return;
+	}
+	m_corked = false;
+	bool close = m_close_after_uncork;
+	m_close_after_uncork = false;
+	if (!discard && m_corkBuffer.Readable() && GetWriteFD() > 0)
+	{
+		WriteNow(&m_corkBuffer);
+	}
+	m_corkBuffer.Clear();
+	if (close)
+	{
+		Close();
+	}
+}
+
 bool Channel::Flush()
 {
 	if (!m_writable)
@@ -558,6 +650,12 @@ bool Channel::DoClose(bool inDestructor)
 
 bool Channel::Close()
 {
+	if (m_corked)
+	{
+		//the corked replies may still be dropped, Uncork closes
+		m_close_after_uncork = true;
+		return true;
+	}
 	if (m_outputBuffer.Readable() && GetWriteFD() > 0)
 	{
 		EnableWriting();
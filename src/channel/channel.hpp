@@ -35,6 +35,7 @@
 #include "channel/channel_pipeline.hpp"
 #include "util/helpers.hpp"
 #include <map>
+#include <sys/uio.h>
 
 /* delayed ack (quick_ack) */
 #ifndef HAVE_TCP_QUICKACK
@@ -143,6 +144,7 @@ namespace ardb
 			int m_fd;
 			Buffer m_inputBuffer;
 			Buffer m_outputBuffer;
+			Buffer m_corkBuffer;
 			int32 m_flush_timertask_id;
 			ChannelPipelineInitializer* m_pipeline_initializor;
 			void* m_pipeline_initailizor_user_data;
@@ -151,6 +153,8 @@ namespace ardb
 			bool m_detached;
 			bool m_writable;
 			bool m_close_after_write;
+			bool m_corked;
+			bool m_close_after_uncork;
 
 			Channel(Channel* parent, ChannelService& factory);
 
@@ -292,6 +296,19 @@ namespace ardb
 			}
 
 			bool Flush();
+			/*
+			 * Write the pieces straight from the caller's memory with one
+			 * writev, only what the socket does not take is copied into the
+			 * output buffer.
+			 */
+			int32 WriteVector(const struct iovec* vec, int count);
+			/*
+			 * While corked everything written is held back, Uncork sends
+			 * it in one go or drops it if 'discard' is set. A Close while
+			 * corked takes effect on Uncork.
+			 */
+			void Cork();
+			void Uncork(bool discard = false);
 			virtual const Address* GetLocalAddress()
 			{
 				return NULL;
@@ -32,6 +32,7 @@
 
 #include <deque>
 #include <string>
+#include <algorithm>
 
 namespace ardb
 {
@@ -60,6 +61,25 @@ namespace ardb
 						m_cmd_seted = true;
 					}
 				}
+				inline std::string& NextArgument(size_t len)
+				{
+					std::string* arg = &m_cmd;
+					if (m_cmd_seted)
+					{
+						m_args.push_back(std::string());
+						arg = &(m_args.back());
+					}
+					m_cmd_seted = true;
+					arg->reserve(len);
+					return *arg;
+				}
+				inline void Swap(RedisCommandFrame& other)
+				{
+					std::swap(m_is_inline, other.m_is_inline);
+					std::swap(m_cmd_seted, other.m_cmd_seted);
+					m_cmd.swap(other.m_cmd);
+					m_args.swap(other.m_args);
+				}
 				friend class RedisCommandDecoder;
 			public:
 				RedisCommandFrame() :
@@ -42,8 +42,8 @@ static const uint32 REDIS_REQ_INLINE = 1;
 static const uint32 REDIS_REQ_MULTIBULK = 2;
 static const char* kCRLF = "\r\n";
 
-int RedisCommandDecoder::ProcessInlineBuffer(ChannelHandlerContext& ctx,
-		Buffer& buffer, RedisCommandFrame& frame)
+int RedisCommandDecoder::ProcessInlineBuffer(Buffer& buffer,
+		RedisCommandFrame& frame)
 {
 	int index = buffer.IndexOf(kCRLF, 2);
 	if (-1 == index)
@@ -85,121 +85,163 @@ int RedisCommandDecoder::ProcessInlineBuffer(ChannelHandlerContext& ctx,
 	return 1;
 }
 
-int RedisCommandDecoder::ProcessMultibulkBuffer(ChannelHandlerContext& ctx,
-		Buffer& buffer, RedisCommandFrame& frame)
+/*
+ * Read the number of a "*<count>\r\n" or "$<len>\r\n" line, 0 if the line
+ * is not complete yet.
+ */
+static int read_request_number(Buffer& buffer, char type, int64& v)
 {
 	int index = buffer.IndexOf(kCRLF, 2);
 	if (-1 == index)
 	{
 		return 0;
 	}
-	char *eptr = NULL;
 	const char* raw = buffer.GetRawReadBuffer();
-	uint32 multibulklen = strtol(raw, &eptr, 10);
-	if (multibulklen <= 0)
-	{
-		buffer.SetReadIndex(index + 2);
-		return 1;
-	} else if (multibulklen > 1024 * 1024)
+	if (raw[0] != type
+			|| !raw_toint64(raw + 1, index - buffer.GetReadIndex() - 1, v))
 	{
-		APIException ex("Protocol error: invalid multibulk length");
-		fire_exception_caught(ctx.GetChannel(), ex);
 		return -1;
 	}
 	buffer.SetReadIndex(index + 2);
-	while (multibulklen > 0)
+	return 1;
+}
+
+int RedisCommandDecoder::ProcessMultibulkBuffer(Buffer& buffer,
+		RedisCommandFrame& frame)
+{
+	if (0 == m_multibulk_len)
 	{
-		int newline_index = buffer.IndexOf(kCRLF, 2);
-		if (-1 == newline_index)
+		int64 multibulklen;
+		int ret = read_request_number(buffer, '*', multibulklen);
+		if (ret <= 0)
 		{
-			return 0;
-		}
-		char ch;
-		if (!buffer.ReadByte(ch))
-		{
-			return 0;
+			m_error = "Protocol error: invalid multibulk length";
+			return ret;
 		}
-		if (ch != '$')
+		if (multibulklen > 1024 * 1024)
 		{
-			char temp[100];
-			sprintf(temp, "Protocol error: expected '$', , got '%c'", ch);
-			APIException ex(temp);
-			fire_exception_caught(ctx.GetChannel(), ex);
+			m_error = "Protocol error: invalid multibulk length";
 			return -1;
 		}
-		if (!buffer.Readable())
+		if (multibulklen <= 0)
 		{
-			return 0;
-		}
-		const char* raw = buffer.GetRawReadBuffer();
-		int32 arglen = (uint32) strtol(raw, &eptr, 10);
-		if (eptr[0] != '\r' || arglen < 0 || arglen > 512 * 1024 * 1024)
-		{
-			APIException ex("Protocol error: invalid bulk length");
-			fire_exception_caught(ctx.GetChannel(), ex);
-			return -1;
+			//an empty request, the frame is left without a command
+			return 1;
 		}
-		buffer.SetReadIndex(newline_index + 2);
-		if (!buffer.Readable())
+		m_multibulk_len = multibulklen;
+		m_bulk_len = -1;
+	}
+	while (m_multibulk_len > 0)
+	{
+		if (m_bulk_len < 0)
 		{
-			return 0;
+			if (!buffer.Readable())
+			{
+				return 0;
+			}
+			if (buffer.GetRawReadBuffer()[0] != '$')
+			{
+				char temp[100];
+				sprintf(temp, "Protocol error: expected '$', got '%c'",
+						buffer.GetRawReadBuffer()[0]);
+				m_error = temp;
+				return -1;
+			}
+			int64 arglen;
+			int ret = read_request_number(buffer, '$', arglen);
+			if (ret <= 0 || arglen < 0 || arglen > 512 * 1024 * 1024)
+			{
+				m_error = "Protocol error: invalid bulk length";
+				return ret == 0 ? 0 : -1;
+			}
+			m_bulk_len = arglen;
+			m_arg = &(frame.NextArgument(arglen));
 		}
-		if (buffer.ReadableBytes() < (uint32) (arglen + 2))
+		/*
+		 * Bulk data goes straight into the argument, nothing is parsed twice
+		 * however many reads it takes to arrive.
+		 */
+		size_t need = m_bulk_len - m_arg->size();
+		size_t len = buffer.ReadableBytes() < need ? buffer.ReadableBytes() : need;
+		m_arg->append(buffer.GetRawReadBuffer(), len);
+		buffer.AdvanceReadIndex(len);
+		if (m_arg->size() < (size_t) m_bulk_len || buffer.ReadableBytes() < 2)
 		{
 			return 0;
 		}
-		frame.FillNextArgument(buffer, arglen);
-		//Buffer* arg = frame.GetNextArgument(arglen);
-		//buffer.Read(arg, arglen);
 		char tempchs[2];
 		buffer.Read(tempchs, 2);
 		if (tempchs[0] != '\r' || tempchs[1] != '\n')
 		{
-			APIException ex("CRLF expected after argument.");
-			fire_exception_caught(ctx.GetChannel(), ex);
+			m_error = "CRLF expected after argument.";
 			return -1;
 		}
-		//buffer.AdvanceReadIndex(arglen + 2);
-		multibulklen--;
+		m_bulk_len = -1;
+		m_arg = NULL;
+		m_multibulk_len--;
 	}
 	return 1;
 }
 
-bool RedisCommandDecoder::Decode(ChannelHandlerContext& ctx, Channel* channel,
-		Buffer& buffer, RedisCommandFrame& msg)
+void RedisCommandDecoder::Reset()
 {
-	//int reqtype = -1;
-	size_t mark_read_index = buffer.GetReadIndex();
-	char ch;
-	if (buffer.ReadByte(ch))
+	m_frame.Clear();
+	m_multibulk_len = 0;
+	m_bulk_len = -1;
+	m_arg = NULL;
+}
+
+int RedisCommandDecoder::DecodeRequest(Buffer& buffer, RedisCommandFrame& msg)
+{
+	while (true)
 	{
-		int ret = -1;
-		if (ch == '*')
-		{
-			//reqtype = REDIS_REQ_MULTIBULK;
-			msg.m_is_inline = false;
-			ret = ProcessMultibulkBuffer(ctx, buffer, msg);
-		} else
+		if (0 == m_multibulk_len && buffer.Readable()
+				&& buffer.GetRawReadBuffer()[0] != '*')
 		{
-			//reqtype = REDIS_REQ_INLINE;
+			size_t mark_read_index = buffer.GetReadIndex();
 			msg.m_is_inline = true;
-			buffer.AdvanceReadIndex(-1);
-			ret = ProcessInlineBuffer(ctx, buffer, msg);
+			int ret = ProcessInlineBuffer(buffer, msg);
+			if (ret <= 0)
+			{
+				msg.Clear();
+				buffer.SetReadIndex(mark_read_index);
+			}
+			return ret;
+		}
+		m_frame.m_is_inline = false;
+		int ret = ProcessMultibulkBuffer(buffer, m_frame);
+		if (ret > 0 && !m_frame.m_cmd_seted)
+		{
+			/*
+			 * Empty "*0" requests are skipped like redis does, the next
+			 * request may be complete already.
+			 */
+			continue;
 		}
 		if (ret > 0)
 		{
-			return true;
-		} else
+			msg.Swap(m_frame);
+			Reset();
+		}
+		else if (ret < 0)
 		{
-			msg.Clear();
-			if (0 == ret)
-			{
-				buffer.SetReadIndex(mark_read_index);
-			}
-			return false;
+			Reset();
 		}
+		return ret;
 	}
-	return false;
+}
+
+bool RedisCommandDecoder::Decode(ChannelHandlerContext& ctx, Channel* channel,
+		Buffer& buffer, RedisCommandFrame& msg)
+{
+	int ret = DecodeRequest(buffer, msg);
+	if (ret < 0)
+	{
+		buffer.SetReadIndex(buffer.GetWriteIndex());
+		APIException ex(m_error, 0);
+		fire_exception_caught(ctx.GetChannel(), ex);
+	}
+	return ret > 0;
 }
 
 //===================================encoder==============================
@@ -38,18 +38,40 @@ namespace ardb
 {
 	namespace codec
 	{
+		/*
+		 * Multibulk requests are parsed incrementally, the decoder keeps the
+		 * request in progress between reads so every byte is parsed once.
+		 */
 		class RedisCommandDecoder: public StackFrameDecoder<RedisCommandFrame>
 		{
+			private:
+				RedisCommandFrame m_frame;
+				int64 m_multibulk_len;
+				int64 m_bulk_len;
+				std::string* m_arg;
+				std::string m_error;
 			protected:
-				int ProcessInlineBuffer(ChannelHandlerContext& ctx,
-				        Buffer& buffer, RedisCommandFrame& frame);
-				int ProcessMultibulkBuffer(ChannelHandlerContext& ctx,
-				        Buffer& buffer, RedisCommandFrame& frame);
+				int ProcessInlineBuffer(Buffer& buffer,
+				        RedisCommandFrame& frame);
+				int ProcessMultibulkBuffer(Buffer& buffer,
+				        RedisCommandFrame& frame);
 				bool Decode(ChannelHandlerContext& ctx, Channel* channel,
 				        Buffer& buffer, RedisCommandFrame& msg);
 			public:
-				RedisCommandDecoder()
+				RedisCommandDecoder() :
+						m_multibulk_len(0), m_bulk_len(-1), m_arg(NULL)
+				{
+				}
+				/*
+				 * Consume the next request of 'buffer', 1 once 'msg' holds a
+				 * complete request, 0 if more data is needed and -1 on
+				 * protocol errors.
+				 */
+				int DecodeRequest(Buffer& buffer, RedisCommandFrame& msg);
+				void Reset();
+				const std::string& GetError()
 				{
+					return m_error;
 				}
 		};
 
@@ -32,6 +32,7 @@
 
 #include <deque>
 #include <string>
+#include <vector>
 
 #define REDIS_REPLY_STRING 1
 #define REDIS_REPLY_ARRAY 2
@@ -46,6 +47,21 @@ namespace ardb
 {
 	namespace codec
 	{
+		/*
+		 * An element of a flat array reply, a string is 'len' bytes of the
+		 * reply's arena at 'offset'.
+		 */
+		struct RedisReplyItem
+		{
+				int type;
+				uint32 len;
+				union
+				{
+						int64_t integer;
+						size_t offset;
+				};
+		};
+
 		struct RedisReply
 		{
 				int type;
@@ -53,6 +69,14 @@ namespace ardb
 				int64_t integer;
 				double double_value;
 				std::deque<RedisReply> elements;
+				/*
+				 * Big arrays are built flat instead of into 'elements': the
+				 * array header and its elements in wire order, with all
+				 * string bytes in one arena. Both keep their memory over
+				 * Clear(), so a reused reply stops allocating.
+				 */
+				std::vector<RedisReplyItem> items;
+				std::string arena;
 				RedisReply() :
 						type(0), integer(0), double_value(0)
 				{
@@ -70,6 +94,41 @@ namespace ardb
 						        0)
 				{
 				}
+				bool IsFlat() const
+				{
+					return type == REDIS_REPLY_ARRAY && !items.empty();
+				}
+				void ReserveFlat(size_t count, size_t bytes)
+				{
+					type = REDIS_REPLY_ARRAY;
+					items.reserve(items.size() + count + 1);
+					arena.reserve(arena.size() + bytes);
+				}
+				void AddFlatString(const char* data, size_t len)
+				{
+					RedisReplyItem item;
+					item.type = REDIS_REPLY_STRING;
+					item.len = len;
+					item.offset = arena.size();
+					arena.append(data, len);
+					AddFlatItem(item);
+				}
+				void AddFlatInteger(int64_t v)
+				{
+					RedisReplyItem item;
+					item.type = REDIS_REPLY_INTEGER;
+					item.len = 0;
+					item.integer = v;
+					AddFlatItem(item);
+				}
+				void AddFlatNil()
+				{
+					RedisReplyItem item;
+					item.type = REDIS_REPLY_NIL;
+					item.len = 0;
+					item.integer = 0;
+					AddFlatItem(item);
+				}
 				void Clear()
 				{
 					type = 0;
@@ -77,6 +136,36 @@ namespace ardb
 					double_value = 0;
 					str.clear();
 					elements.clear();
+					items.clear();
+					arena.clear();
+					/*
+					 * Do not let one huge reply pin its memory.
+					 */
+					if (arena.capacity() > kMaxKeptArena)
+					{
+						std::string().swap(arena);
+					}
+					if (items.capacity() > kMaxKeptItems)
+					{
+						std::vector<RedisReplyItem>().swap(items);
+					}
+				}
+			private:
+				static const size_t kMaxKeptArena = 64 * 1024;
+				static const size_t kMaxKeptItems = 4096;
+				void AddFlatItem(const RedisReplyItem& item)
+				{
+					if (items.empty())
+					{
+						type = REDIS_REPLY_ARRAY;
+						RedisReplyItem header;
+						header.type = REDIS_REPLY_ARRAY;
+						header.len = 0;
+						header.integer = 0;
+						items.push_back(header);
+					}
+					items.push_back(item);
+					items[0].len++;
 				}
 		};
 	}
@@ -31,58 +31,141 @@
 #include "util/buffer_helper.hpp"
 
 #include <limits.h>
+#include <algorithm>
 
 using ardb::BufferHelper;
 using namespace ardb::codec;
 using namespace ardb;
 
-bool RedisReplyEncoder::Encode(Buffer& buf, RedisReply& reply)
+/*
+ * Bulk strings below this size are cheaper to copy than to send as a
+ * separate iovec.
+ */
+static const size_t kRedisReplyRefMinSize = 4096;
+
+static void encode_reply_number(Buffer& buf, char type, int64 v)
+{
+	char tmp[32];
+	uint32 len = 0;
+	tmp[len++] = type;
+	uint64 u = v;
+	if (v < 0)
+	{
+		tmp[len++] = '-';
+		u = 0 - u;
+	}
+	len += fast_itoa(tmp + len, sizeof(tmp) - len, u);
+	tmp[len++] = '\r';
+	tmp[len++] = '\n';
+	buf.Write(tmp, len);
+}
+
+static void encode_reply_bulk(Buffer& buf, const char* data, size_t len,
+        RedisReplyPieceArray* pieces, size_t& mark)
+{
+	encode_reply_number(buf, '$', len);
+	if (NULL != pieces && len >= kRedisReplyRefMinSize)
+	{
+		RedisReplyPiece piece;
+		piece.data = NULL;
+		piece.offset = mark;
+		piece.len = buf.GetWriteIndex() - mark;
+		pieces->push_back(piece);
+		piece.data = data;
+		piece.offset = 0;
+		piece.len = len;
+		pieces->push_back(piece);
+		mark = buf.GetWriteIndex();
+	}
+	else
+	{
+		buf.Write(data, len);
+	}
+	buf.Write("\r\n", 2);
+}
+
+static void encode_flat_reply(Buffer& buf, RedisReply& reply,
+        RedisReplyPieceArray* pieces, size_t& mark)
 {
+	const char* arena = reply.arena.data();
+	for (size_t i = 0; i < reply.items.size(); i++)
+	{
+		const RedisReplyItem& item = reply.items[i];
+		switch (item.type)
+		{
+			case REDIS_REPLY_STRING:
+			{
+				encode_reply_bulk(buf, arena + item.offset, item.len, pieces,
+				        mark);
+				break;
+			}
+			case REDIS_REPLY_INTEGER:
+			{
+				encode_reply_number(buf, ':', item.integer);
+				break;
+			}
+			case REDIS_REPLY_NIL:
+			{
+				buf.Write("$-1\r\n", 5);
+				break;
+			}
+			default:
+			{
+				encode_reply_number(buf, '*', item.len);
+				break;
+			}
+		}
+	}
+}
+
+static bool encode_reply(Buffer& buf, RedisReply& reply,
+        RedisReplyPieceArray* pieces, size_t& mark)
+{
+	if (reply.IsFlat())
+	{
+		encode_flat_reply(buf, reply, pieces, mark);
+		return true;
+	}
 	switch (reply.type)
 	{
 		case REDIS_REPLY_NIL:
 		{
-			buf.Printf("$-1\r\n");
+			buf.Write("$-1\r\n", 5);
 			break;
 		}
 		case REDIS_REPLY_STRING:
 		{
-			buf.Printf("$%d\r\n", reply.str.size());
-			if (reply.str.size() > 0)
-			{
-				buf.Printf("%s\r\n", reply.str.c_str());
-			}
-			else
-			{
-				buf.Printf("\r\n");
-			}
+			encode_reply_bulk(buf, reply.str.data(), reply.str.size(), pieces,
+			        mark);
 			break;
 		}
 		case REDIS_REPLY_ERROR:
 		{
-			buf.Printf("-%s\r\n", reply.str.c_str());
+			buf.WriteByte('-');
+			buf.Write(reply.str.data(), reply.str.size());
+			buf.Write("\r\n", 2);
 			break;
 		}
 		case REDIS_REPLY_INTEGER:
 		{
-			buf.Printf(":%lld\r\n", reply.integer);
+			encode_reply_number(buf, ':', reply.integer);
 			break;
 		}
 		case REDIS_REPLY_DOUBLE:
 		{
 			std::string doubleStrValue;
 			fast_dtoa(reply.double_value, 9, doubleStrValue);
-			buf.Printf("$%d\r\n", doubleStrValue.size());
-			buf.Printf("%s\r\n", doubleStrValue.c_str());
+			encode_reply_bulk(buf, doubleStrValue.data(), doubleStrValue.size(),
+			        NULL, mark);
 			break;
 		}
 		case REDIS_REPLY_ARRAY:
 		{
-			buf.Printf("*%d\r\n", reply.elements.size());
+			encode_reply_number(buf, '*', reply.elements.size());
 			size_t i = 0;
 			while (i < reply.elements.size())
 			{
-				if (!RedisReplyEncoder::Encode(buf, reply.elements[i]))
+				if (!encode_reply(buf, reply.elements[i], pieces, mark))
 				{
 					return false;
 				}
@@ -92,7 +175,9 @@ bool RedisReplyEncoder::Encode(Buffer& buf, RedisReply& reply)
 		}
 		case REDIS_REPLY_STATUS:
 		{
-			buf.Printf("+%s\r\n", reply.str.c_str());
+			buf.WriteByte('+');
+			buf.Write(reply.str.data(), reply.str.size());
+			buf.Write("\r\n", 2);
 			break;
 		}
 		default:
@@ -104,16 +189,67 @@ bool RedisReplyEncoder::Encode(Buffer& buf, RedisReply& reply)
 	return true;
 }
 
+bool RedisReplyEncoder::Encode(Buffer& buf, RedisReply& reply)
+{
+	return Encode(buf, reply, NULL);
+}
+
+bool RedisReplyEncoder::Encode(Buffer& buf, RedisReply& reply,
+        RedisReplyPieceArray* pieces)
+{
+	size_t mark = buf.GetWriteIndex();
+	if (!encode_reply(buf, reply, pieces, mark))
+	{
+		return false;
+	}
+	if (NULL != pieces && !pieces->empty() && buf.GetWriteIndex() > mark)
+	{
+		RedisReplyPiece piece;
+		piece.data = NULL;
+		piece.offset = mark;
+		piece.len = buf.GetWriteIndex() - mark;
+		pieces->push_back(piece);
+	}
+	return true;
+}
+
 bool RedisReplyEncoder::WriteRequested(ChannelHandlerContext& ctx,
         MessageEvent<RedisReply>& e)
 {
 	RedisReply* msg = e.GetMessage();
-	Buffer buffer(1024);
-	if (Encode(buffer, *msg))
+	/*
+	 * Size a flat reply's buffer up front, it is then encoded without
+	 * growing. Big bulks do not count, they are not copied.
+	 */
+	size_t size = 1024;
+	if (msg->IsFlat())
+	{
+		size += msg->items.size() * 16
+		        + std::min(msg->arena.size(), kRedisReplyRefMinSize * 16);
+	}
+	Buffer buffer(size);
+	RedisReplyPieceArray pieces;
+	if (!Encode(buffer, *msg, &pieces))
+	{
+		return false;
+	}
+	if (pieces.empty())
 	{
 		return ctx.GetChannel()->Write(buffer);
 	}
-	return false;
+	/*
+	 * Large bulk strings go out from the reply itself.
+	 */
+	std::vector<struct iovec> vec(pieces.size());
+	for (size_t i = 0; i < pieces.size(); i++)
+	{
+		const char* data =
+		        NULL != pieces[i].data ?
+		                pieces[i].data : buffer.GetRawBuffer() + pieces[i].offset;
+		vec[i].iov_base = const_cast<char*>(data);
+		vec[i].iov_len = pieces[i].len;
+	}
+	return ctx.GetChannel()->WriteVector(&vec[0], vec.size()) >= 0;
 }
 
 //==================================Decoder==========================================
@@ -32,6 +32,7 @@
 #include "channel/all_includes.hpp"
 #include <deque>
 #include <string>
+#include <vector>
 #include "redis_reply.hpp"
 
 namespace ardb
@@ -49,6 +50,18 @@ namespace ardb
 				}
 		};
 
+		/*
+		 * A piece of an encoded reply, either 'len' bytes of the encode
+		 * buffer at 'offset' or a bulk string of the reply itself.
+		 */
+		struct RedisReplyPiece
+		{
+				const char* data;
+				size_t offset;
+				size_t len;
+		};
+		typedef std::vector<RedisReplyPiece> RedisReplyPieceArray;
+
 		class RedisReplyEncoder: public ChannelDownstreamHandler<RedisReply>
 		{
 			private:
@@ -56,6 +69,13 @@ namespace ardb
 						MessageEvent<RedisReply>& e);
 			public:
 				static bool Encode(Buffer& buf, RedisReply& reply);
+				/*
+				 * Bulk strings of at least kRedisReplyRefMinSize bytes are
+				 * left in the reply and listed in 'pieces' between the
+				 * encoded parts instead of being copied into 'buf'.
+				 */
+				static bool Encode(Buffer& buf, RedisReply& reply,
+						RedisReplyPieceArray* pieces);
 		};
 
 		class NullRedisReplyEncoder: public ChannelDownstreamHandler<RedisReply>
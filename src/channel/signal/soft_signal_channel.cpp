@@ -33,19 +33,13 @@
 #include <string.h>
 using namespace ardb;
 
+/*
+ * A pipe rather than an eventfd: an eventfd adds up the values written
+ * before the reader gets to them, which merges and corrupts soft signals
+ * fired by several threads at once. Pipe writes of 8 bytes are atomic.
+ */
 int EventFD::OpenNonBlock()
 {
-#if (HAVE_EVENTFD)
-    int ret = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
-    if (ret == -1)
-    {
-        int err = errno;
-        ERROR_LOG("Failed to create eventfd for signal channel:%s", strerror(err));
-        return -1;
-    }
-    write_fd = ret;
-    read_fd = ret;
-#else
     int pipefd[2];
     int ret = pipe(pipefd);
     if (ret == -1)
@@ -57,7 +51,6 @@ int EventFD::OpenNonBlock()
     write_fd = pipefd[1];
     ardb::make_fd_nonblocking(write_fd);
     ardb::make_fd_nonblocking(read_fd);
-#endif
     return 0;
 }
 
@@ -81,22 +74,16 @@ int EventFD::WriteEvent(uint64 ev)
 {
     if (write_fd > -1)
     {
-#if (HAVE_EVENTFD)
-        if (ev == 0xffffffffffffffffULL)
-        {
-            //Not allowed value.
-            ERROR_LOG(
-                    "EventFD:%llu is not allowed.", ev);
-            return -1;
-        }
-#endif
-        memcpy(_kWriteSigInfoBuf, &ev, sizeof(uint64));
+        /*
+         * Signals are fired from any thread, keep the buffer on the stack.
+         */
+        char buf[sizeof(uint64)];
+        memcpy(buf, &ev, sizeof(uint64));
         uint32 writed = 0;
         uint32 total = sizeof(uint64);
         while (writed < total)
         {
-            int ret = ::write(write_fd, _kWriteSigInfoBuf + writed,
-                    total - writed);
+            int ret = ::write(write_fd, buf + writed, total - writed);
             if (ret >= 0)
             {
                 writed += ret;
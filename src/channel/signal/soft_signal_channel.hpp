@@ -39,7 +39,6 @@ namespace ardb
 	{
 		private:
 			char _kReadSigInfoBuf[sizeof(uint64)];
-			char _kWriteSigInfoBuf[sizeof(uint64)];
 			uint32 m_readed_siginfo_len;
 		public:
 			int write_fd;
@@ -1,388 +1,827 @@
- /*
- *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
- *All rights reserved.
- * 
- *Redistribution and use in source and binary forms, with or without
- *modification, are permitted provided that the following conditions are met:
- * 
- *  * Redistributions of source code must retain the above copyright notice,
- *    this list of conditions and the following disclaimer.
- *  * Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- *  * Neither the name of Redis nor the names of its contributors may be used
- *    to endorse or promote products derived from this software without
- *    specific prior written permission.
- * 
- *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
- *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
- *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
- *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
- *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
- *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
- *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
- *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
- *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
- *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
- *THE POSSIBILITY OF SUCH DAMAGE.
- */
-
-#include "leveldb_engine.hpp"
-#include "ardb.hpp"
-#include "ardb_data.hpp"
-#include "comparator.hpp"
-#include "util/helpers.hpp"
-#include "leveldb/cache.h"
-#include "leveldb/filter_policy.h"
-#include <string.h>
-
-#define LEVELDB_SLICE(slice) leveldb::Slice(slice.data(), slice.size())
-#define ARDB_SLICE(slice) Slice(slice.data(), slice.size())
-
-namespace ardb
-{
-	int LevelDBComparator::Compare(const leveldb::Slice& a,
-			const leveldb::Slice& b) const
-	{
-		return ardb_compare_keys(a.data(), a.size(), b.data(), b.size());
-	}
-
-	void LevelDBComparator::FindShortestSeparator(std::string* start,
-			const leveldb::Slice& limit) const
-	{
-		Buffer ak_buf(const_cast<char*>(start->data()), 0, start->size());
-		Buffer bk_buf(const_cast<char*>(limit.data()), 0, limit.size());
-		if (!start->size() > 4 && limit.size() > 4)
-		{
-			uint32 aheader, bheader;
-			BufferHelper::ReadFixUInt32(ak_buf, aheader);
-			BufferHelper::ReadFixUInt32(bk_buf, bheader);
-			uint8 type1 = aheader & 0xFF;
-			uint8 type2 = bheader & 0xFF;
-			uint32 adb = aheader >> 8;
-			uint32 bdb = bheader >> 8;
-			assert(adb <= bdb);
-			if (adb < bdb || type1 < type2)
-			{
-				start->resize(4);
-				start->assign(limit.data(), 0, 4);
-			} else
-			{
-				uint32 akeysize = 0, bkeysize = 0;
-				assert(BufferHelper::ReadVarUInt32(ak_buf, akeysize));
-				assert(BufferHelper::ReadVarUInt32(bk_buf, bkeysize));
-				assert(akeysize <= bkeysize);
-				if (akeysize < bkeysize)
-				{
-					start->resize(ak_buf.GetReadIndex());
-					start->assign(limit.data(), ak_buf.GetReadIndex());
-				} else
-				{
-					size_t diff_index = ak_buf.GetReadIndex();
-					while ((diff_index < start->size()
-							&& diff_index < limit.size())
-							&& ((*start)[diff_index] == limit[diff_index]))
-					{
-						diff_index++;
-					}
-					if (diff_index >= start->size())
-					{
-						// Do not shorten if one string is a prefix of the other
-					} else
-					{
-						if (diff_index >= start->size() || limit.size())
-						{
-							return;
-						}
-						uint8_t diff_byte =
-								static_cast<uint8_t>((*start)[diff_index]);
-						if (diff_byte < static_cast<uint8_t>(0xff)
-								&& diff_byte + 1
-										< static_cast<uint8_t>(limit[diff_index]))
-						{
-							(*start)[diff_index]++;
-							start->resize(diff_index + 1);
-							assert(Compare(*start, limit) < 0);
-						}
-					}
-				}
-			}
-		}
-	}
-
-	void LevelDBComparator::FindShortSuccessor(std::string* key) const
-	{
-		if (key->size() >= 4)
-		{
-			Buffer ak_buf(const_cast<char*>(key->data()), 0, key->size());
-			uint32 aheader;
-			BufferHelper::ReadFixUInt32(ak_buf, aheader);
-			uint8 type = aheader & 0xFF;
-			uint32 adb = aheader >> 8;
-			aheader = (adb << 8) + (type + 1);
-			aheader = htonl(aheader);
-			key->resize(4);
-			key->assign((const char*) (&aheader), 4);
-		}
-	}
-
-	LevelDBEngineFactory::LevelDBEngineFactory(const Properties& props)
-	{
-		ParseConfig(props, m_cfg);
-
-	}
-
-	void LevelDBEngineFactory::ParseConfig(const Properties& props,
-			LevelDBConfig& cfg)
-	{
-		cfg.path = ".";
-		conf_get_string(props, "data-dir", cfg.path);
-		conf_get_int64(props, "leveldb.block_cache_size", cfg.block_cache_size);
-		conf_get_int64(props, "leveldb.write_buffer_size",
-				cfg.write_buffer_size);
-		conf_get_int64(props, "leveldb.max_open_files", cfg.max_open_files);
-		conf_get_int64(props, "leveldb.block_size", cfg.block_size);
-		conf_get_int64(props, "leveldb.block_restart_interval",
-				cfg.block_restart_interval);
-		conf_get_int64(props, "leveldb.bloom_bits", cfg.bloom_bits);
-		conf_get_int64(props, "leveldb.batch_commit_watermark",
-				cfg.batch_commit_watermark);
-	}
-
-	KeyValueEngine* LevelDBEngineFactory::CreateDB(const std::string& name)
-	{
-		LevelDBEngine* engine = new LevelDBEngine();
-		LevelDBConfig cfg = m_cfg;
-		char tmp[cfg.path.size() + name.size() + 10];
-		sprintf(tmp, "%s/%s", cfg.path.c_str(), name.c_str());
-		cfg.path = tmp;
-		if (engine->Init(cfg) != 0)
-		{
-			DELETE(engine);
-			ERROR_LOG("Failed to create DB:%s", name.c_str());
-			return NULL;
-		}
-		return engine;
-	}
-	void LevelDBEngineFactory::DestroyDB(KeyValueEngine* engine)
-	{
-		LevelDBEngine* leveldb = (LevelDBEngine*) engine;
-		std::string path = leveldb->m_db_path;
-		DELETE(engine);
-		leveldb::Options options;
-		leveldb::DestroyDB(path, options);
-	}
-
-	void LevelDBEngineFactory::CloseDB(KeyValueEngine* engine)
-	{
-		DELETE(engine);
-	}
-	void LevelDBIterator::SeekToFirst()
-	{
-		m_iter->SeekToFirst();
-	}
-	void LevelDBIterator::SeekToLast()
-	{
-		m_iter->SeekToLast();
-	}
-	void LevelDBIterator::Next()
-	{
-		m_iter->Next();
-	}
-	void LevelDBIterator::Prev()
-	{
-		m_iter->Prev();
-	}
-	Slice LevelDBIterator::Key() const
-	{
-		return ARDB_SLICE(m_iter->key());
-	}
-	Slice LevelDBIterator::Value() const
-	{
-		return ARDB_SLICE(m_iter->value());
-	}
-	bool LevelDBIterator::Valid()
-	{
-		return m_iter->Valid();
-	}
-
-	LevelDBEngine::LevelDBEngine() :
-			m_db(NULL)
-	{
-
-	}
-	LevelDBEngine::~LevelDBEngine()
-	{
-		DELETE(m_db);
-		DELETE(m_options.block_cache);
-		DELETE(m_options.filter_policy);
-	}
-	int LevelDBEngine::Init(const LevelDBConfig& cfg)
-	{
-		m_cfg = cfg;
-		m_options.create_if_missing = true;
-		m_options.comparator = &m_comparator;
-		if (cfg.block_cache_size > 0)
-		{
-			leveldb::Cache* cache = leveldb::NewLRUCache(cfg.block_cache_size);
-			m_options.block_cache = cache;
-		}
-		if (cfg.block_size > 0)
-		{
-			m_options.block_size = cfg.block_size;
-		}
-		if (cfg.block_restart_interval > 0)
-		{
-			m_options.block_restart_interval = cfg.block_restart_interval;
-		}
-		if (cfg.write_buffer_size > 0)
-		{
-			m_options.write_buffer_size = cfg.write_buffer_size;
-		}
-		m_options.max_open_files = cfg.max_open_files;
-		if (cfg.bloom_bits > 0)
-		{
-			m_options.filter_policy = leveldb::NewBloomFilterPolicy(
-					cfg.bloom_bits);
-		}
-
-		make_dir(cfg.path);
-		m_db_path = cfg.path;
-		leveldb::Status status = leveldb::DB::Open(m_options, cfg.path.c_str(),
-				&m_db);
-		do
-		{
-			if (!status.ok())
-			{
-				ERROR_LOG(
-						"Failed to init engine:%s", status.ToString().c_str());
-				if (status.IsCorruption())
-				{
-					status = leveldb::RepairDB(cfg.path.c_str(), m_options);
-					if (!status.ok())
-					{
-						ERROR_LOG(
-								"Failed to repair:%s for %s", cfg.path.c_str(), status.ToString().c_str());
-						return -1;
-					}
-					status = leveldb::DB::Open(m_options, cfg.path.c_str(),
-							&m_db);
-				}
-			} else
-			{
-				break;
-			}
-		} while (1);
-		return status.ok() ? 0 : -1;
-	}
-
-	int LevelDBEngine::BeginBatchWrite()
-	{
-		m_batch_local.GetValue().AddRef();
-		return 0;
-	}
-	int LevelDBEngine::CommitBatchWrite()
-	{
-		BatchHolder& holder = m_batch_local.GetValue();
-		holder.ReleaseRef();
-		if (holder.EmptyRef())
-		{
-			return FlushWriteBatch(holder);
-		}
-		return 0;
-	}
-	int LevelDBEngine::DiscardBatchWrite()
-	{
-		BatchHolder& holder = m_batch_local.GetValue();
-		holder.ReleaseRef();
-		holder.Clear();
-		return 0;
-	}
-
-	int LevelDBEngine::FlushWriteBatch(BatchHolder& holder)
-	{
-		leveldb::Status s = m_db->Write(leveldb::WriteOptions(), &holder.batch);
-		holder.Clear();
-		return s.ok() ? 0 : -1;
-	}
-
-	void LevelDBEngine::CompactRange(const Slice& begin, const Slice& end)
-	{
-		leveldb::Slice s(begin.data(), begin.size());
-		leveldb::Slice e(end.data(), end.size());
-		leveldb::Slice* start = s.size() > 0 ? &s : NULL;
-		leveldb::Slice* endpos = e.size() > 0 ? &e : NULL;
-		m_db->CompactRange(start, endpos);
-	}
-
-	void LevelDBEngine::BatchHolder::Put(const Slice& key, const Slice& value)
-	{
-		batch.Put(LEVELDB_SLICE(key), LEVELDB_SLICE(value));
-		count++;
-	}
-	void LevelDBEngine::BatchHolder::Del(const Slice& key)
-	{
-		batch.Delete(LEVELDB_SLICE(key));
-		count++;
-	}
-
-	int LevelDBEngine::Put(const Slice& key, const Slice& value)
-	{
-		leveldb::Status s = leveldb::Status::OK();
-		BatchHolder& holder = m_batch_local.GetValue();
-		if (!holder.EmptyRef())
-		{
-			holder.Put(key, value);
-			if (holder.count >= (uint32) m_cfg.batch_commit_watermark)
-			{
-				FlushWriteBatch(holder);
-			}
-		} else
-		{
-			s = m_db->Put(leveldb::WriteOptions(), LEVELDB_SLICE(key),
-			LEVELDB_SLICE(value));
-		}
-		return s.ok() ? 0 : -1;
-	}
-	int LevelDBEngine::Get(const Slice& key, std::string* value)
-	{
-		leveldb::Status s = m_db->Get(leveldb::ReadOptions(),
-		LEVELDB_SLICE(key), value);
-		return s.ok() ? 0 : -1;
-	}
-	int LevelDBEngine::Del(const Slice& key)
-	{
-		leveldb::Status s = leveldb::Status::OK();
-		BatchHolder& holder = m_batch_local.GetValue();
-		if (!holder.EmptyRef())
-		{
-			holder.Del(key);
-			if (holder.count >= (uint32) m_cfg.batch_commit_watermark)
-			{
-				FlushWriteBatch(holder);
-			}
-		} else
-		{
-			s = m_db->Delete(leveldb::WriteOptions(), LEVELDB_SLICE(key));
-		}
-		return s.ok() ? 0 : -1;
-	}
-
-	Iterator* LevelDBEngine::Find(const Slice& findkey, bool cache)
-	{
-		leveldb::ReadOptions options;
-		options.fill_cache = cache;
-		leveldb::Iterator* iter = m_db->NewIterator(options);
-		iter->Seek(LEVELDB_SLICE(findkey));
-		return new LevelDBIterator(iter);
-	}
-
-	const std::string LevelDBEngine::Stats()
-	{
-		std::string str;
-		m_db->GetProperty("leveldb.stats", &str);
-		return str;
-	}
-
-}
-
+ /*
+ *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
+ *All rights reserved.
+ * 
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ * 
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Redis nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ * 
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+ *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ *THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "leveldb_engine.hpp"
+#include "ardb.hpp"
+#include "ardb_data.hpp"
+#include "comparator.hpp"
+#include "util/helpers.hpp"
+#include "leveldb/cache.h"
+#include "leveldb/filter_policy.h"
+#include <string.h>
+#include <algorithm>
+
+#define LEVELDB_SLICE(slice) leveldb::Slice(slice.data(), slice.size())
+#define ARDB_SLICE(slice) Slice(slice.data(), slice.size())
+
+namespace ardb
+{
+	int LevelDBComparator::Compare(const leveldb::Slice& a,
+			const leveldb::Slice& b) const
+	{
+		if (m_legacy)
+		{
+			return ardb_compare_legacy_keys(a.data(), a.size(), b.data(),
+					b.size());
+		}
+		return ardb_compare_keys(a.data(), a.size(), b.data(), b.size());
+	}
+
+	/*
+	 * Keys are ordered bytewise, so the shortening of the builtin bytewise
+	 * comparator applies as is.
+	 */
+	void LevelDBComparator::FindShortestSeparator(std::string* start,
+			const leveldb::Slice& limit) const
+	{
+		if (!m_legacy)
+		{
+			leveldb::BytewiseComparator()->FindShortestSeparator(start, limit);
+		}
+	}
+
+	void LevelDBComparator::FindShortSuccessor(std::string* key) const
+	{
+		if (!m_legacy)
+		{
+			leveldb::BytewiseComparator()->FindShortSuccessor(key);
+		}
+	}
+
+	LevelDBEngineFactory::LevelDBEngineFactory(const Properties& props)
+	{
+		ParseConfig(props, m_cfg);
+
+	}
+
+	void LevelDBEngineFactory::ParseConfig(const Properties& props,
+			LevelDBConfig& cfg)
+	{
+		cfg.path = ".";
+		conf_get_string(props, "data-dir", cfg.path);
+		conf_get_int64(props, "leveldb.block_cache_size", cfg.block_cache_size);
+		conf_get_int64(props, "leveldb.write_buffer_size",
+				cfg.write_buffer_size);
+		conf_get_int64(props, "leveldb.max_open_files", cfg.max_open_files);
+		conf_get_int64(props, "leveldb.block_size", cfg.block_size);
+		conf_get_int64(props, "leveldb.block_restart_interval",
+				cfg.block_restart_interval);
+		conf_get_int64(props, "leveldb.bloom_bits", cfg.bloom_bits);
+		std::string legacy;
+		conf_get_string(props, "legacy-key-format", legacy);
+		cfg.legacy_key_format = string_tolower(legacy) == "yes";
+	}
+
+	KeyValueEngine* LevelDBEngineFactory::CreateDB(const std::string& name)
+	{
+		LevelDBEngine* engine = new LevelDBEngine();
+		LevelDBConfig cfg = m_cfg;
+		char tmp[cfg.path.size() + name.size() + 10];
+		sprintf(tmp, "%s/%s", cfg.path.c_str(), name.c_str());
+		cfg.path = tmp;
+		if (engine->Init(cfg) != 0)
+		{
+			DELETE(engine);
+			ERROR_LOG("Failed to create DB:%s", name.c_str());
+			return NULL;
+		}
+		return engine;
+	}
+	void LevelDBEngineFactory::DestroyDB(KeyValueEngine* engine)
+	{
+		LevelDBEngine* leveldb = (LevelDBEngine*) engine;
+		std::string path = leveldb->m_db_path;
+		DELETE(engine);
+		leveldb::Options options;
+		leveldb::DestroyDB(path, options);
+	}
+
+	void LevelDBEngineFactory::CloseDB(KeyValueEngine* engine)
+	{
+		DELETE(engine);
+	}
+	void LevelDBIterator::SeekToFirst()
+	{
+		m_iter->SeekToFirst();
+	}
+	void LevelDBIterator::SeekToLast()
+	{
+		m_iter->SeekToLast();
+	}
+	void LevelDBIterator::Next()
+	{
+		m_iter->Next();
+	}
+	void LevelDBIterator::Prev()
+	{
+		m_iter->Prev();
+	}
+	Slice LevelDBIterator::Key() const
+	{
+		return ARDB_SLICE(m_iter->key());
+	}
+	Slice LevelDBIterator::Value() const
+	{
+		return ARDB_SLICE(m_iter->value());
+	}
+	bool LevelDBIterator::Valid()
+	{
+		return m_iter->Valid();
+	}
+
+	LevelDBOverlayIterator::LevelDBOverlayIterator(leveldb::Iterator* iter,
+			WriteOverlay& overlay, const Slice& findkey) :
+			m_iter(iter), m_overlay(overlay), m_forward(true), m_overlay_valid(
+					false), m_overlay_deleted(false), m_use_overlay(false)
+	{
+		m_iter->Seek(LEVELDB_SLICE(findkey));
+		OverlaySeek(std::string(findkey.data(), findkey.size()), true, true);
+		FindNextVisible();
+	}
+
+	void LevelDBOverlayIterator::OverlaySeek(const std::string& key,
+			bool forward, bool inclusive)
+	{
+		WriteOverlay::iterator it;
+		m_overlay_valid = false;
+		if (forward)
+		{
+			it = inclusive ?
+					m_overlay.lower_bound(key) : m_overlay.upper_bound(key);
+			m_overlay_valid = it != m_overlay.end();
+		}
+		else
+		{
+			it = inclusive ?
+					m_overlay.upper_bound(key) : m_overlay.lower_bound(key);
+			if (it != m_overlay.begin())
+			{
+				it--;
+				m_overlay_valid = true;
+			}
+		}
+		if (m_overlay_valid)
+		{
+			m_overlay_key = it->first;
+			m_overlay_deleted = NULL == it->second;
+			if (!m_overlay_deleted)
+			{
+				m_overlay_value = *(it->second);
+			}
+		}
+	}
+
+	void LevelDBOverlayIterator::FindNextVisible()
+	{
+		while (true)
+		{
+			m_use_overlay = false;
+			if (!m_overlay_valid)
+			{
+				return;
+			}
+			int cmp = m_iter->Valid() ?
+					m_iter->key().compare(leveldb::Slice(m_overlay_key)) : 1;
+			if (cmp < 0)
+			{
+				return;
+			}
+			if (!m_overlay_deleted)
+			{
+				m_use_overlay = true;
+				return;
+			}
+			if (cmp == 0)
+			{
+				m_iter->Next();
+			}
+			OverlaySeek(m_overlay_key, true, false);
+		}
+	}
+
+	void LevelDBOverlayIterator::FindPrevVisible()
+	{
+		while (true)
+		{
+			m_use_overlay = false;
+			if (!m_overlay_valid)
+			{
+				return;
+			}
+			int cmp = m_iter->Valid() ?
+					m_iter->key().compare(leveldb::Slice(m_overlay_key)) : -1;
+			if (cmp > 0)
+			{
+				return;
+			}
+			if (!m_overlay_deleted)
+			{
+				m_use_overlay = true;
+				return;
+			}
+			if (cmp == 0)
+			{
+				m_iter->Prev();
+			}
+			OverlaySeek(m_overlay_key, false, false);
+		}
+	}
+
+	void LevelDBOverlayIterator::SeekToFirst()
+	{
+		m_forward = true;
+		m_iter->SeekToFirst();
+		OverlaySeek("", true, true);
+		FindNextVisible();
+	}
+	void LevelDBOverlayIterator::SeekToLast()
+	{
+		m_forward = false;
+		m_iter->SeekToLast();
+		m_overlay_valid = false;
+		if (!m_overlay.empty())
+		{
+			OverlaySeek(m_overlay.rbegin()->first, false, true);
+		}
+		FindPrevVisible();
+	}
+	void LevelDBOverlayIterator::Next()
+	{
+		std::string key = Key().ToString();
+		if (!m_forward)
+		{
+			m_iter->Seek(leveldb::Slice(key));
+			m_forward = true;
+		}
+		if (m_iter->Valid() && m_iter->key() == leveldb::Slice(key))
+		{
+			m_iter->Next();
+		}
+		OverlaySeek(key, true, false);
+		FindNextVisible();
+	}
+	void LevelDBOverlayIterator::Prev()
+	{
+		std::string key = Key().ToString();
+		if (m_forward)
+		{
+			m_iter->Seek(leveldb::Slice(key));
+			if (m_iter->Valid())
+			{
+				m_iter->Prev();
+			}
+			else
+			{
+				m_iter->SeekToLast();
+			}
+			m_forward = false;
+		}
+		else if (m_iter->Valid() && m_iter->key() == leveldb::Slice(key))
+		{
+			m_iter->Prev();
+		}
+		OverlaySeek(key, false, false);
+		FindPrevVisible();
+	}
+	Slice LevelDBOverlayIterator::Key() const
+	{
+		if (m_use_overlay)
+		{
+			return m_overlay_key;
+		}
+		return ARDB_SLICE(m_iter->key());
+	}
+	Slice LevelDBOverlayIterator::Value() const
+	{
+		if (m_use_overlay)
+		{
+			return m_overlay_value;
+		}
+		return ARDB_SLICE(m_iter->value());
+	}
+	bool LevelDBOverlayIterator::Valid()
+	{
+		return m_use_overlay || m_iter->Valid();
+	}
+
+	LevelDBEngine::LevelDBEngine() :
+			m_db(NULL)
+	{
+
+	}
+	LevelDBEngine::~LevelDBEngine()
+	{
+		DELETE(m_db);
+		DELETE(m_options.block_cache);
+		DELETE(m_options.filter_policy);
+	}
+	int LevelDBEngine::Init(const LevelDBConfig& cfg)
+	{
+		m_cfg = cfg;
+		m_options.create_if_missing = true;
+		m_comparator.SetLegacy(cfg.legacy_key_format);
+		m_options.comparator = &m_comparator;
+		if (cfg.block_cache_size > 0)
+		{
+			leveldb::Cache* cache = leveldb::NewLRUCache(cfg.block_cache_size);
+			m_options.block_cache = cache;
+		}
+		if (cfg.block_size > 0)
+		{
+			m_options.block_size = cfg.block_size;
+		}
+		if (cfg.block_restart_interval > 0)
+		{
+			m_options.block_restart_interval = cfg.block_restart_interval;
+		}
+		if (cfg.write_buffer_size > 0)
+		{
+			m_options.write_buffer_size = cfg.write_buffer_size;
+		}
+		m_options.max_open_files = cfg.max_open_files;
+		if (cfg.bloom_bits > 0)
+		{
+			m_options.filter_policy = leveldb::NewBloomFilterPolicy(
+					cfg.bloom_bits);
+		}
+
+		make_dir(cfg.path);
+		m_db_path = cfg.path;
+		leveldb::Status status = leveldb::DB::Open(m_options, cfg.path.c_str(),
+				&m_db);
+		do
+		{
+			if (!status.ok())
+			{
+				ERROR_LOG(
+						"Failed to init engine:%s", status.ToString().c_str());
+				if (status.IsCorruption())
+				{
+					status = leveldb::RepairDB(cfg.path.c_str(), m_options);
+					if (!status.ok())
+					{
+						ERROR_LOG(
+								"Failed to repair:%s for %s", cfg.path.c_str(), status.ToString().c_str());
+						return -1;
+					}
+					status = leveldb::DB::Open(m_options, cfg.path.c_str(),
+							&m_db);
+				}
+			} else
+			{
+				break;
+			}
+		} while (1);
+		return status.ok() ? 0 : -1;
+	}
+
+	int LevelDBEngine::BeginBatchWrite()
+	{
+		m_batch_local.GetValue().AddRef();
+		return 0;
+	}
+	int LevelDBEngine::CommitBatchWrite()
+	{
+		BatchHolder& holder = m_batch_local.GetValue();
+		holder.ReleaseRef();
+		if (holder.EmptyRef())
+		{
+			int ret = FlushWriteBatch(holder);
+			holder.failed = false;
+			return ret;
+		}
+		return 0;
+	}
+	/*
+	 * A write batch can not be rolled back in part, discarding a nested
+	 * batch, e.g. one command of a group commit, drops the enclosing
+	 * batches too. They then fail instead of committing what is left.
+	 */
+	int LevelDBEngine::DiscardBatchWrite()
+	{
+		BatchHolder& holder = m_batch_local.GetValue();
+		holder.ReleaseRef();
+		holder.Clear();
+		holder.failed = !holder.EmptyRef();
+		return 0;
+	}
+
+	/*
+	 * The legacy key format iterates without the write overlay, so commands
+	 * would not see the writes of earlier commands in the group.
+	 */
+	bool LevelDBEngine::SupportGroupCommit()
+	{
+		return !m_cfg.legacy_key_format;
+	}
+	int LevelDBEngine::FlushBatchWrite()
+	{
+		BatchHolder& holder = m_batch_local.GetValue();
+		if (holder.EmptyRef())
+		{
+			return 0;
+		}
+		return FlushWriteBatch(holder);
+	}
+
+	int LevelDBEngine::FlushWriteBatch(BatchHolder& holder)
+	{
+		if (holder.failed)
+		{
+			holder.Clear();
+			return -1;
+		}
+		if (holder.overlay.empty())
+		{
+			return 0;
+		}
+		leveldb::Status s = m_db->Write(leveldb::WriteOptions(), &holder.batch);
+		holder.Clear();
+		return s.ok() ? 0 : -1;
+	}
+
+	void LevelDBEngine::CompactRange(const Slice& begin, const Slice& end)
+	{
+		leveldb::Slice s(begin.data(), begin.size());
+		leveldb::Slice e(end.data(), end.size());
+		leveldb::Slice* start = s.size() > 0 ? &s : NULL;
+		leveldb::Slice* endpos = e.size() > 0 ? &e : NULL;
+		m_db->CompactRange(start, endpos);
+	}
+
+	/*
+	 * Counts the table files only, writes still in the memtable are not
+	 * included.
+	 */
+	uint64 LevelDBEngine::EstimateSize(const Slice& begin, const Slice& end)
+	{
+		std::string limit(end.data(), end.size());
+		if (limit.empty())
+		{
+			limit.assign(16, '\xff');
+		}
+		leveldb::Range range(LEVELDB_SLICE(begin), leveldb::Slice(limit));
+		uint64_t size = 0;
+		m_db->GetApproximateSizes(&range, 1, &size);
+		return size;
+	}
+
+	void LevelDBEngine::BatchHolder::Put(const Slice& key, const Slice& value)
+	{
+		batch.Put(LEVELDB_SLICE(key), LEVELDB_SLICE(value));
+		std::string*& v = overlay[std::string(key.data(), key.size())];
+		if (NULL == v)
+		{
+			NEW(v, std::string);
+		}
+		v->assign(value.data(), value.size());
+	}
+	void LevelDBEngine::BatchHolder::Del(const Slice& key)
+	{
+		batch.Delete(LEVELDB_SLICE(key));
+		std::string*& v = overlay[std::string(key.data(), key.size())];
+		DELETE(v);
+	}
+	void LevelDBEngine::BatchHolder::Clear()
+	{
+		batch.Clear();
+		WriteOverlay::iterator it = overlay.begin();
+		while (it != overlay.end())
+		{
+			DELETE(it->second);
+			it++;
+		}
+		overlay.clear();
+	}
+
+	int LevelDBEngine::Put(const Slice& key, const Slice& value)
+	{
+		leveldb::Status s = leveldb::Status::OK();
+		BatchHolder& holder = m_batch_local.GetValue();
+		if (!holder.EmptyRef())
+		{
+			holder.Put(key, value);
+		} else
+		{
+			s = m_db->Put(leveldb::WriteOptions(), LEVELDB_SLICE(key),
+			LEVELDB_SLICE(value));
+		}
+		return s.ok() ? 0 : -1;
+	}
+	int LevelDBEngine::Get(const Slice& key, std::string* value)
+	{
+		BatchHolder& holder = m_batch_local.GetValue();
+		if (!holder.overlay.empty())
+		{
+			WriteOverlay::iterator it = holder.overlay.find(
+					std::string(key.data(), key.size()));
+			if (it != holder.overlay.end())
+			{
+				if (NULL == it->second)
+				{
+					return -1;
+				}
+				if (NULL != value)
+				{
+					value->assign(*(it->second));
+				}
+				return 0;
+			}
+		}
+		leveldb::Status s = m_db->Get(NewReadOptions(), LEVELDB_SLICE(key),
+		        value);
+		return s.ok() ? 0 : -1;
+	}
+	int LevelDBEngine::Del(const Slice& key)
+	{
+		leveldb::Status s = leveldb::Status::OK();
+		BatchHolder& holder = m_batch_local.GetValue();
+		if (!holder.EmptyRef())
+		{
+			holder.Del(key);
+		} else
+		{
+			s = m_db->Delete(leveldb::WriteOptions(), LEVELDB_SLICE(key));
+		}
+		return s.ok() ? 0 : -1;
+	}
+
+	Iterator* LevelDBEngine::Find(const Slice& findkey, bool cache)
+	{
+		leveldb::Iterator* iter = m_db->NewIterator(NewReadOptions(cache));
+		BatchHolder& holder = m_batch_local.GetValue();
+		/*
+		 * The overlay is ordered bytewise, which only matches the DB order
+		 * for the current key format.
+		 */
+		if (!holder.overlay.empty() && !m_cfg.legacy_key_format)
+		{
+			return new LevelDBOverlayIterator(iter, holder.overlay, findkey);
+		}
+		iter->Seek(LEVELDB_SLICE(findkey));
+		return new LevelDBIterator(iter);
+	}
+
+	leveldb::ReadOptions LevelDBEngine::NewReadOptions(bool cache)
+	{
+		leveldb::ReadOptions options;
+		options.fill_cache = cache;
+		options.snapshot = m_snapshot_local.GetValue().snapshot;
+		return options;
+	}
+
+	int LevelDBEngine::NewSnapshot()
+	{
+		SnapshotHolder& holder = m_snapshot_local.GetValue();
+		if (0 == holder.ref)
+		{
+			holder.snapshot = m_db->GetSnapshot();
+		}
+		holder.ref++;
+		return 0;
+	}
+
+	int LevelDBEngine::ReleaseSnapshot()
+	{
+		SnapshotHolder& holder = m_snapshot_local.GetValue();
+		if (0 == holder.ref)
+		{
+			return -1;
+		}
+		holder.ref--;
+		if (0 == holder.ref)
+		{
+			m_db->ReleaseSnapshot(holder.snapshot);
+			holder.snapshot = NULL;
+		}
+		return 0;
+	}
+
+	struct MultiGetKeyLess
+	{
+			const leveldb::Comparator* cmp;
+			const SliceArray& keys;
+			MultiGetKeyLess(const leveldb::Comparator* c, const SliceArray& k) :
+					cmp(c), keys(k)
+			{
+			}
+			bool operator()(uint32 a, uint32 b) const
+			{
+				return cmp->Compare(LEVELDB_SLICE(keys[a]), LEVELDB_SLICE(keys[b]))
+				        < 0;
+			}
+	};
+
+	/*
+	 * The keys are visited in comparator order. A key close after the
+	 * previous one is reached with a few Next() calls of one iterator,
+	 * which is much cheaper than a Get when the keys are dense, e.g. MGET
+	 * over a run of ids. Once stepping does not reach a key, the following
+	 * keys are looked up with Get, which can skip tables by their bloom
+	 * filters, and every kMultiGetProbe Gets the iterator is tried again.
+	 * All reads use one snapshot.
+	 */
+	void LevelDBEngine::MultiGet(const SliceArray& keys, StringArray& values,
+	        std::vector<int>& errs)
+	{
+		static const uint32 kMultiGetMaxSteps = 4;
+		static const uint32 kMultiGetProbe = 16;
+		values.clear();
+		values.resize(keys.size());
+		errs.assign(keys.size(), -1);
+		if (keys.empty())
+		{
+			return;
+		}
+		std::vector<uint32> order(keys.size());
+		for (uint32 i = 0; i < keys.size(); i++)
+		{
+			order[i] = i;
+		}
+		std::sort(order.begin(), order.end(),
+		        MultiGetKeyLess(&m_comparator, keys));
+		BatchHolder& holder = m_batch_local.GetValue();
+		leveldb::ReadOptions options = NewReadOptions();
+		const leveldb::Snapshot* snapshot = NULL;
+		if (NULL == options.snapshot)
+		{
+			snapshot = m_db->GetSnapshot();
+			options.snapshot = snapshot;
+		}
+		leveldb::Iterator* iter = NULL;
+		bool walking = true;
+		bool positioned = false;
+		uint32 gets = 0;
+		for (uint32 i = 0; i < order.size(); i++)
+		{
+			uint32 idx = order[i];
+			leveldb::Slice key = LEVELDB_SLICE(keys[idx]);
+			if (!holder.overlay.empty())
+			{
+				WriteOverlay::iterator it = holder.overlay.find(
+				        std::string(key.data(), key.size()));
+				if (it != holder.overlay.end())
+				{
+					if (NULL != it->second)
+					{
+						values[idx] = *(it->second);
+						errs[idx] = 0;
+					}
+					continue;
+				}
+			}
+			if (walking)
+			{
+				if (NULL == iter)
+				{
+					iter = m_db->NewIterator(options);
+				}
+				if (!positioned)
+				{
+					iter->Seek(key);
+					positioned = true;
+				}
+				else
+				{
+					uint32 steps = 0;
+					while (iter->Valid() && steps < kMultiGetMaxSteps
+					        && m_comparator.Compare(iter->key(), key) < 0)
+					{
+						iter->Next();
+						steps++;
+					}
+					if (iter->Valid()
+					        && m_comparator.Compare(iter->key(), key) < 0)
+					{
+						walking = false;
+						positioned = false;
+					}
+				}
+				if (walking)
+				{
+					if (iter->Valid()
+					        && m_comparator.Compare(iter->key(), key) == 0)
+					{
+						values[idx].assign(iter->value().data(),
+						        iter->value().size());
+						errs[idx] = 0;
+					}
+					continue;
+				}
+			}
+			if (m_db->Get(options, key, &values[idx]).ok())
+			{
+				errs[idx] = 0;
+			}
+			gets++;
+			if (gets % kMultiGetProbe == 0)
+			{
+				walking = true;
+			}
+		}
+		delete iter;
+		if (NULL != snapshot)
+		{
+			m_db->ReleaseSnapshot(snapshot);
+		}
+	}
+
+	/*
+	 * Table files are immutable and only ever deleted, so they are hard
+	 * linked; the MANIFEST is copied up to its current size and the write
+	 * ahead logs are copied. A flush or compaction appends to the MANIFEST,
+	 * so if it grew meanwhile the file set may have changed and the
+	 * checkpoint is taken again.
+	 */
+	int LevelDBEngine::Checkpoint(const std::string& dir)
+	{
+		static const uint32 kMaxCheckpointTries = 10;
+		for (uint32 i = 0; i < kMaxCheckpointTries; i++)
+		{
+			remove_dir(dir);
+			if (!make_dir(dir))
+			{
+				return -1;
+			}
+			Buffer current;
+			if (0 != file_read_full(m_db_path + "/CURRENT", current))
+			{
+				return -1;
+			}
+			std::string manifest = trim_string(current.AsString());
+			std::string manifest_path = m_db_path + "/" + manifest;
+			int64 manifest_size = file_size(manifest_path);
+			std::string content = manifest + "\n";
+			if (manifest_size <= 0
+			        || file_copy(manifest_path, dir + "/" + manifest,
+			                manifest_size) != manifest_size
+			        || 0 != file_write_content(dir + "/CURRENT", content))
+			{
+				continue;
+			}
+			std::deque<std::string> files;
+			list_subfiles(m_db_path, files);
+			bool fail = false;
+			while (!fail && !files.empty())
+			{
+				std::string name = files.front();
+				files.pop_front();
+				std::string src = m_db_path + "/" + name;
+				if (has_suffix(name, ".sst"))
+				{
+					fail = 0 != file_link(src, dir + "/" + name);
+				}
+				else if (has_suffix(name, ".log"))
+				{
+					fail = file_copy(src, dir + "/" + name) < 0;
+				}
+			}
+			Buffer after;
+			if (!fail && 0 == file_read_full(m_db_path + "/CURRENT", after)
+			        && trim_string(after.AsString()) == manifest
+			        && file_size(manifest_path) == manifest_size)
+			{
+				return 0;
+			}
+			WARN_LOG("Files changed while checkpointing %s, retry.",
+			        m_db_path.c_str());
+		}
+		remove_dir(dir);
+		return -1;
+	}
+
+	const std::string LevelDBEngine::Stats()
+	{
+		std::string str;
+		m_db->GetProperty("leveldb.stats", &str);
+		return str;
+	}
+
+}
+
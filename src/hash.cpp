@@ -57,49 +57,121 @@
 */
 
 #include "ardb.hpp"
+#include <fnmatch.h>
 
 namespace ardb
 {
+	int Ardb::GetHashMetaValue(const DBID& db, const Slice& key,
+			HashMetaValue& meta)
+	{
+		KeyObject k(key, HASH_META, db);
+		ValueObject v;
+		if (0 == GetValue(k, &v))
+		{
+			if (v.type != INTEGER)
+			{
+				return ERR_INVALID_TYPE;
+			}
+			meta.size = v.v.int_v;
+			return 0;
+		}
+		return ERR_NOT_EXIST;
+	}
+
+	void Ardb::SetHashMetaValue(const DBID& db, const Slice& key,
+			HashMetaValue& meta)
+	{
+		KeyObject k(key, HASH_META, db);
+		if (meta.size == 0)
+		{
+			DelValue(k);
+			return;
+		}
+		ValueObject v((int64) meta.size);
+		SetValue(k, v);
+	}
+
 	int Ardb::SetHashValue(const DBID& db, const Slice& key, const Slice& field,
-			ValueObject& value)
+			ValueObject& value, bool* created)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		HashKeyObject k(key, field, db);
+		bool isnew = 0 != GetValue(k, NULL);
+		if (NULL != created)
+		{
+			*created = isnew;
+		}
+		if (!isnew)
+		{
+			return SetValue(k, value);
+		}
+		HashMetaValue meta;
+		GetHashMetaValue(db, key, meta);
+		meta.size++;
+		BatchWriteGuard guard(GetEngine());
+		SetHashMetaValue(db, key, meta);
 		return SetValue(k, value);
 	}
+
 	int Ardb::HSet(const DBID& db, const Slice& key, const Slice& field,
 			const Slice& value)
 	{
 		ValueObject valueobject;
 		smart_fill_value(value, valueobject);
-		return SetHashValue(db, key, field, valueobject) == 0 ? 1 : 0;
+		bool created = false;
+		int ret = SetHashValue(db, key, field, valueobject, &created);
+		if (0 != ret)
+		{
+			return ret;
+		}
+		return created ? 1 : 0;
 	}
 
 	int Ardb::HSetNX(const DBID& db, const Slice& key, const Slice& field,
 			const Slice& value)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		if (HExists(db, key, field))
 		{
 			return 0;
 		}
-		return HSet(db, key, field, value) > 0 ? 1 : 0;
+		return HSet(db, key, field, value) >= 0 ? 1 : 0;
 	}
 
 	int Ardb::HDel(const DBID& db, const Slice& key, const Slice& field)
 	{
-		HashKeyObject k(key, field, db);
-		return DelValue( k);
+		SliceArray fields;
+		fields.push_back(field);
+		return HDel(db, key, fields);
 	}
 
 	int Ardb::HDel(const DBID& db, const Slice& key, const SliceArray& fields)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
+		HashMetaValue meta;
+		if (0 != GetHashMetaValue(db, key, meta))
+		{
+			return 0;
+		}
 		BatchWriteGuard guard(GetEngine());
+		uint32 count = 0;
 		SliceArray::const_iterator it = fields.begin();
 		while (it != fields.end())
 		{
-			HDel(db, key, *it);
+			HashKeyObject k(key, *it, db);
+			if (0 == GetValue(k, NULL))
+			{
+				DelValue(k);
+				count++;
+			}
 			it++;
 		}
-		return fields.size();
+		if (count > 0)
+		{
+			meta.size = meta.size > count ? meta.size - count : 0;
+			SetHashMetaValue(db, key, meta);
+		}
+		return count;
 	}
 
 	int Ardb::HGetValue(const DBID& db, const Slice& key, const Slice& field,
@@ -136,15 +208,30 @@ namespace ardb
 		{
 			return ERR_INVALID_ARGS;
 		}
+		KeyLockerGuard keyguard(m_key_locker, db, key);
+		HashMetaValue meta;
+		GetHashMetaValue(db, key, meta);
+		uint32 oldsize = meta.size;
 		BatchWriteGuard guard(GetEngine());
 		SliceArray::const_iterator it = fields.begin();
 		SliceArray::const_iterator sit = values.begin();
 		while (it != fields.end())
 		{
-			HSet(db, key, *it, *sit);
+			HashKeyObject k(key, *it, db);
+			if (0 != GetValue(k, NULL))
+			{
+				meta.size++;
+			}
+			ValueObject valueobject;
+			smart_fill_value(*sit, valueobject);
+			SetValue(k, valueobject);
 			it++;
 			sit++;
 		}
+		if (meta.size != oldsize)
+		{
+			SetHashMetaValue(db, key, meta);
+		}
 		return 0;
 	}
 
@@ -183,8 +270,11 @@ namespace ardb
 				{
 				}
 		} walk(this);
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		BatchWriteGuard guard(GetEngine());
 		Walk( sk, false, &walk);
+		KeyObject mk(key, HASH_META, db);
+		DelValue(mk);
 		return 0;
 	}
 
@@ -214,24 +304,12 @@ namespace ardb
 
 	int Ardb::HLen(const DBID& db, const Slice& key)
 	{
-		Slice empty;
-		HashKeyObject k(key, empty, db);
-		Iterator* it = FindValue(k);
-		int len = 0;
-		while (NULL != it && it->Valid())
+		HashMetaValue meta;
+		if (0 != GetHashMetaValue(db, key, meta))
 		{
-			Slice tmpkey = it->Key();
-			KeyObject* kk = decode_key(tmpkey, &k);
-			if (NULL == kk)
-			{
-				break;
-			}
-			len++;
-			it->Next();
-			DELETE(kk);
+			return 0;
 		}
-		DELETE(it);
-		return len;
+		return meta.size;
 	}
 
 	int Ardb::HVals(const DBID& db, const Slice& key, StringArray& values)
@@ -299,6 +377,7 @@ namespace ardb
 	int Ardb::HIncrby(const DBID& db, const Slice& key, const Slice& field,
 			int64_t increment, int64_t& value)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		ValueObject v;
 		v.type = INTEGER;
 		HGetValue(db, key, field, &v);
@@ -337,6 +416,7 @@ namespace ardb
 	int Ardb::HIncrbyFloat(const DBID& db, const Slice& key, const Slice& field,
 			double increment, double& value)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		ValueObject v;
 		v.type = DOUBLE;
 		HGetValue(db, key, field, &v);
@@ -354,5 +434,89 @@ namespace ardb
 		value = v.v.double_v;
 		return SetHashValue(db, key, field, v);
 	}
+
+	int Ardb::HScan(const DBID& db, const Slice& key,
+			const std::string& cursor, const std::string& pattern,
+			uint32 limit, ValueArray& vs, std::string& newcursor)
+	{
+		Slice empty;
+		HashKeyObject hk(key, empty, db);
+		struct HScanWalk: public WalkHandler
+		{
+				const std::string& z_pattern;
+				ValueArray& z_vs;
+				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
+				{
+					HashKeyObject* hek = (HashKeyObject*) k;
+					std::string field(hek->field.data(), hek->field.size());
+					if (fnmatch(z_pattern.c_str(), field.c_str(), 0) == 0)
+					{
+						ValueObject fv;
+						fill_raw_value(hek->field, fv);
+						z_vs.push_back(fv);
+						z_vs.push_back(*v);
+					}
+					return 0;
+				}
+				HScanWalk(const std::string& p, ValueArray& vals) :
+						z_pattern(p), z_vs(vals)
+				{
+				}
+		} walk(pattern, vs);
+		return ScanElements(hk, cursor, limit, &walk, newcursor);
+	}
+
+	/*
+	 * Count the fields of every hash into its HASH_META record, for data
+	 * written before hashes kept one.
+	 */
+	int Ardb::RebuildHashMeta()
+	{
+		static const uint32 kBatchSize = 1024;
+		DBID lastdb = 0;
+		std::string lastkey;
+		HashMetaValue meta;
+		uint64 count = 0;
+		Iterator* iter = GetEngine()->Find(Slice(), false);
+		GetEngine()->BeginBatchWrite();
+		while (NULL != iter && iter->Valid())
+		{
+			DBID db;
+			KeyType type;
+			if (peek_dbkey_header(iter->Key(), db, type) && type == HASH_FIELD)
+			{
+				KeyObject* k = decode_key(iter->Key(), NULL);
+				if (NULL != k)
+				{
+					if (meta.size > 0
+					        && (db != lastdb || k->key.compare(lastkey) != 0))
+					{
+						SetHashMetaValue(lastdb, lastkey, meta);
+						meta.size = 0;
+						count++;
+						if (count % kBatchSize == 0)
+						{
+							GetEngine()->CommitBatchWrite();
+							GetEngine()->BeginBatchWrite();
+						}
+					}
+					lastdb = db;
+					lastkey.assign(k->key.data(), k->key.size());
+					meta.size++;
+				}
+				DELETE(k);
+			}
+			iter->Next();
+		}
+		if (meta.size > 0)
+		{
+			SetHashMetaValue(lastdb, lastkey, meta);
+			count++;
+		}
+		GetEngine()->CommitBatchWrite();
+		DELETE(iter);
+		INFO_LOG("Rebuilt %"PRIu64" hash meta records.", count);
+		return 0;
+	}
 }
 
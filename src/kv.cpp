@@ -46,23 +46,34 @@ namespace ardb
 			{
 				return 0;
 			}
-			Buffer readbuf(const_cast<char*>(value.data()), 0, value.size());
-			if (decode_value(readbuf, *v))
+			return DecodeRawValue(k, value, v, expire);
+		}
+		return ERR_NOT_EXIST;
+	}
+
+	/*
+	 * Decode the raw value of 'k' read from the engine, an expired value
+	 * is deleted.
+	 */
+	int Ardb::DecodeRawValue(const Slice& k, const std::string& value,
+			ValueObject* v, uint64* expire)
+	{
+		Buffer readbuf(const_cast<char*>(value.data()), 0, value.size());
+		if (decode_value(readbuf, *v))
+		{
+			uint64 tmp = 0;
+			BufferHelper::ReadVarUInt64(readbuf, tmp);
+			if (NULL != expire)
 			{
-				uint64 tmp = 0;
-				BufferHelper::ReadVarUInt64(readbuf, tmp);
-				if (NULL != expire)
-				{
-					*expire = tmp;
-				}
-				if (tmp > 0 && get_current_epoch_micros() >= tmp)
-				{
-					GetEngine()->Del(k);
-					return ERR_NOT_EXIST;
-				} else
-				{
-					return ARDB_OK;
-				}
+				*expire = tmp;
+			}
+			if (tmp > 0 && get_current_epoch_micros() >= tmp)
+			{
+				GetEngine()->Del(k);
+				return ERR_NOT_EXIST;
+			} else
+			{
+				return ARDB_OK;
 			}
 		}
 		return ERR_NOT_EXIST;
@@ -95,9 +106,173 @@ namespace ardb
 		}
 		Slice k(keybuf.GetRawReadBuffer(), keybuf.ReadableBytes());
 		Slice v(valuebuf.GetRawReadBuffer(), valuebuf.ReadableBytes());
+		KeyType dirtype = directory_key_type(key.type);
+		if (dirtype != KEY_END || (expire > 0 && key.type == KV))
+		{
+			BatchWriteGuard guard(GetEngine());
+			if (dirtype != KEY_END)
+			{
+				SetKeyDirectory(key.db, key.key, dirtype);
+			}
+			if (expire > 0 && key.type == KV)
+			{
+				AddExpireIndex(key.db, key.key, expire);
+			}
+			return RawSet(k, v);
+		}
 		return RawSet(k, v);
 	}
 
+	int Ardb::SetKeyDirectory(const DBID& db, const Slice& key, KeyType type)
+	{
+		KeyObject dk(key, KEY_DIRECTORY, db);
+		Buffer keybuf(key.size() + 16);
+		encode_key(keybuf, dk);
+		ValueObject dv((int64) type);
+		Buffer valuebuf(16);
+		encode_value(valuebuf, dv);
+		return RawSet(Slice(keybuf.GetRawReadBuffer(), keybuf.ReadableBytes()),
+		        Slice(valuebuf.GetRawReadBuffer(), valuebuf.ReadableBytes()));
+	}
+
+	int Ardb::AddExpireIndex(const DBID& db, const Slice& key, uint64 expire)
+	{
+		ExpireKeyObject ek(key, expire, db);
+		Buffer keybuf(key.size() + 24);
+		encode_key(keybuf, ek);
+		ValueObject empty;
+		Buffer valuebuf(8);
+		encode_value(valuebuf, empty);
+		return RawSet(Slice(keybuf.GetRawReadBuffer(), keybuf.ReadableBytes()),
+		        Slice(valuebuf.GetRawReadBuffer(), valuebuf.ReadableBytes()));
+	}
+
+	/*
+	 * Expire time of a KV key is stored after its value, other types keep
+	 * it in a KEY_EXPIRATION_MAPPING record.
+	 */
+	int Ardb::GetExpiration(const DBID& db, const Slice& key, uint64& expire)
+	{
+		expire = 0;
+		KeyObject k(key, KV, db);
+		Buffer keybuf(key.size() + 16);
+		encode_key(keybuf, k);
+		std::string value;
+		if (0 == GetEngine()->Get(
+		        Slice(keybuf.GetRawReadBuffer(), keybuf.ReadableBytes()),
+		        &value))
+		{
+			Buffer readbuf(const_cast<char*>(value.data()), 0, value.size());
+			ValueObject v;
+			if (decode_value(readbuf, v))
+			{
+				BufferHelper::ReadVarUInt64(readbuf, expire);
+			}
+			return 0;
+		}
+		KeyObject mk(key, KEY_EXPIRATION_MAPPING, db);
+		ValueObject v;
+		if (0 == GetValue(mk, &v) && v.type == INTEGER)
+		{
+			expire = v.v.int_v;
+			return 0;
+		}
+		return ERR_NOT_EXIST;
+	}
+
+	int Ardb::CheckExpiredKeys(uint32 limit)
+	{
+		struct DueKey
+		{
+				DBID db;
+				std::string key;
+				uint64 expireat;
+				std::string indexkey;
+		};
+		uint64 start = get_current_epoch_micros();
+		std::vector<DueKey> dues;
+		ExpireKeyObject startkey(Slice(), 0, 0);
+		Iterator* iter = FindValue(startkey, false);
+		while (NULL != iter && iter->Valid() && dues.size() < limit)
+		{
+			KeyObject* k = decode_key(iter->Key(), NULL);
+			if (NULL == k || k->type != KEY_EXPIRATION_ELEMENT
+			        || ((ExpireKeyObject*) k)->expireat > start)
+			{
+				DELETE(k);
+				break;
+			}
+			ExpireKeyObject* ek = (ExpireKeyObject*) k;
+			DueKey due;
+			due.db = ek->keydb;
+			due.key.assign(ek->key.data(), ek->key.size());
+			due.expireat = ek->expireat;
+			due.indexkey.assign(iter->Key().data(), iter->Key().size());
+			dues.push_back(due);
+			DELETE(k);
+			iter->Next();
+		}
+		DELETE(iter);
+
+		uint32 expired = 0;
+		for (uint32 i = 0; i < dues.size(); i++)
+		{
+			DueKey& due = dues[i];
+			KeyLockerGuard keyguard(m_key_locker, due.db, due.key);
+			BatchWriteGuard guard(GetEngine());
+			uint64 expire = 0;
+			/*
+			 * Index entries are never updated in place, an entry whose time
+			 * differs from the key's current expire time is stale.
+			 */
+			if (0 == GetExpiration(due.db, due.key, expire)
+			        && expire == due.expireat)
+			{
+				Del(due.db, due.key);
+				expired++;
+			}
+			RawDel(due.indexkey);
+		}
+
+		uint64 end = get_current_epoch_micros();
+		LockGuard<ThreadMutex> guard(m_mutex);
+		m_expire_stat.expired_keys += expired;
+		m_expire_stat.sweeps++;
+		m_expire_stat.last_sweep_micros = end - start;
+		m_expire_stat.total_sweep_micros += end - start;
+		if (end - start > m_expire_stat.max_sweep_micros)
+		{
+			m_expire_stat.max_sweep_micros = end - start;
+		}
+		if (0 == m_expire_stat.sample_time)
+		{
+			m_expire_stat.sample_time = end;
+		}
+		else if (end - m_expire_stat.sample_time >= 1000000)
+		{
+			m_expire_stat.expired_per_sec = (m_expire_stat.expired_keys
+			        - m_expire_stat.sample_expired_keys) * 1000000
+			        / (end - m_expire_stat.sample_time);
+			m_expire_stat.sample_time = end;
+			m_expire_stat.sample_expired_keys = m_expire_stat.expired_keys;
+		}
+		return expired;
+	}
+
+	const std::string Ardb::ExpireStats()
+	{
+		LockGuard<ThreadMutex> guard(m_mutex);
+		char tmp[512];
+		sprintf(tmp,
+		        "expired_keys:%"PRIu64"\r\nexpired_keys_per_sec:%"PRIu64"\r\nexpire_sweeps:%"PRIu64"\r\nexpire_sweep_last_us:%"PRIu64"\r\nexpire_sweep_avg_us:%"PRIu64"\r\nexpire_sweep_max_us:%"PRIu64"\r\n",
+		        m_expire_stat.expired_keys, m_expire_stat.expired_per_sec,
+		        m_expire_stat.sweeps, m_expire_stat.last_sweep_micros,
+		        m_expire_stat.sweeps > 0 ?
+		                m_expire_stat.total_sweep_micros / m_expire_stat.sweeps :
+		                0, m_expire_stat.max_sweep_micros);
+		return tmp;
+	}
+
 	int Ardb::DelValue(KeyObject& key)
 	{
 		if (NULL != m_key_watcher)
@@ -107,6 +282,23 @@ namespace ardb
 		Buffer keybuf(key.key.size() + 16);
 		encode_key(keybuf, key);
 		Slice k(keybuf.GetRawReadBuffer(), keybuf.ReadableBytes());
+		if (directory_key_type(key.type) != KEY_END)
+		{
+			/*
+			 * A meta record only goes with its emptied key, so does the
+			 * key's TTL, a key created again later must not inherit it.
+			 */
+			BatchWriteGuard guard(GetEngine());
+			KeyObject dk(key.key, KEY_DIRECTORY, key.db);
+			Buffer dkeybuf(key.key.size() + 16);
+			encode_key(dkeybuf, dk);
+			RawDel(Slice(dkeybuf.GetRawReadBuffer(), dkeybuf.ReadableBytes()));
+			KeyObject mk(key.key, KEY_EXPIRATION_MAPPING, key.db);
+			Buffer mkeybuf(key.key.size() + 16);
+			encode_key(mkeybuf, mk);
+			RawDel(Slice(mkeybuf.GetRawReadBuffer(), mkeybuf.ReadableBytes()));
+			return RawDel(k);
+		}
 		return RawDel(k);
 	}
 
@@ -137,23 +329,31 @@ namespace ardb
 		{
 			return ERR_INVALID_ARGS;
 		}
+		/*
+		 * Check all keys before writing anything, a discarded batch would
+		 * also drop the writes of the enclosing group commit.
+		 */
 		SliceArray::iterator kit = keys.begin();
-		SliceArray::iterator vit = values.begin();
-		BatchWriteGuard guard(GetEngine());
 		while (kit != keys.end())
 		{
 			KeyObject keyobject(*kit, KV, db);
 			ValueObject valueobject;
-			if (0 != GetValue(keyobject, &valueobject))
+			if (0 == GetValue(keyobject, &valueobject))
 			{
-				smart_fill_value(*vit, valueobject);
-				SetValue(keyobject, valueobject);
-			} else
-			{
-				guard.MarkFailed();
 				return -1;
 			}
 			kit++;
+		}
+		kit = keys.begin();
+		SliceArray::iterator vit = values.begin();
+		BatchWriteGuard guard(GetEngine());
+		while (kit != keys.end())
+		{
+			KeyObject keyobject(*kit, KV, db);
+			ValueObject valueobject;
+			smart_fill_value(*vit, valueobject);
+			SetValue(keyobject, valueobject);
+			kit++;
 			vit++;
 		}
 		return keys.size();
@@ -162,6 +362,7 @@ namespace ardb
 	int Ardb::Set(const DBID& db, const Slice& key, const Slice& value, int ex,
 			int px, int nxx)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		KeyObject k(key, KV, db);
 		if (-1 == nxx)
 		{
@@ -179,10 +380,9 @@ namespace ardb
 
 		if (px > 0)
 		{
-			PSetEx(db, key, value, px);
+			return PSetEx(db, key, value, px);
 		}
-		SetEx(db, key, value, ex);
-		return 0;
+		return SetEx(db, key, value, ex);
 	}
 
 	int Ardb::Set(const DBID& db, const Slice& key, const Slice& value)
@@ -192,6 +392,7 @@ namespace ardb
 
 	int Ardb::SetNX(const DBID& db, const Slice& key, const Slice& value)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		if (!Exists(db, key))
 		{
 			KeyObject keyobject(key, KV, db);
@@ -211,6 +412,7 @@ namespace ardb
 	int Ardb::PSetEx(const DBID& db, const Slice& key, const Slice& value,
 			uint32_t ms)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		KeyObject keyobject(key, KV, db);
 		ValueObject valueobject;
 		smart_fill_value(value, valueobject);
@@ -245,17 +447,43 @@ namespace ardb
 		return ret;
 	}
 
+	/*
+	 * All keys are looked up by the engine at once, so MGET sees the keys
+	 * as of one point in time.
+	 */
 	int Ardb::MGet(const DBID& db, SliceArray& keys, ValueArray& value)
 	{
+		Buffer keybuf(keys.size() * 32);
+		std::vector<uint32> offsets;
 		SliceArray::iterator it = keys.begin();
-		int i = 0;
 		while (it != keys.end())
+		{
+			KeyObject keyobject(*it, KV, db);
+			offsets.push_back(keybuf.ReadableBytes());
+			encode_key(keybuf, keyobject);
+			it++;
+		}
+		offsets.push_back(keybuf.ReadableBytes());
+		SliceArray rawkeys;
+		for (uint32 i = 0; i < keys.size(); i++)
+		{
+			rawkeys.push_back(
+					Slice(keybuf.GetRawReadBuffer() + offsets[i],
+							offsets[i + 1] - offsets[i]));
+		}
+		StringArray rawvalues;
+		std::vector<int> errs;
+		GetEngine()->MultiGet(rawkeys, rawvalues, errs);
+		for (uint32 i = 0; i < keys.size(); i++)
 		{
 			ValueObject v;
 			value.push_back(v);
-			GetValue(db, *it, &value[i]);
-			it++;
-			i++;
+			if (0 == errs[i]
+					&& 0 != DecodeRawValue(rawkeys[i], rawvalues[i],
+							&value.back(), NULL))
+			{
+				value.back().Clear();
+			}
 		}
 		return 0;
 	}
@@ -267,6 +495,7 @@ namespace ardb
 		{
 			case KV:
 			{
+				KeyLockerGuard keyguard(m_key_locker, db, key);
 				KeyObject k(key, KV, db);
 				DelValue(k);
 				break;
@@ -306,6 +535,11 @@ namespace ardb
 				return -1;
 			}
 		}
+		if (type != KV)
+		{
+			KeyObject mk(key, KEY_EXPIRATION_MAPPING, db);
+			DelValue(mk);
+		}
 		return 0;
 	}
 
@@ -333,13 +567,26 @@ namespace ardb
 
 	int Ardb::SetExpiration(const DBID& db, const Slice& key, uint64_t expire)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		KeyObject keyobject(key, KV, db);
 		ValueObject value;
 		if (0 == GetValue(keyobject, &value))
 		{
 			return SetValue(keyobject, value, expire);
 		}
-		return ERR_NOT_EXIST;
+		if (Type(db, key) < 0)
+		{
+			return ERR_NOT_EXIST;
+		}
+		BatchWriteGuard guard(GetEngine());
+		KeyObject mk(key, KEY_EXPIRATION_MAPPING, db);
+		if (0 == expire)
+		{
+			return DelValue(mk);
+		}
+		ValueObject mv((int64) expire);
+		AddExpireIndex(db, key, expire);
+		return SetValue(mk, mv);
 	}
 
 	int Ardb::Strlen(const DBID& db, const Slice& key)
@@ -378,20 +625,22 @@ namespace ardb
 
 	int Ardb::Pexpireat(const DBID& db, const Slice& key, uint64_t ms)
 	{
-		return SetExpiration(db, key, ms);
+		return SetExpiration(db, key, ms * 1000);
 	}
 
 	int64 Ardb::PTTL(const DBID& db, const Slice& key)
 	{
-		ValueObject v;
-		KeyObject k(key, KV, db);
 		uint64 expire = 0;
-		if (0 == GetValue(k, &v, &expire))
+		if (0 == GetExpiration(db, key, expire) || Type(db, key) >= 0)
 		{
 			int ttl = 0;
+			uint64_t now = get_current_epoch_micros();
+			if (expire > 0 && expire <= now)
+			{
+				return ERR_NOT_EXIST;
+			}
 			if (expire > 0)
 			{
-				uint64_t now = get_current_epoch_micros();
 				uint64_t ttlsus = expire - now;
 				ttl = ttlsus / 1000;
 				if (ttlsus % 1000 >= 500)
@@ -493,8 +742,7 @@ namespace ardb
 		while (keytype <= TABLE_META)
 		{
 			KeyObject start(lastkey, keytype, db);
-			HashKeyObject hstart(lastkey, Slice(), db);
-			Iterator* iter = FindValue(keytype == HASH_FIELD ? hstart : start);
+			Iterator* iter = FindValue(start);
 			if (!iter->Valid())
 			{
 				DELETE(iter);
@@ -529,10 +777,10 @@ namespace ardb
 							}
 							case ZSET_META:
 							{
-								keytype = HASH_FIELD;
+								keytype = HASH_META;
 								break;
 							}
-							case HASH_FIELD:
+							case HASH_META:
 							{
 								keytype = LIST_META;
 								break;
@@ -565,5 +813,109 @@ namespace ardb
 		}
 		return 0;
 	}
+
+	/*
+	 * Key types reported by SCAN, all other types only hold parts of keys
+	 * which are reported through one of these.
+	 */
+	static bool is_scan_key_type(KeyType type)
+	{
+		switch (type)
+		{
+			case KV:
+			case SET_META:
+			case ZSET_META:
+			case HASH_META:
+			case LIST_META:
+			case TABLE_META:
+			case BITSET_META:
+			{
+				return true;
+			}
+			default:
+			{
+				return false;
+			}
+		}
+	}
+
+	/*
+	 * Incremental key iteration. The cursor is the hex encoded engine key
+	 * to resume from, "0" starts a new iteration and is returned once the
+	 * db is exhausted. At most 'limit' keys are visited per call, MATCH and
+	 * TYPE filters apply to the visited keys like redis does.
+	 */
+	int Ardb::Scan(const DBID& db, const std::string& cursor,
+	        const std::string& pattern, uint32 limit, int type,
+	        StringArray& keys, std::string& newcursor)
+	{
+		std::string seek;
+		if (cursor == "0")
+		{
+			KeyObject start(Slice(), type < 0 ? KV : (KeyType) type, db);
+			Buffer keybuf(16);
+			encode_key(keybuf, start);
+			seek.assign(keybuf.GetRawReadBuffer(), keybuf.ReadableBytes());
+		}
+		else
+		{
+			DBID cursordb;
+			KeyType cursortype;
+			if (!string_fromhex(cursor, seek)
+			        || !peek_dbkey_header(seek, cursordb, cursortype)
+			        || cursordb != db || (type >= 0 && cursortype != type))
+			{
+				return ERR_INVALID_ARGS;
+			}
+		}
+		newcursor = "0";
+		uint32 visited = 0;
+		Iterator* iter = GetEngine()->Find(seek, false);
+		while (NULL != iter && iter->Valid())
+		{
+			Slice tmpkey = iter->Key();
+			DBID kdb;
+			KeyType ktype;
+			if (!peek_dbkey_header(tmpkey, kdb, ktype) || kdb != db
+			        || (type >= 0 && ktype != type))
+			{
+				break;
+			}
+			if (!is_scan_key_type(ktype))
+			{
+				/*
+				 * Jump over the whole range of this type, every key of the
+				 * next type starts with its bare header.
+				 */
+				Buffer keybuf(16);
+				BufferHelper::WriteFixUInt32(keybuf, (uint32) (db << 8) + ktype + 1);
+				seek.assign(keybuf.GetRawReadBuffer(), keybuf.ReadableBytes());
+				DELETE(iter);
+				iter = GetEngine()->Find(seek, false);
+				continue;
+			}
+			if (visited >= limit)
+			{
+				newcursor = string_tohex(tmpkey.ToString());
+				break;
+			}
+			KeyObject* kk = decode_key(tmpkey, NULL);
+			if (NULL == kk)
+			{
+				iter->Next();
+				continue;
+			}
+			visited++;
+			std::string key(kk->key.data(), kk->key.size());
+			DELETE(kk);
+			if (fnmatch(pattern.c_str(), key.c_str(), 0) == 0)
+			{
+				keys.push_back(key);
+			}
+			iter->Next();
+		}
+		DELETE(iter);
+		return 0;
+	}
 }
 
@@ -38,8 +38,8 @@ namespace ardb
 			return false;
 		}
 		return BufferHelper::ReadVarUInt32(*(v.v.raw), meta.size)
-		        && BufferHelper::ReadFixFloat(*(v.v.raw), meta.min_score)
-		        && BufferHelper::ReadFixFloat(*(v.v.raw), meta.max_score);
+		        && BufferHelper::ReadVarInt64(*(v.v.raw), meta.min_index)
+		        && BufferHelper::ReadVarInt64(*(v.v.raw), meta.max_index);
 	}
 	static void EncodeListMetaData(ValueObject& v, ListMetaValue& meta)
 	{
@@ -49,8 +49,24 @@ namespace ardb
 			v.v.raw = new Buffer(16);
 		}
 		BufferHelper::WriteVarUInt32(*(v.v.raw), meta.size);
-		BufferHelper::WriteFixFloat(*(v.v.raw), meta.min_score);
-		BufferHelper::WriteFixFloat(*(v.v.raw), meta.max_score);
+		BufferHelper::WriteVarInt64(*(v.v.raw), meta.min_index);
+		BufferHelper::WriteVarInt64(*(v.v.raw), meta.max_index);
+	}
+
+	/*
+	 * Turn a redis style list offset into the element index, false if it is
+	 * out of the list.
+	 */
+	static bool list_offset_index(ListMetaValue& meta, int offset,
+	        int64& index)
+	{
+		int64 pos = offset < 0 ? (int64) meta.size + offset : offset;
+		if (pos < 0 || pos >= (int64) meta.size)
+		{
+			return false;
+		}
+		index = meta.min_index + pos;
+		return true;
 	}
 
 	int Ardb::GetListMetaValue(const DBID& db, const Slice& key,
@@ -74,20 +90,58 @@ namespace ardb
 	void Ardb::SetListMetaValue(const DBID& db, const Slice& key,
 	        ListMetaValue& meta)
 	{
+		KeyObject k(key, LIST_META, db);
+		if (meta.size == 0)
+		{
+			DelValue(k);
+			return;
+		}
 		ValueObject v;
 		EncodeListMetaData(v, meta);
-		KeyObject k(key, LIST_META, db);
 		SetValue(k, v);
 	}
 
+	/*
+	 * Move the elements with indexes in [from, to] by 'delta', one position
+	 * to either side. The walk runs away from the written indexes, so every
+	 * element is read before it is overwritten.
+	 */
+	void Ardb::ListShift(const DBID& db, const Slice& key, int64 from,
+	        int64 to, int64 delta)
+	{
+		if (from > to)
+		{
+			return;
+		}
+		struct ShiftWalk: public WalkHandler
+		{
+				Ardb* ldb;
+				int64 l_delta;
+				uint64 l_count;
+				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
+				{
+					ListKeyObject* lk = (ListKeyObject*) k;
+					ListKeyObject dst(lk->key, lk->index + l_delta, lk->db);
+					ldb->SetValue(dst, *v);
+					return cursor + 1 >= l_count ? -1 : 0;
+				}
+				ShiftWalk(Ardb* db, int64 d, uint64 count) :
+						ldb(db), l_delta(d), l_count(count)
+				{
+				}
+		} walk(this, delta, to - from + 1);
+		ListKeyObject lk(key, delta > 0 ? to : from, db);
+		Walk(lk, delta > 0, &walk);
+	}
+
 	int Ardb::ListPush(const DBID& db, const Slice& key, const Slice& value,
-	        bool athead, bool onlyexist, float withscore)
+	        bool athead, bool onlyexist)
 	{
 		KeyLockerGuard keyguard(m_key_locker, db, key);
 		KeyObject k(key, LIST_META, db);
 		ValueObject v;
 		ListMetaValue meta;
-		float score = withscore != FLT_MAX ? withscore : 0;
+		int64 index = 0;
 		if (0 == GetValue(k, &v))
 		{
 			if (!DecodeListMetaData(v, meta))
@@ -95,30 +149,15 @@ namespace ardb
 				return ERR_INVALID_TYPE;
 			}
 			meta.size++;
-			if (withscore != FLT_MAX)
+			if (athead)
 			{
-				score = withscore;
-				if (score < meta.min_score)
-				{
-					meta.min_score = score;
-				}
-				else if (score > meta.max_score)
-				{
-					meta.max_score = score;
-				}
+				meta.min_index--;
+				index = meta.min_index;
 			}
 			else
 			{
-				if (athead)
-				{
-					meta.min_score--;
-					score = meta.min_score;
-				}
-				else
-				{
-					meta.max_score++;
-					score = meta.max_score;
-				}
+				meta.max_index++;
+				index = meta.max_index;
 			}
 		}
 		else
@@ -128,16 +167,16 @@ namespace ardb
 				return ERR_NOT_EXIST;
 			}
 			meta.size++;
-			score = 0;
 		}
 		BatchWriteGuard guard(GetEngine());
-		ListKeyObject lk(key, score, db);
+		ListKeyObject lk(key, index, db);
 		ValueObject lv;
 		smart_fill_value(value, lv);
 		if (0 == SetValue(lk, lv))
 		{
-			EncodeListMetaData(v, meta);
-			return SetValue(k, v) == 0 ? meta.size : -1;
+			ValueObject mv;
+			EncodeListMetaData(mv, meta);
+			return SetValue(k, mv) == 0 ? meta.size : -1;
 		}
 		return -1;
 	}
@@ -163,6 +202,11 @@ namespace ardb
 		return len < 0 ? 0 : len;
 	}
 
+	/*
+	 * The new element takes the index next to the pivot and the elements
+	 * on the shorter side of the pivot move one position outwards, so the
+	 * indexes stay dense.
+	 */
 	int Ardb::LInsert(const DBID& db, const Slice& key, const Slice& opstr,
 	        const Slice& pivot, const Slice& value)
 	{
@@ -175,71 +219,62 @@ namespace ardb
 		{
 			return ERR_INVALID_OPERATION;
 		}
-		ListKeyObject lk(key, -FLT_MAX, db);
+		KeyLockerGuard keyguard(m_key_locker, db, key);
+		ListMetaValue meta;
+		GetListMetaValue(db, key, meta);
+		if (meta.size == 0)
+		{
+			return 0;
+		}
+		ListKeyObject lk(key, meta.min_index, db);
 		struct LInsertWalk: public WalkHandler
 		{
-				bool before_pivot;
-				float pivot_score;
-				float next_score;
+				int64 pivot_index;
 				bool found;
 				const Slice& cmp_value;
 				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
 				{
-					ListKeyObject* sek = (ListKeyObject*) k;
-					if (found && !before_pivot)
-					{
-						next_score = sek->score;
-						return -1;
-					}
 					value_convert_to_raw(*v);
 					Slice cmp(v->v.raw->GetRawReadBuffer(),
 					        v->v.raw->ReadableBytes());
 					if (cmp.compare(cmp_value) == 0)
 					{
-						pivot_score = sek->score;
+						pivot_index = ((ListKeyObject*) k)->index;
 						found = true;
-						if (before_pivot)
-						{
-							return -1;
-						}
-					}
-					else
-					{
-						if (before_pivot)
-						{
-							next_score = sek->score;
-						}
+						return -1;
 					}
 					return 0;
 				}
-				LInsertWalk(bool flag, const Slice& value) :
-						before_pivot(flag), pivot_score(-FLT_MAX), next_score(
-						        -FLT_MAX), found(false), cmp_value(value)
+				LInsertWalk(const Slice& value) :
+						pivot_index(0), found(false), cmp_value(value)
 				{
 				}
-		} walk(before, pivot);
+		} walk(pivot);
 		Walk(lk, false, &walk);
 		if (!walk.found)
 		{
 			return ERR_NOT_EXIST;
 		}
-		float score = 0;
-		if (walk.next_score != -FLT_MAX)
+		int64 index = before ? walk.pivot_index : walk.pivot_index + 1;
+		BatchWriteGuard guard(GetEngine());
+		if (index - meta.min_index < meta.max_index + 1 - index)
 		{
-			score = (walk.next_score + walk.pivot_score) / 2;
+			ListShift(db, key, meta.min_index, index - 1, -1);
+			meta.min_index--;
+			index--;
 		}
 		else
 		{
-			if (before)
-			{
-				score = walk.pivot_score - 1;
-			}
-			else
-			{
-				score = walk.pivot_score + 1;
-			}
+			ListShift(db, key, index, meta.max_index, 1);
+			meta.max_index++;
 		}
-		return ListPush(db, key, value, true, false, score);
+		ListKeyObject ek(key, index, db);
+		ValueObject ev;
+		smart_fill_value(value, ev);
+		SetValue(ek, ev);
+		meta.size++;
+		SetListMetaValue(db, key, meta);
+		return meta.size;
 	}
 
 	int Ardb::ListPop(const DBID& db, const Slice& key, bool athead,
@@ -249,7 +284,6 @@ namespace ardb
 		KeyObject k(key, LIST_META, db);
 		ValueObject v;
 		ListMetaValue meta;
-		float score;
 		if (0 == GetValue(k, &v))
 		{
 			if (!DecodeListMetaData(v, meta))
@@ -260,62 +294,27 @@ namespace ardb
 			{
 				return ERR_NOT_EXIST;
 			}
+			ListKeyObject lk(key, athead ? meta.min_index : meta.max_index,
+			        db);
+			ValueObject lv;
+			if (0 != GetValue(lk, &lv))
+			{
+				return ERR_NOT_EXIST;
+			}
+			lv.ToString(value);
 			meta.size--;
 			if (athead)
 			{
-				score = meta.min_score;
-				//meta.min_score = meta.min_score + 1;
+				meta.min_index++;
 			}
 			else
 			{
-				score = meta.max_score;
-				//meta.max_score = meta.max_score-1;
-			}
-			if (meta.size == 0)
-			{
-				meta.min_score = meta.max_score = 0;
+				meta.max_index--;
 			}
-			ListKeyObject lk(key, score, db);
 			BatchWriteGuard guard(GetEngine());
-			struct LPopWalk: public WalkHandler
-			{
-					Ardb* ldb;
-					std::string& pop_value;
-					ListMetaValue& lmeta;
-					bool reverse;
-					int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
-					{
-						if (cursor == 0)
-						{
-							ListKeyObject* lk = (ListKeyObject*) k;
-							v->ToString(pop_value);
-							ldb->DelValue(*lk);
-							return 0;
-						}
-						else
-						{
-							ListKeyObject* lk = (ListKeyObject*) k;
-							if (reverse)
-							{
-								lmeta.max_score = lk->score;
-							}
-							else
-							{
-								lmeta.min_score = lk->score;
-							}
-							return -1;
-						}
-					}
-					LPopWalk(Ardb* db, std::string& v,
-					        ListMetaValue& meta, bool r) :
-							ldb(db), pop_value(v), lmeta(meta), reverse(
-							        r)
-					{
-					}
-			} walk(this,value, meta, !athead);
-			Walk(lk, !athead, &walk);
-			EncodeListMetaData(v, meta);
-			return SetValue(k, v);
+			DelValue(lk);
+			SetListMetaValue(db, key, meta);
+			return 0;
 		}
 		else
 		{
@@ -335,40 +334,21 @@ namespace ardb
 	int Ardb::LIndex(const DBID& db, const Slice& key, int index,
 	        std::string& v)
 	{
-		ListKeyObject lk(key, -FLT_MAX, db);
-		bool reverse = false;
-		if (index < 0)
+		ListMetaValue meta;
+		GetListMetaValue(db, key, meta);
+		int64 pos;
+		if (!list_offset_index(meta, index, pos))
 		{
-			index = 0 - index;
-			lk.score = FLT_MAX;
-			reverse = true;
+			return ERR_NOT_EXIST;
 		}
-		struct LIndexWalk: public WalkHandler
-		{
-				uint32 lcursor;
-				uint32 index;
-				std::string& found_value;
-				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
-				{
-					if (cursor == index)
-					{
-						v->ToString(found_value);
-						return -1;
-					}
-					lcursor++;
-					return 0;
-				}
-				LIndexWalk(uint32 i, std::string& v) :
-						lcursor(0), index(i), found_value(v)
-				{
-				}
-		} walk((uint32)index, v);
-		Walk(lk, reverse, &walk);
-		if (walk.lcursor == walk.index)
+		ListKeyObject lk(key, pos, db);
+		ValueObject lv;
+		if (0 != GetValue(lk, &lv))
 		{
-			return 0;
+			return ERR_NOT_EXIST;
 		}
-		return ERR_NOT_EXIST;
+		lv.ToString(v);
+		return 0;
 	}
 
 	int Ardb::LRange(const DBID& db, const Slice& key, int start, int end,
@@ -397,33 +377,29 @@ namespace ardb
 		{
 			return 0;
 		}
-		if (end < 0)
+		if (end >= len)
 		{
-			end = 0;
+			end = len - 1;
 		}
-		ListKeyObject lk(key, meta.min_score, db);
+		if (end < start)
+		{
+			return 0;
+		}
+		ListKeyObject lk(key, meta.min_index + start, db);
 		struct LRangeWalk: public WalkHandler
 		{
-				uint32 l_start;
-				uint32 l_stop;
+				uint32 l_count;
 				ValueArray& found_values;
 				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
 				{
-					if (cursor >= l_start && cursor <= l_stop)
-					{
-						found_values.push_back(*v);
-					}
-					if (cursor >= l_stop)
-					{
-						return -1;
-					}
-					return 0;
+					found_values.push_back(*v);
+					return cursor + 1 >= l_count ? -1 : 0;
 				}
-				LRangeWalk(int start, int stop, ValueArray& vs) :
-						l_start(start), l_stop(stop), found_values(vs)
+				LRangeWalk(uint32 count, ValueArray& vs) :
+						l_count(count), found_values(vs)
 				{
 				}
-		} walk(start, end, values);
+		} walk(end - start + 1, values);
 		Walk(lk, false, &walk);
 		return 0;
 	}
@@ -431,30 +407,26 @@ namespace ardb
 	int Ardb::LClear(const DBID& db, const Slice& key)
 	{
 		KeyLockerGuard keyguard(m_key_locker, db, key);
-		ListKeyObject lk(key, -FLT_MAX, db);
-		struct LClearWalk: public WalkHandler
-		{
-				Ardb* z_db;
-				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
-				{
-					ListKeyObject* sek = (ListKeyObject*) k;
-					z_db->DelValue(*sek);
-					std::string str;
-					v->ToString(str);
-					return 0;
-				}
-				LClearWalk(Ardb* db) :
-						z_db(db)
-				{
-				}
-		} walk(this);
+		ListMetaValue meta;
+		GetListMetaValue(db, key, meta);
 		BatchWriteGuard guard(GetEngine());
-		Walk(lk, false, &walk);
+		if (meta.size > 0)
+		{
+			for (int64 i = meta.min_index; i <= meta.max_index; i++)
+			{
+				ListKeyObject lk(key, i, db);
+				DelValue(lk);
+			}
+		}
 		KeyObject k(key, LIST_META, db);
 		DelValue(k);
 		return 0;
 	}
 
+	/*
+	 * Removed elements leave holes which are closed by moving the elements
+	 * on the shorter side of the removed range inwards.
+	 */
 	int Ardb::LRem(const DBID& db, const Slice& key, int count,
 	        const Slice& value)
 	{
@@ -465,96 +437,112 @@ namespace ardb
 		{
 			return 0;
 		}
-		ListKeyObject lk(key, meta.min_score, db);
+		ListKeyObject lk(key, meta.min_index, db);
 		int total = count;
 		bool fromhead = true;
 		if (count < 0)
 		{
 			fromhead = false;
 			total = 0 - count;
-			lk.score = meta.max_score;
+			lk.index = meta.max_index;
 		}
 		struct LRemWalk: public WalkHandler
 		{
-				Ardb* z_db;
 				const Slice& cmp_value;
-				int remcount;
 				int rem_total;
+				std::set<int64> removed;
 				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
 				{
-					ListKeyObject* sek = (ListKeyObject*) k;
+					value_convert_to_raw(*v);
 					Slice cmp(v->v.raw->GetRawReadBuffer(),
 					        v->v.raw->ReadableBytes());
 					if (cmp.compare(cmp_value) == 0)
 					{
-						z_db->DelValue(*sek);
-						remcount++;
-						if (rem_total == remcount)
+						removed.insert(((ListKeyObject*) k)->index);
+						if (rem_total == (int) removed.size())
 						{
 							return -1;
 						}
 					}
 					return 0;
 				}
-				LRemWalk(Ardb* db, const Slice& v, int total) :
-						z_db(db), cmp_value(v), remcount(0), rem_total(total)
+				LRemWalk(const Slice& v, int total) :
+						cmp_value(v), rem_total(total)
 				{
 				}
-		} walk(this, value, total);
-		BatchWriteGuard guard(GetEngine());
+		} walk(value, total);
 		Walk(lk, !fromhead, &walk);
-		meta.size -= walk.remcount;
-		SetListMetaValue(db, key, meta);
-		return walk.remcount;
-	}
-
-	int Ardb::LSet(const DBID& db, const Slice& key, int index,
-	        const Slice& value)
-	{
-		int len = LLen(db, key);
-		if (len <= 0)
-		{
-			return ERR_NOT_EXIST;
-		}
-		if (index < 0)
-		{
-			index += len;
-		}
-		if (index >= len)
+		if (walk.removed.empty())
 		{
-			return ERR_NOT_EXIST;
+			return 0;
 		}
-		ListKeyObject lk(key, -FLT_MAX, db);
-		struct LSetWalk: public WalkHandler
+		int64 first = *(walk.removed.begin());
+		int64 last = *(walk.removed.rbegin());
+		bool tohead = last - meta.min_index < meta.max_index - first;
+		struct LCompactWalk: public WalkHandler
 		{
-				Ardb* z_db;
-				const Slice& set_value;
-				uint32 lcursor;
-				uint32 dst_idx;
+				Ardb* ldb;
+				std::set<int64>& l_removed;
+				int64 l_next;
+				int64 l_step;
 				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
 				{
-					ListKeyObject* sek = (ListKeyObject*) k;
-					if (cursor == dst_idx)
+					ListKeyObject* lk = (ListKeyObject*) k;
+					if (l_removed.count(lk->index) == 0)
 					{
-						ValueObject v;
-						smart_fill_value(set_value, v);
-						z_db->SetValue(*sek, v);
-						return -1;
+						if (lk->index != l_next)
+						{
+							ListKeyObject dst(lk->key, l_next, lk->db);
+							ldb->SetValue(dst, *v);
+						}
+						l_next += l_step;
 					}
-					lcursor++;
 					return 0;
 				}
-				LSetWalk(Ardb* db, const Slice& v, uint32 index) :
-						z_db(db), set_value(v), lcursor(0), dst_idx(index)
+				LCompactWalk(Ardb* db, std::set<int64>& removed, int64 next,
+				        int64 step) :
+						ldb(db), l_removed(removed), l_next(next), l_step(step)
 				{
 				}
-		} walk(this, value, (uint32)index);
-		Walk(lk, false, &walk);
-		if (walk.lcursor != walk.dst_idx)
+		} compact(this, walk.removed, tohead ? last : first, tohead ? -1 : 1);
+		BatchWriteGuard guard(GetEngine());
+		ListKeyObject start(key, tohead ? last : first, db);
+		Walk(start, tohead, &compact);
+		int64 size = walk.removed.size();
+		for (int64 i = 0; i < size; i++)
+		{
+			ListKeyObject dk(key, tohead ? meta.min_index + i :
+			        meta.max_index - i, db);
+			DelValue(dk);
+		}
+		if (tohead)
+		{
+			meta.min_index += size;
+		}
+		else
+		{
+			meta.max_index -= size;
+		}
+		meta.size -= size;
+		SetListMetaValue(db, key, meta);
+		return size;
+	}
+
+	int Ardb::LSet(const DBID& db, const Slice& key, int index,
+	        const Slice& value)
+	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
+		ListMetaValue meta;
+		GetListMetaValue(db, key, meta);
+		int64 pos;
+		if (!list_offset_index(meta, index, pos))
 		{
 			return ERR_NOT_EXIST;
 		}
-		return 0;
+		ListKeyObject lk(key, pos, db);
+		ValueObject v;
+		smart_fill_value(value, v);
+		return SetValue(lk, v);
 	}
 
 	int Ardb::LTrim(const DBID& db, const Slice& key, int start, int stop)
@@ -579,49 +567,30 @@ namespace ardb
 		{
 			start = 0;
 		}
-		if (stop < 0)
+		if (stop >= len)
 		{
-			stop = 0;
+			stop = len - 1;
 		}
-		if (start >= len)
+		if (start >= len || start > stop)
 		{
 			return LClear(db, key);
 		}
-		ListKeyObject lk(key, meta.min_score, db);
-		struct LTrimWalk: public WalkHandler
-		{
-				Ardb* ldb;
-				uint32 lstart, lstop;
-				ListMetaValue& lmeta;
-				LTrimWalk(Ardb* db, int start, int stop, ListMetaValue& meta) :
-						ldb(db), lstart(start), lstop(stop), lmeta(meta)
-				{
-				}
-				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
-				{
-					ListKeyObject* lek = (ListKeyObject*) k;
-					if (cursor >= lstart && cursor <= lstop)
-					{
-						if (lek->score < lmeta.min_score)
-						{
-							lmeta.min_score = lek->score;
-						}
-						if (lek->score > lmeta.max_score)
-						{
-							lmeta.max_score = lek->score;
-						}
-						return 0;
-					}
-					else
-					{
-						lmeta.size--;
-						ldb->DelValue(*lek);
-					}
-					return 0;
-				}
-		} walk(this, start, stop, meta);
 		BatchWriteGuard guard(GetEngine());
-		Walk(lk, false, &walk);
+		int64 min_index = meta.min_index + start;
+		int64 max_index = meta.min_index + stop;
+		for (int64 i = meta.min_index; i < min_index; i++)
+		{
+			ListKeyObject lk(key, i, db);
+			DelValue(lk);
+		}
+		for (int64 i = max_index + 1; i <= meta.max_index; i++)
+		{
+			ListKeyObject lk(key, i, db);
+			DelValue(lk);
+		}
+		meta.min_index = min_index;
+		meta.max_index = max_index;
+		meta.size = stop - start + 1;
 		SetListMetaValue(db, key, meta);
 		return 0;
 	}
@@ -643,5 +612,70 @@ namespace ardb
 		}
 		return ERR_NOT_EXIST;
 	}
+
+	/*
+	 * Data format versions before 5 keyed list elements by a float score,
+	 * renumber the elements of every list from 0 in the old order.
+	 */
+	int Ardb::RebuildListIndex()
+	{
+		static const uint32 kBatchSize = 1024;
+		DBID lastdb = 0;
+		std::string lastkey;
+		ListMetaValue meta;
+		uint64 count = 0;
+		Iterator* iter = GetEngine()->Find(Slice(), false);
+		GetEngine()->BeginBatchWrite();
+		while (NULL != iter && iter->Valid())
+		{
+			DBID db;
+			KeyType type;
+			if (peek_dbkey_header(iter->Key(), db, type) && type == LIST_ELEMENT)
+			{
+				Buffer buf(const_cast<char*>(iter->Key().data()), 0,
+				        iter->Key().size());
+				uint32 header;
+				Slice name;
+				float score;
+				if (BufferHelper::ReadFixUInt32(buf, header)
+				        && BufferHelper::ReadOrderedSlice(buf, name)
+				        && BufferHelper::ReadOrderedFloat(buf, score)
+				        && buf.ReadableBytes() == 0)
+				{
+					if (meta.size > 0
+					        && (db != lastdb || name.compare(lastkey) != 0))
+					{
+						SetListMetaValue(lastdb, lastkey, meta);
+						meta = ListMetaValue();
+					}
+					lastdb = db;
+					lastkey.assign(name.data(), name.size());
+					ListKeyObject lk(name, meta.size, db);
+					Buffer kbuf(name.size() + 16);
+					encode_key(kbuf, lk);
+					RawSet(Slice(kbuf.GetRawReadBuffer(), kbuf.ReadableBytes()),
+					        iter->Value());
+					RawDel(iter->Key());
+					meta.max_index = meta.size;
+					meta.size++;
+					count++;
+					if (count % kBatchSize == 0)
+					{
+						GetEngine()->CommitBatchWrite();
+						GetEngine()->BeginBatchWrite();
+					}
+				}
+			}
+			iter->Next();
+		}
+		if (meta.size > 0)
+		{
+			SetListMetaValue(lastdb, lastkey, meta);
+		}
+		GetEngine()->CommitBatchWrite();
+		DELETE(iter);
+		INFO_LOG("Renumbered %"PRIu64" list elements.", count);
+		return 0;
+	}
 }
 
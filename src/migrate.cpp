@@ -0,0 +1,211 @@
+ /*
+ *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
+ *All rights reserved.
+ * 
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ * 
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Redis nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ * 
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+ *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ *THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Offline migration of a data dir written by an older data format version
+ * into a new data dir with the current key encoding.
+ */
+#include "ardb.hpp"
+#include "util/helpers.hpp"
+#ifdef __USE_KYOTOCABINET__
+#include "engine/kyotocabinet_engine.hpp"
+typedef ardb::KCDBEngineFactory SelectedDBEngineFactory;
+#elif defined __USE_LMDB__
+#include "engine/lmdb_engine.hpp"
+typedef ardb::LMDBEngineFactory SelectedDBEngineFactory;
+#else
+#include "engine/leveldb_engine.hpp"
+typedef ardb::LevelDBEngineFactory SelectedDBEngineFactory;
+#endif
+
+using namespace ardb;
+
+static const uint32 kMigrateBatchSize = 1024;
+
+void usage()
+{
+	fprintf(stderr,
+			"Usage: ./ardb-migrate /path/to/ardb.conf /path/to/new/data-dir\n");
+	fprintf(stderr,
+			"       Convert the data-dir of the conf file from data format version 1 to version %d.\n",
+			ARDB_FORMAT_VERSION);
+	fprintf(stderr,
+			"       Replace the old data-dir with the new one after success.\n");
+	exit(1);
+}
+
+/*
+ * Version 1 data has no expiration index, build it from the expire time
+ * stored after KV values.
+ */
+static void add_expire_index(Ardb& dst, const KeyObject& k, const Slice& value)
+{
+	Buffer readbuf(const_cast<char*>(value.data()), 0, value.size());
+	ValueObject v;
+	uint64 expire = 0;
+	if (!decode_value(readbuf, v)
+			|| !BufferHelper::ReadVarUInt64(readbuf, expire) || 0 == expire)
+	{
+		return;
+	}
+	ExpireKeyObject ek(k.key, expire, k.db);
+	Buffer kbuf, vbuf;
+	encode_key(kbuf, ek);
+	ValueObject empty;
+	encode_value(vbuf, empty);
+	dst.RawSet(Slice(kbuf.GetRawReadBuffer(), kbuf.ReadableBytes()),
+			Slice(vbuf.GetRawReadBuffer(), vbuf.ReadableBytes()));
+}
+
+static int migrate(KeyValueEngine* src, Ardb& dst)
+{
+	KeyObject verkey(Slice(), KEY_END, ARDB_GLOBAL_DB);
+	Buffer verbuf;
+	encode_key(verbuf, verkey);
+	std::string ver;
+	if (0 != src->Get(Slice(verbuf.GetRawReadBuffer(), verbuf.ReadableBytes()),
+			&ver))
+	{
+		ERROR_LOG("No data format version found in source data.");
+		return -1;
+	}
+	ValueObject vo;
+	Buffer vobuf(const_cast<char*>(ver.data()), 0, ver.size());
+	if (!decode_value(vobuf, vo) || vo.type != INTEGER || vo.v.int_v != 1)
+	{
+		ERROR_LOG("Source data is not data format version 1.");
+		return -1;
+	}
+
+	uint64 count = 0;
+	Iterator* iter = src->Find(Slice(), false);
+	dst.GetEngine()->BeginBatchWrite();
+	while (NULL != iter && iter->Valid())
+	{
+		KeyObject* k = decode_legacy_key(iter->Key(), NULL);
+		if (NULL == k)
+		{
+			ERROR_LOG("Invalid key at record:%"PRIu64, count);
+			dst.GetEngine()->DiscardBatchWrite();
+			DELETE(iter);
+			return -1;
+		}
+		if (k->type != KEY_END)
+		{
+			Buffer kbuf;
+			if (k->type == LIST_ELEMENT)
+			{
+				/*
+				 * Keep the score, UpgradeData renumbers the list elements.
+				 */
+				encode_key_prefix(kbuf, *k);
+				BufferHelper::WriteOrderedFloat(kbuf,
+						((LegacyListKeyObject*) k)->score);
+			}
+			else
+			{
+				encode_key(kbuf, *k);
+			}
+			dst.RawSet(Slice(kbuf.GetRawReadBuffer(), kbuf.ReadableBytes()),
+					iter->Value());
+			if (k->type == KV)
+			{
+				add_expire_index(dst, *k, iter->Value());
+			}
+			count++;
+			if (count % kMigrateBatchSize == 0)
+			{
+				dst.GetEngine()->CommitBatchWrite();
+				dst.GetEngine()->BeginBatchWrite();
+			}
+		}
+		DELETE(k);
+		iter->Next();
+	}
+	dst.GetEngine()->CommitBatchWrite();
+	DELETE(iter);
+	INFO_LOG("Migrated %"PRIu64" records.", count);
+	return dst.UpgradeData(2);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 3)
+	{
+		usage();
+	}
+	Properties props;
+	if (!parse_conf_file(argv[1], props, " "))
+	{
+		printf("Error: Failed to parse conf file:%s\n", argv[1]);
+		return -1;
+	}
+	std::string home;
+	conf_get_string(props, "home", home);
+	setenv("ARDB_HOME", home.empty() ? "../ardb" : home.c_str(), 1);
+	replace_env_var(props);
+
+	std::string dest = argv[2];
+	if (is_dir_exist(dest) || is_file_exist(dest))
+	{
+		printf("Error: Destination %s already exists.\n", dest.c_str());
+		return -1;
+	}
+
+	Properties srcprops = props;
+	srcprops["legacy-key-format"] = "yes";
+	SelectedDBEngineFactory srcfactory(srcprops);
+	KeyValueEngine* src = srcfactory.CreateDB(srcfactory.GetName());
+	if (NULL == src)
+	{
+		printf("Error: Failed to open source data.\n");
+		return -1;
+	}
+
+	Properties dstprops = props;
+	dstprops["data-dir"] = dest;
+	SelectedDBEngineFactory dstfactory(dstprops);
+	int ret = -1;
+	{
+		Ardb dst(&dstfactory, false);
+		if (dst.Init())
+		{
+			ret = migrate(src, dst);
+		}
+	}
+	srcfactory.CloseDB(src);
+	if (0 != ret)
+	{
+		printf("Error: Failed to migrate data to %s.\n", dest.c_str());
+		return -1;
+	}
+	printf("Data migrated to %s with data format version %d.\n", dest.c_str(),
+			ARDB_FORMAT_VERSION);
+	return 0;
+}
@@ -0,0 +1,529 @@
+ /*
+ *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
+ *All rights reserved.
+ * 
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ * 
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Redis nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ * 
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+ *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ *THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "replication.hpp"
+#include "util/crc32c.hpp"
+#include "util/file_helper.hpp"
+#include <sys/stat.h>
+#include <sys/fcntl.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
+#include <algorithm>
+
+/*
+ * Oplog segment layout:
+ *
+ *   header:  "ARDBOPL2"
+ *   record:  [len:4][crc32c:4][seq:8][op:len], the crc covers seq and op
+ *   footer:  [seq:8][offset:8]... [index offset:8][count:4][crc32c:4]"ARDBOPIX"
+ *
+ * The footer is a sparse index with one entry per kOpLogIndexInterval bytes
+ * of records, written when the segment is sealed. Integers are in network
+ * byte order.
+ */
+namespace ardb
+{
+	static const char kOpLogMagic[] = "ARDBOPL2";
+	static const char kOpLogIndexMagic[] = "ARDBOPIX";
+	static const uint32 kOpLogMagicSize = 8;
+	static const uint32 kOpLogRecordHeaderSize = 16;
+	static const uint32 kOpLogIndexEntrySize = 16;
+	static const uint32 kOpLogTrailerSize = 24;
+	static const uint32 kOpLogIndexInterval = 64 * 1024;
+	static const uint32 kOpLogFlushTrigger = 1 * 1024 * 1024;
+	/*
+	 * Set op written without its value, the value is read from the db.
+	 */
+	static const uint8 kOpValueInDB = 0x80;
+
+	CachedWriteOp::CachedWriteOp(uint8 t, OpKey& k) :
+			CachedOp(t), key(k), v(NULL)
+	{
+	}
+	bool CachedWriteOp::IsInDBSet(DBIDSet& dbs)
+	{
+		DBID dbid;
+		KeyType keytype;
+		peek_dbkey_header(key.key, dbid, keytype);
+		if (dbs.count(dbid) == 0)
+		{
+			return false;
+		}
+		return true;
+	}
+	CachedWriteOp::~CachedWriteOp()
+	{
+		DELETE(v);
+	}
+	CachedCmdOp::CachedCmdOp(RedisCommandFrame* c) :
+			CachedOp(kOtherOpType), cmd(c)
+	{
+	}
+	CachedCmdOp::~CachedCmdOp()
+	{
+		DELETE(cmd);
+	}
+
+	OpKey::OpKey(const std::string& k) :
+			key(k)
+	{
+
+	}
+	bool OpKey::operator<(const OpKey& other) const
+	{
+		return key < other.key;
+	}
+
+	static inline uint32 read_fixed32(const char* p)
+	{
+		uint32 v;
+		memcpy(&v, p, sizeof(v));
+		return ntohl(v);
+	}
+
+	static inline uint64 read_fixed64(const char* p)
+	{
+		return ((uint64) read_fixed32(p) << 32) | read_fixed32(p + 4);
+	}
+
+	static bool index_seq_less(uint64 seq, const OpLogIndexEntry& entry)
+	{
+		return seq < entry.seq;
+	}
+
+	void OpLogFile::EncodeOp(Buffer& buf, CachedOp* op)
+	{
+		uint8 optype = op->type;
+		if (optype == kSetOpType || optype == kDelOpType)
+		{
+			CachedWriteOp* writeOp = (CachedWriteOp*) op;
+			if (optype == kSetOpType && NULL == writeOp->v)
+			{
+				optype |= kOpValueInDB;
+			}
+			buf.WriteByte(optype);
+			BufferHelper::WriteVarString(buf, writeOp->key.key);
+			if (optype == kSetOpType)
+			{
+				BufferHelper::WriteVarString(buf, *(writeOp->v));
+			}
+		}
+		else
+		{
+			CachedCmdOp* cmdOp = (CachedCmdOp*) op;
+			buf.WriteByte(optype);
+			BufferHelper::WriteVarUInt32(buf,
+			        cmdOp->cmd->GetArguments().size() + 1);
+			BufferHelper::WriteVarString(buf, cmdOp->cmd->GetCommand());
+			for (uint32 i = 0; i < cmdOp->cmd->GetArguments().size(); i++)
+			{
+				BufferHelper::WriteVarString(buf, *(cmdOp->cmd->GetArgument(i)));
+			}
+		}
+	}
+
+	CachedOp* OpLogFile::DecodeOp(const Slice& op)
+	{
+		Buffer buf(const_cast<char*>(op.data()), 0, op.size());
+		uint8 optype;
+		if (!BufferHelper::ReadFixUInt8(buf, optype))
+		{
+			return NULL;
+		}
+		uint8 type = optype & ~kOpValueInDB;
+		if (type == kSetOpType || type == kDelOpType)
+		{
+			std::string key;
+			if (!BufferHelper::ReadVarString(buf, key))
+			{
+				return NULL;
+			}
+			OpKey ok(key);
+			CachedWriteOp* writeOp = new CachedWriteOp(type, ok);
+			if (optype == kSetOpType)
+			{
+				Slice value;
+				if (!BufferHelper::ReadVarSlice(buf, value))
+				{
+					DELETE(writeOp);
+					return NULL;
+				}
+				writeOp->v = new std::string(value.data(), value.size());
+			}
+			return writeOp;
+		}
+		else if (type == kOtherOpType)
+		{
+			uint32 size;
+			if (!BufferHelper::ReadVarUInt32(buf, size))
+			{
+				return NULL;
+			}
+			ArgumentArray strs;
+			for (uint32 i = 0; i < size; i++)
+			{
+				std::string str;
+				if (!BufferHelper::ReadVarString(buf, str))
+				{
+					return NULL;
+				}
+				strs.push_back(str);
+			}
+			return new CachedCmdOp(new RedisCommandFrame(strs));
+		}
+		return NULL;
+	}
+
+	OpLogFile::OpLogFile(const std::string& path) :
+			m_op_log_file_fd(-1), m_file_path(path), m_last_flush_ts(0), m_write_offset(
+			        0), m_map(NULL), m_map_size(0), m_data_end(0), m_read_offset(
+			        0)
+	{
+	}
+
+	/*
+	 * Reopening the current segment drops a torn last record left by a
+	 * crash, and the footer if the segment was already sealed.
+	 */
+	int OpLogFile::OpenWrite()
+	{
+		if (file_size(m_file_path) > 0)
+		{
+			if (OpenRead() < 0)
+			{
+				std::string old = m_file_path + ".old";
+				WARN_LOG(
+				        "Unreadable oplog file %s is moved to %s.", m_file_path.c_str(), old.c_str());
+				rename(m_file_path.c_str(), old.c_str());
+			}
+			else
+			{
+				m_index.clear();
+				m_read_offset = kOpLogMagicSize;
+				uint64 seq;
+				Slice op;
+				size_t offset = m_read_offset;
+				while (Next(seq, op) == 1)
+				{
+					if (m_index.empty()
+					        || offset - m_index.back().offset
+					                >= kOpLogIndexInterval)
+					{
+						OpLogIndexEntry entry = { seq, offset };
+						m_index.push_back(entry);
+					}
+					offset = m_read_offset;
+				}
+				m_write_offset = offset;
+				size_t size = m_map_size;
+				Close();
+				if (m_write_offset < size
+				        && 0 != truncate(m_file_path.c_str(), m_write_offset))
+				{
+					ERROR_LOG(
+					        "Failed to truncate oplog file:%s", m_file_path.c_str());
+					return -1;
+				}
+			}
+		}
+		int mod = S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
+		m_op_log_file_fd = ::open(m_file_path.c_str(),
+		        O_RDWR | O_CREAT | O_APPEND, mod);
+		if (m_op_log_file_fd > 0)
+		{
+			m_write_buffer.EnsureWritableBytes(kOpLogFlushTrigger);
+			if (0 == m_write_offset)
+			{
+				m_write_buffer.Write(kOpLogMagic, kOpLogMagicSize);
+				m_write_offset = kOpLogMagicSize;
+			}
+		}
+		return m_op_log_file_fd;
+	}
+
+	int OpLogFile::OpenRead()
+	{
+		m_op_log_file_fd = ::open(m_file_path.c_str(), O_RDONLY);
+		if (m_op_log_file_fd < 0)
+		{
+			return -1;
+		}
+		struct stat st;
+		if (0 != fstat(m_op_log_file_fd, &st)
+		        || st.st_size < (off_t) kOpLogMagicSize)
+		{
+			Close();
+			return -1;
+		}
+		void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED,
+		        m_op_log_file_fd, 0);
+		if (MAP_FAILED == map)
+		{
+			ERROR_LOG(
+			        "Failed to mmap oplog file %s:%s", m_file_path.c_str(), strerror(errno));
+			Close();
+			return -1;
+		}
+		m_map = (char*) map;
+		m_map_size = st.st_size;
+		madvise(m_map, m_map_size, MADV_SEQUENTIAL);
+		if (0 != memcmp(m_map, kOpLogMagic, kOpLogMagicSize))
+		{
+			Close();
+			return -1;
+		}
+		m_data_end = m_map_size;
+		m_read_offset = kOpLogMagicSize;
+		LoadIndex();
+		return m_op_log_file_fd;
+	}
+
+	void OpLogFile::LoadIndex()
+	{
+		m_index.clear();
+		if (m_map_size < kOpLogMagicSize + kOpLogTrailerSize)
+		{
+			return;
+		}
+		const char* trailer = m_map + m_map_size - kOpLogTrailerSize;
+		if (0
+		        != memcmp(trailer + kOpLogTrailerSize - kOpLogMagicSize,
+		                kOpLogIndexMagic, kOpLogMagicSize))
+		{
+			return;
+		}
+		uint64 index_offset = read_fixed64(trailer);
+		uint32 count = read_fixed32(trailer + 8);
+		uint32 crc = read_fixed32(trailer + 12);
+		if (index_offset < kOpLogMagicSize
+		        || index_offset + (uint64) count * kOpLogIndexEntrySize
+		                + kOpLogTrailerSize != m_map_size
+		        || crc
+		                != crc32c(m_map + index_offset,
+		                        count * kOpLogIndexEntrySize))
+		{
+			WARN_LOG("Invalid index in oplog file:%s", m_file_path.c_str());
+			return;
+		}
+		m_data_end = index_offset;
+		m_index.resize(count);
+		for (uint32 i = 0; i < count; i++)
+		{
+			const char* p = m_map + index_offset + i * kOpLogIndexEntrySize;
+			m_index[i].seq = read_fixed64(p);
+			m_index[i].offset = read_fixed64(p + 8);
+		}
+	}
+
+	bool OpLogFile::PeekFirstSeq(uint64& seq)
+	{
+		if (NULL == m_map
+		        || m_data_end < kOpLogMagicSize + kOpLogRecordHeaderSize)
+		{
+			return false;
+		}
+		seq = read_fixed64(m_map + kOpLogMagicSize + 8);
+		return true;
+	}
+
+	/*
+	 * Binary search the index, then walk the record headers to the first
+	 * record whose seq is not less than 'seq'.
+	 */
+	bool OpLogFile::Seek(uint64 seq)
+	{
+		if (NULL == m_map)
+		{
+			return false;
+		}
+		m_read_offset = kOpLogMagicSize;
+		std::vector<OpLogIndexEntry>::iterator found = std::upper_bound(
+		        m_index.begin(), m_index.end(), seq, index_seq_less);
+		if (found != m_index.begin())
+		{
+			m_read_offset = (found - 1)->offset;
+		}
+		while (m_read_offset + kOpLogRecordHeaderSize <= m_data_end)
+		{
+			const char* p = m_map + m_read_offset;
+			if (read_fixed64(p + 8) >= seq)
+			{
+				return true;
+			}
+			m_read_offset += kOpLogRecordHeaderSize + read_fixed32(p);
+		}
+		return false;
+	}
+
+	/*
+	 * Returns 1 with the next record, 0 at the end of the segment, -1 if
+	 * the record is corrupted.
+	 */
+	int OpLogFile::Next(uint64& seq, Slice& op)
+	{
+		if (NULL == m_map
+		        || m_read_offset + kOpLogRecordHeaderSize > m_data_end)
+		{
+			return 0;
+		}
+		const char* p = m_map + m_read_offset;
+		uint32 len = read_fixed32(p);
+		if (m_read_offset + kOpLogRecordHeaderSize + len > m_data_end)
+		{
+			return 0;
+		}
+		if (read_fixed32(p + 4) != crc32c(p + 8, 8 + len))
+		{
+			WARN_LOG(
+			        "Corrupted oplog record at %s:%zu", m_file_path.c_str(), m_read_offset);
+			return -1;
+		}
+		seq = read_fixed64(p + 8);
+		op = Slice(p + kOpLogRecordHeaderSize, len);
+		m_read_offset += kOpLogRecordHeaderSize + len;
+		return 1;
+	}
+
+	int OpLogFile::Load(CachedOpVisitor* visitor, uint32 maxReadBytes)
+	{
+		size_t start = m_read_offset;
+		uint64 seq;
+		Slice op;
+		while (Next(seq, op) == 1)
+		{
+			CachedOp* cop = DecodeOp(op);
+			if (NULL == cop)
+			{
+				ERROR_LOG(
+				        "Faild to decode oplog %"PRIu64" in %s", seq, m_file_path.c_str());
+				return -1;
+			}
+			visitor->OnCachedOp(cop, seq);
+			if (m_read_offset - start >= maxReadBytes)
+			{
+				return 0;
+			}
+		}
+		return -1;
+	}
+
+	bool OpLogFile::Write(uint64 seq, Buffer& op)
+	{
+		if (m_op_log_file_fd < 0)
+		{
+			return false;
+		}
+		if (m_index.empty()
+		        || m_write_offset - m_index.back().offset >= kOpLogIndexInterval)
+		{
+			OpLogIndexEntry entry = { seq, m_write_offset };
+			m_index.push_back(entry);
+		}
+		uint32 len = op.ReadableBytes();
+		m_write_buffer.EnsureWritableBytes(kOpLogRecordHeaderSize + len);
+		char* record = const_cast<char*>(m_write_buffer.GetRawWriteBuffer());
+		BufferHelper::WriteFixUInt32(m_write_buffer, len);
+		BufferHelper::WriteFixUInt32(m_write_buffer, 0);
+		BufferHelper::WriteFixUInt64(m_write_buffer, seq);
+		m_write_buffer.Write(&op, len);
+		uint32 crc = htonl(crc32c(record + 8, 8 + len));
+		memcpy(record + 4, &crc, sizeof(crc));
+		m_write_offset += kOpLogRecordHeaderSize + len;
+		if (m_write_buffer.ReadableBytes() >= kOpLogFlushTrigger)
+		{
+			Flush();
+		}
+		return true;
+	}
+
+	void OpLogFile::Seal()
+	{
+		if (m_op_log_file_fd < 0)
+		{
+			return;
+		}
+		Buffer footer(m_index.size() * kOpLogIndexEntrySize + kOpLogTrailerSize);
+		for (uint32 i = 0; i < m_index.size(); i++)
+		{
+			BufferHelper::WriteFixUInt64(footer, m_index[i].seq);
+			BufferHelper::WriteFixUInt64(footer, m_index[i].offset);
+		}
+		uint32 crc = crc32c(footer.GetRawReadBuffer(), footer.ReadableBytes());
+		BufferHelper::WriteFixUInt64(footer, m_write_offset);
+		BufferHelper::WriteFixUInt32(footer, m_index.size());
+		BufferHelper::WriteFixUInt32(footer, crc);
+		footer.Write(kOpLogIndexMagic, kOpLogMagicSize);
+		m_write_buffer.Write(&footer, footer.ReadableBytes());
+		Flush();
+	}
+
+	void OpLogFile::Flush()
+	{
+		while (m_write_buffer.Readable() && m_op_log_file_fd > 0)
+		{
+			int err = 0;
+			//DEBUG_LOG("Flush %u bytes",m_write_buffer.ReadableBytes() );
+			m_write_buffer.WriteFD(m_op_log_file_fd, err);
+			if (err != 0)
+			{
+				ERROR_LOG("Write oplog failed:%s", strerror(err));
+			}
+			if (m_write_buffer.Readable())
+			{
+				m_write_buffer.DiscardReadedBytes();
+			}
+			else
+			{
+				m_write_buffer.Clear();
+			}
+			m_last_flush_ts = time(NULL);
+		}
+	}
+
+	void OpLogFile::Close()
+	{
+		if (NULL != m_map)
+		{
+			munmap(m_map, m_map_size);
+			m_map = NULL;
+			m_map_size = m_data_end = 0;
+		}
+		if (m_op_log_file_fd > 0)
+		{
+			::close(m_op_log_file_fd);
+		}
+		m_op_log_file_fd = -1;
+	}
+
+	OpLogFile::~OpLogFile()
+	{
+		Flush();
+		Close();
+	}
+}
@@ -34,196 +34,8 @@
 #include <sys/fcntl.h>
 #include <sstream>
 
-#define OPLOGS_VER 1
-
 namespace ardb
 {
-	static const uint8 kSetOpType = 1;
-	static const uint8 kDelOpType = 2;
-	static const uint8 kOtherOpType = 3;
-
-	CachedWriteOp::CachedWriteOp(uint8 t, OpKey& k) :
-			CachedOp(t), key(k), v(NULL)
-	{
-	}
-	bool CachedWriteOp::IsInDBSet(DBIDSet& dbs)
-	{
-		DBID dbid;
-		KeyType keytype;
-		peek_dbkey_header(key.key, dbid, keytype);
-		if (dbs.count(dbid) == 0)
-		{
-			return false;
-		}
-		return true;
-	}
-	CachedWriteOp::~CachedWriteOp()
-	{
-		DELETE(v);
-	}
-	CachedCmdOp::CachedCmdOp(RedisCommandFrame* c) :
-			CachedOp(kOtherOpType), cmd(c)
-	{
-	}
-	CachedCmdOp::~CachedCmdOp()
-	{
-		DELETE(cmd);
-	}
-
-	OpKey::OpKey(const std::string& k) :
-			key(k)
-	{
-
-	}
-	bool OpKey::operator<(const OpKey& other) const
-	{
-		return key < other.key;
-	}
-
-	static const uint32 kOpLogFlushTrigger = 1 * 1024 * 1024;
-	OpLogFile::OpLogFile(const std::string& path) :
-			m_op_log_file_fd(-1), m_file_path(path), m_last_flush_ts(0)
-	{
-	}
-
-	int OpLogFile::OpenWrite()
-	{
-		int mod = S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
-		m_op_log_file_fd = ::open(m_file_path.c_str(),
-				O_RDWR | O_CREAT | O_APPEND, mod);
-		if (m_op_log_file_fd > 0)
-		{
-			m_write_buffer.EnsureWritableBytes(kOpLogFlushTrigger);
-		}
-		return m_op_log_file_fd;
-	}
-
-	int OpLogFile::OpenRead()
-	{
-		m_op_log_file_fd = ::open(m_file_path.c_str(), O_RDONLY);
-		return m_op_log_file_fd;
-	}
-
-	int OpLogFile::Load(CachedOpVisitor* visitor, uint32 maxReadBytes)
-	{
-		if (m_op_log_file_fd == -1)
-		{
-			return -1;
-		}
-		if (m_read_buffer.ReadableBytes() < maxReadBytes)
-		{
-			m_read_buffer.EnsureWritableBytes(
-					maxReadBytes - m_read_buffer.ReadableBytes());
-			char* tmpbuf = const_cast<char*>(m_read_buffer.GetRawWriteBuffer());
-			uint32 tmpbufsize = m_read_buffer.WriteableBytes();
-			size_t ret = ::read(m_op_log_file_fd, tmpbuf, tmpbufsize);
-			if (ret <= 0)
-			{
-				return -1;
-			}
-			m_read_buffer.AdvanceWriteIndex(ret);
-		}
-
-		uint32 mark = m_read_buffer.GetReadIndex();
-		while (true)
-		{
-			mark = m_read_buffer.GetReadIndex();
-			uint64 seq = 0;
-			if (!BufferHelper::ReadVarUInt64(m_read_buffer, seq))
-			{
-				break;
-			}
-			uint8 type;
-			if (!BufferHelper::ReadFixUInt8(m_read_buffer, type))
-			{
-				break;
-			}
-			if (type == kSetOpType || type == kDelOpType)
-			{
-				std::string key;
-				if (!BufferHelper::ReadVarString(m_read_buffer, key))
-				{
-					break;
-				}
-				OpKey ok(key);
-				CachedWriteOp* op = new CachedWriteOp(type, ok);
-				visitor->OnCachedOp(op, seq);
-			} else if (type == kOtherOpType)
-			{
-				uint32 size;
-				if (!BufferHelper::ReadVarUInt32(m_read_buffer, size))
-				{
-					break;
-				}
-				ArgumentArray strs;
-				for (uint32 i = 0; i < size; i++)
-				{
-					std::string str;
-					if (!BufferHelper::ReadVarString(m_read_buffer, str))
-					{
-						goto ret;
-					}
-					strs.push_back(str);
-				}
-				RedisCommandFrame* cmd = new RedisCommandFrame(strs);
-				CachedCmdOp* op = new CachedCmdOp(cmd);
-				visitor->OnCachedOp(op, seq);
-			} else
-			{
-				ERROR_LOG(
-						"Faild to read file:%u %llu at %u for %s", type, seq, m_read_buffer.GetReadIndex(), m_file_path.c_str());
-				return -1;
-			}
-		}
-		ret: m_read_buffer.SetReadIndex(mark);
-		m_read_buffer.DiscardReadedBytes();
-		return 0;
-	}
-
-	bool OpLogFile::Write(Buffer& content)
-	{
-		if (m_op_log_file_fd < 0)
-		{
-			return false;
-		}
-		m_write_buffer.Write(&content, content.ReadableBytes());
-		if (m_write_buffer.ReadableBytes() >= kOpLogFlushTrigger)
-		{
-			Flush();
-		}
-		return true;
-	}
-
-	void OpLogFile::Flush()
-	{
-		while (m_write_buffer.Readable() && m_op_log_file_fd > 0)
-		{
-			int err = 0;
-			//DEBUG_LOG("Flush %u bytes",m_write_buffer.ReadableBytes() );
-			m_write_buffer.WriteFD(m_op_log_file_fd, err);
-			if (err != 0)
-			{
-				ERROR_LOG("Write oplog failed:%s", strerror(err));
-			}
-			if (m_write_buffer.Readable())
-			{
-				m_write_buffer.DiscardReadedBytes();
-			} else
-			{
-				m_write_buffer.Clear();
-			}
-			m_last_flush_ts = time(NULL);
-		}
-	}
-
-	OpLogFile::~OpLogFile()
-	{
-		if (m_op_log_file_fd > 0)
-		{
-			::close(m_op_log_file_fd);
-		}
-	}
-
 	OpLogs::OpLogs(ArdbServer* server) :
 			m_server(server), m_min_seq(0), m_max_seq(0), m_op_log_file(NULL), m_current_oplog_record_size(
 					0), m_last_flush_time(0)
@@ -278,15 +90,8 @@ namespace ardb
 		{
 			return false;
 		}
-		FILE* cacheOpFile = fopen(GetOpLogPath(log_index).c_str(), "rb");
-		Buffer buffer;
-		buffer.EnsureWritableBytes(512);
-		char* tmpbuf = const_cast<char*>(buffer.GetRawWriteBuffer());
-		uint32 tmpbufsize = buffer.WriteableBytes();
-		size_t ret = fread(tmpbuf, 1, tmpbufsize, cacheOpFile);
-		buffer.AdvanceWriteIndex(ret);
-		fclose(cacheOpFile);
-		return BufferHelper::ReadVarUInt64(buffer, seq);
+		OpLogFile oplog(GetOpLogPath(log_index));
+		return oplog.OpenRead() > 0 && oplog.PeekFirstSeq(seq);
 	}
 
 	void OpLogs::Load()
@@ -379,7 +184,7 @@ namespace ardb
 
 	void OpLogs::RollbackOpLogs()
 	{
-		m_op_log_file->Flush();
+		m_op_log_file->Seal();
 		DELETE(m_op_log_file);
 		for (int i = m_server->m_cfg.repl_max_backup_logs - 1; i >= 0; --i)
 		{
@@ -394,30 +199,13 @@ namespace ardb
 
 	void OpLogs::WriteCachedOp(uint64 seq, CachedOp* op)
 	{
-		Buffer tmp;
-		BufferHelper::WriteVarUInt64(tmp, seq);
-		uint8 optype = op->type;
-		tmp.WriteByte(optype);
-		if (optype == kSetOpType || optype == kDelOpType)
-		{
-			CachedWriteOp* writeOp = (CachedWriteOp*) op;
-			/*
-			 * Only key would be persisted
-			 */
-			BufferHelper::WriteVarString(tmp, writeOp->key.key);
-		} else
-		{
-			CachedCmdOp* cmdOp = (CachedCmdOp*) op;
-			BufferHelper::WriteVarUInt32(tmp,
-					cmdOp->cmd->GetArguments().size() + 1);
-			BufferHelper::WriteVarString(tmp, cmdOp->cmd->GetCommand());
-			for (uint32 i = 0; i < cmdOp->cmd->GetArguments().size(); i++)
-			{
-				BufferHelper::WriteVarString(tmp,
-						*(cmdOp->cmd->GetArgument(i)));
-			}
-		}
-		m_op_log_file->Write(tmp);
+		/*
+		 * Values are persisted with their keys, so slaves catching up from
+		 * the oplog files never read the db.
+		 */
+		m_op_buffer.Clear();
+		OpLogFile::EncodeOp(m_op_buffer, op);
+		m_op_log_file->Write(seq, m_op_buffer);
 		m_current_oplog_record_size++;
 		if (m_current_oplog_record_size
 				>= m_server->GetServerConfig().repl_backlog_size)
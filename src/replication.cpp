@@ -45,37 +45,35 @@ namespace ardb
 	static const uint8 kInstrctionRecordSetCmd = 2;
 	static const uint8 kInstrctionRecordDelCmd = 3;
 	static const uint8 kInstrctionRecordRedisCmd = 4;
+	static const uint8 kInstrctionRecordBatch = 5;
 
 	static const uint8 kFullSyncIter = 0;
 	static const uint8 kFullSyncLogs = 1;
 	static const uint8 kFullSyncMem = 2;
+	static const uint8 kFullSyncBulk = 3;
 	static const uint32 kMaxSyncRecordsPeriod = 2000;
+	static const uint32 kBulkSyncBlockSize = 512 * 1024;
+	static const uint32 kBulkSyncMaxQueuedBlocks = 16;
+	static const uint32 kBulkSyncMaxPendingBytes = 4 * 1024 * 1024;
+	static const uint32 kBulkSyncRangesPerReader = 4;
+	static const uint32 kFeedSlaveWriteSize = 64 * 1024;
 
 	static const uint8 kSoftSinglaInstruction = 1;
 
 	static const uint8 kRedisTestDB = 1;
 	static const uint8 kArdbDB = 2;
 
-	struct kWriteReplInstructionData
-	{
-			std::vector<void*> ptrs;
-			bool from_master;
-			kWriteReplInstructionData() :
-					from_master(false)
-			{
-			}
-	};
-
 	SlaveConn::SlaveConn(Channel* c) :
 			conn(c), synced_cmd_seq(0), state(kSlaveStateConnected), type(
-			        kRedisTestDB)
+			        kRedisTestDB), bulk_sync(false)
 	{
 
 	}
 	SlaveConn::SlaveConn(Channel* c, const std::string& key, uint64 seq,
 	        DBIDSet& dbs) :
 			conn(c), server_key(key), synced_cmd_seq(seq), state(
-			        kSlaveStateConnected), type(kArdbDB), syncdbs(dbs)
+			        kSlaveStateConnected), type(kArdbDB), bulk_sync(false), syncdbs(
+			        dbs)
 	{
 	}
 
@@ -86,14 +84,42 @@ namespace ardb
 		return conn->Write(buf);
 	}
 
-	void SlaveClient::MessageReceived(ChannelHandlerContext& ctx,
-	        MessageEvent<RedisCommandFrame>& e)
+	/*
+	 * Synced ardb masters append the sequence to every replicated write.
+	 */
+	int SlaveClient::ApplyRawWrite(Slice* args, uint32 argc, uint64& seq)
+	{
+		bool with_seq = m_slave_state == kSlaveStateSynced
+		        && m_server_type == kArdbDB;
+		int ret = apply_raw_write(m_serv->m_db, args, argc, with_seq, seq);
+		if (ret > 0)
+		{
+			m_applied_writes++;
+		}
+		return ret;
+	}
+
+	void SlaveClient::HandleCommand(Channel* conn, RedisCommandFrame& frame)
 	{
-		DEBUG_LOG("Recv master cmd %s", e.GetMessage()->GetCommand().c_str());
-		RedisCommandFrame* cmd = e.GetMessage();
+		DEBUG_LOG("Recv master cmd %s", frame.GetCommand().c_str());
+		RedisCommandFrame* cmd = &frame;
 		if (!strcasecmp(cmd->GetCommand().c_str(), "ping"))
 		{
 			m_ping_recved = true;
+			/*
+			 * Ardb masters ping with their last seq and the bytes they
+			 * still had queued for this slave.
+			 */
+			if (cmd->GetArguments().size() >= 2)
+			{
+				uint64 seq = 0, pending = 0;
+				if (string_touint64(*(cmd->GetArgument(0)), seq)
+				        && string_touint64(*(cmd->GetArgument(1)), pending))
+				{
+					m_master_seq = seq;
+					m_master_pending_bytes = pending;
+				}
+			}
 			return;
 		}
 		else if (!strcasecmp(cmd->GetCommand().c_str(), "arsynced"))
@@ -105,6 +131,11 @@ namespace ardb
 			m_sync_seq = seq;
 			return;
 		}
+		else if (!strcasecmp(cmd->GetCommand().c_str(), "arbulk"))
+		{
+			LoadBulkBlock(conn, *(cmd->GetArgument(0)));
+			return;
+		}
 
 		if (m_slave_state == kSlaveStateSynced && m_server_type == kArdbDB)
 		{
@@ -116,19 +147,133 @@ namespace ardb
 			}
 			cmd->GetArguments().pop_back();
 		}
+		m_applied_cmds++;
+		m_serv->ProcessRedisCommand(*m_actx, *cmd);
+	}
+
+	/*
+	 * The raw records of a bulk full sync go straight into the engine, they
+	 * are neither replayed as commands nor logged in this instance's oplog.
+	 */
+	void SlaveClient::LoadBulkBlock(Channel* conn, const std::string& block)
+	{
+		if (load_bulk_block(m_serv->m_db->GetEngine(), block) < 0)
+		{
+			ERROR_LOG("Failed to load bulk sync block.");
+			conn->Close();
+		}
+	}
+
+	/*
+	 * Applies everything complete in one read from the master as one
+	 * engine batch. Replicated raw writes go to the engine directly, other
+	 * commands are dispatched as usual inside the same batch. If the engine
+	 * has no group commit, only runs of raw writes are batched.
+	 */
+	void SlaveClient::ApplyReplicated(Channel* conn, Buffer& msg)
+	{
 		if (NULL == m_actx)
 		{
 			NEW(m_actx, ArdbConnContext);
 		}
 		m_actx->is_slave_conn = true;
-		m_actx->conn = ctx.GetChannel();
-		m_serv->ProcessRedisCommand(*m_actx, *cmd);
+		m_actx->conn = conn;
+		m_serv->m_ctx_local.SetValue(m_actx);
+
+		Ardb* db = m_serv->m_db;
+		KeyValueEngine* engine = db->GetEngine();
+		bool grouping = db->BeginGroupCommit();
+		bool batching = false;
+		bool failed = false;
+		uint64 applied_seq = m_sync_seq;
+		uint64 seq = m_sync_seq;
+		Slice args[kMaxRawWriteArgs];
+		while (NULL != m_client && msg.Readable())
+		{
+			uint32 argc = 0;
+			int len = peek_request(msg.GetRawReadBuffer(), msg.ReadableBytes(),
+			        args, kMaxRawWriteArgs, argc);
+			if (0 == len)
+			{
+				break;
+			}
+			if (len > 0)
+			{
+				if (!grouping && !batching && argc >= 2 && argc <= kMaxRawWriteArgs)
+				{
+					engine->BeginBatchWrite();
+					batching = true;
+				}
+				int ret = ApplyRawWrite(args, argc, seq);
+				if (ret < 0)
+				{
+					failed = true;
+					break;
+				}
+				if (ret > 0)
+				{
+					msg.AdvanceReadIndex(len);
+					continue;
+				}
+			}
+			if (batching)
+			{
+				batching = false;
+				if (0 != engine->CommitBatchWrite())
+				{
+					failed = true;
+					break;
+				}
+			}
+			RedisCommandFrame cmd;
+			int ret = m_decoder.DecodeRequest(msg, cmd);
+			if (ret <= 0)
+			{
+				ERROR_LOG("Failed to decode replicated command:%s",
+				        m_decoder.GetError().c_str());
+				failed = true;
+				break;
+			}
+			m_sync_seq = seq;
+			HandleCommand(conn, cmd);
+			seq = m_sync_seq;
+		}
+		if (batching && 0 != engine->CommitBatchWrite())
+		{
+			failed = true;
+		}
+		if (grouping && 0 != db->EndGroupCommit())
+		{
+			failed = true;
+		}
+		m_serv->m_ctx_local.SetValue(NULL);
+		if (failed)
+		{
+			/*
+			 * Sync again from the last sequence known to be applied.
+			 */
+			ERROR_LOG(
+			        "Failed to apply replicated commands, resync from %"PRIu64, applied_seq);
+			m_sync_seq = applied_seq;
+			if (NULL != m_client)
+			{
+				conn->Close();
+			}
+			return;
+		}
+		m_sync_seq = seq;
+		m_applied_batches++;
 	}
 
 	void SlaveClient::MessageReceived(ChannelHandlerContext& ctx,
 	        MessageEvent<Buffer>& e)
 	{
 		Buffer* msg = e.GetMessage();
+		if (m_applying)
+		{
+			ApplyReplicated(ctx.GetChannel(), *msg);
+			return;
+		}
 		switch (m_slave_state)
 		{
 			case kSlaveStateWaitingReplConfRes:
@@ -268,17 +413,19 @@ namespace ardb
 		{
 			msg->SkipBytes(m_chunk_len);
 			m_chunk_len = 0;
-			m_client->GetPipeline().Remove("handler");
-			m_client->GetPipeline().AddLast("decoder", &m_decoder);
+			m_decoder.Reset();
 			m_client->GetPipeline().AddLast("encoder", &m_encoder);
-			ChannelUpstreamHandler<RedisCommandFrame>* handler = this;
-			m_client->GetPipeline().AddLast("handler", handler);
+			m_applying = true;
 
 			//ardb server would send 'arsynced' after all data synced
 			if (m_server_type == kRedisTestDB)
 			{
 				m_slave_state = kSlaveStateSynced;
 			}
+			if (msg->Readable())
+			{
+				ApplyReplicated(ctx.GetChannel(), *msg);
+			}
 		}
 	}
 
@@ -287,6 +434,7 @@ namespace ardb
 	{
 		m_client = NULL;
 		m_slave_state = 0;
+		m_applying = false;
 		DELETE(m_actx);
 		//reconnect master after 1000ms
 		struct ReconnectTask: public Runnable
@@ -365,11 +513,12 @@ namespace ardb
 	{
 		LoadSyncState();
 		Buffer replconf;
-		replconf.Printf("replconf listening-port %u\r\n",
+		replconf.Printf("replconf listening-port %u bulk-sync 1\r\n",
 		        m_serv->GetServerConfig().listen_port);
 		ctx.GetChannel()->Write(replconf);
 		m_slave_state = kSlaveStateWaitingReplConfRes;
 		m_ping_recved = true;
+		m_applying = false;
 	}
 
 	int SlaveClient::ConnectMaster(const std::string& host, uint32 port)
@@ -411,6 +560,31 @@ namespace ardb
 		return 0;
 	}
 
+	const std::string SlaveClient::Stats()
+	{
+		std::string info;
+		char tmp[1024];
+		uint64 sync_seq = m_sync_seq;
+		uint64 master_seq = m_master_seq;
+		sprintf(tmp, "master_host:%s\r\nmaster_port:%u\r\n",
+		        m_master_addr.GetHost().c_str(), m_master_addr.GetPort());
+		info.append(tmp);
+		info.append("master_link_status:").append(
+		        m_slave_state == kSlaveStateSynced ? "up" : "down").append("\r\n");
+		sprintf(tmp,
+		        "slave_repl_seq:%"PRIu64"\r\nmaster_repl_seq:%"PRIu64"\r\nslave_repl_seq_lag:%"PRIu64"\r\nslave_repl_bytes_behind:%"PRIu64"\r\n",
+		        sync_seq, master_seq,
+		        master_seq > sync_seq ? master_seq - sync_seq : 0,
+		        (uint64) m_master_pending_bytes);
+		info.append(tmp);
+		sprintf(tmp,
+		        "slave_applied_writes:%"PRIu64"\r\nslave_applied_cmds:%"PRIu64"\r\nslave_apply_batches:%"PRIu64"\r\n",
+		        (uint64) m_applied_writes, (uint64) m_applied_cmds,
+		        (uint64) m_applied_batches);
+		info.append(tmp);
+		return info;
+	}
+
 	void SlaveClient::Stop()
 	{
 		SocketHostAddress empty;
@@ -431,7 +605,7 @@ namespace ardb
 
 	ReplicationService::ReplicationService(ArdbServer* serv) :
 			m_server(serv), m_is_saving(false), m_last_save(0), m_oplogs(serv), m_inst_signal(
-			        NULL), m_master_slave_id(0)
+			        NULL), m_inst_notified(0), m_master_slave_id(0)
 	{
 	}
 
@@ -447,9 +621,21 @@ namespace ardb
 		SlaveConnTable::iterator it = m_slaves.begin();
 		while (it != m_slaves.end())
 		{
+			SlaveConn& conn = it->second;
 			Buffer tmp;
-			tmp.Write("PING\r\n", 6);
-			it->second.conn->Write(tmp);
+			if (conn.type == kArdbDB)
+			{
+				/*
+				 * Lets the slave know how far behind it is.
+				 */
+				tmp.Printf("PING %"PRIu64" %u\r\n", m_oplogs.GetMaxSeq(),
+				        conn.conn->WritableBytes());
+			}
+			else
+			{
+				tmp.Write("PING\r\n", 6);
+			}
+			conn.conn->Write(tmp);
 			it++;
 		}
 	}
@@ -468,6 +654,7 @@ namespace ardb
 				content.WriteByte((char) 255);
 				ch.conn->Write(content);
 				ch.state = kSlaveStateSynced;
+				LockGuard<ThreadMutex> guard(m_slaves_mutex);
 				m_slaves[ch.conn->GetID()] = ch;
 			}
 			else
@@ -476,7 +663,10 @@ namespace ardb
 				Buffer content;
 				content.Printf("$0\r\n");
 				ch.conn->Write(content);
-				m_slaves[ch.conn->GetID()] = ch;
+				{
+					LockGuard<ThreadMutex> guard(m_slaves_mutex);
+					m_slaves[ch.conn->GetID()] = ch;
+				}
 				SlaveConn& c = m_slaves[ch.conn->GetID()];
 				if (m_oplogs.VerifyClient(c.server_key, c.synced_cmd_seq))
 				{
@@ -511,19 +701,24 @@ namespace ardb
 			SlaveConn& conn = it->second;
 			if (conn.state == kSlaveStateSynced)
 			{
+				/*
+				 * Commands are gathered and written in large chunks instead
+				 * of one socket write per op.
+				 */
 				while (m_oplogs.LoadOpLog(conn.syncdbs, conn.synced_cmd_seq,
 				        tmp, conn.conn->GetID() == m_master_slave_id) == 1)
 				{
-					if (tmp.Readable())
+					if (tmp.ReadableBytes() >= kFeedSlaveWriteSize)
 					{
 						conn.conn->Write(tmp);
+						tmp.Clear();
 					}
-					tmp.Clear();
 				}
 				if (tmp.Readable())
 				{
 					conn.conn->Write(tmp);
 				}
+				tmp.Clear();
 			}
 			else
 			{
@@ -592,13 +787,54 @@ namespace ardb
 	void ReplicationService::ChannelClosed(ChannelHandlerContext& ctx,
 	        ChannelStateEvent& e)
 	{
+		LockGuard<ThreadMutex> guard(m_slaves_mutex);
 		m_slaves.erase(ctx.GetChannel()->GetID());
 	}
 
+	const std::string ReplicationService::Stats()
+	{
+		std::string info;
+		char tmp[1024];
+		uint64 max_seq = m_oplogs.GetMaxSeq();
+		LockGuard<ThreadMutex> guard(m_slaves_mutex);
+		sprintf(tmp, "connected_slaves:%u\r\n", (uint32) m_slaves.size());
+		info.append(tmp);
+		uint32 i = 0;
+		SlaveConnTable::iterator it = m_slaves.begin();
+		while (it != m_slaves.end())
+		{
+			SlaveConn& conn = it->second;
+			/*
+			 * 'synced_cmd_seq' is the last op sent to the slave.
+			 */
+			uint64 lag = 0;
+			if (conn.state == kSlaveStateSynced && conn.type == kArdbDB
+			        && max_seq > conn.synced_cmd_seq)
+			{
+				lag = max_seq - conn.synced_cmd_seq;
+			}
+			sprintf(tmp,
+			        "slave%u:id=%u,state=%s,seq=%"PRIu64",seq_lag=%"PRIu64",bytes_behind=%u\r\n",
+			        i, conn.conn->GetID(),
+			        conn.state == kSlaveStateSynced ? "synced" : "syncing",
+			        conn.synced_cmd_seq, lag, conn.conn->WritableBytes());
+			info.append(tmp);
+			i++;
+			it++;
+		}
+		return info;
+	}
+
 	void ReplicationService::ProcessInstructions()
 	{
 		ReplInstruction instruction;
 		uint32 count = 0;
+		bool feed = false;
+		/*
+		 * Reset before popping, a producer pushing after this point fires
+		 * a new signal.
+		 */
+		__sync_bool_compare_and_swap(&m_inst_notified, 1, 0);
 		while (m_inst_queue.Pop(instruction))
 		{
 			switch (instruction.type)
@@ -611,36 +847,12 @@ namespace ardb
 					CheckSlaveQueue();
 					break;
 				}
-				case kInstrctionRecordSetCmd:
+				case kInstrctionRecordBatch:
 				{
-					kWriteReplInstructionData* tp =
-					        (kWriteReplInstructionData*) (instruction.ptr);
-					std::string* k = (std::string*) tp->ptrs[0];
-					std::string* v = (std::string*) tp->ptrs[1];
-					CachedOp* op = m_oplogs.SaveSetOp(*k, v);
-					if (NULL != op)
-					{
-						op->from_master = tp->from_master;
-					}
-					DELETE(k);
-					//DELETE(v);
-					DELETE(tp);
-					FeedSlaves();
-					break;
-				}
-				case kInstrctionRecordDelCmd:
-				{
-					kWriteReplInstructionData* tp =
-					        (kWriteReplInstructionData*) (instruction.ptr);
-					std::string* k = (std::string*) tp->ptrs[0];
-					CachedOp* op = m_oplogs.SaveDeleteOp(*k);
-					if (NULL != op)
-					{
-						op->from_master = tp->from_master;
-					}
-					DELETE(k);
-					DELETE(tp);
-					FeedSlaves();
+					ReplBatch* batch = (ReplBatch*) (instruction.ptr);
+					SaveBatch(*batch);
+					DELETE(batch);
+					feed = true;
 					break;
 				}
 				default:
@@ -656,17 +868,62 @@ namespace ardb
 				{
 					m_inst_signal->FireSoftSignal(kSoftSinglaInstruction, 0);
 				}
+				break;
+			}
+		}
+		if (feed)
+		{
+			FeedSlaves();
+		}
+	}
+
+	void ReplicationService::SaveBatch(ReplBatch& batch)
+	{
+		while (batch.ops.Readable())
+		{
+			uint8 type;
+			Slice key, value;
+			if (!BufferHelper::ReadFixUInt8(batch.ops, type)
+			        || !BufferHelper::ReadVarSlice(batch.ops, key))
+			{
+				ERROR_LOG("Invalid replication batch record.");
 				return;
 			}
+			CachedOp* op = NULL;
+			if (type == kInstrctionRecordSetCmd)
+			{
+				if (!BufferHelper::ReadVarSlice(batch.ops, value))
+				{
+					ERROR_LOG("Invalid replication batch record.");
+					return;
+				}
+				op = m_oplogs.SaveSetOp(std::string(key.data(), key.size()),
+				        new std::string(value.data(), value.size()));
+			}
+			else
+			{
+				op = m_oplogs.SaveDeleteOp(std::string(key.data(), key.size()));
+			}
+			if (NULL != op)
+			{
+				op->from_master = batch.from_master;
+			}
 		}
 	}
 
+	/*
+	 * One wakeup covers everything queued before the replication thread
+	 * gets to it, the 100ms instruction task catches any race.
+	 */
 	void ReplicationService::OfferInstruction(ReplInstruction& inst)
 	{
 		m_inst_queue.Push(inst);
 		if (NULL != m_inst_signal)
 		{
-			m_inst_signal->FireSoftSignal(kSoftSinglaInstruction, 0);
+			if (__sync_bool_compare_and_swap(&m_inst_notified, 0, 1))
+			{
+				m_inst_signal->FireSoftSignal(kSoftSinglaInstruction, 0);
+			}
 		}
 		else
 		{
@@ -675,7 +932,8 @@ namespace ardb
 	}
 
 	void ReplicationService::ServARSlaveClient(Channel* client,
-	        const std::string& serverKey, uint64 seq, DBIDSet& dbs)
+	        const std::string& serverKey, uint64 seq, DBIDSet& dbs,
+	        bool bulk_sync)
 	{
 		DEBUG_LOG("ServARSlaveClient for %s", serverKey.c_str());
 		client->Flush();
@@ -683,8 +941,9 @@ namespace ardb
 		client->ClearPipeline();
 		ChannelUpstreamHandler<Buffer>* handler = this;
 		client->GetPipeline().AddLast("handler", handler);
-		ReplInstruction instrct(kInstrctionSlaveClientQueue,
-		        new SlaveConn(client, serverKey, seq, dbs));
+		SlaveConn* conn = new SlaveConn(client, serverKey, seq, dbs);
+		conn->bulk_sync = bulk_sync;
+		ReplInstruction instrct(kInstrctionSlaveClientQueue, conn);
 		OfferInstruction(instrct);
 	}
 
@@ -711,38 +970,73 @@ namespace ardb
 			//Read oplogs from disk
 			state = kFullSyncLogs;
 		}
+		else if (conn.bulk_sync && GetConfig().repl_bulk_sync_threads > 0)
+		{
+			state = kFullSyncBulk;
+		}
 		m_serv.GetTimer().Schedule(
 		        new LoadSyncTask(this, conn.conn->GetID(), state), 1, -1);
 	}
 
-	int ReplicationService::OnKeyUpdated(const Slice& key, const Slice& value)
+	ReplBatch& ReplicationService::GetLocalBatch()
 	{
-		std::string* nk = new std::string(key.data(), key.size());
-		std::string* nv = new std::string(value.data(), value.size());
-		kWriteReplInstructionData* data = new kWriteReplInstructionData;
-		data->ptrs.push_back(nk);
-		data->ptrs.push_back(nv);
-		if (NULL != m_server->GetCurrentContext())
+		ReplBatchHolder& holder = m_batch_local.GetValue();
+		if (NULL == holder.batch)
 		{
-			data->from_master = m_server->GetCurrentContext()->is_slave_conn;
+			NEW(holder.batch, ReplBatch);
+		}
+		if (!holder.batch->ops.Readable())
+		{
+			holder.batch->ops.Clear();
+			holder.batch->from_master = false;
+			if (NULL != m_server->GetCurrentContext())
+			{
+				holder.batch->from_master =
+				        m_server->GetCurrentContext()->is_slave_conn;
+			}
 		}
+		return *(holder.batch);
+	}
 
-		ReplInstruction instrct(kInstrctionRecordSetCmd, data);
-		OfferInstruction(instrct);
+	/*
+	 * Writes are only appended to the thread's batch here, nothing goes to
+	 * the replication thread before the engine commits them.
+	 */
+	int ReplicationService::OnKeyUpdated(const Slice& key, const Slice& value)
+	{
+		ReplBatch& batch = GetLocalBatch();
+		BufferHelper::WriteFixUInt8(batch.ops, kInstrctionRecordSetCmd);
+		BufferHelper::WriteVarSlice(batch.ops, key);
+		BufferHelper::WriteVarSlice(batch.ops, value);
 		return 0;
 	}
 	int ReplicationService::OnKeyDeleted(const Slice& key)
 	{
-		std::string* nk = new std::string(key.data(), key.size());
-		kWriteReplInstructionData* data = new kWriteReplInstructionData;
-		data->ptrs.push_back(nk);
-		if (NULL != m_server->GetCurrentContext())
+		ReplBatch& batch = GetLocalBatch();
+		BufferHelper::WriteFixUInt8(batch.ops, kInstrctionRecordDelCmd);
+		BufferHelper::WriteVarSlice(batch.ops, key);
+		return 0;
+	}
+
+	void ReplicationService::OnBatchCommitted()
+	{
+		ReplBatchHolder& holder = m_batch_local.GetValue();
+		if (NULL == holder.batch || !holder.batch->ops.Readable())
 		{
-			data->from_master = m_server->GetCurrentContext()->is_slave_conn;
+			return;
 		}
-		ReplInstruction instrct(kInstrctionRecordDelCmd, data);
+		ReplInstruction instrct(kInstrctionRecordBatch, holder.batch);
+		holder.batch = NULL;
 		OfferInstruction(instrct);
-		return 0;
+	}
+
+	void ReplicationService::OnBatchDiscarded()
+	{
+		ReplBatchHolder& holder = m_batch_local.GetValue();
+		if (NULL != holder.batch)
+		{
+			holder.batch->ops.Clear();
+		}
 	}
 
 	void ReplicationService::RecordFlushDB(const DBID& db)
@@ -761,37 +1055,31 @@ namespace ardb
 			ERROR_LOG("Empty bakup dir for backup.");
 			return -1;
 		}
-		//m_server->m_db->CloseAll();
 		m_is_saving = true;
-		int ret = 0;
-		char cmd[m_server->m_cfg.data_base_path.size() + 256];
 		make_dir(m_server->m_cfg.backup_dir);
-		std::string dest = m_server->m_cfg.backup_dir
-		        + "/ardb_all_data.save.tar";
-		std::string shasumfile = m_server->m_cfg.backup_dir
-		        + "/ardb_all_data.sha1sum";
-		sprintf(cmd, "tar cf %s %s;", dest.c_str(),
-		        m_server->m_cfg.data_base_path.c_str());
-		ret = system(cmd);
-		if (-1 == ret)
+		/*
+		 * The checkpoint is written aside and renamed over the previous one,
+		 * so the backup dir always holds one complete checkpoint.
+		 */
+		std::string dest = m_server->m_cfg.backup_dir + "/ardb_checkpoint";
+		std::string tmp = dest + ".tmp";
+		uint64 start = get_current_epoch_millis();
+		int ret = GetDB().GetEngine()->Checkpoint(tmp);
+		if (0 == ret)
+		{
+			remove_dir(dest);
+			ret = rename(tmp.c_str(), dest.c_str());
+		}
+		if (0 == ret)
 		{
-			ERROR_LOG( "Failed to create backup data archive:%s", dest.c_str());
+			INFO_LOG(
+			        "Saved checkpoint %s in %"PRIu64"ms.", dest.c_str(), get_current_epoch_millis() - start);
+			m_last_save = time(NULL);
 		}
 		else
 		{
-			std::string sha1sum_str;
-			ret = sha1sum_file(dest, sha1sum_str);
-			if (-1 == ret)
-			{
-				ERROR_LOG(
-				        "Failed to compute sha1sum for data archive:%s", dest.c_str());
-			}
-			else
-			{
-				INFO_LOG("Save file SHA1sum is %s", sha1sum_str.c_str());
-				file_write_content(shasumfile, sha1sum_str);
-				m_last_save = time(NULL);
-			}
+			ERROR_LOG("Failed to save checkpoint:%s", dest.c_str());
+			remove_dir(tmp);
 		}
 		m_is_saving = false;
 		return ret;
@@ -866,7 +1154,9 @@ namespace ardb
 
 	LoadSyncTask::LoadSyncTask(ReplicationService* repl, uint32 id, uint8 state) :
 			m_repl(repl), m_conn_id(id), m_iter(NULL), m_op_log(NULL), m_start_time(
-			        0), m_seq_after_sync_iter(0), m_state(state)
+			        0), m_seq_after_sync_iter(0), m_state(state), m_bulk_next_range(
+			        0), m_bulk_queued(0), m_bulk_done_readers(0), m_bulk_abort(
+			        false), m_bulk_records(0), m_bulk_bytes(0)
 	{
 		SlaveConn* conn = m_repl->GetSlaveConn(m_conn_id);
 		if (NULL != conn)
@@ -964,6 +1254,188 @@ namespace ardb
 		m_repl->GetChannelService().GetTimer().Schedule(this, 1, -1);
 	}
 
+	void LoadSyncTask::StartBulkReaders(SlaveConn& conn)
+	{
+		struct BulkSyncReader: public Thread
+		{
+				LoadSyncTask* task;
+				BulkSyncReader(LoadSyncTask* t) :
+						task(t)
+				{
+				}
+				void Run()
+				{
+					task->ReadBulkRanges();
+				}
+		};
+		KeyValueEngine* engine = m_repl->GetDB().GetEngine();
+		std::vector<KeyRange> bases;
+		if (conn.syncdbs.empty())
+		{
+			bases.push_back(KeyRange());
+		}
+		DBIDSet::iterator it = conn.syncdbs.begin();
+		while (it != conn.syncdbs.end())
+		{
+			KeyObject start(Slice(), KV, *it);
+			KeyObject end(Slice(), KV, *it + 1);
+			Buffer sbuf, ebuf;
+			encode_key(sbuf, start);
+			encode_key(ebuf, end);
+			KeyRange range;
+			range.begin = sbuf.AsString();
+			range.end = ebuf.AsString();
+			bases.push_back(range);
+			it++;
+		}
+		uint32 threads = m_repl->GetConfig().repl_bulk_sync_threads;
+		uint32 parts = threads * kBulkSyncRangesPerReader;
+		std::vector<uint64> sizes;
+		uint64 total = 0;
+		for (uint32 i = 0; i < bases.size(); i++)
+		{
+			sizes.push_back(engine->EstimateSize(bases[i].begin, bases[i].end));
+			total += sizes[i];
+		}
+		for (uint32 i = 0; i < bases.size(); i++)
+		{
+			uint32 n = total > 0 ? sizes[i] * parts / total : 1;
+			split_key_range(engine, bases[i], n > 0 ? n : 1, m_bulk_ranges);
+		}
+		if (threads > m_bulk_ranges.size())
+		{
+			threads = m_bulk_ranges.size();
+		}
+		INFO_LOG(
+		        "Start bulk sync of %u key ranges with %u readers.", (uint32) m_bulk_ranges.size(), threads);
+		for (uint32 i = 0; i < threads; i++)
+		{
+			Thread* reader = new BulkSyncReader(this);
+			m_bulk_readers.push_back(reader);
+			reader->Start();
+		}
+	}
+
+	void LoadSyncTask::StopBulkReaders()
+	{
+		m_bulk_abort = true;
+		for (uint32 i = 0; i < m_bulk_readers.size(); i++)
+		{
+			m_bulk_readers[i]->Join();
+			DELETE(m_bulk_readers[i]);
+		}
+		m_bulk_readers.clear();
+		Buffer* block = NULL;
+		while (m_bulk_blocks.Pop(block))
+		{
+			DELETE(block);
+		}
+	}
+
+	/*
+	 * Runs in the reader threads, every reader takes the next unread range
+	 * until all are done.
+	 */
+	void LoadSyncTask::ReadBulkRanges()
+	{
+		KeyValueEngine* engine = m_repl->GetDB().GetEngine();
+		Buffer records(kBulkSyncBlockSize + 4096);
+		uint64 count = 0;
+		uint32 idx;
+		while (!m_bulk_abort
+		        && (idx = __sync_fetch_and_add(&m_bulk_next_range, 1))
+		                < m_bulk_ranges.size())
+		{
+			const KeyRange& range = m_bulk_ranges[idx];
+			Slice end(range.end);
+			Iterator* iter = engine->Find(range.begin, false);
+			while (!m_bulk_abort && NULL != iter && iter->Valid())
+			{
+				Slice key = iter->Key();
+				if (!range.end.empty() && key.compare(end) >= 0)
+				{
+					break;
+				}
+				BufferHelper::WriteVarSlice(records, key);
+				BufferHelper::WriteVarSlice(records, iter->Value());
+				count++;
+				if (records.ReadableBytes() >= kBulkSyncBlockSize)
+				{
+					QueueBulkBlock(records);
+				}
+				iter->Next();
+			}
+			DELETE(iter);
+		}
+		if (records.Readable())
+		{
+			QueueBulkBlock(records);
+		}
+		__sync_fetch_and_add(&m_bulk_records, count);
+		__sync_fetch_and_add(&m_bulk_done_readers, 1);
+	}
+
+	/*
+	 * A block goes to the slave as one 'arbulk' command whose argument is
+	 * the records, readers wait while the replication thread is behind.
+	 */
+	void LoadSyncTask::QueueBulkBlock(Buffer& records)
+	{
+		while (!m_bulk_abort && m_bulk_queued >= kBulkSyncMaxQueuedBlocks)
+		{
+			Thread::Sleep(1);
+		}
+		uint32 len = records.ReadableBytes();
+		Buffer* block = new Buffer(len + 32);
+		encode_bulk_block(records, *block);
+		__sync_fetch_and_add(&m_bulk_bytes, len);
+		__sync_fetch_and_add(&m_bulk_queued, 1);
+		m_bulk_blocks.Push(block);
+	}
+
+	/*
+	 * The oplogs are sent from the sequence taken before the readers start,
+	 * so writes the readers may have missed are replayed afterwards.
+	 */
+	void LoadSyncTask::SyncBulk()
+	{
+		SlaveConn* conn = m_repl->GetSlaveConn(m_conn_id);
+		if (m_bulk_readers.empty())
+		{
+			m_seq_after_sync_iter = m_repl->GetOpLogs().GetMaxSeq();
+			StartBulkReaders(*conn);
+		}
+		bool readers_done = m_bulk_done_readers == m_bulk_readers.size();
+		bool drained = false;
+		while (conn->conn->WritableBytes() < kBulkSyncMaxPendingBytes)
+		{
+			Buffer* block = NULL;
+			if (!m_bulk_blocks.Pop(block))
+			{
+				drained = true;
+				break;
+			}
+			__sync_fetch_and_sub(&m_bulk_queued, 1);
+			bool written = conn->conn->Write(*block);
+			DELETE(block);
+			if (!written)
+			{
+				m_repl->OnLoadSynced(this, false);
+				return;
+			}
+		}
+		if (readers_done && drained)
+		{
+			StopBulkReaders();
+			INFO_LOG(
+			        "Bulk synced %"PRIu64" records(%"PRIu64" bytes) in %"PRIu64"ms.", m_bulk_records, m_bulk_bytes, get_current_epoch_millis() - m_start_time);
+			m_state = kFullSyncLogs;
+			conn->synced_cmd_seq = m_seq_after_sync_iter;
+		}
+		//sync after 1ms in next schedule
+		m_repl->GetChannelService().GetTimer().Schedule(this, 1, -1);
+	}
+
 	void LoadSyncTask::SyncOpLogs()
 	{
 		SlaveConn* conn = m_repl->GetSlaveConn(m_conn_id);
@@ -976,29 +1448,30 @@ namespace ardb
 			//compute oplog file sequence
 			if (NULL == m_op_log)
 			{
+				/*
+				 * Stream from the newest segment starting at or before the
+				 * first op the slave misses.
+				 */
 				uint64 start_seq;
-				for (uint32 i = m_repl->GetConfig().repl_max_backup_logs; i > 0;
-				        i--)
+				for (uint32 i = 1; i <= m_repl->GetConfig().repl_max_backup_logs;
+				        i++)
 				{
-					if (m_repl->GetOpLogs().PeekOpLogStartSeq(i, start_seq))
+					if (m_repl->GetOpLogs().PeekOpLogStartSeq(i, start_seq)
+					        && start_seq <= conn->synced_cmd_seq + 1)
 					{
-						if (start_seq > (conn->synced_cmd_seq + 1))
+						m_op_log = new OpLogFile(
+						        m_repl->GetOpLogs().GetOpLogPath(i));
+						if (m_op_log->OpenRead() < 0
+						        || !m_op_log->Seek(conn->synced_cmd_seq + 1))
 						{
-							ERROR_LOG(
-							        "Can NOT sync to slave, since current node is too busy on writing.");
-							m_repl->OnLoadSynced(this, false);
-							return;
+							DELETE(m_op_log);
 						}
-						if (start_seq + m_repl->GetConfig().repl_backlog_size
-						        > conn->synced_cmd_seq + 1)
+						else
 						{
-							m_op_log = new OpLogFile(
-							        m_repl->GetOpLogs().GetOpLogPath(i));
-							m_op_log->OpenRead();
 							INFO_LOG(
 							        "Start sync from oplog:%s", m_repl->GetOpLogs().GetOpLogPath(i).c_str());
-							break;
 						}
+						break;
 					}
 				}
 			}
@@ -1084,6 +1557,11 @@ namespace ardb
 				SyncDBIter();
 				break;
 			}
+			case kFullSyncBulk:
+			{
+				SyncBulk();
+				break;
+			}
 			case kFullSyncLogs:
 			{
 				SyncOpLogs();
@@ -1112,6 +1590,7 @@ namespace ardb
 
 	LoadSyncTask::~LoadSyncTask()
 	{
+		StopBulkReaders();
 		DELETE(m_iter);
 		DELETE(m_op_log);
 	}
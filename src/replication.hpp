@@ -48,6 +48,10 @@ namespace ardb
 			uint64 synced_cmd_seq;
 			uint32 state;
 			uint8 type;
+			/*
+			 * The slave can load a full sync as raw record blocks.
+			 */
+			bool bulk_sync;
 			DBIDSet syncdbs;
 			SlaveConn(Channel* c = NULL);
 			SlaveConn(Channel* c, const std::string& key, uint64 seq,
@@ -65,6 +69,10 @@ namespace ardb
 			bool operator<(const OpKey& other) const;
 	};
 
+	static const uint8 kSetOpType = 1;
+	static const uint8 kDelOpType = 2;
+	static const uint8 kOtherOpType = 3;
+
 	struct CachedOp
 	{
 			uint8 type;
@@ -92,6 +100,57 @@ namespace ardb
 			~CachedCmdOp();
 	};
 
+	/*
+	 * The raw writes of one committed engine batch, kept as
+	 * [type][key][value] records in a single buffer.
+	 */
+	struct ReplBatch
+	{
+			Buffer ops;
+			bool from_master;
+			ReplBatch() :
+					ops(256), from_master(false)
+			{
+			}
+	};
+	struct ReplBatchHolder
+	{
+			ReplBatch* batch;
+			ReplBatchHolder() :
+					batch(NULL)
+			{
+			}
+			~ReplBatchHolder()
+			{
+				delete batch;
+			}
+	};
+
+	/*
+	 * Encoded keys in [begin, end), an empty 'end' is the end of the
+	 * keyspace.
+	 */
+	struct KeyRange
+	{
+			std::string begin;
+			std::string end;
+	};
+
+	/*
+	 * Connection free replication helpers, see replication_helper.cpp.
+	 */
+	static const uint32 kMaxRawWriteArgs = 4;
+	int peek_request(const char* p, size_t len, Slice* args, uint32 max,
+	        uint32& argc);
+	int apply_raw_write(Ardb* db, Slice* args, uint32 argc, bool with_seq,
+	        uint64& seq);
+	static const uint32 kSplitKeyBytes = 16;
+	void mid_point(const uint8* a, const uint8* b, uint8* mid);
+	void split_key_range(KeyValueEngine* engine, const KeyRange& range,
+	        uint32 parts, std::vector<KeyRange>& ranges);
+	void encode_bulk_block(Buffer& records, Buffer& block);
+	int64 load_bulk_block(KeyValueEngine* engine, const Slice& block);
+
 	struct ReplInstruction
 	{
 			uint8 type;
@@ -114,21 +173,45 @@ namespace ardb
 			}
 	};
 
+	struct OpLogIndexEntry
+	{
+			uint64 seq;
+			uint64 offset;
+	};
+
+	/*
+	 * One oplog segment of CRC checked records carrying whole ops, with a
+	 * sparse seq to offset index appended when it is sealed. Segments are
+	 * read through mmap.
+	 */
 	class OpLogFile
 	{
 		private:
 			int m_op_log_file_fd;
 			std::string m_file_path;
-			Buffer m_read_buffer;
 			Buffer m_write_buffer;
 			time_t m_last_flush_ts;
+			uint64 m_write_offset;
+			std::vector<OpLogIndexEntry> m_index;
+			char* m_map;
+			size_t m_map_size;
+			size_t m_data_end;
+			size_t m_read_offset;
+			void LoadIndex();
+			void Close();
 		public:
 			OpLogFile(const std::string& path);
 			int OpenWrite();
 			int OpenRead();
+			bool PeekFirstSeq(uint64& seq);
+			bool Seek(uint64 seq);
+			int Next(uint64& seq, Slice& op);
 			int Load(CachedOpVisitor* visitor, uint32 maxReadBytes = 4096);
-			bool Write(Buffer& content);
+			bool Write(uint64 seq, Buffer& op);
 			void Flush();
+			void Seal();
+			static void EncodeOp(Buffer& buf, CachedOp* op);
+			static CachedOp* DecodeOp(const Slice& op);
 			time_t LastFlush()
 			{
 				return m_last_flush_ts;
@@ -156,6 +239,7 @@ namespace ardb
 			uint64 m_min_seq;
 			uint64 m_max_seq;
 			OpLogFile* m_op_log_file;
+			Buffer m_op_buffer;
 			uint32 m_current_oplog_record_size;
 			time_t m_last_flush_time;
 
@@ -209,8 +293,7 @@ namespace ardb
 	};
 
 	class ArdbConnContext;
-	class SlaveClient: public ChannelUpstreamHandler<RedisCommandFrame>,
-			public ChannelUpstreamHandler<Buffer>,
+	class SlaveClient: public ChannelUpstreamHandler<Buffer>,
 			public Runnable
 	{
 		private:
@@ -221,6 +304,11 @@ namespace ardb
 			uint32 m_slave_state;
 			bool m_cron_inited;
 			bool m_ping_recved;
+			/*
+			 * Set once the sync chunk is consumed, the rest of the stream
+			 * is replicated writes and commands.
+			 */
+			bool m_applying;
 			RedisCommandDecoder m_decoder;
 			NullRedisReplyEncoder m_encoder;
 
@@ -234,14 +322,26 @@ namespace ardb
 
 			ArdbConnContext *m_actx;
 
-			void MessageReceived(ChannelHandlerContext& ctx,
-					MessageEvent<RedisCommandFrame>& e);
+			/*
+			 * Lag against the master, the master's seq and the bytes it had
+			 * queued for us come with its pings.
+			 */
+			volatile uint64 m_master_seq;
+			volatile uint64 m_master_pending_bytes;
+			volatile uint64 m_applied_writes;
+			volatile uint64 m_applied_cmds;
+			volatile uint64 m_applied_batches;
+
+			void ApplyReplicated(Channel* conn, Buffer& msg);
+			int ApplyRawWrite(Slice* args, uint32 argc, uint64& seq);
+			void HandleCommand(Channel* conn, RedisCommandFrame& cmd);
 			void MessageReceived(ChannelHandlerContext& ctx,
 					MessageEvent<Buffer>& e);
 			void ChannelClosed(ChannelHandlerContext& ctx,
 					ChannelStateEvent& e);
 			void ChannelConnected(ChannelHandlerContext& ctx,
 					ChannelStateEvent& e);
+			void LoadBulkBlock(Channel* conn, const std::string& block);
 			void Timeout();
 			void Run();
 			void PersistSyncState();
@@ -249,8 +349,11 @@ namespace ardb
 		public:
 			SlaveClient(ArdbServer* serv) :
 					m_serv(serv), m_client(NULL), m_chunk_len(0), m_slave_state(
-							0), m_cron_inited(false), m_ping_recved(false), m_server_type(
-							0), m_server_key("-"), m_sync_seq(0), m_actx(NULL)
+							0), m_cron_inited(false), m_ping_recved(false), m_applying(
+							false), m_server_type(0), m_server_key("-"), m_sync_seq(
+							0), m_actx(NULL), m_master_seq(0), m_master_pending_bytes(
+							0), m_applied_writes(0), m_applied_cmds(0), m_applied_batches(
+							0)
 			{
 			}
 			const SocketHostAddress& GetMasterAddress()
@@ -263,6 +366,7 @@ namespace ardb
 			}
 
 			int ConnectMaster(const std::string& host, uint32 port);
+			const std::string Stats();
 			void Close();
 			void Stop();
 	};
@@ -279,9 +383,30 @@ namespace ardb
 			uint64 m_seq_after_sync_iter;
 			uint8 m_state;
 			DBIDSet m_syncing_dbs;
+
+			/*
+			 * Bulk full sync: reader threads scan the key ranges and queue
+			 * blocks of raw records, the replication thread writes them to
+			 * the slave.
+			 */
+			std::vector<KeyRange> m_bulk_ranges;
+			std::vector<Thread*> m_bulk_readers;
+			MPSCQueue<Buffer*> m_bulk_blocks;
+			volatile uint32 m_bulk_next_range;
+			volatile uint32 m_bulk_queued;
+			volatile uint32 m_bulk_done_readers;
+			volatile bool m_bulk_abort;
+			volatile uint64 m_bulk_records;
+			volatile uint64 m_bulk_bytes;
+
 			void Run();
 			void SyncDBIter();
+			void SyncBulk();
 			void SyncOpLogs();
+			void StartBulkReaders(SlaveConn& conn);
+			void StopBulkReaders();
+			void ReadBulkRanges();
+			void QueueBulkBlock(Buffer& records);
 		public:
 			LoadSyncTask(ReplicationService* repl, uint32 id, uint8 state);
 			~LoadSyncTask();
@@ -303,11 +428,21 @@ namespace ardb
 			typedef std::map<uint32, SlaveConn> SlaveConnTable;
 			SyncClientQueue m_waiting_slaves;
 			SlaveConnTable m_slaves;
+			/*
+			 * Guards m_slaves against INFO, which runs on other threads.
+			 */
+			ThreadMutex m_slaves_mutex;
 
 			OpLogs m_oplogs;
 
 			SoftSignalChannel* m_inst_signal;
 			MPSCQueue<ReplInstruction> m_inst_queue;
+			volatile uint32 m_inst_notified;
+			/*
+			 * The batch the calling thread is building, handed over to the
+			 * replication thread when the engine commits it.
+			 */
+			ThreadLocal<ReplBatchHolder> m_batch_local;
 
 			//connection id for the connection that is master-slave
 			uint32 m_master_slave_id;
@@ -326,8 +461,12 @@ namespace ardb
 			void FeedSlaves();
 			void LoadSync(SlaveConn& client);
 
+			ReplBatch& GetLocalBatch();
+			void SaveBatch(ReplBatch& batch);
 			int OnKeyUpdated(const Slice& key, const Slice& value);
 			int OnKeyDeleted(const Slice& key);
+			void OnBatchCommitted();
+			void OnBatchDiscarded();
 			void OfferInstruction(ReplInstruction& inst);
 
 			void OnLoadSynced(LoadSyncTask* task, bool success);
@@ -338,8 +477,10 @@ namespace ardb
 			int Init();
 			void ServSlaveClient(Channel* client);
 			void ServARSlaveClient(Channel* client,
-					const std::string& serverKey, uint64 seq, DBIDSet& dbs);
+					const std::string& serverKey, uint64 seq, DBIDSet& dbs,
+					bool bulk_sync = false);
 			void RecordFlushDB(const DBID& db);
+			const std::string Stats();
 			OpLogs& GetOpLogs()
 			{
 				return m_oplogs;
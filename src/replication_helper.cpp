@@ -0,0 +1,311 @@
+ /*
+ *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
+ *All rights reserved.
+ * 
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ * 
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Redis nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ * 
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+ *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ *THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "replication.hpp"
+#include "util/buffer_helper.hpp"
+
+/*
+ * The parts of replication which do not need a connection: peeking at
+ * replicated requests and applying raw writes, cutting the keyspace into
+ * ranges for the bulk sync readers and the 'arbulk' blocks of raw records.
+ *
+ *   block:   *2\r\n$6\r\narbulk\r\n$<len>\r\n<records>\r\n
+ *   record:  [key size:varint][key][value size:varint][value]
+ */
+namespace ardb
+{
+	static void key_point(const std::string& key, uint8* point, uint8 fill)
+	{
+		memset(point, fill, kSplitKeyBytes);
+		memcpy(point, key.data(),
+		        key.size() < kSplitKeyBytes ? key.size() : kSplitKeyBytes);
+	}
+
+	/*
+	 * 'mid' = ('a' + 'b') / 2 of two big endian numbers.
+	 */
+	void mid_point(const uint8* a, const uint8* b, uint8* mid)
+	{
+		uint32 carry = 0;
+		for (int32 i = kSplitKeyBytes - 1; i >= 0; i--)
+		{
+			uint32 sum = a[i] + b[i] + carry;
+			mid[i] = sum & 0xFF;
+			carry = sum >> 8;
+		}
+		for (uint32 i = 0; i < kSplitKeyBytes; i++)
+		{
+			uint32 v = (carry << 8) | mid[i];
+			mid[i] = v >> 1;
+			carry = v & 1;
+		}
+	}
+
+	/*
+	 * Cuts 'range' into about 'parts' ranges of the same estimated size,
+	 * each cut point is found by bisecting the keys as numbers of their
+	 * first kSplitKeyBytes bytes.
+	 */
+	void split_key_range(KeyValueEngine* engine, const KeyRange& range,
+	        uint32 parts, std::vector<KeyRange>& ranges)
+	{
+		uint64 total = parts > 1 ? engine->EstimateSize(range.begin, range.end) : 0;
+		uint8 lo[kSplitKeyBytes], hi[kSplitKeyBytes], mid[kSplitKeyBytes];
+		KeyRange current;
+		current.begin = range.begin;
+		for (uint32 i = 1; total > 0 && i < parts; i++)
+		{
+			uint64 target = total / parts * i;
+			key_point(current.begin, lo, 0);
+			key_point(range.end, hi, range.end.empty() ? 0xFF : 0);
+			while (true)
+			{
+				mid_point(lo, hi, mid);
+				if (0 == memcmp(mid, lo, kSplitKeyBytes))
+				{
+					break;
+				}
+				std::string key((const char*) mid, kSplitKeyBytes);
+				if (engine->EstimateSize(range.begin, key) < target)
+				{
+					memcpy(lo, mid, kSplitKeyBytes);
+				}
+				else
+				{
+					memcpy(hi, mid, kSplitKeyBytes);
+				}
+			}
+			std::string cut((const char*) hi, kSplitKeyBytes);
+			if (cut <= current.begin || (!range.end.empty() && cut >= range.end))
+			{
+				continue;
+			}
+			current.end = cut;
+			ranges.push_back(current);
+			current.begin = cut;
+		}
+		current.end = range.end;
+		ranges.push_back(current);
+	}
+
+	/*
+	 * Reads the number ending with '\r\n' at 'pos', returns 1 when read, 0 if
+	 * the line is not complete, -1 if it is not a number or too big for a
+	 * request.
+	 */
+	static int peek_number(const char* p, size_t len, size_t& pos, int64& n)
+	{
+		n = 0;
+		size_t start = pos;
+		while (pos < len && p[pos] >= '0' && p[pos] <= '9')
+		{
+			n = n * 10 + (p[pos] - '0');
+			if (n > INT32_MAX)
+			{
+				return -1;
+			}
+			pos++;
+		}
+		if (pos + 2 > len)
+		{
+			return 0;
+		}
+		if (pos == start || p[pos] != '\r' || p[pos + 1] != '\n')
+		{
+			return -1;
+		}
+		pos += 2;
+		return 1;
+	}
+
+	/*
+	 * Finds the end of the request at the front of 'p' without decoding it,
+	 * the first 'max' arguments of a multibulk request are set in 'args'.
+	 * Returns the request length, 0 if it is not complete yet and -1 if it
+	 * is not a valid multibulk request.
+	 */
+	int peek_request(const char* p, size_t len, Slice* args, uint32 max,
+	        uint32& argc)
+	{
+		argc = 0;
+		if (0 == len)
+		{
+			return 0;
+		}
+		if (p[0] != '*')
+		{
+			const char* nl = (const char*) memchr(p, '\n', len);
+			return NULL == nl ? 0 : nl - p + 1;
+		}
+		size_t pos = 1;
+		int64 count = 0;
+		int ret = peek_number(p, len, pos, count);
+		if (ret <= 0)
+		{
+			return ret;
+		}
+		for (int64 i = 0; i < count; i++)
+		{
+			if (pos >= len)
+			{
+				return 0;
+			}
+			if (p[pos] != '$')
+			{
+				return -1;
+			}
+			pos++;
+			int64 size = 0;
+			ret = peek_number(p, len, pos, size);
+			if (ret <= 0)
+			{
+				return ret;
+			}
+			if (pos + size + 2 > len)
+			{
+				return 0;
+			}
+			if (i < max)
+			{
+				args[i] = Slice(p + pos, size);
+			}
+			pos += size + 2;
+		}
+		if (pos > INT32_MAX)
+		{
+			return -1;
+		}
+		argc = count;
+		return pos;
+	}
+
+	/*
+	 * 'value' is left alone unless 's' is a number.
+	 */
+	static bool slice_touint64(const Slice& s, uint64& value)
+	{
+		if (s.empty() || s.size() > 20)
+		{
+			return false;
+		}
+		uint64 v = 0;
+		for (size_t i = 0; i < s.size(); i++)
+		{
+			if (s[i] < '0' || s[i] > '9')
+			{
+				return false;
+			}
+			uint64 next = v * 10 + (s[i] - '0');
+			if (next / 10 != v)
+			{
+				return false;
+			}
+			v = next;
+		}
+		value = v;
+		return true;
+	}
+
+	/*
+	 * Applies a replicated '__set__'/'__del__' directly to the engine, a
+	 * synced ardb master appends its sequence which is read into 'seq'.
+	 * Returns 1 if applied, 0 if the request is not a raw write and -1 if
+	 * it failed.
+	 */
+	int apply_raw_write(Ardb* db, Slice* args, uint32 argc, bool with_seq,
+	        uint64& seq)
+	{
+		if (argc < 2 || argc > kMaxRawWriteArgs || args[0].size() != 7)
+		{
+			return 0;
+		}
+		uint32 keyargs = argc - (with_seq ? 1 : 0);
+		bool set = false;
+		if (!strncasecmp(args[0].data(), "__set__", 7) && keyargs == 3)
+		{
+			set = true;
+		}
+		else if (strncasecmp(args[0].data(), "__del__", 7) || keyargs != 2)
+		{
+			return 0;
+		}
+		if (with_seq && !slice_touint64(args[argc - 1], seq))
+		{
+			ERROR_LOG("Invalid string value for sequence:%s",
+			        args[argc - 1].ToString().c_str());
+		}
+		int ret = set ? db->RawSet(args[1], args[2]) : db->RawDel(args[1]);
+		return 0 != ret ? -1 : 1;
+	}
+
+	/*
+	 * Moves 'records' into 'block' as one 'arbulk' command.
+	 */
+	void encode_bulk_block(Buffer& records, Buffer& block)
+	{
+		uint32 len = records.ReadableBytes();
+		block.Printf("*2\r\n$6\r\narbulk\r\n$%u\r\n", len);
+		block.Write(&records, len);
+		block.Write("\r\n", 2);
+		records.Clear();
+	}
+
+	/*
+	 * Returns the number of records written or -1. A block which does not
+	 * parse is rejected before anything is written, so the batch is never
+	 * discarded, that would also drop the writes of an enclosing batch.
+	 */
+	int64 load_bulk_block(KeyValueEngine* engine, const Slice& block)
+	{
+		Buffer records(const_cast<char*>(block.data()), 0, block.size());
+		Slice key, value;
+		int64 count = 0;
+		while (records.Readable())
+		{
+			if (!BufferHelper::ReadVarSlice(records, key)
+			        || !BufferHelper::ReadVarSlice(records, value))
+			{
+				return -1;
+			}
+			count++;
+		}
+		records.SetReadIndex(0);
+		BatchWriteGuard guard(engine);
+		while (records.Readable())
+		{
+			BufferHelper::ReadVarSlice(records, key);
+			BufferHelper::ReadVarSlice(records, value);
+			if (0 != engine->Put(key, value))
+			{
+				return -1;
+			}
+		}
+		return count;
+	}
+}
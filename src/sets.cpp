@@ -28,6 +28,7 @@
  */
 
 #include "ardb.hpp"
+#include <fnmatch.h>
 
 namespace ardb
 {
@@ -74,6 +75,11 @@ namespace ardb
 	{
 		KeyObject k(key, SET_META, db);
 		//SetKeyObject k(key, Slice());
+		if (meta.size == 0)
+		{
+			DelValue(k);
+			return;
+		}
 		ValueObject v;
 		EncodeSetMetaData(v, meta);
 		SetValue(k, v);
@@ -302,6 +308,7 @@ namespace ardb
 		{
 			return ERR_INVALID_ARGS;
 		}
+		SnapshotGuard snapshot(GetEngine());
 		SetMetaValueArray metas;
 		SliceArray::iterator kit = keys.begin();
 		while (kit != keys.end())
@@ -438,6 +445,7 @@ namespace ardb
 		{
 			return ERR_INVALID_ARGS;
 		}
+		SnapshotGuard snapshot(GetEngine());
 		int32 min_size = -1;
 		SetMetaValueArray metas;
 		uint32 min_idx = 0;
@@ -699,6 +707,7 @@ namespace ardb
 
 	int Ardb::SUnion(const DBID& db, SliceArray& keys, ValueSet& values)
 	{
+		SnapshotGuard snapshot(GetEngine());
 		for (uint32 i = 0; i < keys.size(); i++)
 		{
 			Slice k = keys.at(i);
@@ -750,5 +759,34 @@ namespace ardb
 		}
 		return 0;
 	}
+
+	int Ardb::SScan(const DBID& db, const Slice& key,
+	        const std::string& cursor, const std::string& pattern,
+	        uint32 limit, ValueArray& vs, std::string& newcursor)
+	{
+		Slice empty;
+		SetKeyObject sk(key, empty, db);
+		struct SScanWalk: public WalkHandler
+		{
+				const std::string& z_pattern;
+				ValueArray& z_vs;
+				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
+				{
+					SetKeyObject* sek = (SetKeyObject*) k;
+					std::string member;
+					sek->value.ToString(member);
+					if (fnmatch(z_pattern.c_str(), member.c_str(), 0) == 0)
+					{
+						z_vs.push_back(sek->value);
+					}
+					return 0;
+				}
+				SScanWalk(const std::string& p, ValueArray& vals) :
+						z_pattern(p), z_vs(vals)
+				{
+				}
+		} walk(pattern, vs);
+		return ScanElements(sk, cursor, limit, &walk, newcursor);
+	}
 }
 
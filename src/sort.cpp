@@ -174,6 +174,7 @@ namespace ardb
 			DEBUG_LOG("Failed to parse sort options.");
 			return ERR_INVALID_ARGS;
 		}
+		SnapshotGuard snapshot(GetEngine());
 		int type = Type(db, key);
 		ValueArray sortvals;
 		switch (type)
@@ -337,27 +338,28 @@ namespace ardb
 			}
 		}
 
+		snapshot.Release();
 		if (options.store_dst != NULL && !values.empty())
 		{
 			BatchWriteGuard guard(GetEngine());
 			LClear(db, options.store_dst);
 			ValueArray::iterator it = values.begin();
-			uint64 score = 0;
+			int64 index = 0;
 
 			while (it != values.end())
 			{
 				if (it->type != EMPTY)
 				{
-					ListKeyObject lk(options.store_dst, score, db);
+					ListKeyObject lk(options.store_dst, index, db);
 					SetValue(lk, *it);
-					score++;
+					index++;
 				}
 				it++;
 			}
 			ListMetaValue meta;
-			meta.min_score = 0;
-			meta.max_score = (score - 1);
-			meta.size = score;
+			meta.min_index = 0;
+			meta.max_index = index - 1;
+			meta.size = index;
 			SetListMetaValue(db, options.store_dst, meta);
 		}
 		return 0;
@@ -33,6 +33,7 @@ namespace ardb
 {
 	int Ardb::Append(const DBID& db, const Slice& key, const Slice& value)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		KeyObject k(key, KV, db);
 		ValueObject v;
 		if (GetValue(k, &v) < 0)
@@ -63,6 +64,7 @@ namespace ardb
 	int Ardb::Incrby(const DBID& db, const Slice& key, int64_t increment,
 	        int64_t& value)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		KeyObject k(key, KV, db);
 		ValueObject v;
 		if (GetValue(k, &v) < 0)
@@ -98,6 +100,7 @@ namespace ardb
 	int Ardb::IncrbyFloat(const DBID& db, const Slice& key, double increment,
 	        double& value)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		KeyObject k(key, KV, db);
 		ValueObject v;
 		if (GetValue(k, &v) < 0)
@@ -152,6 +155,7 @@ namespace ardb
 	int Ardb::SetRange(const DBID& db, const Slice& key, int start,
 	        const Slice& value)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		KeyObject k(key, KV, db);
 		ValueObject v;
 		if (GetValue(k, &v) < 0)
@@ -172,6 +176,7 @@ namespace ardb
 	int Ardb::GetSet(const DBID& db, const Slice& key, const Slice& value,
 	        std::string& v)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, key);
 		if (Get(db, key, &v) < 0)
 		{
 			Set(db, key, value);
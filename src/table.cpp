@@ -401,6 +401,52 @@ namespace ardb
 			}
 			meta.indexed.insert(tmp);
 		}
+		/*
+		 * Composite indexes follow as an optional section, schemas written
+		 * before they existed end here.
+		 */
+		uint32 complen = 0;
+		if (v.v.raw->Readable()
+				&& !BufferHelper::ReadVarUInt32(*(v.v.raw), complen))
+		{
+			return false;
+		}
+		for (uint32 i = 0; i < complen; i++)
+		{
+			TableIndexDef def;
+			uint8 ready;
+			uint32 len;
+			if (!BufferHelper::ReadVarString(*(v.v.raw), def.name)
+					|| !BufferHelper::ReadFixUInt8(*(v.v.raw), ready)
+					|| !BufferHelper::ReadVarUInt32(*(v.v.raw), len))
+			{
+				return false;
+			}
+			def.ready = ready != 0;
+			for (uint32 j = 0; j < len; j++)
+			{
+				std::string tmp;
+				if (!BufferHelper::ReadVarString(*(v.v.raw), tmp))
+				{
+					return false;
+				}
+				def.cols.push_back(tmp);
+			}
+			if (!BufferHelper::ReadVarUInt32(*(v.v.raw), len))
+			{
+				return false;
+			}
+			for (uint32 j = 0; j < len; j++)
+			{
+				std::string tmp;
+				if (!BufferHelper::ReadVarString(*(v.v.raw), tmp))
+				{
+					return false;
+				}
+				def.covered.push_back(tmp);
+			}
+			meta.composites.push_back(def);
+		}
 		return true;
 	}
 	static void EncodeTableSchemaData(ValueObject& v, TableSchemaValue& meta)
@@ -429,6 +475,27 @@ namespace ardb
 			BufferHelper::WriteVarString(*(v.v.raw), *it);
 			it++;
 		}
+		if (meta.composites.empty())
+		{
+			return;
+		}
+		BufferHelper::WriteVarUInt32(*(v.v.raw), meta.composites.size());
+		for (uint32 i = 0; i < meta.composites.size(); i++)
+		{
+			TableIndexDef& def = meta.composites[i];
+			BufferHelper::WriteVarString(*(v.v.raw), def.name);
+			BufferHelper::WriteFixUInt8(*(v.v.raw), def.ready ? 1 : 0);
+			BufferHelper::WriteVarUInt32(*(v.v.raw), def.cols.size());
+			for (uint32 j = 0; j < def.cols.size(); j++)
+			{
+				BufferHelper::WriteVarString(*(v.v.raw), def.cols[j]);
+			}
+			BufferHelper::WriteVarUInt32(*(v.v.raw), def.covered.size());
+			for (uint32 j = 0; j < def.covered.size(); j++)
+			{
+				BufferHelper::WriteVarString(*(v.v.raw), def.covered[j]);
+			}
+		}
 	}
 
 	int TableSchemaValue::Index(const Slice& key)
@@ -453,6 +520,24 @@ namespace ardb
 		std::string str(name.data(), name.size());
 		return indexed.count(str) > 0 || Index(name) >= 0;
 	}
+	TableIndexDef* TableSchemaValue::CompositeIndex(const Slice& name)
+	{
+		for (uint32 i = 0; i < composites.size(); i++)
+		{
+			if (name.compare(composites[i].name) == 0)
+			{
+				return &(composites[i]);
+			}
+		}
+		return NULL;
+	}
+	bool TableIndexDef::Uses(const Slice& col) const
+	{
+		std::string str(col.data(), col.size());
+		return std::find(cols.begin(), cols.end(), str) != cols.end()
+				|| std::find(covered.begin(), covered.end(), str)
+						!= covered.end();
+	}
 
 	int Ardb::GetTableMetaValue(const DBID& db, const Slice& tableName,
 			TableMetaValue& meta)
@@ -541,7 +626,6 @@ namespace ardb
 			TableSchemaValue& schema, Condition& cond,
 			SliceSet& prefetch_keyset, TableKeyIndexValueTable& results)
 	{
-		results.clear();
 		TableIndexKeyObject index(tableName, cond.keyname, cond.keyvalue, db);
 		TableColKeyObject colstart(tableName, cond.keyname, db);
 		bool reverse = cond.cmp == CMP_LESS || cond.cmp == CMP_LESS_EQ;
@@ -862,6 +946,7 @@ namespace ardb
 
 	int Ardb::TDelCol(const DBID& db, const Slice& tableName, const Slice& col)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, tableName);
 		TableSchemaValue schema;
 		if (0 != GetTableSchemaValue(db, tableName, schema))
 		{
@@ -898,11 +983,19 @@ namespace ardb
 							return -1;
 						}
 						tdb->DelValue(*sek);
+					} else if (k->type == TABLE_COMPOSITE_INDEX)
+					{
+						TableCompositeIndexKeyObject* sek =
+								(TableCompositeIndexKeyObject*) k;
+						if (sek->indexname != name)
+						{
+							return -1;
+						}
+						tdb->DelValue(*sek);
 					}
 					return 0;
 				}
 		} walk(this, col);
-		KeyLockerGuard keyguard(m_key_locker, db, tableName);
 		BatchWriteGuard guard(GetEngine());
 		TableIndexKeyObject start(tableName, col, ValueObject(), db);
 		TableColKeyObject col_start(tableName, col, db);
@@ -914,12 +1007,36 @@ namespace ardb
 		{
 			Walk(col_start, false, &walk);
 		}
+		/*
+		 * Composite indexes using the column go with it.
+		 */
+		bool dropped = false;
+		TableIndexDefArray::iterator dit = schema.composites.begin();
+		while (dit != schema.composites.end())
+		{
+			if (!dit->Uses(col))
+			{
+				dit++;
+				continue;
+			}
+			TIndexWalk drop(this, dit->name);
+			TableCompositeIndexKeyObject cstart(tableName, dit->name,
+					dit->cols.size(), db);
+			Walk(cstart, false, &drop);
+			dit = schema.composites.erase(dit);
+			dropped = true;
+		}
+		if (dropped)
+		{
+			SetTableSchemaValue(db, tableName, schema);
+		}
 		return 0;
 	}
 
 	int Ardb::TCreateIndex(const DBID& db, const Slice& tableName,
 			const Slice& col)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, tableName);
 		TableSchemaValue schema;
 		if (0 != GetTableSchemaValue(db, tableName, schema))
 		{
@@ -951,7 +1068,6 @@ namespace ardb
 					return 0;
 				}
 		} walk(this, col);
-		KeyLockerGuard keyguard(m_key_locker, db, tableName);
 		BatchWriteGuard guard(GetEngine());
 		schema.indexed.insert(std::string(col.data(), col.size()));
 		TableColKeyObject start(tableName, col, db);
@@ -960,71 +1076,737 @@ namespace ardb
 		return 0;
 	}
 
-	int Ardb::TCol(const DBID& db, const Slice& tableName,
-			TableSchemaValue& schema, const Slice& col,
-			TableKeyIndexValueTable& rs)
+	static const ValueObject& row_column_value(TableSchemaValue& schema,
+			const ValueArray& rowkey, NameValueTable& row,
+			const std::string& name)
 	{
-		int idx = schema.Index(col);
-		if (idx == ERR_NOT_EXIST)
+		static const ValueObject empty;
+		int idx = schema.Index(name);
+		if (idx >= 0 && (uint32) idx < rowkey.size())
 		{
-			return 0;
+			return rowkey[idx];
 		}
-		struct TColWalk: public WalkHandler
+		NameValueTable::iterator found = row.find(name);
+		return found == row.end() ? empty : found->second;
+	}
+
+	/*
+	 * Reads the non key columns of a row the composite indexes, or only
+	 * 'def', are built from into 'row'. Missing columns stay missing.
+	 */
+	void Ardb::TReadIndexedColumns(const DBID& db, const Slice& tableName,
+			TableSchemaValue& schema, const ValueArray& rowkey,
+			NameValueTable& row, TableIndexDef* def)
+	{
+		for (uint32 i = 0; i < schema.composites.size(); i++)
+		{
+			TableIndexDef& cdef = schema.composites[i];
+			if (NULL != def && def->name != cdef.name)
+			{
+				continue;
+			}
+			StringArray names = cdef.cols;
+			names.insert(names.end(), cdef.covered.begin(),
+					cdef.covered.end());
+			for (uint32 j = 0; j < names.size(); j++)
+			{
+				if (schema.Index(names[j]) >= 0 || row.count(names[j]) > 0)
+				{
+					continue;
+				}
+				TableColKeyObject k(tableName, names[j], db);
+				k.index = rowkey;
+				ValueObject v;
+				if (0 == GetValue(k, &v))
+				{
+					row[names[j]] = v;
+				}
+			}
+		}
+	}
+
+	/*
+	 * Writes, or removes, the entries of a row in the composite indexes, or
+	 * only in 'def'. A missing column is indexed as an empty value, so that
+	 * every row has an entry in every index.
+	 */
+	void Ardb::TSetCompositeIndexes(const DBID& db, const Slice& tableName,
+			TableSchemaValue& schema, const ValueArray& rowkey,
+			NameValueTable& row, bool remove, TableIndexDef* def)
+	{
+		for (uint32 i = 0; i < schema.composites.size(); i++)
+		{
+			TableIndexDef& cdef = schema.composites[i];
+			if (NULL != def && def->name != cdef.name)
+			{
+				continue;
+			}
+			TableCompositeIndexKeyObject k(tableName, cdef.name,
+					cdef.cols.size(), db);
+			k.index = rowkey;
+			for (uint32 j = 0; j < cdef.cols.size(); j++)
+			{
+				k.colvalues.push_back(
+						row_column_value(schema, rowkey, row, cdef.cols[j]));
+			}
+			if (remove)
+			{
+				DelValue(k);
+				continue;
+			}
+			ValueObject v;
+			if (!cdef.covered.empty())
+			{
+				v.type = RAW;
+				v.v.raw = new Buffer(16);
+				for (uint32 j = 0; j < cdef.covered.size(); j++)
+				{
+					encode_value(*(v.v.raw),
+							row_column_value(schema, rowkey, row,
+									cdef.covered[j]));
+				}
+			}
+			SetValue(k, v);
+		}
+	}
+
+	/*
+	 * Creates an index over several columns, holding the values of the
+	 * 'covered' columns too. The index goes into the schema first, so
+	 * writers keep it up to date from then on. The existing rows are then
+	 * indexed in batches, each one under the table lock for a short while
+	 * only, and last the index is marked ready for queries.
+	 */
+	int Ardb::TCreateIndex(const DBID& db, const Slice& tableName,
+			SliceArray& cols, SliceArray& covered)
+	{
+		static const uint32 kBatchSize = 1024;
+		if (cols.empty())
+		{
+			return ERR_INVALID_ARGS;
+		}
+		if (cols.size() == 1 && covered.empty())
+		{
+			return TCreateIndex(db, tableName, cols[0]);
+		}
+		TableIndexDef def;
+		for (uint32 i = 0; i < cols.size(); i++)
+		{
+			def.cols.push_back(std::string(cols[i].data(), cols[i].size()));
+			if (i > 0)
+			{
+				def.name.append(",");
+			}
+			def.name.append(def.cols[i]);
+		}
+		for (uint32 i = 0; i < covered.size(); i++)
+		{
+			def.covered.push_back(
+					std::string(covered[i].data(), covered[i].size()));
+		}
+		std::string keyname;
+		{
+			KeyLockerGuard keyguard(m_key_locker, db, tableName);
+			TableSchemaValue schema;
+			if (0 != GetTableSchemaValue(db, tableName, schema)
+					|| schema.keynames.empty())
+			{
+				return -1;
+			}
+			if (NULL != schema.CompositeIndex(def.name))
+			{
+				return 0;
+			}
+			schema.composites.push_back(def);
+			SetTableSchemaValue(db, tableName, schema);
+			keyname = schema.keynames[0];
+		}
+
+		/*
+		 * Every row has an entry in the index of the first key column, its
+		 * walk is the cursor over the rows.
+		 */
+		struct TRowKeyWalk: public WalkHandler
 		{
 				Slice name;
-				int colidx;
-				TableSchemaValue& sc;
-				TableKeyIndexValueTable& vvs;
-				TColWalk(const Slice& n, int idx, TableSchemaValue& scm,
-						TableKeyIndexValueTable& vs) :
-						name(n), colidx(idx), sc(scm), vvs(vs)
+				std::deque<TableKeyIndex>& rowkeys;
+				TRowKeyWalk(const Slice& n, std::deque<TableKeyIndex>& ks) :
+						name(n), rowkeys(ks)
 				{
 				}
 				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
 				{
-					if (colidx >= 0)
+					TableIndexKeyObject* ik = (TableIndexKeyObject*) k;
+					if (ik->colname != name)
 					{
-						TableIndexKeyObject* sek = (TableIndexKeyObject*) k;
-						if (sek->colname != name)
-						{
-							return -1;
-						}
-						std::string colname(name.data(), name.size());
-						vvs[sek->index][colname] = sek->colvalue;
-						//prefetch key value
-						for (uint32 i = 0; i < sc.keynames.size(); i++)
-						{
-							if (i != (uint32) colidx)
-							{
-								vvs[sek->index][sc.keynames[colidx]] =
-										sek->index[colidx];
-							}
-						}
-					} else
-					{
-						TableColKeyObject* sek = (TableColKeyObject*) k;
-						if (sek->colname != name)
-						{
-							return -1;
-						}
-						std::string colname(name.data(), name.size());
-						vvs[sek->index][colname] = *v;
+						return -1;
 					}
+					rowkeys.push_back(ik->index);
 					return 0;
 				}
-		} walk(col, idx, schema, rs);
-		if (idx >= 0)
+		};
+		std::string cursor = "0";
+		do
+		{
+			std::deque<TableKeyIndex> rowkeys;
+			TRowKeyWalk walk(keyname, rowkeys);
+			TableIndexKeyObject start(tableName, keyname, ValueObject(), db);
+			std::string next;
+			ScanElements(start, cursor, kBatchSize, &walk, next);
+			cursor = next;
+			{
+				KeyLockerGuard keyguard(m_key_locker, db, tableName);
+				TableSchemaValue schema;
+				if (0 != GetTableSchemaValue(db, tableName, schema)
+						|| NULL == schema.CompositeIndex(def.name))
+				{
+					//table cleared or index dropped meanwhile
+					return 0;
+				}
+				BatchWriteGuard guard(GetEngine());
+				while (!rowkeys.empty())
+				{
+					TableKeyIndex& rowkey = rowkeys.front();
+					if (TRowExists(db, tableName, schema, rowkey))
+					{
+						NameValueTable row;
+						TReadIndexedColumns(db, tableName, schema, rowkey, row,
+								&def);
+						TSetCompositeIndexes(db, tableName, schema, rowkey,
+								row, false, &def);
+					}
+					rowkeys.pop_front();
+				}
+			}
+			/*
+			 * In a group commit the batch is part of the group's and the
+			 * table lock is held until the group ends, write both out now.
+			 */
+			if (0 != SyncGroupCommit())
+			{
+				return -1;
+			}
+		} while (cursor != "0");
+
+		KeyLockerGuard keyguard(m_key_locker, db, tableName);
+		TableSchemaValue schema;
+		if (0 != GetTableSchemaValue(db, tableName, schema))
 		{
-			TableIndexKeyObject start(tableName, col, ValueObject(), db);
-			Walk(start, false, &walk);
-		} else
+			return 0;
+		}
+		TableIndexDef* created = schema.CompositeIndex(def.name);
+		if (NULL != created)
 		{
-			TableColKeyObject start(tableName, col, db);
-			Walk(start, false, &walk);
+			created->ready = true;
+			SetTableSchemaValue(db, tableName, schema);
 		}
 		return 0;
 	}
 
+	/*
+	 * Narrows the bounds of 'plan' by one condition on its column.
+	 */
+	static void tighten_scan_bounds(TableScanPlan& plan, Condition& cond)
+	{
+		bool low = false;
+		bool high = false;
+		bool inclusive = true;
+		switch (cond.cmp)
+		{
+			case CMP_EQAUL:
+			{
+				low = high = true;
+				break;
+			}
+			case CMP_GREATE:
+			{
+				low = true;
+				inclusive = false;
+				break;
+			}
+			case CMP_GREATE_EQ:
+			{
+				low = true;
+				break;
+			}
+			case CMP_LESS:
+			{
+				high = true;
+				inclusive = false;
+				break;
+			}
+			case CMP_LESS_EQ:
+			{
+				high = true;
+				break;
+			}
+			default:
+			{
+				return;
+			}
+		}
+		if (low)
+		{
+			int cmp = plan.has_low ? cond.keyvalue.Compare(plan.low) : 1;
+			if (cmp > 0 || (cmp == 0 && !inclusive))
+			{
+				plan.has_low = true;
+				plan.low = cond.keyvalue;
+				plan.low_inclusive = inclusive;
+			}
+		}
+		if (high)
+		{
+			int cmp = plan.has_high ? cond.keyvalue.Compare(plan.high) : -1;
+			if (cmp < 0 || (cmp == 0 && !inclusive))
+			{
+				plan.has_high = true;
+				plan.high = cond.keyvalue;
+				plan.high_inclusive = inclusive;
+			}
+		}
+	}
+
+	/*
+	 * Lower ranks are expected to visit fewer entries: an equal match on an
+	 * index, a closed range, an open range, the entries of a column, and
+	 * last a walk over a whole index.
+	 */
+	static int scan_plan_rank(TableScanPlan& plan)
+	{
+		if (!plan.use_index)
+		{
+			return 3;
+		}
+		if (plan.has_low && plan.has_high)
+		{
+			return plan.low.Compare(plan.high) == 0 ? 0 : 1;
+		}
+		return plan.has_low || plan.has_high ? 2 : 4;
+	}
+
+	/*
+	 * Makes 'plan' a walk over composite index 'def': the leading index
+	 * columns with an equal condition form the prefix, the conditions on
+	 * the column after them bound it. Returns the number of index columns
+	 * the walk is narrowed by.
+	 */
+	static uint32 plan_composite_scan(TableIndexDef& def, Conditions& conds,
+			TableScanPlan& plan)
+	{
+		plan.composite = def;
+		for (uint32 i = 0; i < def.cols.size(); i++)
+		{
+			TableScanPlan col;
+			for (uint32 j = 0; j < conds.size(); j++)
+			{
+				if (conds[j].keyname == def.cols[i])
+				{
+					tighten_scan_bounds(col, conds[j]);
+				}
+			}
+			plan.column = def.cols[i];
+			if (scan_plan_rank(col) == 0 && col.low_inclusive
+					&& col.high_inclusive)
+			{
+				plan.prefix.push_back(col.low);
+				continue;
+			}
+			plan.has_low = col.has_low;
+			plan.low = col.low;
+			plan.low_inclusive = col.low_inclusive;
+			plan.has_high = col.has_high;
+			plan.high = col.high;
+			plan.high_inclusive = col.high_inclusive;
+			return i + (col.has_low || col.has_high ? 1 : 0);
+		}
+		return def.cols.size();
+	}
+
+	/*
+	 * Whether composite index 'def' holds every column a query reads.
+	 */
+	static bool composite_covers(TableSchemaValue& schema, TableIndexDef& def,
+			TableQueryOptions& options)
+	{
+		StringArray names = options.names;
+		for (uint32 i = 0; i < options.conds.size(); i++)
+		{
+			names.push_back(options.conds[i].keyname);
+		}
+		for (uint32 i = 0; i < names.size(); i++)
+		{
+			if (schema.Index(names[i]) < 0 && !def.Uses(names[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/*
+	 * Whether the walk of 'plan' returns rows in the order of column
+	 * 'name', columns of a composite index prefix are constant.
+	 */
+	static bool scan_ordered_by(TableScanPlan& plan, const std::string& name)
+	{
+		if (!plan.use_index)
+		{
+			return false;
+		}
+		if (plan.column == name)
+		{
+			return true;
+		}
+		for (uint32 i = 0; i < plan.prefix.size(); i++)
+		{
+			if (plan.composite.cols[i] == name)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/*
+	 * Picks how TGet reads the rows of a query. Queries joining conditions
+	 * with 'or' are not planned, they still go through TGetIndexs.
+	 */
+	bool Ardb::TPlanQuery(TableSchemaValue& schema, TableQueryOptions& options,
+			int sort_idx, TableScanPlan& plan)
+	{
+		Conditions& conds = options.conds;
+		for (uint32 i = 0; i + 1 < conds.size(); i++)
+		{
+			if (conds[i].logicop != LOGIC_AND)
+			{
+				return false;
+			}
+		}
+		bool planned = false;
+		int best = 0;
+		uint32 best_narrowed = 0;
+		bool best_covers = false;
+		for (uint32 i = 0; i < conds.size(); i++)
+		{
+			TableScanPlan candidate;
+			candidate.column = conds[i].keyname;
+			candidate.use_index = schema.HasIndex(candidate.column);
+			for (uint32 j = 0; j < conds.size(); j++)
+			{
+				if (conds[j].keyname == candidate.column)
+				{
+					tighten_scan_bounds(candidate, conds[j]);
+				}
+			}
+			int rank = scan_plan_rank(candidate);
+			if (!planned || rank < best)
+			{
+				plan = candidate;
+				best = rank;
+				best_narrowed = candidate.has_low || candidate.has_high ? 1 : 0;
+				planned = true;
+			}
+		}
+		/*
+		 * A composite index competes on the same ranks, an equal prefix
+		 * counting as an equal match. Ties go to the walk narrowed by more
+		 * columns, then to the one needing no column lookups. A whole walk
+		 * over an index only pays off if it covers the query.
+		 */
+		for (uint32 i = 0; i < schema.composites.size(); i++)
+		{
+			TableIndexDef& def = schema.composites[i];
+			if (!def.ready)
+			{
+				continue;
+			}
+			TableScanPlan candidate;
+			uint32 narrowed = plan_composite_scan(def, conds, candidate);
+			int rank = candidate.prefix.empty() ?
+					scan_plan_rank(candidate) : 0;
+			bool covers = composite_covers(schema, def, options);
+			if (rank == 4 && !covers)
+			{
+				continue;
+			}
+			if (!planned || rank < best
+					|| (rank == best
+							&& (narrowed > best_narrowed
+									|| (narrowed == best_narrowed && covers
+											&& !best_covers))))
+			{
+				plan = candidate;
+				best = rank;
+				best_narrowed = narrowed;
+				best_covers = covers;
+				planned = true;
+			}
+		}
+		/*
+		 * Rows read in the order column's index need no sort and the walk
+		 * can stop at the limit, which is worth more than anything but an
+		 * equal match on another index. The index misses the rows without
+		 * the column, so it is only walked if every row has it or a
+		 * condition on it drops the others anyway.
+		 */
+		if (sort_idx >= 0 && !options.with_alpha
+				&& !(planned && scan_ordered_by(plan, options.names[sort_idx])))
+		{
+			const std::string& ordercol = options.names[sort_idx];
+			TableScanPlan ordered;
+			ordered.column = ordercol;
+			bool restricted = schema.Index(ordercol) >= 0;
+			for (uint32 j = 0; j < conds.size(); j++)
+			{
+				if (conds[j].keyname == ordercol)
+				{
+					tighten_scan_bounds(ordered, conds[j]);
+					restricted = true;
+				}
+			}
+			if (restricted && schema.HasIndex(ordercol)
+					&& (!planned || best > 0))
+			{
+				plan = ordered;
+				planned = true;
+			}
+		}
+		if (!planned)
+		{
+			plan.column = schema.keynames[0];
+			if (options.names.size() == 1 && schema.Index(options.names[0]) < 0)
+			{
+				plan.column = options.names[0];
+				plan.use_index = schema.HasIndex(plan.column);
+			}
+		}
+		plan.ordered = sort_idx < 0
+				|| (!options.with_alpha
+						&& scan_ordered_by(plan, options.names[sort_idx]));
+		plan.reverse = sort_idx >= 0 && plan.ordered && options.is_desc;
+		return true;
+	}
+
+	/*
+	 * Walks the entries of 'plan.column' within the plan's bounds, like
+	 * Walk does for a whole key.
+	 */
+	void Ardb::TScan(const DBID& db, const Slice& tableName, TableScanPlan& plan,
+			WalkHandler* handler)
+	{
+		if (!plan.composite.name.empty())
+		{
+			TScanComposite(db, tableName, plan, handler);
+			return;
+		}
+		TableIndexKeyObject index(tableName, plan.column, ValueObject(), db);
+		TableColKeyObject col(tableName, plan.column, db);
+		KeyObject* expected = &col;
+		bool bounded = false;
+		bool seek_after = plan.reverse;
+		if (plan.use_index)
+		{
+			expected = &index;
+			if (!plan.reverse && plan.has_low)
+			{
+				index.colvalue = plan.low;
+				bounded = true;
+				seek_after = !plan.low_inclusive;
+			} else if (plan.reverse && plan.has_high)
+			{
+				index.colvalue = plan.high;
+				bounded = true;
+				seek_after = plan.high_inclusive;
+			}
+		}
+		Buffer keybuf(tableName.size() + plan.column.size() + 32);
+		encode_key(keybuf, *expected);
+		std::string start(keybuf.GetRawReadBuffer(), keybuf.ReadableBytes());
+		if (seek_after)
+		{
+			/*
+			 * The encoded key ends with the 4 bytes count of an empty row
+			 * key, without it (and without the empty value's type byte when
+			 * there is no bound) it prefixes every entry to skip.
+			 */
+			size_t prefix_len = start.size() - 4;
+			if (plan.use_index && !bounded)
+			{
+				prefix_len--;
+			}
+			std::string prefix = start.substr(0, prefix_len);
+			next_key(prefix, start);
+		}
+		Iterator* iter = GetEngine()->Find(start, false);
+		if (NULL == iter)
+		{
+			return;
+		}
+		if (plan.reverse)
+		{
+			if (iter->Valid())
+			{
+				iter->Prev();
+			} else
+			{
+				iter->SeekToLast();
+			}
+		}
+		uint32 cursor = 0;
+		while (iter->Valid())
+		{
+			KeyObject* k = decode_key(iter->Key(), expected);
+			if (NULL == k || k->key.compare(tableName) != 0)
+			{
+				DELETE(k);
+				break;
+			}
+			bool inrange = true;
+			if (plan.use_index)
+			{
+				TableIndexKeyObject* ik = (TableIndexKeyObject*) k;
+				if (ik->colname.compare(plan.column) != 0)
+				{
+					inrange = false;
+				} else if (!plan.reverse && plan.has_high)
+				{
+					int cmp = ik->colvalue.Compare(plan.high);
+					inrange = cmp < 0 || (cmp == 0 && plan.high_inclusive);
+				} else if (plan.reverse && plan.has_low)
+				{
+					int cmp = ik->colvalue.Compare(plan.low);
+					inrange = cmp > 0 || (cmp == 0 && plan.low_inclusive);
+				}
+			} else
+			{
+				inrange = ((TableColKeyObject*) k)->colname.compare(plan.column)
+						== 0;
+			}
+			if (!inrange)
+			{
+				DELETE(k);
+				break;
+			}
+			ValueObject v;
+			Buffer readbuf(const_cast<char*>(iter->Value().data()), 0,
+					iter->Value().size());
+			decode_value(readbuf, v, false);
+			int ret = handler->OnKeyValue(k, &v, cursor++);
+			DELETE(k);
+			if (ret < 0)
+			{
+				break;
+			}
+			if (plan.reverse)
+			{
+				iter->Prev();
+			} else
+			{
+				iter->Next();
+			}
+		}
+		DELETE(iter);
+	}
+
+	/*
+	 * Walks the entries of the plan's composite index with the plan's
+	 * prefix, within the bounds on the index column after it.
+	 */
+	void Ardb::TScanComposite(const DBID& db, const Slice& tableName,
+			TableScanPlan& plan, WalkHandler* handler)
+	{
+		TableIndexDef& def = plan.composite;
+		uint32 width = def.cols.size();
+		TableCompositeIndexKeyObject expected(tableName, def.name, width, db);
+		expected.colvalues = plan.prefix;
+		bool seek_after = plan.reverse;
+		if (!plan.reverse && plan.has_low)
+		{
+			expected.colvalues.push_back(plan.low);
+			seek_after = !plan.low_inclusive;
+		} else if (plan.reverse && plan.has_high)
+		{
+			expected.colvalues.push_back(plan.high);
+			seek_after = plan.high_inclusive;
+		}
+		Buffer keybuf(tableName.size() + def.name.size() + 32);
+		encode_key(keybuf, expected);
+		std::string start(keybuf.GetRawReadBuffer(), keybuf.ReadableBytes());
+		if (seek_after)
+		{
+			/*
+			 * Without a row key the encoded key prefixes every entry to skip.
+			 */
+			std::string prefix = start;
+			next_key(prefix, start);
+		}
+		Iterator* iter = GetEngine()->Find(start, false);
+		if (NULL == iter)
+		{
+			return;
+		}
+		if (plan.reverse)
+		{
+			if (iter->Valid())
+			{
+				iter->Prev();
+			} else
+			{
+				iter->SeekToLast();
+			}
+		}
+		uint32 p = plan.prefix.size();
+		uint32 cursor = 0;
+		while (iter->Valid())
+		{
+			KeyObject* k = decode_key(iter->Key(), &expected);
+			TableCompositeIndexKeyObject* ck = (TableCompositeIndexKeyObject*) k;
+			bool inrange = NULL != k && ck->indexname.compare(def.name) == 0
+					&& ck->colvalues.size() == width;
+			for (uint32 i = 0; inrange && i < p; i++)
+			{
+				inrange = ck->colvalues[i].Compare(plan.prefix[i]) == 0;
+			}
+			if (inrange && p < width)
+			{
+				ValueObject& cv = ck->colvalues[p];
+				if (!plan.reverse && plan.has_high)
+				{
+					int cmp = cv.Compare(plan.high);
+					inrange = cmp < 0 || (cmp == 0 && plan.high_inclusive);
+				} else if (plan.reverse && plan.has_low)
+				{
+					int cmp = cv.Compare(plan.low);
+					inrange = cmp > 0 || (cmp == 0 && plan.low_inclusive);
+				}
+			}
+			if (!inrange)
+			{
+				DELETE(k);
+				break;
+			}
+			ValueObject v;
+			Buffer readbuf(const_cast<char*>(iter->Value().data()), 0,
+					iter->Value().size());
+			decode_value(readbuf, v, false);
+			int ret = handler->OnKeyValue(k, &v, cursor++);
+			DELETE(k);
+			if (ret < 0)
+			{
+				break;
+			}
+			if (plan.reverse)
+			{
+				iter->Prev();
+			} else
+			{
+				iter->Next();
+			}
+		}
+		DELETE(iter);
+	}
+
 	int Ardb::TGet(const DBID& db, const Slice& tableName,
 			TableQueryOptions& options, ValueArray& values, std::string& err)
 	{
@@ -1056,6 +1838,7 @@ namespace ardb
 			{
 				sort_idx = i;
 			}
+			kit++;
 		}
 
 		/*
@@ -1082,77 +1865,231 @@ namespace ardb
 			return -1;
 		}
 
-		std::deque<TableRow> rows;
-		if (options.conds.empty())
+		//check colname in conditions
+		Conditions::iterator cit = options.conds.begin();
+		while (cit != options.conds.end())
 		{
-			TableKeyIndexValueTable rs;
-			StringArray::const_iterator nit = options.names.begin();
-			bool all_key_filled = false;
-			while (nit != options.names.end())
+			if (schema.Index(cit->keyname) == ERR_NOT_EXIST)
 			{
-				//Read records sequentially
-				const Slice& colname = *nit;
-				if (schema.Index(colname) >= 0 && !all_key_filled)
-				{
-					if (!all_key_filled)
+				err = "Invalid where condition";
+				DEBUG_LOG("ERROR:%s", err.c_str());
+				return -1;
+			}
+			cit++;
+		}
+
+		std::deque<TableRow> rows;
+		TableScanPlan plan;
+		if (TPlanQuery(schema, options, sort_idx, plan))
+		{
+			/*
+			 * Checks the conditions on each row the plan walks, reading the
+			 * other columns by point lookups. Rows in query order go straight
+			 * to 'values' until the limit, others are kept for sorting or
+			 * aggregation, at most twice the rows the limit needs.
+			 */
+			struct TPlanRowWalk: public WalkHandler
+			{
+					Ardb* tdb;
+					DBID tdbid;
+					Slice table;
+					TableSchemaValue& sc;
+					TableQueryOptions& opt;
+					TableScanPlan& tplan;
+					std::deque<TableRow>& trows;
+					ValueArray& tvalues;
+					int sort_item_idx;
+					bool key_requested;
+					bool stream;
+					uint32 offset;
+					uint32 limit;
+					uint32 keep;
+					uint32 emitted;
+					int64 matched;
+					TPlanRowWalk(Ardb* d, const DBID& id, const Slice& t,
+							TableSchemaValue& s, TableQueryOptions& o,
+							TableScanPlan& p, std::deque<TableRow>& rs,
+							ValueArray& vs) :
+							tdb(d), tdbid(id), table(t), sc(s), opt(o), tplan(p), trows(
+									rs), tvalues(vs), sort_item_idx(-1), key_requested(
+									false), stream(false), offset(0), limit(0), keep(
+									0), emitted(0), matched(0)
 					{
-						all_key_filled = true;
-					} else
+					}
+					ValueObject* ColumnValue(const std::string& name,
+							ValueArray& rowkey,
+							std::map<std::string, ValueObject>& cols)
 					{
-						nit++;
-						continue;
+						int idx = sc.Index(name);
+						if (idx >= 0 && (uint32) idx < rowkey.size())
+						{
+							return &(rowkey[idx]);
+						}
+						std::map<std::string, ValueObject>::iterator found =
+								cols.find(name);
+						if (found == cols.end())
+						{
+							TableColKeyObject key(table, name, tdbid);
+							key.index = rowkey;
+							found = cols.insert(
+									std::make_pair(name, ValueObject())).first;
+							tdb->GetValue(key, &(found->second));
+						}
+						return found->second.type == EMPTY ?
+								NULL : &(found->second);
+					}
+					int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
+					{
+						ValueArray* rowkey = NULL;
+						std::map<std::string, ValueObject> cols;
+						if (k->type == TABLE_INDEX)
+						{
+							TableIndexKeyObject* ik = (TableIndexKeyObject*) k;
+							rowkey = &(ik->index);
+							cols[tplan.column] = ik->colvalue;
+						} else if (k->type == TABLE_COMPOSITE_INDEX)
+						{
+							TableCompositeIndexKeyObject* ck =
+									(TableCompositeIndexKeyObject*) k;
+							TableIndexDef& def = tplan.composite;
+							rowkey = &(ck->index);
+							for (uint32 i = 0; i < def.cols.size(); i++)
+							{
+								cols[def.cols[i]] = ck->colvalues[i];
+							}
+							for (uint32 i = 0;
+									v->type == RAW && i < def.covered.size(); i++)
+							{
+								decode_value(*(v->v.raw), cols[def.covered[i]]);
+							}
+						} else
+						{
+							TableColKeyObject* ck = (TableColKeyObject*) k;
+							rowkey = &(ck->index);
+							cols[tplan.column] = *v;
+						}
+						for (uint32 i = 0; i < opt.conds.size(); i++)
+						{
+							Condition& cond = opt.conds[i];
+							ValueObject* cv = ColumnValue(cond.keyname, *rowkey,
+									cols);
+							int cmp = 0;
+							if (NULL == cv || !cond.MatchValue(*cv, cmp))
+							{
+								return 0;
+							}
+						}
+						/*
+						 * Without conditions a row is only in the result if it
+						 * has one of the columns asked for.
+						 */
+						if (opt.conds.empty() && !key_requested)
+						{
+							bool found = false;
+							for (uint32 i = 0; i < opt.names.size() && !found;
+									i++)
+							{
+								found = NULL
+										!= ColumnValue(opt.names[i], *rowkey, cols);
+							}
+							if (!found)
+							{
+								return 0;
+							}
+						}
+						matched++;
+						if (opt.aggregate == AGGREGATE_COUNT)
+						{
+							return 0;
+						}
+						if (stream && matched <= offset)
+						{
+							return 0;
+						}
+						TableRow row;
+						row.sort_item_idx = sort_item_idx;
+						for (uint32 i = 0; i < opt.names.size(); i++)
+						{
+							ValueObject vv;
+							ValueObject* cv = ColumnValue(opt.names[i], *rowkey,
+									cols);
+							if (NULL != cv)
+							{
+								vv = *cv;
+							}
+							if (opt.with_alpha)
+							{
+								value_convert_to_raw(vv);
+							} else
+							{
+								value_convert_to_number(vv);
+							}
+							row.vs.push_back(vv);
+						}
+						if (stream)
+						{
+							tvalues.insert(tvalues.end(), row.vs.begin(),
+									row.vs.end());
+							emitted++;
+							return limit > 0 && emitted >= limit ? -1 : 0;
+						}
+						trows.push_back(row);
+						if (keep > 0 && trows.size() >= 2 * keep)
+						{
+							if (!opt.is_desc)
+							{
+								std::sort(trows.begin(), trows.end(),
+										less_value<TableRow>);
+							} else
+							{
+								std::sort(trows.begin(), trows.end(),
+										greater_value<TableRow>);
+							}
+							trows.resize(keep);
+						}
+						return 0;
 					}
+			} walk(this, db, tableName, schema, options, plan, rows, values);
+			walk.sort_item_idx = sort_idx;
+			for (uint32 i = 0; i < options.names.size(); i++)
+			{
+				if (schema.Index(options.names[i]) >= 0)
+				{
+					walk.key_requested = true;
 				}
-				TCol(db, tableName, schema, colname, rs);
-				nit++;
 			}
-
+			walk.stream = plan.ordered && options.aggregate == AGGREGATE_EMPTY;
+			if (options.with_limit && options.limit_count > 0)
+			{
+				walk.offset = options.limit_offset;
+				walk.limit = options.limit_count;
+				if (!walk.stream && options.aggregate == AGGREGATE_EMPTY
+						&& options.limit_offset >= 0)
+				{
+					walk.keep = options.limit_offset + options.limit_count;
+				}
+			} else if (options.with_limit)
+			{
+				walk.offset = options.limit_offset;
+			}
+			SnapshotGuard snapshot(GetEngine());
+			TScan(db, tableName, plan, &walk);
 			if (options.aggregate == AGGREGATE_COUNT)
 			{
-				ValueObject countobj((int64) rs.size());
+				ValueObject countobj(walk.matched);
 				values.push_back(countobj);
 				return 0;
 			}
-			TableKeyIndexValueTable::iterator tit = rs.begin();
-			while (tit != rs.end())
+			if (walk.stream)
 			{
-				TableRow row;
-				row.sort_item_idx = sort_idx;
-				StringArray::const_iterator nit = options.names.begin();
-				while (nit != options.names.end())
-				{
-					std::string colname(nit->data(), nit->size());
-					ValueObject& vv = tit->second[colname];
-					NameValueTable::iterator found = tit->second.find(colname);
-					if (options.with_alpha)
-					{
-						value_convert_to_raw(vv);
-					} else
-					{
-						value_convert_to_number(vv);
-					}
-					row.vs.push_back(vv);
-					nit++;
-				}
-				rows.push_back(row);
-				tit++;
+				return 0;
 			}
-			rs.clear();
-		} else //!options.conds.empty()
-		{
-			//check colname in conditions
-			Conditions::iterator cit = options.conds.begin();
-			while (cit != options.conds.end())
+			if (plan.ordered)
 			{
-				if (schema.Index(cit->keyname) == ERR_NOT_EXIST)
-				{
-					err = "Invalid where condition";
-					DEBUG_LOG("ERROR:%s", err.c_str());
-					return -1;
-				}
-				cit++;
+				sort_idx = -1;
 			}
-
+		} else
+		{
 			TableKeyIndexValueTable set1, set2;
 			TableKeyIndexValueTable* index = &set1;
 			TableKeyIndexValueTable* tmp = &set2;
@@ -1313,6 +2250,7 @@ namespace ardb
 	int Ardb::TUpdate(const DBID& db, const Slice& tableName,
 			TableUpdateOptions& options)
 	{
+		KeyLockerGuard keyguard(m_key_locker, db, tableName);
 		TableSchemaValue schema;
 		if (0 != GetTableSchemaValue(db, tableName, schema))
 		{
@@ -1329,9 +2267,22 @@ namespace ardb
 		}
 		uint32 colsize = schema.valnames.size();
 		DEBUG_LOG("###Found %d rows for update", index->size());
-		KeyLockerGuard keyguard(m_key_locker, db, tableName);
 		StringStringMap::const_iterator it = options.colnvs.begin();
 		BatchWriteGuard guard(GetEngine());
+		std::deque<NameValueTable> indexed_rows;
+		if (!schema.composites.empty())
+		{
+			TableKeyIndexValueTable::iterator iit = index->begin();
+			while (iit != index->end())
+			{
+				indexed_rows.push_back(NameValueTable());
+				TReadIndexedColumns(db, tableName, schema, iit->first,
+						indexed_rows.back());
+				TSetCompositeIndexes(db, tableName, schema, iit->first,
+						indexed_rows.back(), true);
+				iit++;
+			}
+		}
 		while (!index->empty() && it != options.colnvs.end())
 		{
 			TableKeyIndexValueTable::iterator iit = index->begin();
@@ -1376,6 +2327,30 @@ namespace ardb
 			}
 			it++;
 		}
+		if (!schema.composites.empty())
+		{
+			TableKeyIndexValueTable::iterator iit = index->begin();
+			for (uint32 i = 0; iit != index->end(); i++, iit++)
+			{
+				ValueArray rowkey = iit->first;
+				NameValueTable& row = indexed_rows[i];
+				it = options.colnvs.begin();
+				while (it != options.colnvs.end())
+				{
+					int idx = schema.Index(it->first);
+					if (idx >= 0)
+					{
+						smart_fill_value(it->second, rowkey[idx]);
+					} else
+					{
+						smart_fill_value(it->second, row[it->first]);
+					}
+					it++;
+				}
+				TSetCompositeIndexes(db, tableName, schema, rowkey, row,
+						false);
+			}
+		}
 		if (schema.valnames.size() != colsize)
 		{
 			SetTableSchemaValue(db, tableName, schema);
@@ -1441,6 +2416,11 @@ namespace ardb
 		}
 		uint32 colsize = schema.valnames.size();
 		bool hasrecord = TRowExists(db, tableName, schema, index);
+		NameValueTable indexed_row;
+		if (hasrecord && !schema.composites.empty())
+		{
+			TReadIndexedColumns(db, tableName, schema, index, indexed_row);
+		}
 		BatchWriteGuard guard(GetEngine());
 
 		//write value
@@ -1490,6 +2470,22 @@ namespace ardb
 			SetValue(tik, empty);
 			kit++;
 		}
+		if (!schema.composites.empty())
+		{
+			if (hasrecord)
+			{
+				TSetCompositeIndexes(db, tableName, schema, index, indexed_row,
+						true);
+			}
+			it = colnvs.begin();
+			while (it != colnvs.end())
+			{
+				smart_fill_value(it->second, indexed_row[it->first]);
+				it++;
+			}
+			TSetCompositeIndexes(db, tableName, schema, index, indexed_row,
+					false);
+		}
 
 		if (!hasrecord)
 		{
@@ -1511,6 +2507,7 @@ namespace ardb
 			return TClear(db, tableName);
 		}
 
+		KeyLockerGuard keyguard(m_key_locker, db, tableName);
 		TableMetaValue meta;
 		GetTableMetaValue(db, tableName, meta);
 		if (meta.size == 0)
@@ -1538,11 +2535,17 @@ namespace ardb
 		{
 			return 0;
 		}
-		KeyLockerGuard keyguard(m_key_locker, db, tableName);
 		BatchWriteGuard guard(GetEngine());
 		TableKeyIndexValueTable::iterator iit = index->begin();
 		while (iit != index->end())
 		{
+			if (!schema.composites.empty())
+			{
+				NameValueTable row;
+				TReadIndexedColumns(db, tableName, schema, iit->first, row);
+				TSetCompositeIndexes(db, tableName, schema, iit->first, row,
+						true);
+			}
 			for (uint32 i = 0; i < schema.keynames.size(); i++)
 			{
 				TableIndexKeyObject tik(tableName, schema.keynames[i],
@@ -1589,6 +2592,11 @@ namespace ardb
 					{
 						TableIndexKeyObject* tk = (TableIndexKeyObject*) k;
 						tdb->DelValue(*tk);
+					} else if (k->type == TABLE_COMPOSITE_INDEX)
+					{
+						TableCompositeIndexKeyObject* tk =
+								(TableCompositeIndexKeyObject*) k;
+						tdb->DelValue(*tk);
 					} else
 					{
 						TableColKeyObject* tk = (TableColKeyObject*) k;
@@ -1604,8 +2612,10 @@ namespace ardb
 		Slice empty;
 		TableIndexKeyObject istart(tableName, empty, empty, db);
 		TableColKeyObject cstart(tableName, empty, db);
+		TableCompositeIndexKeyObject ccstart(tableName, empty, 0, db);
 		Walk(istart, false, &walk);
 		Walk(cstart, false, &walk);
+		Walk(ccstart, false, &walk);
 		KeyObject k(tableName, TABLE_META, db);
 		KeyObject sck(tableName, TABLE_SCHEMA, db);
 		DelValue(k);
@@ -1641,6 +2651,29 @@ namespace ardb
 				str.append(" ");
 				it++;
 			}
+			if (!schema.composites.empty())
+			{
+				str.append("Indexes: ");
+			}
+			for (uint32 i = 0; i < schema.composites.size(); i++)
+			{
+				TableIndexDef& def = schema.composites[i];
+				str.append(def.name);
+				if (!def.covered.empty())
+				{
+					str.append("(C:");
+					for (uint32 j = 0; j < def.covered.size(); j++)
+					{
+						str.append(j > 0 ? "," : "").append(def.covered[j]);
+					}
+					str.append(")");
+				}
+				if (!def.ready)
+				{
+					str.append("(building)");
+				}
+				str.append(" ");
+			}
 			return 0;
 		}
 		return -1;
@@ -66,6 +66,7 @@ namespace ardb
 				for (uint32 i = 0; i < ctx.transaction_cmds->size(); i++)
 				{
 					RedisCommandFrame& cmd = ctx.transaction_cmds->at(i);
+					ctx.reply.Clear();
 					DoRedisCommand(ctx,
 							FindRedisCommandHandlerSetting(cmd.GetCommand()),
 							cmd);
@@ -0,0 +1,411 @@
+ /*
+ *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
+ *All rights reserved.
+ * 
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ * 
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Redis nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ * 
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+ *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ *THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "util/bit_kernels.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BIT_KERNELS_X86 1
+#endif
+
+namespace ardb
+{
+	static inline uint64 popcount64_portable(uint64 x)
+	{
+		x = x - ((x >> 1) & 0x5555555555555555ULL);
+		x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+		x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+		return (x * 0x0101010101010101ULL) >> 56;
+	}
+
+	/*
+	 * A run starts at every set bit whose lower neighbour is clear; the
+	 * neighbour of bit 0 is the top bit of the previous word.
+	 */
+	static inline uint64 run_starts(uint64 prev, uint64 w)
+	{
+		return w & ~((w << 1) | (prev >> 63));
+	}
+
+	static void op_words(uint32 op, uint64* dst, const uint64* src, size_t n)
+	{
+		size_t i;
+		switch (op)
+		{
+			case BIT_KERNEL_AND:
+				for (i = 0; i < n; i++)
+					dst[i] &= src[i];
+				break;
+			case BIT_KERNEL_OR:
+				for (i = 0; i < n; i++)
+					dst[i] |= src[i];
+				break;
+			default:
+				for (i = 0; i < n; i++)
+					dst[i] ^= src[i];
+				break;
+		}
+	}
+
+	static void negate_words(uint64* dst, size_t n)
+	{
+		for (size_t i = 0; i < n; i++)
+			dst[i] = ~dst[i];
+	}
+
+	static inline uint64 op_word(uint32 op, uint64 a, uint64 b)
+	{
+		return op == BIT_KERNEL_AND ? a & b : (op == BIT_KERNEL_OR ? a | b : a ^ b);
+	}
+
+	static uint64 popcount_portable(const uint64* words, size_t n)
+	{
+		uint64 count = 0;
+		for (size_t i = 0; i < n; i++)
+			count += popcount64_portable(words[i]);
+		return count;
+	}
+
+	static uint64 op_popcount_portable(uint32 op, const uint64* a,
+	        const uint64* b, size_t n)
+	{
+		uint64 count = 0;
+		for (size_t i = 0; i < n; i++)
+			count += popcount64_portable(op_word(op, a[i], b[i]));
+		return count;
+	}
+
+	static uint64 count_runs_portable(const uint64* words, size_t n)
+	{
+		uint64 count = 0, prev = 0;
+		for (size_t i = 0; i < n; i++)
+		{
+			count += popcount64_portable(run_starts(prev, words[i]));
+			prev = words[i];
+		}
+		return count;
+	}
+
+	static const BitKernels kPortableKernels =
+	{ "portable", popcount_portable, op_words, negate_words,
+	        op_popcount_portable, count_runs_portable };
+
+#ifdef BIT_KERNELS_X86
+	__attribute__((target("popcnt")))
+	static uint64 popcount_popcnt(const uint64* words, size_t n)
+	{
+		uint64 count = 0;
+		for (size_t i = 0; i < n; i++)
+			count += __builtin_popcountll(words[i]);
+		return count;
+	}
+
+	__attribute__((target("popcnt")))
+	static uint64 op_popcount_popcnt(uint32 op, const uint64* a,
+	        const uint64* b, size_t n)
+	{
+		uint64 count = 0;
+		size_t i;
+		switch (op)
+		{
+			case BIT_KERNEL_AND:
+				for (i = 0; i < n; i++)
+					count += __builtin_popcountll(a[i] & b[i]);
+				break;
+			case BIT_KERNEL_OR:
+				for (i = 0; i < n; i++)
+					count += __builtin_popcountll(a[i] | b[i]);
+				break;
+			default:
+				for (i = 0; i < n; i++)
+					count += __builtin_popcountll(a[i] ^ b[i]);
+				break;
+		}
+		return count;
+	}
+
+	__attribute__((target("popcnt")))
+	static uint64 count_runs_popcnt(const uint64* words, size_t n)
+	{
+		uint64 count = 0, prev = 0;
+		for (size_t i = 0; i < n; i++)
+		{
+			count += __builtin_popcountll(run_starts(prev, words[i]));
+			prev = words[i];
+		}
+		return count;
+	}
+
+	static const BitKernels kPopcntKernels =
+	{ "popcnt", popcount_popcnt, op_words, negate_words, op_popcount_popcnt,
+	        count_runs_popcnt };
+
+	/*
+	 * AVX2 has no vector popcount: count the nibbles of each byte with a
+	 * shuffle lookup and sum the bytes with SAD (Mula's method).
+	 */
+	__attribute__((target("avx2")))
+	static inline __m256i popcount256(__m256i v)
+	{
+		const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2,
+		        2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+		const __m256i low_mask = _mm256_set1_epi8(0x0f);
+		__m256i lo = _mm256_and_si256(v, low_mask);
+		__m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+		__m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+		        _mm256_shuffle_epi8(lookup, hi));
+		return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+	}
+
+	__attribute__((target("avx2")))
+	static inline uint64 sum256(__m256i acc)
+	{
+		return (uint64) _mm256_extract_epi64(acc, 0)
+		        + (uint64) _mm256_extract_epi64(acc, 1)
+		        + (uint64) _mm256_extract_epi64(acc, 2)
+		        + (uint64) _mm256_extract_epi64(acc, 3);
+	}
+
+	__attribute__((target("avx2,popcnt")))
+	static uint64 popcount_avx2(const uint64* words, size_t n)
+	{
+		__m256i acc = _mm256_setzero_si256();
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			__m256i v = _mm256_loadu_si256((const __m256i*) (words + i));
+			acc = _mm256_add_epi64(acc, popcount256(v));
+		}
+		uint64 count = sum256(acc);
+		for (; i < n; i++)
+			count += __builtin_popcountll(words[i]);
+		return count;
+	}
+
+	__attribute__((target("avx2")))
+	static void op_avx2(uint32 op, uint64* dst, const uint64* src, size_t n)
+	{
+		size_t i = 0;
+		switch (op)
+		{
+			case BIT_KERNEL_AND:
+				for (; i + 4 <= n; i += 4)
+				{
+					__m256i a = _mm256_loadu_si256((const __m256i*) (dst + i));
+					__m256i b = _mm256_loadu_si256((const __m256i*) (src + i));
+					_mm256_storeu_si256((__m256i*) (dst + i), _mm256_and_si256(a, b));
+				}
+				break;
+			case BIT_KERNEL_OR:
+				for (; i + 4 <= n; i += 4)
+				{
+					__m256i a = _mm256_loadu_si256((const __m256i*) (dst + i));
+					__m256i b = _mm256_loadu_si256((const __m256i*) (src + i));
+					_mm256_storeu_si256((__m256i*) (dst + i), _mm256_or_si256(a, b));
+				}
+				break;
+			default:
+				for (; i + 4 <= n; i += 4)
+				{
+					__m256i a = _mm256_loadu_si256((const __m256i*) (dst + i));
+					__m256i b = _mm256_loadu_si256((const __m256i*) (src + i));
+					_mm256_storeu_si256((__m256i*) (dst + i), _mm256_xor_si256(a, b));
+				}
+				break;
+		}
+		op_words(op, dst + i, src + i, n - i);
+	}
+
+	__attribute__((target("avx2")))
+	static void negate_avx2(uint64* dst, size_t n)
+	{
+		const __m256i ones = _mm256_set1_epi64x(-1);
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			__m256i v = _mm256_loadu_si256((const __m256i*) (dst + i));
+			_mm256_storeu_si256((__m256i*) (dst + i), _mm256_xor_si256(v, ones));
+		}
+		negate_words(dst + i, n - i);
+	}
+
+	__attribute__((target("avx2,popcnt")))
+	static uint64 op_popcount_avx2(uint32 op, const uint64* a, const uint64* b,
+	        size_t n)
+	{
+		__m256i acc = _mm256_setzero_si256();
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			__m256i x = _mm256_loadu_si256((const __m256i*) (a + i));
+			__m256i y = _mm256_loadu_si256((const __m256i*) (b + i));
+			__m256i v = op == BIT_KERNEL_AND ? _mm256_and_si256(x, y) : (
+			        op == BIT_KERNEL_OR ? _mm256_or_si256(x, y) : _mm256_xor_si256(x, y));
+			acc = _mm256_add_epi64(acc, popcount256(v));
+		}
+		uint64 count = sum256(acc);
+		for (; i < n; i++)
+			count += __builtin_popcountll(op_word(op, a[i], b[i]));
+		return count;
+	}
+
+	static const BitKernels kAVX2Kernels =
+	{ "avx2", popcount_avx2, op_avx2, negate_avx2, op_popcount_avx2,
+	        count_runs_popcnt };
+
+	__attribute__((target("avx512f")))
+	static inline uint64 sum512(__m512i acc)
+	{
+		uint64 lanes[8];
+		_mm512_storeu_si512((void*) lanes, acc);
+		return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5]
+		        + lanes[6] + lanes[7];
+	}
+
+	__attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+	static uint64 popcount_avx512(const uint64* words, size_t n)
+	{
+		__m512i acc = _mm512_setzero_si512();
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			__m512i v = _mm512_loadu_si512((const void*) (words + i));
+			acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(v));
+		}
+		uint64 count = sum512(acc);
+		for (; i < n; i++)
+			count += __builtin_popcountll(words[i]);
+		return count;
+	}
+
+	__attribute__((target("avx512f")))
+	static void op_avx512(uint32 op, uint64* dst, const uint64* src, size_t n)
+	{
+		size_t i = 0;
+		switch (op)
+		{
+			case BIT_KERNEL_AND:
+				for (; i + 8 <= n; i += 8)
+				{
+					__m512i a = _mm512_loadu_si512((const void*) (dst + i));
+					__m512i b = _mm512_loadu_si512((const void*) (src + i));
+					_mm512_storeu_si512((void*) (dst + i), _mm512_and_si512(a, b));
+				}
+				break;
+			case BIT_KERNEL_OR:
+				for (; i + 8 <= n; i += 8)
+				{
+					__m512i a = _mm512_loadu_si512((const void*) (dst + i));
+					__m512i b = _mm512_loadu_si512((const void*) (src + i));
+					_mm512_storeu_si512((void*) (dst + i), _mm512_or_si512(a, b));
+				}
+				break;
+			default:
+				for (; i + 8 <= n; i += 8)
+				{
+					__m512i a = _mm512_loadu_si512((const void*) (dst + i));
+					__m512i b = _mm512_loadu_si512((const void*) (src + i));
+					_mm512_storeu_si512((void*) (dst + i), _mm512_xor_si512(a, b));
+				}
+				break;
+		}
+		op_words(op, dst + i, src + i, n - i);
+	}
+
+	__attribute__((target("avx512f")))
+	static void negate_avx512(uint64* dst, size_t n)
+	{
+		const __m512i ones = _mm512_set1_epi64(-1);
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			__m512i v = _mm512_loadu_si512((const void*) (dst + i));
+			_mm512_storeu_si512((void*) (dst + i), _mm512_xor_si512(v, ones));
+		}
+		negate_words(dst + i, n - i);
+	}
+
+	__attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+	static uint64 op_popcount_avx512(uint32 op, const uint64* a,
+	        const uint64* b, size_t n)
+	{
+		__m512i acc = _mm512_setzero_si512();
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			__m512i x = _mm512_loadu_si512((const void*) (a + i));
+			__m512i y = _mm512_loadu_si512((const void*) (b + i));
+			__m512i v = op == BIT_KERNEL_AND ? _mm512_and_si512(x, y) : (
+			        op == BIT_KERNEL_OR ? _mm512_or_si512(x, y) : _mm512_xor_si512(x, y));
+			acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(v));
+		}
+		uint64 count = sum512(acc);
+		for (; i < n; i++)
+			count += __builtin_popcountll(op_word(op, a[i], b[i]));
+		return count;
+	}
+
+	static const BitKernels kAVX512Kernels =
+	{ "avx512", popcount_avx512, op_avx512, negate_avx512,
+	        op_popcount_avx512, count_runs_popcnt };
+#endif
+
+	void supported_bit_kernels(std::vector<const BitKernels*>& kernels)
+	{
+		kernels.push_back(&kPortableKernels);
+#ifdef BIT_KERNELS_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("popcnt"))
+		{
+			kernels.push_back(&kPopcntKernels);
+			if (__builtin_cpu_supports("avx2"))
+			{
+				kernels.push_back(&kAVX2Kernels);
+			}
+			if (__builtin_cpu_supports("avx512f")
+			        && __builtin_cpu_supports("avx512vpopcntdq"))
+			{
+				kernels.push_back(&kAVX512Kernels);
+			}
+		}
+#endif
+	}
+
+	static const BitKernels* select_bit_kernels()
+	{
+		std::vector<const BitKernels*> kernels;
+		supported_bit_kernels(kernels);
+		return kernels.back();
+	}
+
+	const BitKernels& bit_kernels()
+	{
+		static const BitKernels* kernels = select_bit_kernels();
+		return *kernels;
+	}
+}
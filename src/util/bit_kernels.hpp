@@ -0,0 +1,75 @@
+ /*
+ *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
+ *All rights reserved.
+ * 
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ * 
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Redis nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ * 
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+ *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ *THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BIT_KERNELS_HPP_
+#define BIT_KERNELS_HPP_
+#include "common.hpp"
+#include <stddef.h>
+#include <vector>
+
+namespace ardb
+{
+	enum BitKernelOp
+	{
+		BIT_KERNEL_AND = 0, BIT_KERNEL_OR = 1, BIT_KERNEL_XOR = 2
+	};
+
+	/*
+	 * Popcount and bitwise kernels over arrays of 64 bit words, the
+	 * bitmap form of a bitset chunk. One set is picked at startup for the
+	 * instructions the CPU has: AVX-512 VPOPCNTDQ, AVX2, POPCNT, or plain
+	 * C++.
+	 */
+	struct BitKernels
+	{
+			const char* name;
+			uint64 (*popcount)(const uint64* words, size_t n);
+			/*
+			 * dst = dst op src
+			 */
+			void (*op)(uint32 op, uint64* dst, const uint64* src, size_t n);
+			void (*negate)(uint64* dst, size_t n);
+			/*
+			 * Popcount of a op b, without writing the result.
+			 */
+			uint64 (*op_popcount)(uint32 op, const uint64* a, const uint64* b,
+			        size_t n);
+			/*
+			 * Number of runs of consecutive set bits.
+			 */
+			uint64 (*count_runs)(const uint64* words, size_t n);
+	};
+
+	const BitKernels& bit_kernels();
+	/*
+	 * Every kernel set the CPU can run, the plain C++ one first.
+	 */
+	void supported_bit_kernels(std::vector<const BitKernels*>& kernels);
+}
+#endif /* BIT_KERNELS_HPP_ */
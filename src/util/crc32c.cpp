@@ -0,0 +1,97 @@
+ /*
+ *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
+ *All rights reserved.
+ * 
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ * 
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Redis nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ * 
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+ *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ *THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "util/crc32c.hpp"
+#include <string.h>
+
+namespace ardb
+{
+	static const uint32 kCRC32CPoly = 0x82F63B78;
+
+	/*
+	 * Slicing-by-8 tables, table[k][b] is the crc of byte b followed by k
+	 * zero bytes.
+	 */
+	struct CRC32CTables
+	{
+			uint32 table[8][256];
+			CRC32CTables()
+			{
+				for (uint32 i = 0; i < 256; i++)
+				{
+					uint32 crc = i;
+					for (uint32 j = 0; j < 8; j++)
+					{
+						crc = (crc & 1) ? (crc >> 1) ^ kCRC32CPoly : crc >> 1;
+					}
+					table[0][i] = crc;
+				}
+				for (uint32 i = 0; i < 256; i++)
+				{
+					for (uint32 k = 1; k < 8; k++)
+					{
+						table[k][i] = (table[k - 1][i] >> 8)
+						        ^ table[0][table[k - 1][i] & 0xFF];
+					}
+				}
+			}
+	};
+	static const CRC32CTables kCRC32CTables;
+
+	uint32 crc32c_extend(uint32 crc, const char* data, size_t len)
+	{
+		const uint32 (*t)[256] = kCRC32CTables.table;
+		const unsigned char* p = (const unsigned char*) data;
+		crc = ~crc;
+		while (len >= 8)
+		{
+			uint32 lo, hi;
+			memcpy(&lo, p, 4);
+			memcpy(&hi, p + 4, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			lo = __builtin_bswap32(lo);
+			hi = __builtin_bswap32(hi);
+#endif
+			lo ^= crc;
+			crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF]
+			        ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+			        ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF]
+			        ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+			p += 8;
+			len -= 8;
+		}
+		while (len > 0)
+		{
+			crc = t[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+			p++;
+			len--;
+		}
+		return ~crc;
+	}
+}
@@ -39,6 +39,7 @@
 #include <sys/ioctl.h>
 #include <stdio.h>
 #include <dirent.h>
+#include <errno.h>
 #include "sha1.h"
 
 namespace ardb
@@ -220,7 +221,7 @@ namespace ardb
 						std::string file_path = path;
 						file_path.append("/").append(ptr->d_name);
 						memset(&buf, 0, sizeof(buf));
-						ret = stat(path.c_str(), &buf);
+						ret = stat(file_path.c_str(), &buf);
 						if (ret == 0)
 						{
 							if (S_ISDIR(buf.st_mode))
@@ -259,7 +260,7 @@ namespace ardb
 						std::string file_path = path;
 						file_path.append("/").append(ptr->d_name);
 						memset(&buf, 0, sizeof(buf));
-						ret = stat(path.c_str(), &buf);
+						ret = stat(file_path.c_str(), &buf);
 						if (ret == 0)
 						{
 							if (S_ISREG(buf.st_mode))
@@ -276,6 +277,79 @@ namespace ardb
 		return -1;
 	}
 
+	int64 file_copy(const std::string& src, const std::string& dst,
+			int64 limit)
+	{
+		FILE* in = fopen(src.c_str(), "rb");
+		if (NULL == in)
+		{
+			return -1;
+		}
+		FILE* out = fopen(dst.c_str(), "wb");
+		if (NULL == out)
+		{
+			fclose(in);
+			return -1;
+		}
+		char buf[65536];
+		int64 total = 0;
+		while (limit < 0 || total < limit)
+		{
+			size_t want = sizeof(buf);
+			if (limit >= 0 && (int64) want > limit - total)
+			{
+				want = limit - total;
+			}
+			size_t len = fread(buf, 1, want, in);
+			if (len == 0 || fwrite(buf, 1, len, out) != len)
+			{
+				break;
+			}
+			total += len;
+		}
+		bool fail = ferror(in) || ferror(out);
+		fclose(in);
+		if (0 != fclose(out) || fail)
+		{
+			return -1;
+		}
+		return total;
+	}
+
+	int file_link(const std::string& src, const std::string& dst)
+	{
+		if (0 == link(src.c_str(), dst.c_str()))
+		{
+			return 0;
+		}
+		if (errno == EXDEV || errno == EPERM)
+		{
+			return file_copy(src, dst) < 0 ? -1 : 0;
+		}
+		return -1;
+	}
+
+	int remove_dir(const std::string& path)
+	{
+		std::deque<std::string> entries;
+		if (0 != list_subdirs(path, entries))
+		{
+			return -1;
+		}
+		while (!entries.empty())
+		{
+			remove_dir(path + "/" + entries.front());
+			entries.pop_front();
+		}
+		list_subfiles(path, entries);
+		while (!entries.empty())
+		{
+			unlink((path + "/" + entries.front()).c_str());
+			entries.pop_front();
+		}
+		return rmdir(path.c_str());
+	}
+
 	int64 file_size(const std::string& path)
 	{
 		struct stat buf;
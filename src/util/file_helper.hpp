@@ -51,6 +51,17 @@ namespace ardb
 	int list_subdirs(const std::string& path, std::deque<std::string>& dirs);
 	int list_subfiles(const std::string& path, std::deque<std::string>& fs);
 
+	/*
+	 * Copy at most 'limit' bytes (all if negative), return the copied size.
+	 */
+	int64 file_copy(const std::string& src, const std::string& dst,
+			int64 limit = -1);
+	/*
+	 * Hard link a file, falling back to a copy across file systems.
+	 */
+	int file_link(const std::string& src, const std::string& dst);
+	int remove_dir(const std::string& path);
+
 	int64 file_size(const std::string& path);
 
 	int sha1sum_file(const std::string& file, std::string& hash);
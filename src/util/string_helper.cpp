@@ -539,4 +539,56 @@ namespace ardb
 		}
 		return std::string(buf, len);
 	}
+
+	std::string string_tohex(const std::string& str)
+	{
+		static const char digits[] = "0123456789abcdef";
+		std::string hex;
+		hex.reserve(str.size() * 2);
+		for (size_t i = 0; i < str.size(); i++)
+		{
+			unsigned char c = (unsigned char) str[i];
+			hex.push_back(digits[c >> 4]);
+			hex.push_back(digits[c & 0x0F]);
+		}
+		return hex;
+	}
+
+	static inline int hex_digit_value(char c)
+	{
+		if (c >= '0' && c <= '9')
+		{
+			return c - '0';
+		}
+		if (c >= 'a' && c <= 'f')
+		{
+			return c - 'a' + 10;
+		}
+		if (c >= 'A' && c <= 'F')
+		{
+			return c - 'A' + 10;
+		}
+		return -1;
+	}
+
+	bool string_fromhex(const std::string& hex, std::string& str)
+	{
+		if (hex.size() % 2 != 0)
+		{
+			return false;
+		}
+		str.clear();
+		str.reserve(hex.size() / 2);
+		for (size_t i = 0; i < hex.size(); i += 2)
+		{
+			int hi = hex_digit_value(hex[i]);
+			int lo = hex_digit_value(hex[i + 1]);
+			if (hi < 0 || lo < 0)
+			{
+				return false;
+			}
+			str.push_back((char) ((hi << 4) | lo));
+		}
+		return true;
+	}
 }
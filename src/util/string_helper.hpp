@@ -125,6 +125,9 @@ namespace ardb
 	bool has_suffix(const std::string& str, const std::string& suffix);
 
 	std::string random_string(uint32 len);
+
+	std::string string_tohex(const std::string& str);
+	bool string_fromhex(const std::string& hex, std::string& str);
 }
 
 #endif /* STRING_HELPER_HPP_ */
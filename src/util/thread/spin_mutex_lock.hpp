@@ -0,0 +1,83 @@
+ /*
+ *Copyright (c) 2013-2013, yinqiwen <yinqiwen@gmail.com>
+ *All rights reserved.
+ * 
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ * 
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Redis nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ * 
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+ *BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ *THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPIN_MUTEX_LOCK_HPP_
+#define SPIN_MUTEX_LOCK_HPP_
+#include <sched.h>
+#include <stdint.h>
+
+namespace ardb
+{
+	/*
+	 * Test-and-test-and-set spin lock for very short critical sections,
+	 * yields the cpu if the lock is held for long.
+	 */
+	class SpinMutexLock
+	{
+		private:
+			volatile int m_locked;
+		public:
+			SpinMutexLock() :
+					m_locked(0)
+			{
+			}
+			bool Lock()
+			{
+				uint32_t spins = 0;
+				while (__sync_lock_test_and_set(&m_locked, 1))
+				{
+					while (m_locked)
+					{
+						if (++spins < 1024)
+						{
+#if defined(__x86_64__) || defined(__i386__)
+							asm volatile("pause" ::: "memory");
+#endif
+						}
+						else
+						{
+							sched_yield();
+						}
+					}
+				}
+				return true;
+			}
+			bool TryLock()
+			{
+				return 0 == __sync_lock_test_and_set(&m_locked, 1);
+			}
+			bool Unlock()
+			{
+				__sync_lock_release(&m_locked);
+				return true;
+			}
+	};
+}
+
+#endif /* SPIN_MUTEX_LOCK_HPP_ */
@@ -44,7 +44,7 @@ namespace ardb
 			}
 			T* InitialValue()
 			{
-				return new T;
+				return new T();
 			}
 		public:
 			ThreadLocal()
@@ -28,6 +28,7 @@
  */
 
 #include "ardb.hpp"
+#include <fnmatch.h>
 
 namespace ardb
 {
@@ -63,9 +64,21 @@ namespace ardb
 		{
 			return false;
 		}
-		return BufferHelper::ReadVarUInt32(*(v.v.raw), meta.size)
-				&& BufferHelper::ReadFixDouble(*(v.v.raw), meta.min_score)
-				&& BufferHelper::ReadFixDouble(*(v.v.raw), meta.max_score);
+		if (!BufferHelper::ReadVarUInt32(*(v.v.raw), meta.size)
+				|| !BufferHelper::ReadFixDouble(*(v.v.raw), meta.min_score)
+				|| !BufferHelper::ReadFixDouble(*(v.v.raw), meta.max_score))
+		{
+			return false;
+		}
+		/*
+		 * Metas written before the rank index have no levels field.
+		 */
+		meta.rank_levels = 0;
+		if (v.v.raw->Readable())
+		{
+			return BufferHelper::ReadVarUInt32(*(v.v.raw), meta.rank_levels);
+		}
+		return true;
 	}
 	static void EncodeZSetMetaData(ValueObject& v, ZSetMetaValue& meta)
 	{
@@ -77,6 +90,95 @@ namespace ardb
 		BufferHelper::WriteVarUInt32(*(v.v.raw), meta.size);
 		BufferHelper::WriteFixDouble(*(v.v.raw), meta.min_score);
 		BufferHelper::WriteFixDouble(*(v.v.raw), meta.max_score);
+		BufferHelper::WriteVarUInt32(*(v.v.raw), meta.rank_levels);
+	}
+
+	static bool DecodeZSetRankNode(ValueObject& v, ZSetRankNode& node)
+	{
+		if (v.type != RAW)
+		{
+			return false;
+		}
+		return BufferHelper::ReadVarUInt32(*(v.v.raw), node.count)
+				&& BufferHelper::ReadVarUInt32(*(v.v.raw), node.width);
+	}
+	static void EncodeZSetRankNode(ValueObject& v, ZSetRankNode& node)
+	{
+		v.type = RAW;
+		if (v.v.raw == NULL)
+		{
+			v.v.raw = new Buffer(16);
+		}
+		BufferHelper::WriteVarUInt32(*(v.v.raw), node.count);
+		BufferHelper::WriteVarUInt32(*(v.v.raw), node.width);
+	}
+
+	/*
+	 * Zsets with more than kZSetRankMinSize elements keep a rank index, it
+	 * is dropped again once they shrink below half of that. Level 0 nodes
+	 * are split when they count more than kZSetRankBucketSize elements,
+	 * upper level nodes when they have more than kZSetRankFanout children,
+	 * so a rank lookup reads at most kZSetRankFanout nodes per level and
+	 * kZSetRankBucketSize elements.
+	 */
+	static const uint32 kZSetRankMinSize = 256;
+	static const uint32 kZSetRankBucketSize = 128;
+	static const uint32 kZSetRankFanout = 32;
+
+	static void zset_element_prefix(const DBID& db, const Slice& key,
+			std::string& prefix)
+	{
+		KeyObject k(key, ZSET_ELEMENT, db);
+		Buffer buf(key.size() + 16);
+		encode_key_prefix(buf, k);
+		prefix.assign(buf.GetRawReadBuffer(), buf.ReadableBytes());
+	}
+
+	/*
+	 * The position of an element is its encoded key without the header and
+	 * key name, positions compare like the elements themselves.
+	 */
+	static void zset_element_pos(const ZSetKeyObject& zsk, std::string& pos)
+	{
+		Buffer prefix(zsk.key.size() + 16);
+		encode_key_prefix(prefix, zsk);
+		Buffer keybuf(zsk.key.size() + 32);
+		encode_key(keybuf, zsk);
+		pos.assign(keybuf.GetRawReadBuffer() + prefix.ReadableBytes(),
+				keybuf.ReadableBytes() - prefix.ReadableBytes());
+	}
+
+	static void zset_rank_node_key(const DBID& db, const Slice& key,
+			uint32 level, const Slice& pos, std::string& nodekey)
+	{
+		ZSetRankKeyObject k(key, ZSET_RANK_NODE, level, pos, db);
+		Buffer buf(key.size() + pos.size() + 16);
+		encode_key(buf, k);
+		nodekey.assign(buf.GetRawReadBuffer(), buf.ReadableBytes());
+	}
+
+	/*
+	 * Decode the boundary of the rank index node the iterator is on, false
+	 * once it left the given level of the zset.
+	 */
+	static bool zset_rank_iter_node(Iterator* iter, const DBID& db,
+			const Slice& key, uint32 level, std::string& pos)
+	{
+		if (NULL == iter || !iter->Valid())
+		{
+			return false;
+		}
+		KeyObject* k = decode_key(iter->Key(), NULL);
+		bool found = NULL != k && k->type == ZSET_RANK_NODE && k->db == db
+				&& k->key.compare(key) == 0
+				&& ((ZSetRankKeyObject*) k)->level == level;
+		if (found)
+		{
+			ZSetRankKeyObject* rk = (ZSetRankKeyObject*) k;
+			pos.assign(rk->pos.data(), rk->pos.size());
+		}
+		DELETE(k);
+		return found;
 	}
 
 	int Ardb::ZAddLimit(const DBID& db, const Slice& key, DoubleArray& scores,
@@ -118,6 +220,8 @@ namespace ardb
 		}
 		ZSetScoreKeyObject zk(key, value, db);
 		ValueObject zv;
+		uint32 rank_levels = meta.rank_levels;
+		std::string pos;
 		if (0 != GetValue(zk, &zv))
 		{
 			meta.size++;
@@ -128,6 +232,8 @@ namespace ardb
 			ValueObject zsv;
 			zsv.type = EMPTY;
 			SetValue(zsk, zsv);
+			zset_element_pos(zsk, pos);
+			ZSetRankInsert(db, key, meta, pos);
 			return 2;
 		} else
 		{
@@ -135,14 +241,18 @@ namespace ardb
 			{
 				ZSetKeyObject zsk(key, value, zv.v.double_v, db);
 				DelValue(zsk);
+				zset_element_pos(zsk, pos);
+				ZSetRankRemove(db, key, meta, pos);
 				zsk.score = score;
 				ValueObject zsv;
 				zsv.type = EMPTY;
 				SetValue(zsk, zsv);
+				zset_element_pos(zsk, pos);
+				ZSetRankInsert(db, key, meta, pos);
 				zv.type = DOUBLE;
 				zv.v.double_v = score;
 				SetValue(zk, zv);
-				return metachange ? 1 : 0;
+				return (metachange || rank_levels != meta.rank_levels) ? 1 : 0;
 			}
 		}
 		return -1;
@@ -188,6 +298,11 @@ namespace ardb
 			ZSetMetaValue& meta)
 	{
 		KeyObject k(key, ZSET_META, db);
+		if (meta.size == 0)
+		{
+			DelValue(k);
+			return;
+		}
 		ValueObject v;
 		EncodeZSetMetaData(v, meta);
 		SetValue(k, v);
@@ -209,6 +324,513 @@ namespace ardb
 		return ERR_NOT_EXIST;
 	}
 
+	int Ardb::GetZSetRankNode(const DBID& db, const Slice& key, uint32 level,
+			const Slice& pos, ZSetRankNode& node)
+	{
+		ZSetRankKeyObject k(key, ZSET_RANK_COUNT, level, pos, db);
+		ValueObject v;
+		if (0 == GetValue(k, &v))
+		{
+			if (!DecodeZSetRankNode(v, node))
+			{
+				return ERR_INVALID_TYPE;
+			}
+			return 0;
+		}
+		return ERR_NOT_EXIST;
+	}
+
+	/*
+	 * Write the counts of a node, 'created' also writes its boundary.
+	 */
+	void Ardb::SetZSetRankNode(const DBID& db, const Slice& key, uint32 level,
+			const Slice& pos, ZSetRankNode& node, bool created)
+	{
+		if (created)
+		{
+			ZSetRankKeyObject bk(key, ZSET_RANK_NODE, level, pos, db);
+			ValueObject empty;
+			SetValue(bk, empty);
+		}
+		ZSetRankKeyObject k(key, ZSET_RANK_COUNT, level, pos, db);
+		ValueObject v;
+		EncodeZSetRankNode(v, node);
+		SetValue(k, v);
+	}
+
+	void Ardb::DelZSetRankNode(const DBID& db, const Slice& key, uint32 level,
+			const Slice& pos)
+	{
+		ZSetRankKeyObject bk(key, ZSET_RANK_NODE, level, pos, db);
+		DelValue(bk);
+		ZSetRankKeyObject k(key, ZSET_RANK_COUNT, level, pos, db);
+		DelValue(k);
+	}
+
+	/*
+	 * Find the boundaries of the nodes whose range contains 'pos', one per
+	 * level. The first child of a node shares its boundary, so every level
+	 * is searched forward from the node found above it.
+	 */
+	int Ardb::ZSetRankPath(const DBID& db, const Slice& key,
+			ZSetMetaValue& meta, const Slice& pos, StringArray& path)
+	{
+		path.assign(meta.rank_levels, std::string());
+		std::string start;
+		for (uint32 level = meta.rank_levels; level > 0; level--)
+		{
+			std::string bound, seek;
+			zset_rank_node_key(db, key, level - 1, pos, bound);
+			zset_rank_node_key(db, key, level - 1, start, seek);
+			Iterator* iter = GetEngine()->Find(seek, false);
+			std::string nodepos;
+			bool found = false;
+			while (zset_rank_iter_node(iter, db, key, level - 1, nodepos)
+					&& iter->Key().compare(bound) <= 0)
+			{
+				found = true;
+				start = nodepos;
+				iter->Next();
+			}
+			DELETE(iter);
+			if (!found)
+			{
+				return ERR_NOT_EXIST;
+			}
+			path[level - 1] = start;
+		}
+		return 0;
+	}
+
+	void Ardb::ZSetRankClear(const DBID& db, const Slice& key,
+			ZSetMetaValue& meta)
+	{
+		if (meta.rank_levels == 0)
+		{
+			return;
+		}
+		KeyObject k(key, ZSET_RANK_NODE, db);
+		Buffer prefixbuf(key.size() + 16);
+		encode_key_prefix(prefixbuf, k);
+		Slice prefix(prefixbuf.GetRawReadBuffer(), prefixbuf.ReadableBytes());
+		Iterator* iter = GetEngine()->Find(prefix, false);
+		while (NULL != iter && iter->Valid() && iter->Key().starts_with(prefix))
+		{
+			KeyObject* rk = decode_key(iter->Key(), NULL);
+			if (NULL != rk && rk->type == ZSET_RANK_NODE)
+			{
+				ZSetRankKeyObject* node = (ZSetRankKeyObject*) rk;
+				std::string pos(node->pos.data(), node->pos.size());
+				DelZSetRankNode(db, key, node->level, pos);
+			}
+			DELETE(rk);
+			iter->Next();
+		}
+		DELETE(iter);
+		meta.rank_levels = 0;
+	}
+
+	/*
+	 * Build the rank index of a zset from its elements, level 0 nodes start
+	 * half full so the following inserts do not split them at once.
+	 */
+	void Ardb::ZSetRankBuild(const DBID& db, const Slice& key,
+			ZSetMetaValue& meta)
+	{
+		ZSetRankClear(db, key, meta);
+		if (meta.size <= kZSetRankMinSize)
+		{
+			return;
+		}
+		std::string prefix;
+		zset_element_prefix(db, key, prefix);
+		StringArray bounds;
+		std::vector<ZSetRankNode> nodes;
+		Iterator* iter = GetEngine()->Find(prefix, false);
+		while (NULL != iter && iter->Valid()
+				&& iter->Key().starts_with(prefix))
+		{
+			if (nodes.empty() || nodes.back().width == kZSetRankBucketSize / 2)
+			{
+				std::string pos;
+				if (!nodes.empty())
+				{
+					pos.assign(iter->Key().data() + prefix.size(),
+							iter->Key().size() - prefix.size());
+				}
+				bounds.push_back(pos);
+				nodes.push_back(ZSetRankNode());
+			}
+			nodes.back().count++;
+			nodes.back().width++;
+			iter->Next();
+		}
+		DELETE(iter);
+		uint32 level = 0;
+		while (true)
+		{
+			for (uint32 i = 0; i < nodes.size(); i++)
+			{
+				SetZSetRankNode(db, key, level, bounds[i], nodes[i], true);
+			}
+			level++;
+			if (nodes.size() <= kZSetRankFanout)
+			{
+				break;
+			}
+			StringArray upperbounds;
+			std::vector<ZSetRankNode> uppernodes;
+			for (uint32 i = 0; i < nodes.size(); i++)
+			{
+				if (uppernodes.empty()
+						|| uppernodes.back().width == kZSetRankFanout / 2)
+				{
+					upperbounds.push_back(bounds[i]);
+					uppernodes.push_back(ZSetRankNode());
+				}
+				uppernodes.back().count += nodes[i].count;
+				uppernodes.back().width++;
+			}
+			bounds.swap(upperbounds);
+			nodes.swap(uppernodes);
+		}
+		meta.rank_levels = level;
+	}
+
+	/*
+	 * Split a node which outgrew its level into two halves. The second half
+	 * becomes a new child of the node above, which may have to split in
+	 * turn, and a new top level is added once the top one gets too wide.
+	 */
+	void Ardb::ZSetRankSplit(const DBID& db, const Slice& key,
+			ZSetMetaValue& meta, StringArray& path, uint32 level,
+			ZSetRankNode& node)
+	{
+		std::string nodepos = path[level];
+		bool created = false;
+		while (true)
+		{
+			ZSetRankNode first;
+			first.width = node.width / 2;
+			std::string splitpos;
+			bool found = false;
+			if (level == 0)
+			{
+				std::string prefix;
+				zset_element_prefix(db, key, prefix);
+				Iterator* iter = GetEngine()->Find(prefix + nodepos, false);
+				uint32 skip = first.width;
+				while (NULL != iter && iter->Valid()
+						&& iter->Key().starts_with(prefix))
+				{
+					if (skip == 0)
+					{
+						splitpos.assign(iter->Key().data() + prefix.size(),
+								iter->Key().size() - prefix.size());
+						found = true;
+						break;
+					}
+					skip--;
+					iter->Next();
+				}
+				DELETE(iter);
+				first.count = first.width;
+			}
+			else
+			{
+				std::string seek;
+				zset_rank_node_key(db, key, level - 1, nodepos, seek);
+				Iterator* iter = GetEngine()->Find(seek, false);
+				uint32 skip = first.width;
+				while (zset_rank_iter_node(iter, db, key, level - 1, splitpos))
+				{
+					if (skip == 0)
+					{
+						found = true;
+						break;
+					}
+					ZSetRankNode child;
+					if (0 != GetZSetRankNode(db, key, level - 1, splitpos, child))
+					{
+						break;
+					}
+					first.count += child.count;
+					skip--;
+					iter->Next();
+				}
+				DELETE(iter);
+			}
+			if (!found || first.count > node.count)
+			{
+				/*
+				 * The node does not match the elements, rebuild the index.
+				 */
+				ZSetRankBuild(db, key, meta);
+				return;
+			}
+			ZSetRankNode second;
+			second.count = node.count - first.count;
+			second.width = node.width - first.width;
+			SetZSetRankNode(db, key, level, nodepos, first, created);
+			SetZSetRankNode(db, key, level, splitpos, second, true);
+			level++;
+			created = false;
+			if (level == meta.rank_levels)
+			{
+				std::string seek, pos;
+				zset_rank_node_key(db, key, level - 1, Slice(), seek);
+				Iterator* iter = GetEngine()->Find(seek, false);
+				uint32 width = 0;
+				while (zset_rank_iter_node(iter, db, key, level - 1, pos))
+				{
+					width++;
+					iter->Next();
+				}
+				DELETE(iter);
+				if (width <= kZSetRankFanout)
+				{
+					return;
+				}
+				meta.rank_levels++;
+				nodepos.clear();
+				node.count = meta.size;
+				node.width = width;
+				created = true;
+			}
+			else
+			{
+				nodepos = path[level];
+				if (0 != GetZSetRankNode(db, key, level, nodepos, node))
+				{
+					ZSetRankBuild(db, key, meta);
+					return;
+				}
+				node.width++;
+				if (node.width <= kZSetRankFanout)
+				{
+					SetZSetRankNode(db, key, level, nodepos, node);
+					return;
+				}
+			}
+		}
+	}
+
+	/*
+	 * Count a new element at 'pos' in the rank index, called after the
+	 * element is written and counted in meta.size.
+	 */
+	void Ardb::ZSetRankInsert(const DBID& db, const Slice& key,
+			ZSetMetaValue& meta, const Slice& pos)
+	{
+		if (meta.rank_levels == 0)
+		{
+			if (meta.size > kZSetRankMinSize)
+			{
+				ZSetRankBuild(db, key, meta);
+			}
+			return;
+		}
+		StringArray path;
+		if (0 != ZSetRankPath(db, key, meta, pos, path))
+		{
+			ZSetRankBuild(db, key, meta);
+			return;
+		}
+		ZSetRankNode bucket;
+		for (uint32 level = 0; level < meta.rank_levels; level++)
+		{
+			ZSetRankNode node;
+			if (0 != GetZSetRankNode(db, key, level, path[level], node))
+			{
+				ZSetRankBuild(db, key, meta);
+				return;
+			}
+			node.count++;
+			if (level == 0)
+			{
+				node.width++;
+				bucket = node;
+			}
+			SetZSetRankNode(db, key, level, path[level], node);
+		}
+		if (bucket.width > kZSetRankBucketSize)
+		{
+			ZSetRankSplit(db, key, meta, path, 0, bucket);
+		}
+	}
+
+	/*
+	 * Uncount a removed element at 'pos', called after the element is
+	 * deleted and uncounted in meta.size. Empty level 0 nodes are dropped
+	 * unless their boundary is also one of the level above.
+	 */
+	void Ardb::ZSetRankRemove(const DBID& db, const Slice& key,
+			ZSetMetaValue& meta, const Slice& pos)
+	{
+		if (meta.rank_levels == 0)
+		{
+			return;
+		}
+		if (meta.size < kZSetRankMinSize / 2)
+		{
+			ZSetRankClear(db, key, meta);
+			return;
+		}
+		StringArray path;
+		if (0 != ZSetRankPath(db, key, meta, pos, path))
+		{
+			ZSetRankBuild(db, key, meta);
+			return;
+		}
+		bool dropped = false;
+		for (uint32 level = 0; level < meta.rank_levels; level++)
+		{
+			const std::string& nodepos = path[level];
+			ZSetRankNode node;
+			if (0 != GetZSetRankNode(db, key, level, nodepos, node)
+					|| node.count == 0)
+			{
+				ZSetRankBuild(db, key, meta);
+				return;
+			}
+			node.count--;
+			if (level == 0)
+			{
+				node.width--;
+				ZSetRankNode upper;
+				if (node.width == 0 && !nodepos.empty()
+						&& (meta.rank_levels == 1
+								|| 0 != GetZSetRankNode(db, key, 1, nodepos,
+										upper)))
+				{
+					DelZSetRankNode(db, key, level, nodepos);
+					dropped = true;
+					continue;
+				}
+			}
+			else if (level == 1 && dropped)
+			{
+				node.width--;
+			}
+			SetZSetRankNode(db, key, level, nodepos, node);
+		}
+	}
+
+	/*
+	 * Number of elements before 'pos', it reads the nodes of every level
+	 * within the range of the node above and walks the elements of one
+	 * level 0 node. Without a rank index it walks from the first element.
+	 */
+	int Ardb::ZSetRankOf(const DBID& db, const Slice& key, ZSetMetaValue& meta,
+			const Slice& pos, uint32& rank)
+	{
+		rank = 0;
+		std::string start;
+		for (uint32 level = meta.rank_levels; level > 0; level--)
+		{
+			std::string bound, seek;
+			zset_rank_node_key(db, key, level - 1, pos, bound);
+			zset_rank_node_key(db, key, level - 1, start, seek);
+			Iterator* iter = GetEngine()->Find(seek, false);
+			std::string nodepos;
+			bool found = false;
+			while (zset_rank_iter_node(iter, db, key, level - 1, nodepos)
+					&& iter->Key().compare(bound) <= 0)
+			{
+				if (found)
+				{
+					ZSetRankNode node;
+					if (0 != GetZSetRankNode(db, key, level - 1, start, node))
+					{
+						found = false;
+						break;
+					}
+					rank += node.count;
+				}
+				found = true;
+				start = nodepos;
+				iter->Next();
+			}
+			DELETE(iter);
+			if (!found)
+			{
+				return ERR_NOT_EXIST;
+			}
+		}
+		std::string prefix;
+		zset_element_prefix(db, key, prefix);
+		std::string end = prefix;
+		end.append(pos.data(), pos.size());
+		Iterator* iter = GetEngine()->Find(prefix + start, false);
+		while (NULL != iter && iter->Valid() && iter->Key().compare(end) < 0)
+		{
+			rank++;
+			iter->Next();
+		}
+		DELETE(iter);
+		return 0;
+	}
+
+	/*
+	 * Find the encoded key of the element with the given rank, the same
+	 * descent as ZSetRankOf with the counts of the nodes deciding the path.
+	 */
+	int Ardb::ZSetElementAt(const DBID& db, const Slice& key,
+			ZSetMetaValue& meta, uint32 rank, std::string& element)
+	{
+		if (rank >= meta.size)
+		{
+			return ERR_NOT_EXIST;
+		}
+		std::string start;
+		for (uint32 level = meta.rank_levels; level > 0; level--)
+		{
+			std::string seek;
+			zset_rank_node_key(db, key, level - 1, start, seek);
+			Iterator* iter = GetEngine()->Find(seek, false);
+			std::string nodepos;
+			bool found = false;
+			while (zset_rank_iter_node(iter, db, key, level - 1, nodepos))
+			{
+				ZSetRankNode node;
+				if (0 != GetZSetRankNode(db, key, level - 1, nodepos, node))
+				{
+					break;
+				}
+				if (rank < node.count)
+				{
+					start = nodepos;
+					found = true;
+					break;
+				}
+				rank -= node.count;
+				iter->Next();
+			}
+			DELETE(iter);
+			if (!found)
+			{
+				return ERR_NOT_EXIST;
+			}
+		}
+		std::string prefix;
+		zset_element_prefix(db, key, prefix);
+		Iterator* iter = GetEngine()->Find(prefix + start, false);
+		int ret = ERR_NOT_EXIST;
+		while (NULL != iter && iter->Valid() && iter->Key().starts_with(prefix))
+		{
+			if (rank == 0)
+			{
+				element = iter->Key().ToString();
+				ret = 0;
+				break;
+			}
+			rank--;
+			iter->Next();
+		}
+		DELETE(iter);
+		return ret;
+	}
+
 	int Ardb::ZCard(const DBID& db, const Slice& key)
 	{
 		ZSetMetaValue meta;
@@ -240,15 +862,14 @@ namespace ardb
 		ValueObject zv;
 		if (0 == GetValue(zk, &zv))
 		{
+			ZSetMetaValue meta;
+			GetZSetMetaValue(db, key, meta);
+			score = zv.v.double_v + increment;
 			BatchWriteGuard guard(GetEngine());
-			SetValue(zk, zv);
-			ZSetKeyObject zsk(key, value, zv.v.double_v, db);
-			DelValue(zsk);
-			zsk.score += increment;
-			ValueObject zsv;
-			zsv.type = EMPTY;
-			SetValue(zsk, zsv);
-			score = zsk.score;
+			if (TryZAdd(db, key, meta, score, value) > 0)
+			{
+				SetZSetMetaValue(db, key, meta);
+			}
 			return 0;
 		}
 		return ERR_NOT_EXIST;
@@ -272,6 +893,7 @@ namespace ardb
 				Ardb* z_db;
 				uint32 count;
 				ValueArray& vs;
+				ZSetMetaValue& z_meta;
 				int OnKeyValue(KeyObject* k, ValueObject* value, uint32 cursor)
 				{
 					ZSetKeyObject* sek = (ZSetKeyObject*) k;
@@ -280,21 +902,24 @@ namespace ardb
 					count--;
 					z_db->DelValue(*sek);
 					z_db->DelValue(tmp);
+					z_meta.size--;
+					std::string pos;
+					zset_element_pos(*sek, pos);
+					z_db->ZSetRankRemove(sek->db, sek->key, z_meta, pos);
 					if (count == 0)
 					{
 						return -1;
 					}
 					return 0;
 				}
-				ZPopWalk(Ardb* db, uint32 i, ValueArray& v) :
-						z_db(db), count(i), vs(v)
+				ZPopWalk(Ardb* db, uint32 i, ValueArray& v, ZSetMetaValue& meta) :
+						z_db(db), count(i), vs(v), z_meta(meta)
 				{
 				}
-		} walk(this, num, pops);
+		} walk(this, num, pops, meta);
 		Walk(sk, reverse, &walk);
 		if (walk.count < num)
 		{
-			meta.size -= (num - walk.count);
 			SetZSetMetaValue(db, key, meta);
 		}
 		return 0;
@@ -329,6 +954,7 @@ namespace ardb
 				}
 		} walk(this);
 		Walk(sk, false, &walk);
+		ZSetRankClear(db, key, meta);
 		KeyObject k(key, ZSET_META, db);
 		DelValue(k);
 		return 0;
@@ -349,6 +975,9 @@ namespace ardb
 			if (0 == GetZSetMetaValue(db, key, meta))
 			{
 				meta.size--;
+				std::string pos;
+				zset_element_pos(zsk, pos);
+				ZSetRankRemove(db, key, meta, pos);
 				SetZSetMetaValue(db, key, meta);
 			}
 			return 0;
@@ -416,33 +1045,20 @@ namespace ardb
 		{
 			return ERR_NOT_EXIST;
 		}
-		Slice empty;
-		ZSetKeyObject start(key, empty, meta.min_score, db);
-		struct ZRankWalk: public WalkHandler
+		double score;
+		if (0 != ZScore(db, key, member, score))
 		{
-				int rank;
-				ValueObject z_member;
-				int foundRank;
-				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
-				{
-					ZSetKeyObject* zko = (ZSetKeyObject*) k;
-					std::string str;
-					if (zko->value.Compare(z_member) == 0)
-					{
-						foundRank = rank;
-						return -1;
-					}
-					rank++;
-					return 0;
-				}
-				ZRankWalk(const Slice& m) :
-						rank(0), foundRank(ERR_NOT_EXIST)
-				{
-					smart_fill_value(m, z_member);
-				}
-		} walk(member);
-		Walk(start, false, &walk);
-		return walk.foundRank;
+			return ERR_NOT_EXIST;
+		}
+		ZSetKeyObject zsk(key, member, score, db);
+		std::string pos;
+		zset_element_pos(zsk, pos);
+		uint32 rank;
+		if (0 != ZSetRankOf(db, key, meta, pos, rank))
+		{
+			return ERR_NOT_EXIST;
+		}
+		return rank;
 	}
 
 	int Ardb::ZRevRank(const DBID& db, const Slice& key, const Slice& member)
@@ -452,34 +1068,12 @@ namespace ardb
 		{
 			return ERR_NOT_EXIST;
 		}
-		Slice empty;
-		ZSetKeyObject start(key, empty, meta.max_score + 1, db);
-		struct ZRevRankWalk: public WalkHandler
+		int rank = ZRank(db, key, member);
+		if (rank < 0)
 		{
-				int rank;
-				ValueObject z_member;
-				int foundRank;
-				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
-				{
-					if (rank < 0)
-						rank = 0;
-					ZSetKeyObject* zko = (ZSetKeyObject*) k;
-					if (zko->value.Compare(z_member) == 0)
-					{
-						foundRank = rank;
-						return -1;
-					}
-					rank++;
-					return 0;
-				}
-				ZRevRankWalk(const Slice& m) :
-						rank(0), foundRank(-1)
-				{
-					smart_fill_value(m, z_member);
-				}
-		} walk(member);
-		Walk(start, true, &walk);
-		return walk.foundRank;
+			return rank;
+		}
+		return meta.size - 1 - rank;
 	}
 
 	int Ardb::ZRemRangeByRank(const DBID& db, const Slice& key, int start,
@@ -503,8 +1097,16 @@ namespace ardb
 		{
 			return ERR_INVALID_ARGS;
 		}
-		Slice empty;
-		ZSetKeyObject tmp(key, empty, meta.min_score, db);
+		std::string first;
+		if (0 != ZSetElementAt(db, key, meta, start, first))
+		{
+			return ERR_NOT_EXIST;
+		}
+		KeyObject* tmp = decode_key(first, NULL);
+		if (NULL == tmp)
+		{
+			return ERR_INVALID_TYPE;
+		}
 		BatchWriteGuard guard(GetEngine());
 		struct ZRemRangeByRankWalk: public WalkHandler
 		{
@@ -523,6 +1125,9 @@ namespace ardb
 						z_db->DelValue(zk);
 						z_db->DelValue(*zsk);
 						z_meta.size--;
+						std::string pos;
+						zset_element_pos(*zsk, pos);
+						z_db->ZSetRankRemove(zsk->db, zsk->key, z_meta, pos);
 						z_count++;
 					}
 					rank++;
@@ -534,12 +1139,13 @@ namespace ardb
 				}
 				ZRemRangeByRankWalk(Ardb* db, int start, int stop,
 						ZSetMetaValue& meta) :
-						rank(0), z_db(db), z_start(start), z_stop(stop), z_meta(
+						rank(start), z_db(db), z_start(start), z_stop(stop), z_meta(
 								meta), z_count(0)
 				{
 				}
 		} walk(this, start, stop, meta);
-		Walk(tmp, false, &walk);
+		Walk(*tmp, false, &walk);
+		DELETE(tmp);
 		SetZSetMetaValue(db, key, meta);
 		return walk.z_count;
 	}
@@ -594,6 +1200,9 @@ namespace ardb
 						z_db->DelValue(zk);
 						z_db->DelValue(*zsk);
 						z_meta.size--;
+						std::string pos;
+						zset_element_pos(*zsk, pos);
+						z_db->ZSetRankRemove(zsk->db, zsk->key, z_meta, pos);
 						z_count++;
 					}
 					if (zsk->score == z_max_score)
@@ -636,9 +1245,16 @@ namespace ardb
 		{
 			return ERR_INVALID_ARGS;
 		}
-		Slice empty;
-		ZSetKeyObject tmp(key, empty, meta.min_score, db);
-
+		std::string first;
+		if (0 != ZSetElementAt(db, key, meta, start, first))
+		{
+			return ERR_NOT_EXIST;
+		}
+		KeyObject* tmp = decode_key(first, NULL);
+		if (NULL == tmp)
+		{
+			return ERR_INVALID_TYPE;
+		}
 		struct ZRangeWalk: public WalkHandler
 		{
 				int rank;
@@ -669,12 +1285,13 @@ namespace ardb
 				}
 				ZRangeWalk(int start, int stop, ValueArray& v,
 						QueryOptions& options) :
-						rank(0), z_start(start), z_stop(stop), z_values(v), z_options(
+						rank(start), z_start(start), z_stop(stop), z_values(v), z_options(
 								options), z_count(0)
 				{
 				}
 		} walk(start, stop, values, options);
-		Walk(tmp, false, &walk);
+		Walk(*tmp, false, &walk);
+		DELETE(tmp);
 		return walk.z_count;
 	}
 
@@ -789,8 +1406,16 @@ namespace ardb
 		{
 			return ERR_INVALID_ARGS;
 		}
-		Slice empty;
-		ZSetKeyObject tmp(key, empty, meta.max_score, db);
+		std::string first;
+		if (0 != ZSetElementAt(db, key, meta, meta.size - 1 - start, first))
+		{
+			return ERR_NOT_EXIST;
+		}
+		KeyObject* tmp = decode_key(first, NULL);
+		if (NULL == tmp)
+		{
+			return ERR_INVALID_TYPE;
+		}
 		struct ZRevRangeWalk: public WalkHandler
 		{
 				int rank;
@@ -801,7 +1426,7 @@ namespace ardb
 				QueryOptions& z_options;
 				ZRevRangeWalk(int start, int stop, ValueArray& values,
 						QueryOptions& options) :
-						rank(0), count(0), z_start(start), z_stop(stop), z_values(
+						rank(start), count(0), z_start(start), z_stop(stop), z_values(
 								values), z_options(options)
 				{
 				}
@@ -825,7 +1450,8 @@ namespace ardb
 					return 0;
 				}
 		} walk(start, stop, values, options);
-		Walk(tmp, true, &walk);
+		Walk(*tmp, true, &walk);
+		DELETE(tmp);
 		return walk.count;
 	}
 
@@ -930,6 +1556,7 @@ namespace ardb
 		}
 
 		ValueScoreMap vm;
+		SnapshotGuard snapshot(GetEngine());
 		struct ZUnionWalk: public WalkHandler
 		{
 				uint32_t z_weight;
@@ -989,6 +1616,7 @@ namespace ardb
 			idx++;
 			kit++;
 		}
+		snapshot.Release();
 		if (vm.size() > 0)
 		{
 			double min_score = 0, max_score = 0;
@@ -1022,6 +1650,7 @@ namespace ardb
 			}
 			meta.min_score = min_score;
 			meta.max_score = max_score;
+			ZSetRankBuild(db, dst, meta);
 			SetZSetMetaValue(db, dst, meta);
 		}
 		return vm.size();
@@ -1036,6 +1665,7 @@ namespace ardb
 		}
 		uint32_t min_size = 0;
 		ZSetMetaValueArray metas;
+		SnapshotGuard snapshot(GetEngine());
 		uint32_t min_idx = 0;
 		uint32_t idx = 0;
 		SliceArray::iterator kit = keys.begin();
@@ -1135,6 +1765,7 @@ namespace ardb
 				result = old;
 			}
 		}
+		snapshot.Release();
 
 		if (cmp->size() > 0)
 		{
@@ -1169,9 +1800,40 @@ namespace ardb
 			}
 			meta.min_score = min_score;
 			meta.max_score = max_score;
+			ZSetRankBuild(db, dst, meta);
 			SetZSetMetaValue(db, dst, meta);
 		}
 		return cmp->size();
 	}
+
+	int Ardb::ZScan(const DBID& db, const Slice& key,
+	        const std::string& cursor, const std::string& pattern,
+	        uint32 limit, ValueArray& vs, std::string& newcursor)
+	{
+		Slice empty;
+		ZSetScoreKeyObject zk(key, empty, db);
+		struct ZScanWalk: public WalkHandler
+		{
+				const std::string& z_pattern;
+				ValueArray& z_vs;
+				int OnKeyValue(KeyObject* k, ValueObject* v, uint32 cursor)
+				{
+					ZSetScoreKeyObject* zsk = (ZSetScoreKeyObject*) k;
+					std::string member;
+					zsk->value.ToString(member);
+					if (fnmatch(z_pattern.c_str(), member.c_str(), 0) == 0)
+					{
+						z_vs.push_back(zsk->value);
+						z_vs.push_back(*v);
+					}
+					return 0;
+				}
+				ZScanWalk(const std::string& p, ValueArray& vals) :
+						z_pattern(p), z_vs(vals)
+				{
+				}
+		} walk(pattern, vs);
+		return ScanElements(zk, cursor, limit, &walk, newcursor);
+	}
 }
 
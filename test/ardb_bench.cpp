@@ -0,0 +1,112 @@
+/*
+ * ardb_bench.cpp
+ *
+ *  Micro benchmarks of ardb internals, run with an optional bench name.
+ */
+
+#include "test_common.hpp"
+#ifdef __USE_KYOTOCABINET__
+#include "engine/kyotocabinet_engine.hpp"
+typedef ardb::KCDBEngineFactory SelectedDBEngineFactory;
+#define _DB_PATH "KyotoCabinet"
+#elif defined __USE_LMDB__
+#include "engine/lmdb_engine.hpp"
+#define _DB_PATH "LMDB"
+typedef ardb::LMDBEngineFactory SelectedDBEngineFactory;
+#else
+#include "engine/leveldb_engine.hpp"
+typedef ardb::LevelDBEngineFactory SelectedDBEngineFactory;
+#define _DB_PATH "LevelDB"
+#endif
+#include "util/thread/thread.hpp"
+#include <string>
+#include <iostream>
+using namespace std;
+
+using namespace ardb;
+
+static void print_bench_result(const char* name, uint32 workers, uint64 ops,
+        uint64 micros)
+{
+	double qps = micros > 0 ? (double) ops * 1000000 / micros : 0;
+	printf("%-24s workers:%-3u ops:%-10"PRIu64" cost:%-8"PRIu64"ms qps:%.0f\n",
+	        name, workers, ops, micros / 1000, qps);
+}
+
+#include "keylock_bench.cpp"
+#include "zset_rank_bench.cpp"
+#include "redis_decoder_bench.cpp"
+#include "redis_reply_bench.cpp"
+#include "group_commit_bench.cpp"
+#include "oplog_bench.cpp"
+#include "mget_bench.cpp"
+#include "bitset_bench.cpp"
+#include "bit_kernels_bench.cpp"
+
+int main(int argc, char** argv)
+{
+	Properties cfg;
+	cfg["data-dir"] = "/tmp/ardb_bench/";
+	cfg["data-dir"].append(_DB_PATH);
+	SelectedDBEngineFactory engine(cfg);
+	std::cout << "ARDB Bench(" << engine.GetName() << ")" << std::endl;
+	Ardb db(&engine);
+	db.Init();
+	std::string name = argc > 1 ? argv[1] : "all";
+	if (name == "all" || name == "keylock")
+	{
+		bench_keylock(db);
+	}
+	if (name == "all" || name == "zrank")
+	{
+		uint32 maxsize = 10000000;
+		if (argc > 2)
+		{
+			string_touint32(argv[2], maxsize);
+		}
+		bench_zset_rank(db, maxsize);
+	}
+	if (name == "all" || name == "decoder")
+	{
+		bench_redis_decoder();
+	}
+	if (name == "all" || name == "reply")
+	{
+		bench_redis_reply();
+	}
+	if (name == "all" || name == "group")
+	{
+		bench_group_commit(db);
+	}
+	if (name == "mget")
+	{
+		bench_mget(db);
+	}
+	if (name == "bitset")
+	{
+		bench_bitset(db);
+	}
+	if (name == "kernels")
+	{
+		bench_bit_kernels();
+	}
+	if (name == "oplog")
+	{
+		uint32 total = 10000000;
+		if (argc > 2)
+		{
+			string_touint32(argv[2], total);
+		}
+		bench_oplog(db, total);
+	}
+	if (name == "pipeline")
+	{
+		uint32 port = 16379;
+		if (argc > 2)
+		{
+			string_touint32(argv[2], port);
+		}
+		bench_pipeline("127.0.0.1", port);
+	}
+	return 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * bit_kernels_bench.cpp
+ *
+ *  Popcount and AND/XOR kernels of every supported instruction set over
+ *  the 512 byte bitmap of one bitset chunk.
+ */
+#include "test_common.hpp"
+#include "util/bit_kernels.hpp"
+
+void bench_bit_kernels()
+{
+	const uint32 loops = 2000000;
+	std::vector<const BitKernels*> kernels;
+	supported_bit_kernels(kernels);
+	uint64 a[BIT_SUBSET_WORDS], b[BIT_SUBSET_WORDS];
+	srand(1);
+	for (uint32 i = 0; i < BIT_SUBSET_WORDS; i++)
+	{
+		a[i] = ((uint64) rand() << 40) ^ ((uint64) rand() << 20) ^ rand();
+		b[i] = ((uint64) rand() << 40) ^ ((uint64) rand() << 20) ^ rand();
+	}
+	printf("selected bit kernels:%s\n", bit_kernels().name);
+	for (uint32 k = 0; k < kernels.size(); k++)
+	{
+		const BitKernels& kernel = *kernels[k];
+		char name[64];
+		volatile uint64 sink = 0;
+		uint64 start = get_current_epoch_micros();
+		for (uint32 i = 0; i < loops; i++)
+		{
+			a[i & (BIT_SUBSET_WORDS - 1)] += i;
+			sink += kernel.popcount(a, BIT_SUBSET_WORDS);
+		}
+		uint64 end = get_current_epoch_micros();
+		sprintf(name, "%s popcount", kernel.name);
+		print_bench_result(name, 1, loops, end - start);
+
+		start = get_current_epoch_micros();
+		for (uint32 i = 0; i < loops; i++)
+		{
+			kernel.op(BIT_KERNEL_XOR, a, b, BIT_SUBSET_WORDS);
+		}
+		end = get_current_epoch_micros();
+		sink += a[0];
+		sprintf(name, "%s xor", kernel.name);
+		print_bench_result(name, 1, loops, end - start);
+
+		start = get_current_epoch_micros();
+		for (uint32 i = 0; i < loops; i++)
+		{
+			a[i & (BIT_SUBSET_WORDS - 1)] += i;
+			sink += kernel.op_popcount(BIT_KERNEL_AND, a, b, BIT_SUBSET_WORDS);
+		}
+		end = get_current_epoch_micros();
+		sprintf(name, "%s and+popcount", kernel.name);
+		print_bench_result(name, 1, loops, end - start);
+
+		start = get_current_epoch_micros();
+		for (uint32 i = 0; i < loops; i++)
+		{
+			a[i & (BIT_SUBSET_WORDS - 1)] += i;
+			sink += kernel.count_runs(a, BIT_SUBSET_WORDS);
+		}
+		end = get_current_epoch_micros();
+		sprintf(name, "%s runs", kernel.name);
+		print_bench_result(name, 1, loops, end - start);
+	}
+}
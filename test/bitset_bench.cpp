@@ -0,0 +1,90 @@
+/*
+ * bitset_bench.cpp
+ *
+ *  SETBIT, stored bytes and BITOP/BITCOUNT over two sparse bitsets with
+ *  random bits spread over 100M offsets, like daily user activity maps.
+ */
+#include "test_common.hpp"
+
+static uint64 bitset_bench_bytes(Ardb& db, const DBID& dbid, const char* key)
+{
+	BitSetKeyObject start(key, 1, dbid);
+	Buffer keybuf;
+	encode_key(keybuf, start);
+	Iterator* iter = db.GetEngine()->Find(
+	        Slice(keybuf.GetRawReadBuffer(), keybuf.ReadableBytes()), false);
+	uint64 bytes = 0;
+	while (NULL != iter && iter->Valid())
+	{
+		KeyObject* k = decode_key(iter->Key(), &start);
+		bool match = NULL != k && k->type == BITSET_ELEMENT
+		        && k->key.compare(start.key) == 0;
+		DELETE(k);
+		if (!match)
+		{
+			break;
+		}
+		bytes += iter->Key().size() + iter->Value().size();
+		iter->Next();
+	}
+	DELETE(iter);
+	return bytes;
+}
+
+void bench_bitset(Ardb& db)
+{
+	DBID dbid = 0;
+	const uint64 range = 100000000;
+	uint32 sizes[] = { 100000, 1000000 };
+	for (uint32 s = 0; s < arraysize(sizes); s++)
+	{
+		const char* keys[] = { "bench_bits1", "bench_bits2" };
+		srand(s + 1);
+		uint64 start = get_current_epoch_micros();
+		for (uint32 k = 0; k < 2; k++)
+		{
+			db.Del(dbid, keys[k]);
+			for (uint32 i = 0; i < sizes[s]; i++)
+			{
+				uint64 offset = ((uint64) rand() * RAND_MAX + rand()) % range;
+				db.SetBit(dbid, keys[k], offset, 1);
+			}
+		}
+		uint64 end = get_current_epoch_micros();
+		char name[64];
+		sprintf(name, "setbit(%u)", sizes[s]);
+		print_bench_result(name, 1, sizes[s] * 2, end - start);
+		uint64 bytes = bitset_bench_bytes(db, dbid, keys[0]);
+		printf("%-24s stored:%.2fMB bytes/bit:%.1f\n", name,
+		        (double) bytes / (1024 * 1024), (double) bytes / sizes[s]);
+
+		SliceArray srcs;
+		srcs.push_back(keys[0]);
+		srcs.push_back(keys[1]);
+		const char* ops[] = { "and", "or", "xor" };
+		for (uint32 o = 0; o < arraysize(ops); o++)
+		{
+			start = get_current_epoch_micros();
+			db.BitOP(dbid, ops[o], "bench_bits_dst", srcs);
+			end = get_current_epoch_micros();
+			sprintf(name, "bitop %s(%u)", ops[o], sizes[s]);
+			print_bench_result(name, 1, 1, end - start);
+			start = get_current_epoch_micros();
+			db.BitOPCount(dbid, ops[o], srcs);
+			end = get_current_epoch_micros();
+			sprintf(name, "bitopcount %s(%u)", ops[o], sizes[s]);
+			print_bench_result(name, 1, 1, end - start);
+		}
+		start = get_current_epoch_micros();
+		for (uint32 i = 0; i < 100; i++)
+		{
+			db.BitCount(dbid, keys[0], i * 1000, range - i * 1000);
+		}
+		end = get_current_epoch_micros();
+		sprintf(name, "bitcount range(%u)", sizes[s]);
+		print_bench_result(name, 1, 100, end - start);
+		db.Del(dbid, "bench_bits_dst");
+		db.Del(dbid, keys[0]);
+		db.Del(dbid, keys[1]);
+	}
+}
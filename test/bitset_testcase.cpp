@@ -5,6 +5,7 @@
  *      Author: yinqiwen
  */
 #include "ardb.hpp"
+#include "util/bit_kernels.hpp"
 #include <string>
 
 using namespace ardb;
@@ -63,10 +64,171 @@ void test_bitop(Ardb& db)
 	CHECK_FATAL( ret != 4000, "bitopcount xor keys failed:%d", ret);
 }
 
+void test_bitset_containers(Ardb& db)
+{
+	DBID dbid = 0;
+	db.Del(dbid, "mybits");
+	/*
+	 * A chunk goes from the offsets, to a bitmap and to runs.
+	 */
+	for (uint32 i = 0; i < 4096; i += 3)
+	{
+		db.SetBit(dbid, "mybits", 4096 * 5 + i, 1);
+	}
+	uint32 wrong = 0;
+	for (uint32 i = 0; i < 4096; i++)
+	{
+		if (db.GetBit(dbid, "mybits", 4096 * 5 + i) != (i % 3 == 0 ? 1 : 0))
+		{
+			wrong++;
+		}
+	}
+	CHECK_FATAL(wrong != 0, "getbit failed for %u bits", wrong);
+	int count = db.BitCount(dbid, "mybits", 0, -1);
+	CHECK_FATAL(count != 1366, "bitcount mybits failed:%d", count);
+	for (uint32 i = 0; i < 4096; i++)
+	{
+		db.SetBit(dbid, "mybits", 4096 * 5 + i, i >= 100 && i < 3000);
+	}
+	count = db.BitCount(dbid, "mybits", 4096 * 5 + 50, 4096 * 5 + 199);
+	CHECK_FATAL(count != 100, "bitcount mybits failed:%d", count);
+	CHECK_FATAL(db.GetBit(dbid, "mybits", 4096 * 5 + 3000) != 0,
+	        "getbit failed");
+	db.SetBit(dbid, "mybits", 4096 * 5 + 3000, 1);
+	count = db.BitCount(dbid, "mybits", 0, -1);
+	CHECK_FATAL(count != 2901, "bitcount mybits failed:%d", count);
+	db.SetBit(dbid, "mybits", 10, 1);
+	db.SetBit(dbid, "mybits", 4096 * 30, 1);
+	count = db.BitCount(dbid, "mybits", 4096 * 5 + 50, 4096 * 28);
+	CHECK_FATAL(count != 2901, "bitcount mybits failed:%d", count);
+	count = db.BitCount(dbid, "mybits", 5, 4096 * 5 + 150);
+	CHECK_FATAL(count != 52, "bitcount mybits failed:%d", count);
+}
+
+void test_bitop_sparse(Ardb& db)
+{
+	DBID dbid = 0;
+	db.Del(dbid, "mybits1");
+	db.Del(dbid, "mybits2");
+	db.Del(dbid, "mybits3");
+	for (uint64 i = 0; i < 100; i++)
+	{
+		db.SetBit(dbid, "mybits1", i * 100003, 1);
+		db.SetBit(dbid, "mybits2", i * 200006, 1);
+	}
+	SliceArray keys;
+	keys.push_back("mybits1");
+	keys.push_back("mybits2");
+	int ret = db.BitOP(dbid, "and", "mybits3", keys);
+	CHECK_FATAL(ret != 50, "bitop and failed:%d", ret);
+	CHECK_FATAL(db.GetBit(dbid, "mybits3", 200006) != 1, "bitop and failed");
+	/*
+	 * The destination is also a source.
+	 */
+	keys.push_back("mybits3");
+	ret = db.BitOP(dbid, "xor", "mybits3", keys);
+	CHECK_FATAL(ret != 150, "bitop xor failed:%d", ret);
+	CHECK_FATAL(db.GetBit(dbid, "mybits3", 200006) != 1, "bitop xor failed");
+	CHECK_FATAL(db.GetBit(dbid, "mybits3", 100003) != 1, "bitop xor failed");
+	keys.clear();
+	keys.push_back("mybits1");
+	ret = db.BitOP(dbid, "not", "mybits3", keys);
+	uint64 len = (99 * 100003 / 8 + 1) * 8;
+	CHECK_FATAL(ret != (int)(len - 100), "bitop not failed:%d", ret);
+	CHECK_FATAL(db.GetBit(dbid, "mybits3", 5) != 1, "bitop not failed");
+	CHECK_FATAL(db.GetBit(dbid, "mybits3", 100003) != 0, "bitop not failed");
+	CHECK_FATAL(db.GetBit(dbid, "mybits3", len) != 0, "bitop not failed");
+	int64 count = db.BitOPCount(dbid, "not", keys);
+	CHECK_FATAL(count != (int64)(len - 100), "bitopcount not failed:%"PRId64, count);
+	keys.push_back("mybits2");
+	count = db.BitOPCount(dbid, "and", keys);
+	CHECK_FATAL(count != 50, "bitopcount and failed:%"PRId64, count);
+	count = db.BitOPCount(dbid, "or", keys);
+	CHECK_FATAL(count != 150, "bitopcount or failed:%"PRId64, count);
+}
+
+void test_bitop_invalid(Ardb& db)
+{
+	DBID dbid = 0;
+	db.Del(dbid, "mybits3");
+	db.Del(dbid, "bitopkey1");
+	db.Del(dbid, "bitopkey2");
+	SliceArray keys;
+	keys.push_back("mybits1");
+	keys.push_back("mybits2");
+	int ret = db.BitOP(dbid, "nand", "mybits3", keys);
+	CHECK_FATAL(ret != -1, "bitop with unknown op:%d", ret);
+	ret = db.BitOP(dbid, "not", "mybits3", keys);
+	CHECK_FATAL(ret != -1, "bitop not with two keys:%d", ret);
+	CHECK_FATAL(db.Exists(dbid, "mybits3"), "invalid bitop wrote dest.");
+
+	/*
+	 * A rejected BITOP in a pipelined group leaves the other writes alone.
+	 */
+	if (db.BeginGroupCommit())
+	{
+		db.Set(dbid, "bitopkey1", "v");
+		db.BitOP(dbid, "not", "mybits3", keys);
+		db.Set(dbid, "bitopkey2", "v");
+		ret = db.EndGroupCommit();
+		CHECK_FATAL(ret != 0, "group with invalid bitop failed:%d", ret);
+		CHECK_FATAL(!db.Exists(dbid, "bitopkey1"), "group lost bitopkey1.");
+		CHECK_FATAL(!db.Exists(dbid, "bitopkey2"), "group lost bitopkey2.");
+	}
+	db.Del(dbid, "bitopkey1");
+	db.Del(dbid, "bitopkey2");
+}
+
+void test_bit_kernels()
+{
+	std::vector<const BitKernels*> kernels;
+	supported_bit_kernels(kernels);
+	uint64 a[67], b[67], x[67], y[67];
+	srand(67);
+	for (uint32 i = 0; i < arraysize(a); i++)
+	{
+		a[i] = ((uint64) rand() << 40) ^ ((uint64) rand() << 20) ^ rand();
+		b[i] = i % 5 == 0 ? ~((uint64) 0) : a[i] << (i % 7);
+	}
+	const BitKernels& base = *kernels[0];
+	uint32 mismatch = 0;
+	for (uint32 k = 1; k < kernels.size(); k++)
+	{
+		const BitKernels& kernel = *kernels[k];
+		/*
+		 * Lengths which are not a multiple of the vector width too.
+		 */
+		for (size_t n = 61; n <= arraysize(a); n++)
+		{
+			mismatch += kernel.popcount(a, n) != base.popcount(a, n);
+			mismatch += kernel.count_runs(b, n) != base.count_runs(b, n);
+			for (uint32 op = BIT_KERNEL_AND; op <= BIT_KERNEL_XOR; op++)
+			{
+				mismatch += kernel.op_popcount(op, a, b, n)
+				        != base.op_popcount(op, a, b, n);
+				memcpy(x, a, sizeof(a));
+				memcpy(y, a, sizeof(a));
+				kernel.op(op, x, b, n);
+				base.op(op, y, b, n);
+				mismatch += memcmp(x, y, sizeof(x)) != 0;
+			}
+			kernel.negate(x, n);
+			base.negate(y, n);
+			mismatch += memcmp(x, y, sizeof(x)) != 0;
+		}
+	}
+	CHECK_FATAL(mismatch != 0, "bit kernels %s mismatch:%u",
+	        bit_kernels().name, mismatch);
+}
+
 void test_bitsets(Ardb& db)
 {
 	test_bitcount(db);
 	test_setgetbit(db);
 	test_bitop(db);
+	test_bitset_containers(db);
+	test_bitop_sparse(db);
+	test_bitop_invalid(db);
+	test_bit_kernels();
 }
 
@@ -0,0 +1,78 @@
+/*
+ * channel_testcase.cpp
+ *
+ *  Corked channel writes: replies held back for a group commit go out or
+ *  are dropped with the commit, also when the connection closes meanwhile.
+ */
+#include "channel/all_includes.hpp"
+#include "util/file_helper.hpp"
+#include <string>
+
+using namespace ardb;
+
+static std::string read_pipe(int fd)
+{
+	std::string str;
+	char buf[256];
+	int len;
+	while ((len = read(fd, buf, sizeof(buf))) > 0)
+	{
+		str.append(buf, len);
+	}
+	return str;
+}
+
+static void write_channel_string(Channel* ch, const char* str)
+{
+	Buffer buf;
+	buf.Write(str, strlen(str));
+	ch->Write(buf);
+}
+
+/*
+ * A pipelined SET and QUIT, the QUIT closes the channel before the group
+ * commits.
+ */
+static void corked_set_quit(ChannelService& service, bool commit,
+        std::string& out)
+{
+	int fds[2];
+	CHECK_FATAL(0 != pipe(fds), "pipe failed.");
+	Channel* ch = service.NewPipeChannel(-1, fds[1]);
+	ch->Cork();
+	write_channel_string(ch, "+OK\r\n");
+	ch->Close();
+	write_channel_string(ch, "+LATE\r\n");
+	if (commit)
+	{
+		ch->Uncork();
+	}
+	else
+	{
+		ch->Close();
+		ch->Uncork(true);
+	}
+	for (int i = 0; i < 10; i++)
+	{
+		aeProcessEvents(service.GetRawEventLoop(),
+		        AE_FILE_EVENTS | AE_DONT_WAIT);
+	}
+	make_fd_nonblocking(fds[0]);
+	out = read_pipe(fds[0]);
+	close(fds[0]);
+}
+
+void test_channel_close_corked()
+{
+	ChannelService service;
+	std::string out;
+	corked_set_quit(service, true, out);
+	CHECK_FATAL(out != "+OK\r\n", "committed corked replies:%s", out.c_str());
+	corked_set_quit(service, false, out);
+	CHECK_FATAL(!out.empty(), "failed commit acknowledged:%s", out.c_str());
+}
+
+void test_channels()
+{
+	test_channel_close_corked();
+}
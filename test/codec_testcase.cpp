@@ -0,0 +1,230 @@
+/*
+ * codec_testcase.cpp
+ *
+ *  Redis request decoding in any read size, inline and malformed requests,
+ *  reply encoding, binary safe bulks, extreme integers and the pieces a
+ *  big bulk is written from.
+ */
+#include "ardb.hpp"
+#include "channel/codec/redis_reply_codec.hpp"
+#include "channel/codec/redis_command_codec.hpp"
+#include <string>
+
+using namespace ardb;
+using namespace ardb::codec;
+
+static std::string encode_reply_string(RedisReply& reply)
+{
+	Buffer buf;
+	RedisReplyEncoder::Encode(buf, reply);
+	return std::string(buf.GetRawReadBuffer(), buf.ReadableBytes());
+}
+
+void test_reply_encode_binary()
+{
+	RedisReply reply;
+	reply.type = REDIS_REPLY_STRING;
+	reply.str.assign("a\0b", 3);
+	std::string expected("$3\r\na\0b\r\n", 9);
+	CHECK_FATAL(encode_reply_string(reply) != expected,
+	        "bulk with embedded NUL encode failed.");
+
+	reply.Clear();
+	reply.type = REDIS_REPLY_STATUS;
+	reply.str.assign("o\0k", 3);
+	expected.assign("+o\0k\r\n", 6);
+	CHECK_FATAL(encode_reply_string(reply) != expected,
+	        "status with embedded NUL encode failed.");
+
+	reply.Clear();
+	reply.AddFlatString("x\0y", 3);
+	reply.AddFlatNil();
+	expected.assign("*2\r\n$3\r\nx\0y\r\n$-1\r\n", 18);
+	CHECK_FATAL(encode_reply_string(reply) != expected,
+	        "flat array with embedded NUL encode failed.");
+}
+
+void test_reply_encode_int64_min()
+{
+	RedisReply reply;
+	reply.type = REDIS_REPLY_INTEGER;
+	reply.integer = INT64_MIN;
+	CHECK_FATAL(encode_reply_string(reply) != ":-9223372036854775808\r\n",
+	        "INT64_MIN integer encode failed:%s",
+	        encode_reply_string(reply).c_str());
+
+	reply.Clear();
+	reply.AddFlatInteger(INT64_MIN);
+	reply.AddFlatInteger(INT64_MAX);
+	CHECK_FATAL(
+	        encode_reply_string(reply)
+	                != "*2\r\n:-9223372036854775808\r\n:9223372036854775807\r\n",
+	        "flat INT64_MIN integer encode failed.");
+
+	/*
+	 * An integer value read back as a bulk string.
+	 */
+	ValueObject v;
+	v.type = INTEGER;
+	v.v.int_v = INT64_MIN;
+	reply.Clear();
+	reply.type = REDIS_REPLY_STRING;
+	v.ToString(reply.str);
+	CHECK_FATAL(
+	        encode_reply_string(reply) != "$20\r\n-9223372036854775808\r\n",
+	        "INT64_MIN bulk encode failed:%s",
+	        encode_reply_string(reply).c_str());
+}
+
+void test_reply_encode_pieces()
+{
+	RedisReply reply;
+	std::string big(5000, 'b');
+	big[100] = 0;
+	reply.AddFlatString("small", 5);
+	reply.AddFlatString(big.data(), big.size());
+	reply.AddFlatInteger(-1);
+	std::string expected = encode_reply_string(reply);
+
+	/*
+	 * The big bulk is referenced from the reply, the pieces joined in
+	 * order give the same bytes as the copying encoder.
+	 */
+	Buffer buf;
+	RedisReplyPieceArray pieces;
+	RedisReplyEncoder::Encode(buf, reply, &pieces);
+	CHECK_FATAL(pieces.size() != 3, "unexpected pieces:%zu", pieces.size());
+	CHECK_FATAL(pieces[1].data != reply.arena.data() + 5,
+	        "big bulk was copied.");
+	std::string joined;
+	for (size_t i = 0; i < pieces.size(); i++)
+	{
+		const char* data =
+		        NULL != pieces[i].data ?
+		                pieces[i].data : buf.GetRawBuffer() + pieces[i].offset;
+		joined.append(data, pieces[i].len);
+	}
+	CHECK_FATAL(joined != expected, "pieces encode mismatch.");
+}
+
+/*
+ * Feed 'input' to 'decoder' 'step' bytes at a time, returns the result of
+ * the first call which did not ask for more data, 0 if none.
+ */
+static int decode_request_in_steps(RedisCommandDecoder& decoder,
+        const std::string& input, size_t step, RedisCommandFrame& frame)
+{
+	Buffer buf;
+	for (size_t i = 0; i < input.size(); i += step)
+	{
+		size_t len = input.size() - i < step ? input.size() - i : step;
+		buf.Write(input.data() + i, len);
+		int ret = decoder.DecodeRequest(buf, frame);
+		if (ret != 0)
+		{
+			return ret;
+		}
+	}
+	return 0;
+}
+
+void test_request_decode_bytewise()
+{
+	std::string input("*3\r\n$3\r\nSET\r\n$3\r\nk\0y\r\n$6\r\nva\r\n\r\n\r\n", 34);
+	RedisCommandDecoder decoder;
+	RedisCommandFrame frame;
+	int ret = decode_request_in_steps(decoder, input, 1, frame);
+	CHECK_FATAL(ret != 1, "bytewise decode failed:%d", ret);
+	CHECK_FATAL(frame.IsInLine() || frame.GetCommand() != "SET"
+	        || frame.GetArguments().size() != 2,
+	        "bytewise decode command failed:%s", frame.GetCommand().c_str());
+	CHECK_FATAL(*frame.GetArgument(0) != std::string("k\0y", 3),
+	        "bytewise decode key failed.");
+	CHECK_FATAL(*frame.GetArgument(1) != "va\r\n\r\n",
+	        "bytewise decode value failed.");
+
+	/*
+	 * Pipelined requests come out one by one from the same buffer.
+	 */
+	Buffer buf;
+	buf.Write("*1\r\n$4\r\nPING\r\n*2\r\n$3\r\nGET\r\n$1\r\nk\r\n", 34);
+	RedisCommandFrame first, second;
+	CHECK_FATAL(decoder.DecodeRequest(buf, first) != 1
+	        || decoder.DecodeRequest(buf, second) != 1,
+	        "pipelined decode failed.");
+	CHECK_FATAL(first.GetCommand() != "PING" || !first.GetArguments().empty()
+	        || second.GetCommand() != "GET" || *second.GetArgument(0) != "k",
+	        "pipelined decode arguments failed.");
+	CHECK_FATAL(buf.Readable(), "pipelined decode left bytes.");
+}
+
+void test_request_decode_inline()
+{
+	RedisCommandDecoder decoder;
+	Buffer buf;
+	buf.Write("set  a   b", 10);
+	RedisCommandFrame frame;
+	CHECK_FATAL(decoder.DecodeRequest(buf, frame) != 0,
+	        "incomplete inline decoded.");
+	buf.Write("\r\nPING\r\n", 8);
+	CHECK_FATAL(decoder.DecodeRequest(buf, frame) != 1, "inline decode failed.");
+	CHECK_FATAL(!frame.IsInLine() || frame.GetCommand() != "set"
+	        || frame.GetArguments().size() != 2 || *frame.GetArgument(0) != "a"
+	        || *frame.GetArgument(1) != "b",
+	        "inline decode arguments failed:%s", frame.GetCommand().c_str());
+	RedisCommandFrame ping;
+	CHECK_FATAL(decoder.DecodeRequest(buf, ping) != 1
+	        || ping.GetCommand() != "PING" || !ping.GetArguments().empty(),
+	        "second inline decode failed.");
+}
+
+void test_request_decode_empty()
+{
+	RedisCommandDecoder decoder;
+	Buffer buf;
+	buf.Write("*0\r\n", 4);
+	RedisCommandFrame frame;
+	CHECK_FATAL(decoder.DecodeRequest(buf, frame) != 0 || buf.Readable(),
+	        "empty multibulk not skipped.");
+	buf.Write("*0\r\n*1\r\n$4\r\nPING\r\n", 18);
+	CHECK_FATAL(decoder.DecodeRequest(buf, frame) != 1
+	        || frame.GetCommand() != "PING",
+	        "request after empty multibulk failed.");
+}
+
+static void check_request_error(const std::string& input,
+        const std::string& error)
+{
+	RedisCommandDecoder decoder;
+	RedisCommandFrame frame;
+	int ret = decode_request_in_steps(decoder, input, input.size(), frame);
+	CHECK_FATAL(ret != -1, "bad request decoded:%d", ret);
+	CHECK_FATAL(decoder.GetError() != error, "unexpected error:%s",
+	        decoder.GetError().c_str());
+}
+
+void test_request_decode_errors()
+{
+	check_request_error("*1\r\n$x\r\nPING\r\n",
+	        "Protocol error: invalid bulk length");
+	check_request_error("*1\r\n$-4\r\nPING\r\n",
+	        "Protocol error: invalid bulk length");
+	check_request_error("*1\r\n$536870913\r\n",
+	        "Protocol error: invalid bulk length");
+	check_request_error("*2000000\r\n",
+	        "Protocol error: invalid multibulk length");
+	check_request_error("*x\r\n", "Protocol error: invalid multibulk length");
+	check_request_error("*1\r\nPING\r\n", "Protocol error: expected '$', got 'P'");
+	check_request_error("*1\r\n$4\r\nPINGxx", "CRLF expected after argument.");
+}
+
+void test_codecs()
+{
+	test_request_decode_bytewise();
+	test_request_decode_inline();
+	test_request_decode_empty();
+	test_request_decode_errors();
+	test_reply_encode_binary();
+	test_reply_encode_int64_min();
+	test_reply_encode_pieces();
+}
@@ -0,0 +1,217 @@
+/*
+ * group_commit_bench.cpp
+ *
+ *  SET/LPUSH throughput when the commands of a pipeline of 1, 16 and 100
+ *  commands are committed as one group, like the server does with
+ *  'group-commit yes'.
+ */
+#include "test_common.hpp"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+struct GroupCommitBenchWorker: public Thread
+{
+		Ardb& db;
+		uint32 round;
+		uint32 id;
+		uint32 ops;
+		uint32 pipeline;
+		bool lpush;
+		GroupCommitBenchWorker(Ardb& d, uint32 r, uint32 i, uint32 n,
+		        uint32 p, bool l) :
+				db(d), round(r), id(i), ops(n), pipeline(p), lpush(l)
+		{
+		}
+		void Run()
+		{
+			DBID dbid = 0;
+			char key[64], value[64];
+			bool grouping = false;
+			for (uint32 i = 0; i < ops; i++)
+			{
+				if (pipeline > 1 && i % pipeline == 0)
+				{
+					grouping = db.BeginGroupCommit();
+				}
+				sprintf(value, "v%u_%u", id, i);
+				if (lpush)
+				{
+					sprintf(key, "bench_group_list_%u_%u", round,
+					        (id * 7 + i) % 32);
+					db.LPush(dbid, key, value);
+				}
+				else
+				{
+					sprintf(key, "bench_group_key_%u_%u_%u", round, id, i);
+					db.Set(dbid, key, value);
+				}
+				if (grouping && (i % pipeline == pipeline - 1 || i == ops - 1))
+				{
+					db.EndGroupCommit();
+					grouping = false;
+				}
+			}
+		}
+};
+
+void bench_group_commit(Ardb& db)
+{
+	const uint32 total_ops = 200000;
+	uint32 workers[] = { 1, 4 };
+	uint32 pipelines[] = { 1, 16, 100 };
+	uint32 round = 0;
+	for (uint32 l = 0; l < 2; l++)
+	{
+		for (uint32 w = 0; w < arraysize(workers); w++)
+		{
+			for (uint32 p = 0; p < arraysize(pipelines); p++)
+			{
+				round++;
+				std::vector<GroupCommitBenchWorker*> threads;
+				uint64 start = get_current_epoch_micros();
+				for (uint32 i = 0; i < workers[w]; i++)
+				{
+					GroupCommitBenchWorker* t = new GroupCommitBenchWorker(db,
+					        round, i, total_ops / workers[w], pipelines[p], l == 1);
+					threads.push_back(t);
+					t->Start();
+				}
+				for (uint32 i = 0; i < threads.size(); i++)
+				{
+					threads[i]->Join();
+					delete threads[i];
+				}
+				uint64 end = get_current_epoch_micros();
+				char name[64];
+				sprintf(name, "%s(pipeline %u)", l == 1 ? "lpush" : "set",
+				        pipelines[p]);
+				print_bench_result(name, workers[w], total_ops, end - start);
+			}
+		}
+	}
+}
+
+/*
+ * Pipelined SET/LPUSH against a running server, compare its throughput
+ * with 'group-commit' on and off.
+ */
+struct PipelineBenchClient: public Thread
+{
+		std::string host;
+		uint32 port;
+		uint32 id;
+		uint32 ops;
+		uint32 pipeline;
+		bool lpush;
+		uint32 replies;
+		PipelineBenchClient(const std::string& h, uint32 p, uint32 i,
+		        uint32 n, uint32 depth, bool l) :
+				host(h), port(p), id(i), ops(n), pipeline(depth), lpush(l), replies(
+				        0)
+		{
+		}
+		void Run()
+		{
+			struct sockaddr_in addr;
+			memset(&addr, 0, sizeof(addr));
+			addr.sin_family = AF_INET;
+			addr.sin_port = htons(port);
+			inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+			int fd = socket(AF_INET, SOCK_STREAM, 0);
+			if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0)
+			{
+				close(fd);
+				return;
+			}
+			int nodelay = 1;
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+			char key[64], value[64], reply[4096];
+			for (uint32 i = 0; i < ops; i += pipeline)
+			{
+				Buffer req;
+				uint32 count = 0;
+				for (; count < pipeline && i + count < ops; count++)
+				{
+					sprintf(value, "v%u_%u", id, i + count);
+					if (lpush)
+					{
+						sprintf(key, "bench_pipeline_list_%u",
+						        (id * 7 + i + count) % 32);
+						req.Printf("*3\r\n$5\r\nLPUSH\r\n$%zu\r\n%s\r\n$%zu\r\n%s\r\n",
+						        strlen(key), key, strlen(value), value);
+					}
+					else
+					{
+						sprintf(key, "bench_pipeline_key_%u_%u", id, i + count);
+						req.Printf("*3\r\n$3\r\nSET\r\n$%zu\r\n%s\r\n$%zu\r\n%s\r\n",
+						        strlen(key), key, strlen(value), value);
+					}
+				}
+				if (write(fd, req.GetRawReadBuffer(), req.ReadableBytes()) < 0)
+				{
+					break;
+				}
+				/*
+				 * Every reply of these commands is a single line.
+				 */
+				uint32 lines = 0;
+				while (lines < count)
+				{
+					int n = read(fd, reply, sizeof(reply));
+					if (n <= 0)
+					{
+						close(fd);
+						return;
+					}
+					for (int k = 0; k < n; k++)
+					{
+						if (reply[k] == '\n')
+						{
+							lines++;
+						}
+					}
+				}
+				replies += lines;
+			}
+			close(fd);
+		}
+};
+
+void bench_pipeline(const std::string& host, uint32 port)
+{
+	const uint32 total_ops = 200000;
+	uint32 clients[] = { 1, 4 };
+	uint32 pipelines[] = { 1, 16, 100 };
+	for (uint32 l = 0; l < 2; l++)
+	{
+		for (uint32 c = 0; c < arraysize(clients); c++)
+		{
+			for (uint32 p = 0; p < arraysize(pipelines); p++)
+			{
+				std::vector<PipelineBenchClient*> threads;
+				uint64 start = get_current_epoch_micros();
+				for (uint32 i = 0; i < clients[c]; i++)
+				{
+					PipelineBenchClient* t = new PipelineBenchClient(host, port,
+					        i, total_ops / clients[c], pipelines[p], l == 1);
+					threads.push_back(t);
+					t->Start();
+				}
+				uint32 replies = 0;
+				for (uint32 i = 0; i < threads.size(); i++)
+				{
+					threads[i]->Join();
+					replies += threads[i]->replies;
+					delete threads[i];
+				}
+				uint64 end = get_current_epoch_micros();
+				char name[64];
+				sprintf(name, "%s(net,pipeline %u)", l == 1 ? "lpush" : "set",
+				        pipelines[p]);
+				print_bench_result(name, clients[c], replies, end - start);
+			}
+		}
+	}
+}
@@ -89,6 +89,19 @@ void test_hash_hlen(Ardb& db)
 
 	CHECK_FATAL( db.HLen(dbid, "myhash") != 5,
 			"hlen myhash failed:%d", db.HLen(dbid, "myhash"));
+	int ret = db.HSet(dbid, "myhash", "field5", "value5");
+	CHECK_FATAL( ret != 0, "hset existing field failed:%d", ret);
+	SliceArray fields;
+	fields.push_back("field1");
+	fields.push_back("field2");
+	fields.push_back("nofield");
+	ret = db.HDel(dbid, "myhash", fields);
+	CHECK_FATAL( ret != 2, "hdel myhash failed:%d", ret);
+	CHECK_FATAL( db.HLen(dbid, "myhash") != 3,
+			"hlen myhash failed:%d", db.HLen(dbid, "myhash"));
+	db.HClear(dbid, "myhash");
+	CHECK_FATAL( db.HLen(dbid, "myhash") != 0,
+			"hlen myhash failed:%d", db.HLen(dbid, "myhash"));
 }
 
 void test_hash_hsetnx(Ardb& db)
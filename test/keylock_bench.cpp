@@ -0,0 +1,76 @@
+/*
+ * keylock_bench.cpp
+ *
+ *  LPUSH/SADD throughput on an overlapping key set with different count
+ *  of worker threads, shows how the key lock table scales.
+ */
+#include "test_common.hpp"
+
+struct KeyLockBenchWorker: public Thread
+{
+		Ardb& db;
+		uint32 id;
+		uint32 ops;
+		uint32 keys;
+		KeyLockBenchWorker(Ardb& d, uint32 i, uint32 n, uint32 k) :
+				db(d), id(i), ops(n), keys(k)
+		{
+		}
+		void Run()
+		{
+			DBID dbid = 0;
+			char key[64], value[64];
+			for (uint32 i = 0; i < ops; i++)
+			{
+				uint32 k = (id * 7 + i) % keys;
+				sprintf(value, "v%u_%u", id, i);
+				if (i % 2 == 0)
+				{
+					sprintf(key, "bench_list_%u", k);
+					db.LPush(dbid, key, value);
+				}
+				else
+				{
+					sprintf(key, "bench_set_%u", k);
+					db.SAdd(dbid, key, value);
+				}
+			}
+		}
+};
+
+void bench_keylock(Ardb& db)
+{
+	const uint32 total_ops = 200000;
+	const uint32 keys = 32;
+	DBID dbid = 0;
+	uint32 workers[] = { 1, 2, 4, 8, 16 };
+	for (uint32 w = 0; w < arraysize(workers); w++)
+	{
+		for (uint32 k = 0; k < keys; k++)
+		{
+			char key[64];
+			sprintf(key, "bench_list_%u", k);
+			db.LClear(dbid, key);
+			sprintf(key, "bench_set_%u", k);
+			db.SClear(dbid, key);
+		}
+		std::vector<KeyLockBenchWorker*> threads;
+		uint64 start = get_current_epoch_micros();
+		for (uint32 i = 0; i < workers[w]; i++)
+		{
+			KeyLockBenchWorker* t = new KeyLockBenchWorker(db, i,
+			        total_ops / workers[w], keys);
+			threads.push_back(t);
+			t->Start();
+		}
+		for (uint32 i = 0; i < threads.size(); i++)
+		{
+			threads[i]->Join();
+			delete threads[i];
+		}
+		uint64 end = get_current_epoch_micros();
+		print_bench_result("keylock(lpush/sadd)", workers[w], total_ops,
+		        end - start);
+	}
+	printf("%s", db.KeyLockStats().c_str());
+}
@@ -114,6 +114,60 @@ void test_lists_lrem(Ardb& db)
 			"lrem mylist failed:%d", db.LLen(dbid, "mylist"));
 }
 
+void test_lists_index(Ardb& db)
+{
+	DBID dbid = 0;
+	db.LClear(dbid, "mylist");
+	char value[16];
+	for (int i = 0; i < 100; i++)
+	{
+		sprintf(value, "v%d", i);
+		db.RPush(dbid, "mylist", value);
+	}
+	db.LPush(dbid, "mylist", "head");
+	db.LInsert(dbid, "mylist", "after", "v10", "after10");
+	db.LInsert(dbid, "mylist", "before", "v90", "before90");
+	CHECK_FATAL(db.LLen(dbid, "mylist") != 103,
+			"linsert mylist failed:%d", db.LLen(dbid, "mylist"));
+	std::string v;
+	db.LIndex(dbid, "mylist", 0, v);
+	CHECK_FATAL( v != "head", "LIndex failed:%s", v.c_str());
+	db.LIndex(dbid, "mylist", 12, v);
+	CHECK_FATAL( v != "after10", "LIndex failed:%s", v.c_str());
+	db.LIndex(dbid, "mylist", 92, v);
+	CHECK_FATAL( v != "before90", "LIndex failed:%s", v.c_str());
+	db.LIndex(dbid, "mylist", -1, v);
+	CHECK_FATAL( v != "v99", "LIndex failed:%s", v.c_str());
+	CHECK_FATAL(db.LIndex(dbid, "mylist", 103, v) != ERR_NOT_EXIST,
+			"LIndex out of range failed");
+	CHECK_FATAL(db.LInsert(dbid, "mylist", "before", "nopivot", "x") >= 0,
+			"LInsert without pivot failed");
+
+	db.LRem(dbid, "mylist", 0, "v50");
+	db.LRem(dbid, "mylist", 1, "v5");
+	CHECK_FATAL(db.LLen(dbid, "mylist") != 101,
+			"lrem mylist failed:%d", db.LLen(dbid, "mylist"));
+	ValueArray array;
+	db.LRange(dbid, "mylist", 49, 51, array);
+	CHECK_FATAL( array.size() != 3, "lrange failed:%zu", array.size());
+	CHECK_FATAL( array[0].ToString(v) != "v48", "lrange failed:%s", v.c_str());
+	CHECK_FATAL( array[1].ToString(v) != "v49", "lrange failed:%s", v.c_str());
+	CHECK_FATAL( array[2].ToString(v) != "v51", "lrange failed:%s", v.c_str());
+	db.LSet(dbid, "mylist", -2, "setv");
+	db.LIndex(dbid, "mylist", 99, v);
+	CHECK_FATAL( v != "setv", "LSet failed:%s", v.c_str());
+
+	db.LTrim(dbid, "mylist", 10, 19);
+	array.clear();
+	db.LRange(dbid, "mylist", 0, -1, array);
+	CHECK_FATAL( array.size() != 10, "ltrim failed:%zu", array.size());
+	CHECK_FATAL( array[0].ToString(v) != "v10", "ltrim failed:%s", v.c_str());
+	db.RPop(dbid, "mylist", v);
+	CHECK_FATAL( v != "v18", "RPop failed:%s", v.c_str());
+	db.LClear(dbid, "mylist");
+	CHECK_FATAL(db.LLen(dbid, "mylist") != 0, "lclear failed");
+}
+
 void test_lists(Ardb& db)
 {
 	test_lists_lpush(db);
@@ -122,5 +176,6 @@ void test_lists(Ardb& db)
 	test_lists_lrange(db);
 	test_lists_lrem(db);
 	test_lists_ltrim(db);
+	test_lists_index(db);
 }
 
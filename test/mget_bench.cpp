@@ -0,0 +1,73 @@
+/*
+ * mget_bench.cpp
+ *
+ *  MGET of 100 keys, one engine Get per key like MGET did before against
+ *  the sorted lookup with one iterator, for dense runs of keys and for
+ *  keys picked at random.
+ */
+#include "test_common.hpp"
+
+static const uint32 kBenchMGetKeys = 1000000;
+static const uint32 kBenchMGetBatch = 100;
+
+void bench_mget(Ardb& db)
+{
+	DBID dbid = 0;
+	char key[64];
+	std::string value(32, 'v');
+	for (uint32 i = 0; i < kBenchMGetKeys; i++)
+	{
+		sprintf(key, "mget_bench_key:%08u", i);
+		db.Set(dbid, key, value);
+	}
+	const uint32 loops = 5000;
+	srand(1);
+	for (uint32 random = 0; random < 2; random++)
+	{
+		std::vector<StringArray> batches(loops);
+		for (uint32 i = 0; i < loops; i++)
+		{
+			uint32 start = rand() % (kBenchMGetKeys - kBenchMGetBatch);
+			for (uint32 j = 0; j < kBenchMGetBatch; j++)
+			{
+				uint32 id = random ? rand() % kBenchMGetKeys : start + j;
+				sprintf(key, "mget_bench_key:%08u", id);
+				batches[i].push_back(key);
+			}
+			for (uint32 j = kBenchMGetBatch - 1; j > 0; j--)
+			{
+				std::swap(batches[i][j], batches[i][rand() % (j + 1)]);
+			}
+		}
+		for (uint32 batched = 0; batched < 2; batched++)
+		{
+			uint64 start = get_current_epoch_micros();
+			for (uint32 i = 0; i < loops; i++)
+			{
+				SliceArray keys;
+				for (uint32 j = 0; j < batches[i].size(); j++)
+				{
+					keys.push_back(batches[i][j]);
+				}
+				ValueArray vs;
+				if (batched)
+				{
+					db.MGet(dbid, keys, vs);
+				}
+				else
+				{
+					for (uint32 j = 0; j < keys.size(); j++)
+					{
+						std::string v;
+						db.Get(dbid, keys[j], &v);
+					}
+				}
+			}
+			uint64 end = get_current_epoch_micros();
+			char name[64];
+			sprintf(name, "mget%u(%s,%s)", kBenchMGetBatch,
+			        random ? "random" : "dense", batched ? "sorted" : "get");
+			print_bench_result(name, 1, loops * kBenchMGetBatch, end - start);
+		}
+	}
+}
@@ -5,6 +5,8 @@
  *      Author: yinqiwen
  */
 #include "test_common.hpp"
+#include "comparator.hpp"
+#include "replication.hpp"
 
 void test_type(Ardb& db)
 {
@@ -25,6 +27,38 @@ void test_type(Ardb& db)
 	CHECK_FATAL( db.Type(dbid, "mybits") != BITSET_META, "type failed.");
 }
 
+void test_key_directory(Ardb& db)
+{
+	DBID dbid = 0;
+	db.SAdd(dbid, "dirset", "1");
+	db.HSet(dbid, "dirhash", "f1", "1");
+	db.HSet(dbid, "dirhash", "f2", "2");
+	db.RPush(dbid, "dirlist", "1");
+	db.ZAdd(dbid, "dirzset", 1, "one");
+	CHECK_FATAL(db.Type(dbid, "dirset") != SET_ELEMENT, "dir type failed.");
+	db.SRem(dbid, "dirset", "1");
+	CHECK_FATAL(db.Type(dbid, "dirset") != -1, "emptied set still typed.");
+	db.HDel(dbid, "dirhash", "f1");
+	CHECK_FATAL(db.Type(dbid, "dirhash") != HASH_FIELD, "hdel dropped type.");
+	db.HDel(dbid, "dirhash", "f2");
+	CHECK_FATAL(db.Type(dbid, "dirhash") != -1, "emptied hash still typed.");
+	std::string v;
+	db.RPop(dbid, "dirlist", v);
+	CHECK_FATAL(db.Type(dbid, "dirlist") != -1, "emptied list still typed.");
+	CHECK_FATAL(db.Del(dbid, "dirlist") != -1, "del of missing key.");
+
+	KeyObject dk("dirzset", KEY_DIRECTORY, dbid);
+	Buffer keybuf;
+	encode_key(keybuf, dk);
+	db.RawDel(Slice(keybuf.GetRawReadBuffer(), keybuf.ReadableBytes()));
+	CHECK_FATAL(db.Type(dbid, "dirzset") != -1, "raw del directory failed.");
+	db.RebuildKeyDirectory();
+	CHECK_FATAL(db.Type(dbid, "dirzset") != ZSET_ELEMENT_SCORE,
+	        "rebuild key directory failed.");
+	db.Del(dbid, "dirzset");
+	CHECK_FATAL(db.Type(dbid, "dirzset") != -1, "del zset kept type.");
+}
+
 void test_sort_list(Ardb& db)
 {
 	DBID dbid = 0;
@@ -208,8 +242,501 @@ void test_sort_zset(Ardb& db)
 	CHECK_FATAL(vs[7].ToString(str) != "v0", "sort result[7]:%s", str.c_str());
 }
 
+
+static int compare_encoded_keys(const KeyObject& a, const KeyObject& b)
+{
+	Buffer abuf, bbuf;
+	encode_key(abuf, a);
+	encode_key(bbuf, b);
+	return ardb_compare_keys(abuf.GetRawReadBuffer(), abuf.ReadableBytes(),
+	        bbuf.GetRawReadBuffer(), bbuf.ReadableBytes());
+}
+
+void test_key_order(Ardb& db)
+{
+	DBID dbid = 0;
+	ZSetKeyObject z1("myzset", "a", -10.5, dbid);
+	ZSetKeyObject z2("myzset", "a", -2, dbid);
+	ZSetKeyObject z3("myzset", "a", 0, dbid);
+	ZSetKeyObject z4("myzset", "b", 0, dbid);
+	ZSetKeyObject z5("myzset", "a", 3.25, dbid);
+	CHECK_FATAL(compare_encoded_keys(z1, z2) >= 0, "zset key order failed.");
+	CHECK_FATAL(compare_encoded_keys(z2, z3) >= 0, "zset key order failed.");
+	CHECK_FATAL(compare_encoded_keys(z3, z4) >= 0, "zset key order failed.");
+	CHECK_FATAL(compare_encoded_keys(z4, z5) >= 0, "zset key order failed.");
+
+	SetKeyObject s1("myset", "-100", dbid);
+	SetKeyObject s2("myset", "7", dbid);
+	SetKeyObject s3("myset", "100000000000", dbid);
+	SetKeyObject s4("myset", "ab", dbid);
+	SetKeyObject s5("myset", "abc", dbid);
+	CHECK_FATAL(compare_encoded_keys(s1, s2) >= 0, "set key order failed.");
+	CHECK_FATAL(compare_encoded_keys(s2, s3) >= 0, "set key order failed.");
+	CHECK_FATAL(compare_encoded_keys(s3, s4) >= 0, "set key order failed.");
+	CHECK_FATAL(compare_encoded_keys(s4, s5) >= 0, "set key order failed.");
+
+	KeyObject k1("b", KV, dbid);
+	KeyObject k2("aa", KV, dbid);
+	KeyObject k3("a", KV, dbid + 1);
+	CHECK_FATAL(compare_encoded_keys(k1, k2) >= 0, "kv key order failed.");
+	CHECK_FATAL(compare_encoded_keys(k2, k3) >= 0, "kv key order failed.");
+
+	std::string raw("a\0b", 3);
+	TableIndexKeyObject t1("mytable", "col", raw, dbid);
+	TableIndexKeyObject t2("mytable", "col", "a\x01", dbid);
+	t1.index.push_back(ValueObject((int64) 2));
+	t2.index.push_back(ValueObject((int64) 1));
+	CHECK_FATAL(compare_encoded_keys(t1, t2) >= 0, "table index key order failed.");
+
+	Buffer buf;
+	encode_key(buf, t1);
+	KeyObject* k = decode_key(
+	        Slice(buf.GetRawReadBuffer(), buf.ReadableBytes()), NULL);
+	CHECK_FATAL(NULL == k || k->type != TABLE_INDEX, "decode key failed.");
+	TableIndexKeyObject* tk = (TableIndexKeyObject*) k;
+	std::string str;
+	CHECK_FATAL(tk->colvalue.ToString(str) != raw, "decode escaped value failed.");
+	CHECK_FATAL(tk->index.size() != 1 || tk->index[0].v.int_v != 2,
+	        "decode table index failed.");
+	DELETE(k);
+}
+
+void test_batch_overlay(Ardb& db)
+{
+	DBID dbid = 0;
+	std::string v;
+	db.HClear(dbid, "overlayhash");
+	db.ZClear(dbid, "overlayzset");
+	db.HSet(dbid, "overlayhash", "f1", "v1");
+	db.HSet(dbid, "overlayhash", "f3", "v3");
+	db.ZAdd(dbid, "overlayzset", 1, "one");
+	db.ZAdd(dbid, "overlayzset", 3, "three");
+	{
+		BatchWriteGuard guard(db.GetEngine());
+		db.HSet(dbid, "overlayhash", "f2", "v2");
+		db.HDel(dbid, "overlayhash", "f1");
+		db.HSet(dbid, "overlayhash", "f3", "v33");
+		CHECK_FATAL(db.HGet(dbid, "overlayhash", "f2", &v) != 0 || v != "v2",
+		        "read batched hset failed.");
+		CHECK_FATAL(db.HGet(dbid, "overlayhash", "f1", &v) == 0,
+		        "read batched hdel failed.");
+		StringArray fields;
+		db.HKeys(dbid, "overlayhash", fields);
+		CHECK_FATAL(fields.size() != 2 || fields[0] != "f2" || fields[1] != "f3",
+		        "iterate batched hash failed:%zu", fields.size());
+
+		DoubleArray scores;
+		SliceArray svs;
+		scores.push_back(2);
+		svs.push_back("two");
+		scores.push_back(4);
+		svs.push_back("two");
+		db.ZAdd(dbid, "overlayzset", scores, svs);
+		db.ZRem(dbid, "overlayzset", "one");
+		CHECK_FATAL(db.ZCard(dbid, "overlayzset") != 2,
+		        "batched zadd meta failed:%d", db.ZCard(dbid, "overlayzset"));
+		QueryOptions options;
+		ValueArray values;
+		db.ZRevRange(dbid, "overlayzset", 0, -1, values, options);
+		CHECK_FATAL(values.size() != 2 || values[0].ToString(v) != "two"
+		        || values[1].ToString(v) != "three",
+		        "reverse iterate batched zset failed:%zu", values.size());
+	}
+	CHECK_FATAL(db.HLen(dbid, "overlayhash") != 2, "commit batch failed.");
+	{
+		BatchWriteGuard guard(db.GetEngine());
+		db.HSet(dbid, "overlayhash", "f4", "v4");
+		guard.MarkFailed();
+	}
+	CHECK_FATAL(db.HGet(dbid, "overlayhash", "f4", &v) == 0,
+	        "discard batch failed.");
+	db.HClear(dbid, "overlayhash");
+	db.ZClear(dbid, "overlayzset");
+}
+
+void test_group_commit_discard(Ardb& db)
+{
+	DBID dbid = 0;
+	db.Del(dbid, "groupkey1");
+	db.Del(dbid, "groupkey2");
+	db.Del(dbid, "groupkey3");
+	if (!db.BeginGroupCommit())
+	{
+		return;
+	}
+	/*
+	 * One command of the group discards its batch, the writes of the
+	 * others went with it and the group must not report success.
+	 */
+	db.Set(dbid, "groupkey1", "v");
+	{
+		BatchWriteGuard guard(db.GetEngine());
+		db.Set(dbid, "groupkey2", "v");
+		guard.MarkFailed();
+	}
+	db.Set(dbid, "groupkey3", "v");
+	int ret = db.EndGroupCommit();
+	CHECK_FATAL(ret != -1, "group with a discarded batch committed:%d", ret);
+	CHECK_FATAL(db.Exists(dbid, "groupkey1"), "discarded group wrote key1.");
+	CHECK_FATAL(db.Exists(dbid, "groupkey2"), "discarded group wrote key2.");
+	CHECK_FATAL(db.Exists(dbid, "groupkey3"), "discarded group wrote key3.");
+
+	db.BeginGroupCommit();
+	db.Set(dbid, "groupkey1", "v");
+	ret = db.EndGroupCommit();
+	CHECK_FATAL(ret != 0, "group after a failed group failed:%d", ret);
+	CHECK_FATAL(!db.Exists(dbid, "groupkey1"), "group commit lost key1.");
+	db.Del(dbid, "groupkey1");
+}
+
+/*
+ * An engine without group commit or FlushBatchWrite, like KyotoCabinet
+ * and LMDB, in front of the test engine.
+ */
+struct PlainEngine: public KeyValueEngine
+{
+		KeyValueEngine* engine;
+		PlainEngine(KeyValueEngine* e) :
+				engine(e)
+		{
+		}
+		int Get(const Slice& key, std::string* value)
+		{
+			return engine->Get(key, value);
+		}
+		int Put(const Slice& key, const Slice& value)
+		{
+			return engine->Put(key, value);
+		}
+		int Del(const Slice& key)
+		{
+			return engine->Del(key);
+		}
+		int BeginBatchWrite()
+		{
+			return engine->BeginBatchWrite();
+		}
+		int CommitBatchWrite()
+		{
+			return engine->CommitBatchWrite();
+		}
+		int DiscardBatchWrite()
+		{
+			return engine->DiscardBatchWrite();
+		}
+		Iterator* Find(const Slice& findkey, bool cache)
+		{
+			return engine->Find(findkey, cache);
+		}
+};
+
+struct PlainEngineFactory: public KeyValueEngineFactory
+{
+		KeyValueEngine* engine;
+		PlainEngineFactory(KeyValueEngine* e) :
+				engine(e)
+		{
+		}
+		const std::string GetName()
+		{
+			return "plain";
+		}
+		KeyValueEngine* CreateDB(const std::string& name)
+		{
+			return new PlainEngine(engine);
+		}
+		void CloseDB(KeyValueEngine* e)
+		{
+			DELETE(e);
+		}
+		void DestroyDB(KeyValueEngine* e)
+		{
+			DELETE(e);
+		}
+};
+
+void test_barrier_without_group(Ardb& db)
+{
+	DBID dbid = 0;
+	PlainEngineFactory factory(db.GetEngine());
+	/*
+	 * One worker thread runs without the key locker.
+	 */
+	Ardb plain(&factory, false);
+	plain.Init();
+	CHECK_FATAL(plain.BeginGroupCommit(), "plain engine opened a group.");
+	plain.Set(dbid, "barrierkey", "v");
+	int ret = plain.SyncGroupCommit();
+	CHECK_FATAL(ret != 0, "barrier without a group failed:%d", ret);
+	CHECK_FATAL(!db.Exists(dbid, "barrierkey"), "barrier lost a write.");
+	db.Del(dbid, "barrierkey");
+}
+
+/*
+ * Keeps the raw writes of the thread's batch the way the replication
+ * service does and counts what it would hand to the replication thread.
+ */
+struct ReplFeedRecorder: public RawKeyListener
+{
+		ReplBatch pending;
+		uint32 pending_ops;
+		uint32 batches;
+		uint32 ops;
+		uint32 discards;
+		ReplFeedRecorder() :
+				pending_ops(0), batches(0), ops(0), discards(0)
+		{
+		}
+		int OnKeyUpdated(const Slice& key, const Slice& value)
+		{
+			BufferHelper::WriteFixUInt8(pending.ops, 0);
+			BufferHelper::WriteVarSlice(pending.ops, key);
+			BufferHelper::WriteVarSlice(pending.ops, value);
+			pending_ops++;
+			return 0;
+		}
+		int OnKeyDeleted(const Slice& key)
+		{
+			BufferHelper::WriteFixUInt8(pending.ops, 1);
+			BufferHelper::WriteVarSlice(pending.ops, key);
+			pending_ops++;
+			return 0;
+		}
+		void OnBatchCommitted()
+		{
+			if (pending.ops.Readable())
+			{
+				batches++;
+				ops += pending_ops;
+			}
+			pending.ops.Clear();
+			pending_ops = 0;
+		}
+		void OnBatchDiscarded()
+		{
+			discards++;
+			pending.ops.Clear();
+			pending_ops = 0;
+		}
+};
+
+void test_repl_batch_feed(Ardb& db)
+{
+	DBID dbid = 0;
+	db.Del(dbid, "feedkey1");
+	db.Del(dbid, "feedkey2");
+	ReplFeedRecorder recorder;
+	db.RegisterRawKeyListener(&recorder);
+
+	/*
+	 * A write outside a batch is its own batch.
+	 */
+	db.Set(dbid, "feedkey1", "v");
+	CHECK_FATAL(recorder.batches != 1 || recorder.pending_ops != 0,
+	        "unbatched write not fed:%u", recorder.batches);
+
+	/*
+	 * Nested batches are fed once, when the outermost commits.
+	 */
+	uint32 ops = recorder.ops;
+	{
+		BatchWriteGuard guard(db.GetEngine());
+		db.Set(dbid, "feedkey1", "v1");
+		{
+			BatchWriteGuard inner(db.GetEngine());
+			db.Set(dbid, "feedkey2", "v2");
+		}
+		CHECK_FATAL(recorder.batches != 1, "inner batch was fed.");
+	}
+	CHECK_FATAL(recorder.batches != 2 || recorder.ops - ops < 2,
+	        "batch not fed as one:%u", recorder.batches);
+
+	/*
+	 * A discarded batch is never fed.
+	 */
+	{
+		BatchWriteGuard guard(db.GetEngine());
+		db.Set(dbid, "feedkey1", "v3");
+		guard.MarkFailed();
+	}
+	CHECK_FATAL(recorder.batches != 2 || recorder.discards != 1,
+	        "discarded batch was fed:%u", recorder.batches);
+	CHECK_FATAL(recorder.pending.ops.Readable(), "discarded batch kept.");
+
+	/*
+	 * A group is fed at each sync and at its end.
+	 */
+	if (db.BeginGroupCommit())
+	{
+		db.Set(dbid, "feedkey1", "v4");
+		CHECK_FATAL(db.SyncGroupCommit() != 0, "sync group failed.");
+		CHECK_FATAL(recorder.batches != 3, "synced group not fed.");
+		db.Set(dbid, "feedkey2", "v5");
+		CHECK_FATAL(db.EndGroupCommit() != 0, "end group failed.");
+		CHECK_FATAL(recorder.batches != 4, "ended group not fed.");
+	}
+	db.RegisterRawKeyListener(NULL);
+	db.Del(dbid, "feedkey1");
+	db.Del(dbid, "feedkey2");
+}
+
+void test_expire_sweep(Ardb& db)
+{
+	DBID dbid = 0;
+	uint64 past = get_current_epoch_millis() - 1;
+	db.Set(dbid, "expkv", "v");
+	db.Pexpireat(dbid, "expkv", past);
+	db.Set(dbid, "expkv2", "v");
+	db.Pexpireat(dbid, "expkv2", past);
+	db.Set(dbid, "expkv2", "v2");
+	db.HSet(dbid, "exphash", "f", "v");
+	db.Pexpireat(dbid, "exphash", past);
+	db.SAdd(dbid, "expset", "v");
+	db.Expire(dbid, "expset", 1000);
+	CHECK_FATAL(db.TTL(dbid, "expset") <= 0, "ttl on set failed.");
+	int expired = db.CheckExpiredKeys(1000);
+	CHECK_FATAL(expired != 2, "expire sweep failed:%d", expired);
+	CHECK_FATAL(db.Type(dbid, "expkv") >= 0, "expired kv still exists.");
+	CHECK_FATAL(db.Type(dbid, "exphash") >= 0, "expired hash still exists.");
+	CHECK_FATAL(!db.Exists(dbid, "expkv2"), "overwritten kv expired.");
+	CHECK_FATAL(db.SCard(dbid, "expset") != 1, "set expired too early.");
+	db.Persist(dbid, "expset");
+	CHECK_FATAL(db.TTL(dbid, "expset") != 0, "persist set failed.");
+	db.Del(dbid, "expkv2");
+	db.Del(dbid, "expset");
+
+	/*
+	 * A collection emptied element by element loses its TTL, a key of the
+	 * same name created later must not inherit it.
+	 */
+	std::string v;
+	db.HSet(dbid, "exphash", "f", "v");
+	db.Expire(dbid, "exphash", 1000);
+	db.HDel(dbid, "exphash", "f");
+	db.HSet(dbid, "exphash", "f", "v");
+	CHECK_FATAL(db.TTL(dbid, "exphash") != 0, "recreated hash kept its ttl.");
+	db.RPush(dbid, "explist", "v");
+	db.Expire(dbid, "explist", 1000);
+	db.LPop(dbid, "explist", v);
+	db.RPush(dbid, "explist", "v");
+	CHECK_FATAL(db.TTL(dbid, "explist") != 0, "recreated list kept its ttl.");
+	db.ZAdd(dbid, "expzset", 1, "v");
+	db.Expire(dbid, "expzset", 1000);
+	db.ZRem(dbid, "expzset", "v");
+	db.ZAdd(dbid, "expzset", 1, "v");
+	CHECK_FATAL(db.TTL(dbid, "expzset") != 0, "recreated zset kept its ttl.");
+	db.SAdd(dbid, "expset", "v");
+	db.Pexpireat(dbid, "expset", past);
+	db.SRem(dbid, "expset", "v");
+	db.SAdd(dbid, "expset", "v");
+	db.CheckExpiredKeys(1000);
+	CHECK_FATAL(db.SCard(dbid, "expset") != 1, "recreated set expired.");
+	db.Del(dbid, "exphash");
+	db.Del(dbid, "explist");
+	db.Del(dbid, "expzset");
+	db.Del(dbid, "expset");
+}
+
+void test_checkpoint(Ardb& db)
+{
+	DBID dbid = 0;
+	std::string base = "./checkpoint_test";
+	db.Set(dbid, "checkpoint_key", "v");
+	Properties cfg;
+	cfg["data-dir"] = base;
+	SelectedDBEngineFactory factory(cfg);
+	std::string dir = base + "/" + factory.GetName();
+	CHECK_FATAL(db.GetEngine()->Checkpoint(dir) != 0, "checkpoint failed.");
+	/*
+	 * Written after the checkpoint, must not show up in it.
+	 */
+	db.Set(dbid, "checkpoint_key2", "v");
+	{
+		Ardb copy(&factory, false);
+		CHECK_FATAL(!copy.Init(), "open checkpoint failed.");
+		std::string v;
+		CHECK_FATAL(copy.Get(dbid, "checkpoint_key", &v) != 0 || v != "v",
+		        "checkpoint lost key.");
+		CHECK_FATAL(copy.Exists(dbid, "checkpoint_key2"),
+		        "checkpoint saw a later write.");
+	}
+	remove_dir(base);
+	db.Del(dbid, "checkpoint_key");
+	db.Del(dbid, "checkpoint_key2");
+}
+
+void test_scan(Ardb& db)
+{
+	DBID dbid = 11;
+	for (int i = 0; i < 20; i++)
+	{
+		char key[32];
+		sprintf(key, "scan_kv%d", i);
+		db.Set(dbid, key, "v");
+	}
+	db.HSet(dbid, "scan_hash", "f0", "v0");
+	db.HSet(dbid, "scan_hash", "f1", "v1");
+	db.SAdd(dbid, "scan_set", "m");
+	db.ZAdd(dbid, "scan_zset", 1, "m");
+	StringSet seen;
+	std::string cursor = "0";
+	uint32 calls = 0;
+	do
+	{
+		StringArray keys;
+		std::string next;
+		CHECK_FATAL(db.Scan(dbid, cursor, "*", 3, -1, keys, next) != 0,
+		        "scan failed.");
+		CHECK_FATAL(keys.size() > 3, "scan returned too many keys.");
+		for (uint32 i = 0; i < keys.size(); i++)
+		{
+			CHECK_FATAL(!seen.insert(keys[i]).second, "scan duplicate key.");
+		}
+		cursor = next;
+		calls++;
+	} while (cursor != "0");
+	CHECK_FATAL(seen.size() != 23, "scan missed keys:%zu", seen.size());
+	CHECK_FATAL(calls < 8, "scan did not stop at the count.");
+	StringArray keys;
+	std::string next;
+	db.Scan(dbid, "0", "scan_*", 100, HASH_META, keys, next);
+	CHECK_FATAL(keys.size() != 1 || keys[0] != "scan_hash" || next != "0",
+	        "scan with type failed.");
+	CHECK_FATAL(db.Scan(dbid, "zz", "*", 10, -1, keys, next) == 0,
+	        "invalid scan cursor accepted.");
+
+	ValueArray vs;
+	db.HScan(dbid, "scan_hash", "0", "*", 1, vs, next);
+	CHECK_FATAL(vs.size() != 2 || next == "0", "hscan failed.");
+	db.HScan(dbid, "scan_hash", next, "*", 1, vs, next);
+	CHECK_FATAL(vs.size() != 4 || next != "0", "hscan resume failed.");
+	std::string str;
+	CHECK_FATAL(vs[2].ToString(str) != "f1", "hscan resume wrong field.");
+	vs.clear();
+	db.SScan(dbid, "scan_set", "0", "*", 10, vs, next);
+	CHECK_FATAL(vs.size() != 1 || next != "0", "sscan failed.");
+	vs.clear();
+	db.ZScan(dbid, "scan_zset", "0", "*", 10, vs, next);
+	CHECK_FATAL(vs.size() != 2 || vs[1].NumberValue() != 1, "zscan failed.");
+	StringSet::iterator it = seen.begin();
+	while (it != seen.end())
+	{
+		db.Del(dbid, *it);
+		it++;
+	}
+}
+
 void test_misc(Ardb& db)
 {
+	test_key_directory(db);
+	test_scan(db);
+	test_checkpoint(db);
+	test_expire_sweep(db);
+	test_key_order(db);
+	test_batch_overlay(db);
+	test_group_commit_discard(db);
+	test_barrier_without_group(db);
+	test_repl_batch_feed(db);
 	test_type(db);
 	test_sort_list(db);
 	test_sort_set(db);
@@ -0,0 +1,151 @@
+/*
+ * oplog_bench.cpp
+ *
+ *  Writes set ops into sealed oplog segments, then catches a slave up from
+ *  several points behind the last op: seek through the segment index and
+ *  stream every op as the __set__ command fed to slaves. The 'db' rows read
+ *  each value from the db like the oplogs did when only keys were kept.
+ */
+#include "test_common.hpp"
+#include "replication.hpp"
+#include "util/file_helper.hpp"
+
+static const uint32 kBenchOplogKeys = 100000;
+static const uint32 kBenchOplogSegmentRecords = 1000000;
+
+static std::string oplog_bench_path(const std::string& dir, uint32 index)
+{
+	char tmp[dir.size() + 32];
+	sprintf(tmp, "%s/repl.oplog.%u", dir.c_str(), index);
+	return tmp;
+}
+
+static uint64 oplog_bench_catchup(Ardb& db, const std::string& dir,
+        uint32 segments, uint64 from, uint64 last, bool lookup, uint64& bytes,
+        uint64& seek_micros)
+{
+	uint64 fed = 0;
+	uint64 seq = from;
+	Buffer out(128 * 1024);
+	char seqbuf[32];
+	while (seq <= last)
+	{
+		OpLogFile* oplog = NULL;
+		for (uint32 i = segments; i > 0; i--)
+		{
+			uint64 start_seq;
+			OpLogFile* file = new OpLogFile(oplog_bench_path(dir, i));
+			if (file->OpenRead() > 0 && file->PeekFirstSeq(start_seq)
+			        && start_seq <= seq)
+			{
+				oplog = file;
+				break;
+			}
+			DELETE(file);
+		}
+		if (NULL == oplog)
+		{
+			break;
+		}
+		uint64 start = get_current_epoch_micros();
+		oplog->Seek(seq);
+		seek_micros += get_current_epoch_micros() - start;
+		uint64 current;
+		Slice op;
+		while (oplog->Next(current, op) == 1)
+		{
+			CachedWriteOp* wop = (CachedWriteOp*) OpLogFile::DecodeOp(op);
+			ArgumentArray strs;
+			strs.push_back("__set__");
+			strs.push_back(wop->key.key);
+			if (lookup)
+			{
+				std::string v;
+				db.RawGet(wop->key.key, &v);
+				strs.push_back(v);
+			}
+			else
+			{
+				strs.push_back(*(wop->v));
+			}
+			sprintf(seqbuf, "%"PRIu64, current);
+			strs.push_back(seqbuf);
+			RedisCommandFrame cmd(strs);
+			RedisCommandEncoder::Encode(out, cmd);
+			if (out.ReadableBytes() >= 64 * 1024)
+			{
+				bytes += out.ReadableBytes();
+				out.Clear();
+			}
+			DELETE(wop);
+			fed++;
+			seq = current + 1;
+		}
+		DELETE(oplog);
+	}
+	bytes += out.ReadableBytes();
+	return fed;
+}
+
+void bench_oplog(Ardb& db, uint32 total)
+{
+	std::string dir = "/tmp/ardb_bench/oplog";
+	remove_dir(dir);
+	make_dir(dir);
+	std::string value(32, 'v');
+	char key[64];
+	for (uint32 i = 0; i < kBenchOplogKeys; i++)
+	{
+		sprintf(key, "oplog_bench_key:%u", i);
+		db.RawSet(key, value);
+	}
+
+	uint32 segments = 0;
+	OpLogFile* oplog = NULL;
+	Buffer op;
+	uint64 start = get_current_epoch_micros();
+	for (uint32 i = 1; i <= total; i++)
+	{
+		if (NULL == oplog)
+		{
+			segments++;
+			oplog = new OpLogFile(oplog_bench_path(dir, segments));
+			oplog->OpenWrite();
+		}
+		sprintf(key, "oplog_bench_key:%u", i % kBenchOplogKeys);
+		OpKey ok(key);
+		CachedWriteOp wop(kSetOpType, ok);
+		wop.v = new std::string(value);
+		op.Clear();
+		OpLogFile::EncodeOp(op, &wop);
+		oplog->Write(i, op);
+		if (i % kBenchOplogSegmentRecords == 0 || i == total)
+		{
+			oplog->Seal();
+			DELETE(oplog);
+		}
+	}
+	uint64 end = get_current_epoch_micros();
+	print_bench_result("oplog(write)", 1, total, end - start);
+
+	uint64 behinds[] = { total, total / 10, 1000 };
+	for (uint32 lookup = 0; lookup < 2; lookup++)
+	{
+		for (uint32 b = 0; b < arraysize(behinds); b++)
+		{
+			uint64 bytes = 0, seek_micros = 0;
+			start = get_current_epoch_micros();
+			uint64 fed = oplog_bench_catchup(db, dir, segments,
+			        total - behinds[b] + 1, total, lookup == 1, bytes,
+			        seek_micros);
+			end = get_current_epoch_micros();
+			char name[64];
+			sprintf(name, "catchup(%s,%"PRIu64")", lookup ? "db" : "log",
+			        behinds[b]);
+			print_bench_result(name, 1, fed, end - start);
+			printf("%-24s seek:%"PRIu64"us fed:%.1fMB\n", name, seek_micros,
+			        (double) bytes / (1024 * 1024));
+		}
+	}
+	remove_dir(dir);
+}
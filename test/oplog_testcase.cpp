@@ -0,0 +1,222 @@
+/*
+ * oplog_testcase.cpp
+ *
+ *  Oplog segments: records read back as written, seeks through the footer
+ *  index, corrupted records, torn tails and files of an older format.
+ */
+#include "ardb.hpp"
+#include "replication.hpp"
+#include "util/file_helper.hpp"
+#include <stdio.h>
+#include <string>
+
+using namespace ardb;
+
+static const char* kTestOplogDir = "/tmp/ardb/oplog_test";
+
+static std::string oplog_test_path(const char* name)
+{
+	return std::string(kTestOplogDir) + "/" + name;
+}
+
+static void oplog_test_value(uint64 seq, std::string& value)
+{
+	char tmp[64];
+	sprintf(tmp, "value:%"PRIu64":", seq);
+	value = tmp;
+	value.append(seq % 200, 'v');
+}
+
+/*
+ * Writes set ops with seqs 'from' to 'to'.
+ */
+static void write_test_ops(OpLogFile& oplog, uint64 from, uint64 to)
+{
+	Buffer op;
+	for (uint64 seq = from; seq <= to; seq++)
+	{
+		char key[64];
+		sprintf(key, "key:%"PRIu64, seq);
+		OpKey ok(key);
+		CachedWriteOp wop(kSetOpType, ok);
+		wop.v = new std::string;
+		oplog_test_value(seq, *(wop.v));
+		op.Clear();
+		OpLogFile::EncodeOp(op, &wop);
+		oplog.Write(seq, op);
+	}
+}
+
+/*
+ * Reads on from the current position and returns the number of ops read,
+ * 'ret' is the result of the last Next or -2 if an op is not the one
+ * written with its seq.
+ */
+static uint64 read_test_ops(OpLogFile& oplog, uint64 from, int& ret)
+{
+	uint64 count = 0;
+	uint64 seq;
+	Slice op;
+	while ((ret = oplog.Next(seq, op)) == 1)
+	{
+		CachedWriteOp* wop = (CachedWriteOp*) OpLogFile::DecodeOp(op);
+		char key[64];
+		sprintf(key, "key:%"PRIu64, seq);
+		std::string value;
+		oplog_test_value(seq, value);
+		bool match = seq == from + count && NULL != wop
+		        && wop->type == kSetOpType && NULL != wop->v
+		        && wop->key.key == key && *(wop->v) == value;
+		DELETE(wop);
+		if (!match)
+		{
+			ret = -2;
+			break;
+		}
+		count++;
+	}
+	return count;
+}
+
+void test_oplog_write_read()
+{
+	std::string path = oplog_test_path("segment");
+	{
+		OpLogFile oplog(path);
+		CHECK_FATAL(oplog.OpenWrite() < 0, "open oplog for write failed.");
+		write_test_ops(oplog, 1, 3000);
+		oplog.Seal();
+	}
+	OpLogFile oplog(path);
+	CHECK_FATAL(oplog.OpenRead() < 0, "open oplog for read failed.");
+	uint64 first;
+	CHECK_FATAL(!oplog.PeekFirstSeq(first) || first != 1,
+	        "first oplog seq failed.");
+	int ret;
+	uint64 count = read_test_ops(oplog, 1, ret);
+	CHECK_FATAL(count != 3000 || ret != 0, "read %"PRIu64" oplog ops:%d",
+	        count, ret);
+
+	/*
+	 * The records span several index entries, seeks land on the record
+	 * asked for and read on from there.
+	 */
+	uint64 seeks[] = { 1, 2, 777, 1500, 2999, 3000 };
+	for (uint32 i = 0; i < arraysize(seeks); i++)
+	{
+		CHECK_FATAL(!oplog.Seek(seeks[i]), "seek %"PRIu64" failed.", seeks[i]);
+		count = read_test_ops(oplog, seeks[i], ret);
+		CHECK_FATAL(count != 3001 - seeks[i] || ret != 0,
+		        "read %"PRIu64" ops after seek %"PRIu64, count, seeks[i]);
+	}
+	CHECK_FATAL(oplog.Seek(3001), "seek past the last op succeeded.");
+}
+
+/*
+ * Overwrites one byte 'pos' bytes from the end of the file.
+ */
+static void corrupt_test_oplog(const std::string& path, long pos)
+{
+	FILE* fp = fopen(path.c_str(), "r+");
+	CHECK_FATAL(NULL == fp, "open %s failed.", path.c_str());
+	fseek(fp, -pos, SEEK_END);
+	int ch = fgetc(fp);
+	fseek(fp, -pos, SEEK_END);
+	fputc(ch ^ 0xFF, fp);
+	fclose(fp);
+}
+
+void test_oplog_bad_crc()
+{
+	std::string path = oplog_test_path("badcrc");
+	{
+		OpLogFile oplog(path);
+		oplog.OpenWrite();
+		write_test_ops(oplog, 1, 10);
+	}
+	/*
+	 * The last byte of the last op's value.
+	 */
+	corrupt_test_oplog(path, 1);
+	OpLogFile oplog(path);
+	CHECK_FATAL(oplog.OpenRead() < 0, "open oplog for read failed.");
+	int ret;
+	uint64 count = read_test_ops(oplog, 1, ret);
+	CHECK_FATAL(count != 9 || ret != -1, "corrupted record read:%"PRIu64,
+	        count);
+}
+
+void test_oplog_torn_tail()
+{
+	std::string path = oplog_test_path("torn");
+	{
+		OpLogFile oplog(path);
+		oplog.OpenWrite();
+		write_test_ops(oplog, 1, 10);
+	}
+	int64 size = file_size(path);
+	CHECK_FATAL(0 != truncate(path.c_str(), size - 5), "truncate failed.");
+
+	/*
+	 * Reopening for write cuts the torn record, appends follow the last
+	 * whole one.
+	 */
+	{
+		OpLogFile oplog(path);
+		CHECK_FATAL(oplog.OpenWrite() < 0, "reopen torn oplog failed.");
+		write_test_ops(oplog, 10, 20);
+		oplog.Seal();
+	}
+	/*
+	 * A sealed segment reopened for write drops its footer.
+	 */
+	{
+		OpLogFile oplog(path);
+		CHECK_FATAL(oplog.OpenWrite() < 0, "reopen sealed oplog failed.");
+		write_test_ops(oplog, 21, 30);
+	}
+	corrupt_test_oplog(path, 1);
+	{
+		OpLogFile oplog(path);
+		CHECK_FATAL(oplog.OpenWrite() < 0, "reopen corrupted oplog failed.");
+		write_test_ops(oplog, 30, 40);
+	}
+	OpLogFile oplog(path);
+	CHECK_FATAL(oplog.OpenRead() < 0, "open oplog for read failed.");
+	int ret;
+	uint64 count = read_test_ops(oplog, 1, ret);
+	CHECK_FATAL(count != 40 || ret != 0, "read %"PRIu64" reopened ops:%d",
+	        count, ret);
+}
+
+void test_oplog_old_format()
+{
+	std::string path = oplog_test_path("old");
+	FILE* fp = fopen(path.c_str(), "w");
+	CHECK_FATAL(NULL == fp, "create %s failed.", path.c_str());
+	fputs("an oplog of the old format", fp);
+	fclose(fp);
+	{
+		OpLogFile oplog(path);
+		CHECK_FATAL(oplog.OpenWrite() < 0, "open old oplog for write failed.");
+		write_test_ops(oplog, 1, 5);
+	}
+	CHECK_FATAL(file_size(path + ".old") != 26, "old oplog not moved aside.");
+	OpLogFile oplog(path);
+	CHECK_FATAL(oplog.OpenRead() < 0, "open oplog for read failed.");
+	int ret;
+	uint64 count = read_test_ops(oplog, 1, ret);
+	CHECK_FATAL(count != 5 || ret != 0, "read %"PRIu64" new ops:%d", count,
+	        ret);
+}
+
+void test_oplogs()
+{
+	remove_dir(kTestOplogDir);
+	make_dir(kTestOplogDir);
+	test_oplog_write_read();
+	test_oplog_bad_crc();
+	test_oplog_torn_tail();
+	test_oplog_old_format();
+	remove_dir(kTestOplogDir);
+}
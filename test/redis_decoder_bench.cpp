@@ -0,0 +1,83 @@
+/*
+ * redis_decoder_bench.cpp
+ *
+ *  RESP request decoding fed in socket sized reads, many small pipelined
+ *  commands and a few huge SETs which span thousands of reads.
+ */
+#include "test_common.hpp"
+#include "channel/codec/redis_command_codec.hpp"
+
+using namespace ardb::codec;
+
+static void append_request(Buffer& buf, const std::string& key,
+        const std::string& value)
+{
+	buf.Printf("*3\r\n$3\r\nSET\r\n$%zu\r\n", key.size());
+	buf.Write(key.data(), key.size());
+	buf.Printf("\r\n$%zu\r\n", value.size());
+	buf.Write(value.data(), value.size());
+	buf.Write("\r\n", 2);
+}
+
+/*
+ * Feed 'input' to a decoder 'readsize' bytes at a time the way the
+ * channel does, returns the number of decoded requests.
+ */
+static uint32 decode_in_reads(Buffer& input, uint32 readsize)
+{
+	RedisCommandDecoder decoder;
+	Buffer cumulation;
+	uint32 count = 0;
+	while (input.Readable())
+	{
+		uint32 len = input.ReadableBytes() < readsize ?
+		        input.ReadableBytes() : readsize;
+		cumulation.DiscardReadedBytes();
+		cumulation.Write(&input, len);
+		while (true)
+		{
+			RedisCommandFrame frame;
+			int ret = decoder.DecodeRequest(cumulation, frame);
+			if (ret < 0)
+			{
+				printf("decode error:%s\n", decoder.GetError().c_str());
+				return count;
+			}
+			if (ret == 0)
+			{
+				break;
+			}
+			count++;
+		}
+	}
+	return count;
+}
+
+void bench_redis_decoder()
+{
+	const uint32 small = 1000000;
+	Buffer input;
+	char key[32];
+	for (uint32 i = 0; i < small; i++)
+	{
+		sprintf(key, "key:%u", i);
+		append_request(input, key, "value");
+	}
+	uint64 start = get_current_epoch_micros();
+	uint32 count = decode_in_reads(input, 16 * 1024);
+	uint64 end = get_current_epoch_micros();
+	print_bench_result("decode(small)", 1, count, end - start);
+
+	const uint32 huge = 4;
+	Buffer hugeinput;
+	std::string value(50 * 1024 * 1024, 'x');
+	for (uint32 i = 0; i < huge; i++)
+	{
+		sprintf(key, "hugekey:%u", i);
+		append_request(hugeinput, key, value);
+	}
+	start = get_current_epoch_micros();
+	count = decode_in_reads(hugeinput, 8 * 1024);
+	end = get_current_epoch_micros();
+	print_bench_result("decode(50MB,8KB reads)", 1, count, end - start);
+}
@@ -0,0 +1,113 @@
+/*
+ * redis_reply_bench.cpp
+ *
+ *  Building and encoding an LRANGE 0 599 sized array reply, one RedisReply
+ *  node per element against the flat arena form, with the number of
+ *  operator new calls per reply.
+ */
+#include "test_common.hpp"
+#include "channel/codec/redis_reply_codec.hpp"
+#include <new>
+
+using namespace ardb::codec;
+
+static __thread uint64 g_new_count = 0;
+
+void* operator new(size_t size)
+{
+	g_new_count++;
+	void* p = malloc(size == 0 ? 1 : size);
+	if (NULL == p)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p)
+{
+	free(p);
+}
+
+void operator delete[](void* p)
+{
+	free(p);
+}
+
+static void fill_tree_reply(RedisReply& reply, ValueArray& vs)
+{
+	reply.type = REDIS_REPLY_ARRAY;
+	ValueArray::iterator it = vs.begin();
+	while (it != vs.end())
+	{
+		RedisReply r;
+		r.type = REDIS_REPLY_STRING;
+		it->ToString(r.str);
+		reply.elements.push_back(r);
+		it++;
+	}
+}
+
+static void fill_flat_reply(RedisReply& reply, ValueArray& vs)
+{
+	size_t bytes = 0;
+	ValueArray::iterator it = vs.begin();
+	while (it != vs.end())
+	{
+		bytes += it->v.raw->ReadableBytes();
+		it++;
+	}
+	reply.ReserveFlat(vs.size(), bytes);
+	it = vs.begin();
+	while (it != vs.end())
+	{
+		reply.AddFlatString(it->v.raw->GetRawReadBuffer(),
+		        it->v.raw->ReadableBytes());
+		it++;
+	}
+}
+
+void bench_redis_reply()
+{
+	const uint32 loops = 20000;
+	uint32 sizes[] = { 10, 100 };
+	for (uint32 s = 0; s < arraysize(sizes); s++)
+	{
+		ValueArray vs;
+		ValueObject value;
+		smart_fill_value(std::string(sizes[s], 'x'), value);
+		vs.resize(600, value);
+		Buffer out(1024 * 1024);
+		for (uint32 flat = 0; flat < 2; flat++)
+		{
+			RedisReply reply;
+			uint64 news = g_new_count;
+			uint64 start = get_current_epoch_micros();
+			for (uint32 i = 0; i < loops; i++)
+			{
+				if (flat)
+				{
+					fill_flat_reply(reply, vs);
+				}
+				else
+				{
+					fill_tree_reply(reply, vs);
+				}
+				out.Clear();
+				RedisReplyEncoder::Encode(out, reply);
+				reply.Clear();
+			}
+			uint64 end = get_current_epoch_micros();
+			char name[64];
+			sprintf(name, "lrange600(%s,%ub)", flat ? "flat" : "tree", sizes[s]);
+			print_bench_result(name, 1, loops, end - start);
+			printf("%-24s allocations per reply:%.1f\n", name,
+			        (double) (g_new_count - news) / loops);
+		}
+	}
+}
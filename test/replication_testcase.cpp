@@ -0,0 +1,299 @@
+/*
+ * replication_testcase.cpp
+ *
+ *  The connection free parts of replication: peeking at replicated
+ *  requests, raw writes, key range splitting and the 'arbulk' blocks of a
+ *  bulk full sync.
+ */
+#include "ardb.hpp"
+#include "replication.hpp"
+#include "util/buffer_helper.hpp"
+#include <string>
+
+using namespace ardb;
+
+void test_mid_point()
+{
+	uint8 a[kSplitKeyBytes], b[kSplitKeyBytes], mid[kSplitKeyBytes];
+	memset(a, 0, kSplitKeyBytes);
+	memset(b, 0xFF, kSplitKeyBytes);
+	mid_point(a, b, mid);
+	CHECK_FATAL(mid[0] != 0x7F || mid[kSplitKeyBytes - 1] != 0xFF,
+	        "mid point of the keyspace failed:%x", mid[0]);
+
+	/*
+	 * A carry out of the top byte is shifted back in.
+	 */
+	memset(a, 0xFF, kSplitKeyBytes);
+	mid_point(a, b, mid);
+	CHECK_FATAL(memcmp(mid, a, kSplitKeyBytes) != 0, "mid point of equals failed.");
+	memset(a, 0, kSplitKeyBytes);
+	memset(b, 0, kSplitKeyBytes);
+	a[kSplitKeyBytes - 2] = 0x00;
+	a[kSplitKeyBytes - 1] = 0xFF;
+	b[kSplitKeyBytes - 2] = 0x01;
+	b[kSplitKeyBytes - 1] = 0x01;
+	mid_point(a, b, mid);
+	CHECK_FATAL(mid[kSplitKeyBytes - 2] != 0x01 || mid[kSplitKeyBytes - 1] != 0x00,
+	        "mid point carry failed:%x %x", mid[kSplitKeyBytes - 2],
+	        mid[kSplitKeyBytes - 1]);
+	b[kSplitKeyBytes - 2] = 0x00;
+	b[kSplitKeyBytes - 1] = 0xFF;
+	mid_point(a, b, mid);
+	CHECK_FATAL(memcmp(mid, a, kSplitKeyBytes) != 0, "mid point of equals failed.");
+}
+
+static void db_key_range(DBID dbid, KeyRange& range)
+{
+	KeyObject start(Slice(), KV, dbid);
+	KeyObject end(Slice(), KV, dbid + 1);
+	Buffer sbuf, ebuf;
+	encode_key(sbuf, start);
+	encode_key(ebuf, end);
+	range.begin = sbuf.AsString();
+	range.end = ebuf.AsString();
+}
+
+static void del_split_keys(Ardb& db, DBID dbid)
+{
+	for (uint32 i = 0; i < 20000; i++)
+	{
+		char key[32];
+		sprintf(key, "split_key%u", i);
+		db.Del(dbid, key);
+	}
+}
+
+void test_split_key_range(Ardb& db)
+{
+	DBID dbid = 12;
+	std::string value(256, 'v');
+	for (uint32 i = 0; i < 20000; i++)
+	{
+		char key[32];
+		sprintf(key, "split_key%u", i);
+		db.Set(dbid, key, value);
+	}
+	KeyRange range;
+	db_key_range(dbid, range);
+	KeyValueEngine* engine = db.GetEngine();
+	engine->CompactRange(range.begin, range.end);
+
+	std::vector<KeyRange> ranges;
+	split_key_range(engine, range, 1, ranges);
+	CHECK_FATAL(ranges.size() != 1 || ranges[0].begin != range.begin
+	        || ranges[0].end != range.end, "split into one range failed.");
+
+	ranges.clear();
+	split_key_range(engine, range, 4, ranges);
+	if (engine->EstimateSize(range.begin, range.end) > 0)
+	{
+		CHECK_FATAL(ranges.size() < 2, "split into ranges failed:%zu",
+		        ranges.size());
+	}
+	CHECK_FATAL(ranges.front().begin != range.begin, "split lost the begin.");
+	CHECK_FATAL(ranges.back().end != range.end, "split lost the end.");
+	for (uint32 i = 1; i < ranges.size(); i++)
+	{
+		CHECK_FATAL(ranges[i].begin != ranges[i - 1].end,
+		        "split ranges are not contiguous at %u", i);
+		CHECK_FATAL(ranges[i].begin <= ranges[i - 1].begin,
+		        "split ranges are not ordered at %u", i);
+	}
+
+	/*
+	 * Every key is in exactly one range.
+	 */
+	uint32 count = 0;
+	for (uint32 i = 0; i < ranges.size(); i++)
+	{
+		Iterator* iter = engine->Find(ranges[i].begin, false);
+		while (NULL != iter && iter->Valid()
+		        && iter->Key().compare(Slice(ranges[i].end)) < 0)
+		{
+			count++;
+			iter->Next();
+		}
+		DELETE(iter);
+	}
+	CHECK_FATAL(count != 20000, "split ranges hold %u keys", count);
+	del_split_keys(db, dbid);
+}
+
+static void del_bulk_keys(Ardb& db, DBID dbid)
+{
+	db.Del(dbid, "bulk_key1");
+	db.Del(dbid, "bulk_key2");
+	db.Del(dbid, "bulk_hash");
+}
+
+void test_bulk_block(Ardb& db)
+{
+	DBID dbid = 12;
+	del_bulk_keys(db, dbid);
+	db.Set(dbid, "bulk_key1", std::string("v\0v", 3));
+	db.Set(dbid, "bulk_key2", "\r\n");
+	db.HSet(dbid, "bulk_hash", "f", "v");
+	KeyRange range;
+	db_key_range(dbid, range);
+	KeyValueEngine* engine = db.GetEngine();
+
+	/*
+	 * Records as a bulk sync reader takes them from the engine.
+	 */
+	Buffer records;
+	uint32 count = 0;
+	Iterator* iter = engine->Find(range.begin, false);
+	while (NULL != iter && iter->Valid()
+	        && iter->Key().compare(Slice(range.end)) < 0)
+	{
+		BufferHelper::WriteVarSlice(records, iter->Key());
+		BufferHelper::WriteVarSlice(records, iter->Value());
+		count++;
+		iter->Next();
+	}
+	DELETE(iter);
+	CHECK_FATAL(count < 3, "too few bulk records:%u", count);
+
+	std::string raw = records.AsString();
+	Buffer block;
+	encode_bulk_block(records, block);
+	CHECK_FATAL(records.Readable(), "bulk records not moved.");
+	char head[64];
+	sprintf(head, "*2\r\n$6\r\narbulk\r\n$%u\r\n", (uint32) raw.size());
+	std::string encoded = block.AsString();
+	CHECK_FATAL(encoded != head + raw + "\r\n", "bulk block format mismatch.");
+
+	RedisCommandDecoder decoder;
+	RedisCommandFrame frame;
+	CHECK_FATAL(decoder.DecodeRequest(block, frame) <= 0,
+	        "decode bulk block failed.");
+	CHECK_FATAL(strcasecmp(frame.GetCommand().c_str(), "arbulk") != 0
+	        || *(frame.GetArgument(0)) != raw, "decoded bulk block mismatch.");
+
+	/*
+	 * A truncated block writes nothing.
+	 */
+	del_bulk_keys(db, dbid);
+	int64 loaded = load_bulk_block(engine, Slice(raw.data(), raw.size() - 1));
+	CHECK_FATAL(loaded != -1, "truncated bulk block loaded:%"PRId64, loaded);
+	CHECK_FATAL(db.Exists(dbid, "bulk_key1"), "truncated bulk block wrote.");
+
+	loaded = load_bulk_block(engine, *(frame.GetArgument(0)));
+	CHECK_FATAL(loaded != count, "bulk block loaded:%"PRId64, loaded);
+	std::string v;
+	CHECK_FATAL(db.Get(dbid, "bulk_key1", &v) != 0 || v != std::string("v\0v", 3),
+	        "bulk loaded key1 mismatch.");
+	CHECK_FATAL(db.Get(dbid, "bulk_key2", &v) != 0 || v != "\r\n",
+	        "bulk loaded key2 mismatch.");
+	CHECK_FATAL(db.HGet(dbid, "bulk_hash", "f", &v) != 0 || v != "v",
+	        "bulk loaded hash mismatch.");
+	del_bulk_keys(db, dbid);
+}
+
+void test_peek_request()
+{
+	Slice args[kMaxRawWriteArgs];
+	uint32 argc = 0;
+	std::string req = "*3\r\n$7\r\n__set__\r\n$1\r\nk\r\n$3\r\n";
+	req.append("v\0v\r\n", 5);
+	int len = peek_request(req.data(), req.size(), args, kMaxRawWriteArgs, argc);
+	CHECK_FATAL(len != (int) req.size() || argc != 3, "peek request failed:%d",
+	        len);
+	CHECK_FATAL(args[0] != "__set__" || args[1] != "k"
+	        || args[2] != Slice("v\0v", 3), "peek request args mismatch.");
+
+	/*
+	 * Every partial frame waits for more.
+	 */
+	uint32 partial = 0;
+	for (size_t i = 0; i < req.size(); i++)
+	{
+		partial += peek_request(req.data(), i, args, kMaxRawWriteArgs, argc)
+		        != 0;
+	}
+	CHECK_FATAL(partial != 0, "partial requests peeked:%u", partial);
+	std::string two = req + "*1\r\n$4\r\nping\r\n";
+	len = peek_request(two.data(), two.size(), args, kMaxRawWriteArgs, argc);
+	CHECK_FATAL(len != (int) req.size(), "peek first of two failed:%d", len);
+
+	/*
+	 * Only the first 'max' arguments are set.
+	 */
+	std::string many = "*5\r\n$1\r\na\r\n$1\r\nb\r\n$1\r\nc\r\n$1\r\nd\r\n$1\r\ne\r\n";
+	len = peek_request(many.data(), many.size(), args, 2, argc);
+	CHECK_FATAL(len != (int) many.size() || argc != 5 || args[1] != "b",
+	        "peek long request failed:%d", len);
+
+	std::string inl = "ping\r\n*1\r\n";
+	len = peek_request(inl.data(), inl.size(), args, kMaxRawWriteArgs, argc);
+	CHECK_FATAL(len != 6 || argc != 0, "peek inline request failed:%d", len);
+	len = peek_request(inl.data(), 4, args, kMaxRawWriteArgs, argc);
+	CHECK_FATAL(len != 0, "peek partial inline request:%d", len);
+
+	const char* bads[] = { "*1\r\n$x\r\nping\r\n", "*1\r\n$-1\r\n",
+	        "*1\r\n#4\r\nping\r\n", "*1\r\n$4\nping\r\n",
+	        "*1\r\n$99999999999\r\n", "*x\r\n" };
+	for (uint32 i = 0; i < arraysize(bads); i++)
+	{
+		len = peek_request(bads[i], strlen(bads[i]), args, kMaxRawWriteArgs,
+		        argc);
+		CHECK_FATAL(len != -1, "bad request %u peeked:%d", i, len);
+	}
+}
+
+void test_apply_raw_write(Ardb& db)
+{
+	DBID dbid = 12;
+	db.Set(dbid, "raw_key", "v");
+	KeyObject k("raw_key", KV, dbid);
+	Buffer kbuf;
+	encode_key(kbuf, k);
+	std::string rawkey = kbuf.AsString();
+	std::string rawvalue;
+	db.GetEngine()->Get(rawkey, &rawvalue);
+	db.Del(dbid, "raw_key");
+
+	Slice args[kMaxRawWriteArgs];
+	args[0] = "__SET__";
+	args[1] = rawkey;
+	args[2] = rawvalue;
+	args[3] = "123";
+	uint64 seq = 0;
+	int ret = apply_raw_write(&db, args, 4, false, seq);
+	CHECK_FATAL(ret != 0, "set with an extra arg applied:%d", ret);
+	ret = apply_raw_write(&db, args, 4, true, seq);
+	CHECK_FATAL(ret != 1 || seq != 123, "raw set with seq failed:%d", ret);
+	std::string v;
+	CHECK_FATAL(db.Get(dbid, "raw_key", &v) != 0 || v != "v",
+	        "raw set not applied.");
+
+	/*
+	 * A bad sequence is not half parsed into 'seq'.
+	 */
+	args[0] = "__del__";
+	args[2] = "12x";
+	ret = apply_raw_write(&db, args, 3, true, seq);
+	CHECK_FATAL(ret != 1 || seq != 123, "raw del with bad seq:%d %"PRIu64,
+	        ret, seq);
+	CHECK_FATAL(db.Exists(dbid, "raw_key"), "raw del not applied.");
+	args[2] = "99999999999999999999";
+	ret = apply_raw_write(&db, args, 3, true, seq);
+	CHECK_FATAL(seq != 123, "overflowed seq parsed:%"PRIu64, seq);
+	args[2] = "124";
+	ret = apply_raw_write(&db, args, 3, true, seq);
+	CHECK_FATAL(ret != 1 || seq != 124, "raw del with seq failed:%d", ret);
+
+	args[0] = "__get__";
+	ret = apply_raw_write(&db, args, 2, false, seq);
+	CHECK_FATAL(ret != 0, "unknown raw write applied:%d", ret);
+}
+
+void test_replication(Ardb& db)
+{
+	test_peek_request();
+	test_apply_raw_write(db);
+	test_mid_point();
+	test_split_key_range(db);
+	test_bulk_block(db);
+}
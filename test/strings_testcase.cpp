@@ -5,6 +5,7 @@
  *      Author: yinqiwen
  */
 #include "ardb.hpp"
+#include "util/thread/thread.hpp"
 #include <string>
 
 using namespace ardb;
@@ -109,6 +110,112 @@ void test_strings_expire(Ardb& db)
 	CHECK_FATAL(db.Exists(dbid, "intkey1") == true, "Expire intkey failed");
 }
 
+class StringsIncrWorker: public Thread
+{
+	private:
+		Ardb& m_db;
+		int m_count;
+	public:
+		StringsIncrWorker(Ardb& db, int count) :
+				m_db(db), m_count(count)
+		{
+		}
+		void Run()
+		{
+			DBID dbid = 0;
+			for (int i = 0; i < m_count; i++)
+			{
+				int64_t iv = 0;
+				double dv = 0;
+				m_db.Incr(dbid, "concurrent_intkey", iv);
+				m_db.IncrbyFloat(dbid, "concurrent_floatkey", 0.5, dv);
+				m_db.Append(dbid, "concurrent_strkey", "a");
+			}
+		}
+};
+
+static std::string mget_str(const ValueObject& v)
+{
+	std::string str;
+	return v.ToString(str);
+}
+
+void test_strings_mget(Ardb& db)
+{
+	DBID dbid = 0;
+	db.Set(dbid, "mkey3", "v3");
+	db.Set(dbid, "mkey1", "v1");
+	db.Set(dbid, "mkey2", "v2");
+	db.Del(dbid, "mkey_none");
+	SliceArray keys;
+	keys.push_back("mkey2");
+	keys.push_back("mkey_none");
+	keys.push_back("mkey1");
+	keys.push_back("mkey3");
+	keys.push_back("mkey2");
+	ValueArray vs;
+	db.MGet(dbid, keys, vs);
+	CHECK_FATAL(vs.size() != 5, "MGet failed:%zu", vs.size());
+	CHECK_FATAL(mget_str(vs[0]) != "v2" || mget_str(vs[2]) != "v1"
+			|| mget_str(vs[3]) != "v3" || mget_str(vs[4]) != "v2",
+			"MGet failed");
+	CHECK_FATAL(vs[1].type != EMPTY, "MGet failed");
+	{
+		BatchWriteGuard guard(db.GetEngine());
+		db.Set(dbid, "mkey1", "v11");
+		db.Del(dbid, "mkey3");
+		vs.clear();
+		db.MGet(dbid, keys, vs);
+		CHECK_FATAL(mget_str(vs[2]) != "v11" || vs[3].type != EMPTY,
+				"MGet in batch failed");
+	}
+	std::string v;
+	{
+		SnapshotGuard snapshot(db.GetEngine());
+		db.Set(dbid, "mkey2", "v22");
+		db.Get(dbid, "mkey2", &v);
+		CHECK_FATAL(v != "v2", "Get from snapshot failed:%s", v.c_str());
+	}
+	db.Get(dbid, "mkey2", &v);
+	CHECK_FATAL(v != "v22", "Get after snapshot failed:%s", v.c_str());
+	db.Del(dbid, "mkey1");
+	db.Del(dbid, "mkey2");
+}
+
+void test_strings_concurrent_incr(Ardb& db)
+{
+	DBID dbid = 0;
+	const int thread_count = 8;
+	const int incr_count = 2000;
+	db.Del(dbid, "concurrent_intkey");
+	db.Set(dbid, "concurrent_floatkey", "0");
+	db.Del(dbid, "concurrent_strkey");
+	StringsIncrWorker* workers[thread_count];
+	for (int i = 0; i < thread_count; i++)
+	{
+		workers[i] = new StringsIncrWorker(db, incr_count);
+		workers[i]->Start();
+	}
+	for (int i = 0; i < thread_count; i++)
+	{
+		workers[i]->Join();
+		delete workers[i];
+	}
+	int64_t iv = 0;
+	double dv = 0;
+	db.Incrby(dbid, "concurrent_intkey", 0, iv);
+	CHECK_FATAL(iv != thread_count * incr_count,
+			"Concurrent incr failed:%"PRId64, iv);
+	db.IncrbyFloat(dbid, "concurrent_floatkey", 0, dv);
+	CHECK_FATAL(dv != thread_count * incr_count * 0.5,
+			"Concurrent incrbyfloat failed:%f", dv);
+	CHECK_FATAL(db.Strlen(dbid, "concurrent_strkey") != thread_count * incr_count,
+			"Concurrent append failed:%d", db.Strlen(dbid, "concurrent_strkey"));
+	db.Del(dbid, "concurrent_intkey");
+	db.Del(dbid, "concurrent_floatkey");
+	db.Del(dbid, "concurrent_strkey");
+}
+
 void test_strings(Ardb& db)
 {
 	test_strings_append(db);
@@ -121,5 +228,7 @@ void test_strings(Ardb& db)
 	test_strings_exists(db);
 	test_strings_setnx(db);
 	test_strings_expire(db);
+	test_strings_mget(db);
+	test_strings_concurrent_incr(db);
 }
 
@@ -302,6 +302,361 @@ void test_table_create_index(Ardb& db)
 	CHECK_FATAL((end-start) > 10, "%"PRIu64, (end-start));
 }
 
+void test_table_plan(Ardb& db)
+{
+	DBID dbid = 0;
+	db.TClear(dbid, "plantable");
+	StringArray strs;
+	string_to_string_array("key1 key2", strs);
+	SliceArray array;
+	strings_to_slices(strs, array);
+	db.TCreate(dbid, "plantable", array);
+
+	TableInsertOptions insert_options;
+	std::string err;
+	for (uint32 i = 0; i < 200; i++)
+	{
+		char tmp[1024];
+		sprintf(tmp, "5 key1 %u key2 %u name n%u age %u score %u", i, i % 10,
+		        i, 100 + (i * 7) % 200, i % 3);
+		string_to_string_array(tmp, strs);
+		TableInsertOptions::Parse(strs, 0, insert_options);
+		db.TInsert(dbid, "plantable", insert_options, false, err);
+	}
+	db.TCreateIndex(dbid, "plantable", "age");
+
+	std::string str;
+	ValueArray result;
+	TableQueryOptions options;
+	string_to_string_array(
+	        "2 key1 age where age>=150 and age<160 and score=1", strs);
+	TableQueryOptions::Parse(strs, 0, options);
+	db.TGet(dbid, "plantable", options, result, err);
+	uint32 expected = 0;
+	for (uint32 i = 0; i < 200; i++)
+	{
+		uint32 age = 100 + (i * 7) % 200;
+		if (age >= 150 && age < 160 && i % 3 == 1)
+		{
+			expected++;
+		}
+	}
+	CHECK_FATAL( result.size() != expected * 2, "%zu", result.size());
+	for (uint32 i = 3; i < result.size(); i += 2)
+	{
+		CHECK_FATAL( result[i].Compare(result[i - 2]) <= 0,
+		        "%s", result[i].ToString(str).c_str());
+	}
+
+	string_to_string_array("2 key1 age orderby age desc limit 1 3", strs);
+	TableQueryOptions::Parse(strs, 0, options);
+	db.TGet(dbid, "plantable", options, result, err);
+	CHECK_FATAL( result.size() != 6, "%zu", result.size());
+	CHECK_FATAL( result[1].ToString(str) != "298", "%s", str.c_str());
+	CHECK_FATAL( result[5].ToString(str) != "296", "%s", str.c_str());
+
+	string_to_string_array("1 name orderby name desc limit 0 2 where key2=3",
+	        strs);
+	TableQueryOptions::Parse(strs, 0, options);
+	db.TGet(dbid, "plantable", options, result, err);
+	CHECK_FATAL( result.size() != 2, "%zu", result.size());
+	CHECK_FATAL( result[0].ToString(str) != "n93", "%s", str.c_str());
+	CHECK_FATAL( result[1].ToString(str) != "n83", "%s", str.c_str());
+
+	string_to_string_array("1 key1 aggregate count where score!=0", strs);
+	TableQueryOptions::Parse(strs, 0, options);
+	db.TGet(dbid, "plantable", options, result, err);
+	CHECK_FATAL( result.size() != 1, "%zu", result.size());
+	CHECK_FATAL( result[0].ToString(str) != "133", "%s", str.c_str());
+
+	string_to_string_array("1 key1 where key1=3 or key1=5", strs);
+	TableQueryOptions::Parse(strs, 0, options);
+	db.TGet(dbid, "plantable", options, result, err);
+	CHECK_FATAL( result.size() != 2, "%zu", result.size());
+
+	/*
+	 * A row without the indexed order column is still in the result.
+	 */
+	string_to_string_array("3 key1 500 key2 0 name n500", strs);
+	TableInsertOptions::Parse(strs, 0, insert_options);
+	db.TInsert(dbid, "plantable", insert_options, false, err);
+	string_to_string_array("2 name age orderby age", strs);
+	TableQueryOptions::Parse(strs, 0, options);
+	db.TGet(dbid, "plantable", options, result, err);
+	CHECK_FATAL( result.size() != 402, "%zu", result.size());
+	bool found = false;
+	for (uint32 i = 0; i < result.size(); i += 2)
+	{
+		found = found || result[i].ToString(str) == "n500";
+	}
+	CHECK_FATAL( !found, "row without the order column dropped.");
+	string_to_string_array("2 name age orderby age where age>=0", strs);
+	TableQueryOptions::Parse(strs, 0, options);
+	db.TGet(dbid, "plantable", options, result, err);
+	CHECK_FATAL( result.size() != 400, "%zu", result.size());
+}
+
+static void check_composite_query(Ardb& db, DBID dbid,
+        std::map<uint32, uint32>& grp3)
+{
+	StringArray strs;
+	std::string err, str;
+	ValueArray result;
+	TableQueryOptions options;
+	string_to_string_array(
+	        "2 name age orderby age desc where grp=3 and age>=150 and age<250",
+	        strs);
+	TableQueryOptions::Parse(strs, 0, options);
+	db.TGet(dbid, "ctable", options, result, err);
+	std::vector<std::pair<uint32, uint32> > expected;
+	std::map<uint32, uint32>::iterator it = grp3.begin();
+	while (it != grp3.end())
+	{
+		if (it->second >= 150 && it->second < 250)
+		{
+			expected.push_back(std::make_pair(it->second, it->first));
+		}
+		it++;
+	}
+	std::sort(expected.rbegin(), expected.rend());
+	CHECK_FATAL( result.size() != expected.size() * 2, "%zu", result.size());
+	for (uint32 i = 0; i < expected.size(); i++)
+	{
+		char name[32];
+		sprintf(name, "n%u", expected[i].second);
+		CHECK_FATAL( result[i * 2].ToString(str) != name, "%s", str.c_str());
+		CHECK_FATAL( result[i * 2 + 1].NumberValue() != expected[i].first,
+		        "%s", result[i * 2 + 1].ToString(str).c_str());
+	}
+}
+
+void test_table_composite_index(Ardb& db)
+{
+	DBID dbid = 0;
+	db.TClear(dbid, "ctable");
+	StringArray strs;
+	string_to_string_array("key1", strs);
+	SliceArray array;
+	strings_to_slices(strs, array);
+	db.TCreate(dbid, "ctable", array);
+
+	TableInsertOptions insert_options;
+	std::string err, str;
+	std::map<uint32, uint32> grp3;
+	for (uint32 i = 0; i < 200; i++)
+	{
+		char tmp[1024];
+		sprintf(tmp, "4 key1 %u grp %u age %u name n%u", i, i % 10,
+		        100 + (i * 7) % 200, i);
+		string_to_string_array(tmp, strs);
+		TableInsertOptions::Parse(strs, 0, insert_options);
+		db.TInsert(dbid, "ctable", insert_options, false, err);
+		if (i % 10 == 3)
+		{
+			grp3[i] = 100 + (i * 7) % 200;
+		}
+	}
+	SliceArray cols, covered;
+	cols.push_back("grp");
+	cols.push_back("age");
+	covered.push_back("name");
+	CHECK_FATAL(db.TCreateIndex(dbid, "ctable", cols, covered) != 0,
+	        "Failed to create index");
+	db.TDesc(dbid, "ctable", str);
+	CHECK_FATAL(str.find("Indexes: grp,age(C:name) ") == std::string::npos,
+	        "%s", str.c_str());
+	check_composite_query(db, dbid, grp3);
+
+	TableUpdateOptions update_options;
+	string_to_string_array("grp=3,age=201 where key1=4", strs);
+	TableUpdateOptions::Parse(strs, 0, update_options);
+	db.TUpdate(dbid, "ctable", update_options);
+	grp3[4] = 201;
+	TableDeleteOptions delete_options;
+	string_to_string_array("where key1=13", strs);
+	TableDeleteOptions::Parse(strs, 0, delete_options);
+	db.TDel(dbid, "ctable", delete_options, err);
+	grp3.erase(13);
+	check_composite_query(db, dbid, grp3);
+
+	ValueArray result;
+	TableQueryOptions options;
+	string_to_string_array("2 grp age orderby grp limit 0 5", strs);
+	TableQueryOptions::Parse(strs, 0, options);
+	db.TGet(dbid, "ctable", options, result, err);
+	CHECK_FATAL( result.size() != 10, "%zu", result.size());
+	for (uint32 i = 0; i < result.size(); i += 2)
+	{
+		CHECK_FATAL( result[i].NumberValue() != 0,
+		        "%s", result[i].ToString(str).c_str());
+		CHECK_FATAL(i > 0 && result[i + 1].Compare(result[i - 1]) <= 0,
+		        "%s", result[i + 1].ToString(str).c_str());
+	}
+
+	db.TDelCol(dbid, "ctable", "name");
+	str.clear();
+	db.TDesc(dbid, "ctable", str);
+	CHECK_FATAL(str.find("Indexes:") != std::string::npos, "%s", str.c_str());
+}
+
+static uint32 count_composite_entries(Ardb& db, DBID dbid,
+        const std::string& table, const std::string& index, uint32 width)
+{
+	Buffer prefix;
+	TableCompositeIndexKeyObject key(table, index, width, dbid);
+	encode_key_prefix(prefix, key);
+	Slice prefix_slice(prefix.GetRawReadBuffer(), prefix.ReadableBytes());
+	uint32 count = 0;
+	Iterator* iter = db.GetEngine()->Find(prefix_slice, false);
+	while (NULL != iter && iter->Valid() && iter->Key().starts_with(prefix_slice))
+	{
+		count++;
+		iter->Next();
+	}
+	DELETE(iter);
+	return count;
+}
+
+void test_table_composite_backfill(Ardb& db)
+{
+	DBID dbid = 0;
+	db.TClear(dbid, "btable");
+	StringArray strs;
+	string_to_string_array("key1", strs);
+	SliceArray array;
+	strings_to_slices(strs, array);
+	db.TCreate(dbid, "btable", array);
+
+	/*
+	 * More rows than one backfill batch holds.
+	 */
+	TableInsertOptions insert_options;
+	std::string err, str;
+	for (uint32 i = 0; i < 2500; i++)
+	{
+		char tmp[1024];
+		sprintf(tmp, "3 key1 %u grp %u age %u", i, i % 10, 100 + i % 300);
+		string_to_string_array(tmp, strs);
+		TableInsertOptions::Parse(strs, 0, insert_options);
+		db.TInsert(dbid, "btable", insert_options, false, err);
+	}
+	SliceArray cols, covered;
+	cols.push_back("grp");
+	cols.push_back("age");
+	CHECK_FATAL(db.TCreateIndex(dbid, "btable", cols, covered) != 0,
+	        "Failed to create index");
+	uint32 count = count_composite_entries(db, dbid, "btable", "grp,age", 2);
+	CHECK_FATAL(count != 2500, "composite index holds %u entries", count);
+
+	ValueArray result;
+	TableQueryOptions options;
+	string_to_string_array("1 key1 where grp=7 and age>=100", strs);
+	TableQueryOptions::Parse(strs, 0, options);
+	db.TGet(dbid, "btable", options, result, err);
+	CHECK_FATAL( result.size() != 250, "%zu", result.size());
+	std::set<uint32> keys;
+	for (uint32 i = 0; i < result.size(); i++)
+	{
+		uint32 k = (uint32) result[i].NumberValue();
+		CHECK_FATAL( k % 10 != 7, "%u", k);
+		keys.insert(k);
+	}
+	CHECK_FATAL( keys.size() != 250, "%zu", keys.size());
+
+	/*
+	 * Dropping a column of the composite drops the index and its entries.
+	 */
+	db.TDelCol(dbid, "btable", "age");
+	db.TDesc(dbid, "btable", str);
+	CHECK_FATAL(str.find("Indexes:") != std::string::npos, "%s", str.c_str());
+	count = count_composite_entries(db, dbid, "btable", "grp,age", 2);
+	CHECK_FATAL(count != 0, "composite index left %u entries", count);
+	db.TClear(dbid, "btable");
+}
+
+/*
+ * Inserts a row as soon as an index shows up in the table's schema.
+ */
+class TableBuildInsertWorker: public Thread
+{
+	private:
+		Ardb& m_db;
+	public:
+		volatile bool inserted;
+		TableBuildInsertWorker(Ardb& db) :
+				m_db(db), inserted(false)
+		{
+		}
+		void Run()
+		{
+			DBID dbid = 0;
+			std::string str;
+			while (str.find("Indexes:") == std::string::npos)
+			{
+				str.clear();
+				m_db.TDesc(dbid, "gtable", str);
+			}
+			StringArray strs;
+			std::string err;
+			TableInsertOptions insert_options;
+			string_to_string_array("3 key1 6000 grp 0 age 0", strs);
+			TableInsertOptions::Parse(strs, 0, insert_options);
+			m_db.TInsert(dbid, "gtable", insert_options, false, err);
+			inserted = true;
+		}
+};
+
+void test_table_composite_backfill_group(Ardb& db)
+{
+	DBID dbid = 0;
+	db.TClear(dbid, "gtable");
+	StringArray strs;
+	string_to_string_array("key1", strs);
+	SliceArray array;
+	strings_to_slices(strs, array);
+	db.TCreate(dbid, "gtable", array);
+	TableInsertOptions insert_options;
+	std::string err;
+	for (uint32 i = 0; i < 6000; i++)
+	{
+		char tmp[1024];
+		sprintf(tmp, "3 key1 %u grp %u age %u", i, i % 10, i % 300);
+		string_to_string_array(tmp, strs);
+		TableInsertOptions::Parse(strs, 0, insert_options);
+		db.TInsert(dbid, "gtable", insert_options, false, err);
+	}
+	if (!db.BeginGroupCommit())
+	{
+		db.TClear(dbid, "gtable");
+		return;
+	}
+
+	/*
+	 * Each backfill batch is written and the table unlocked before the
+	 * next, so another client gets to write the table before the build
+	 * and the group end.
+	 */
+	TableBuildInsertWorker worker(db);
+	worker.Start();
+	SliceArray cols, covered;
+	cols.push_back("grp");
+	cols.push_back("age");
+	int ret = db.TCreateIndex(dbid, "gtable", cols, covered);
+	CHECK_FATAL(ret != 0, "Failed to create index:%d", ret);
+	for (uint32 i = 0; i < 500 && !worker.inserted; i++)
+	{
+		usleep(10000);
+	}
+	bool inserted = worker.inserted;
+	ret = db.EndGroupCommit();
+	worker.Join();
+	CHECK_FATAL(ret != 0, "index build group failed:%d", ret);
+	CHECK_FATAL(!inserted, "table locked for the whole index build.");
+	uint32 count = count_composite_entries(db, dbid, "gtable", "grp,age", 2);
+	CHECK_FATAL(count != 6001, "composite index holds %u entries", count);
+	db.TClear(dbid, "gtable");
+}
+
 void test_tables(Ardb& db)
 {
 	test_table_insert_get(db);
@@ -311,4 +666,8 @@ void test_tables(Ardb& db)
 	test_table_delcol(db);
 	test_table_getall(db);
 	test_table_create_index(db);
+	test_table_plan(db);
+	test_table_composite_index(db);
+	test_table_composite_backfill(db);
+	test_table_composite_backfill_group(db);
 }
@@ -12,6 +12,10 @@
 #include "table_testcase.cpp"
 #include "bitset_testcase.cpp"
 #include "misc_testcase.cpp"
+#include "codec_testcase.cpp"
+#include "channel_testcase.cpp"
+#include "replication_testcase.cpp"
+#include "oplog_testcase.cpp"
 
 void test_all(Ardb& db)
 {
@@ -23,4 +27,8 @@ void test_all(Ardb& db)
 	test_tables(db);
 	test_bitsets(db);
 	test_misc(db);
+	test_codecs();
+	test_channels();
+	test_replication(db);
+	test_oplogs();
 }
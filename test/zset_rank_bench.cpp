@@ -0,0 +1,74 @@
+/*
+ * zset_rank_bench.cpp
+ *
+ *  ZRANK and offset based ZRANGE latency on zsets of 10K, 1M and 10M
+ *  members, shows that rank lookups do not grow with the zset size.
+ */
+#include "test_common.hpp"
+
+static void fill_bench_zset(Ardb& db, const DBID& dbid, const char* key,
+        uint32 size)
+{
+	const uint32 batch = 1000;
+	char member[32];
+	DoubleArray scores;
+	StringArray members;
+	SliceArray svs;
+	uint64 start = get_current_epoch_micros();
+	for (uint32 i = 0; i < size; i++)
+	{
+		sprintf(member, "member_%u", i);
+		scores.push_back((double) ((i * 2654435761U) % size));
+		members.push_back(member);
+		if (members.size() == batch || i == size - 1)
+		{
+			for (uint32 j = 0; j < members.size(); j++)
+			{
+				svs.push_back(members[j]);
+			}
+			db.ZAdd(dbid, key, scores, svs);
+			scores.clear();
+			members.clear();
+			svs.clear();
+		}
+	}
+	uint64 end = get_current_epoch_micros();
+	print_bench_result("zadd", 1, size, end - start);
+}
+
+void bench_zset_rank(Ardb& db, uint32 maxsize)
+{
+	const uint32 lookups = 10000;
+	DBID dbid = 0;
+	uint32 sizes[] = { 10000, 1000000, 10000000 };
+	for (uint32 s = 0; s < arraysize(sizes) && sizes[s] <= maxsize; s++)
+	{
+		char key[64];
+		sprintf(key, "bench_zset_%u", sizes[s]);
+		db.ZClear(dbid, key);
+		fill_bench_zset(db, dbid, key, sizes[s]);
+		printf("zset size:%u\n", db.ZCard(dbid, key));
+
+		char member[32];
+		uint64 start = get_current_epoch_micros();
+		for (uint32 i = 0; i < lookups; i++)
+		{
+			sprintf(member, "member_%u", (i * 7919) % sizes[s]);
+			db.ZRank(dbid, key, member);
+		}
+		uint64 end = get_current_epoch_micros();
+		print_bench_result("zrank", 1, lookups, end - start);
+
+		QueryOptions options;
+		start = get_current_epoch_micros();
+		for (uint32 i = 0; i < lookups; i++)
+		{
+			ValueArray values;
+			int rank = (i * 7919) % sizes[s];
+			db.ZRange(dbid, key, rank, rank + 9, values, options);
+		}
+		end = get_current_epoch_micros();
+		print_bench_result("zrange(offset,10)", 1, lookups, end - start);
+		db.ZClear(dbid, key);
+	}
+}
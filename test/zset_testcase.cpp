@@ -229,6 +229,66 @@ void test_zsets_union(Ardb& db)
 			"Fail:%s", values[4].ToString(str).c_str());
 }
 
+void test_zsets_rank_index(Ardb& db)
+{
+	DBID dbid = 0;
+	const int count = 3000;
+	db.ZClear(dbid, "bigzset");
+	/*
+	 * Scores are a permutation of [0, count), so a member's rank is its
+	 * score, and members are added out of order to split the index nodes.
+	 */
+	char member[32];
+	for (int i = 0; i < count; i++)
+	{
+		sprintf(member, "m%d", i);
+		db.ZAdd(dbid, "bigzset", (i * 7919) % count, member);
+	}
+	for (int i = 0; i < count; i += 97)
+	{
+		sprintf(member, "m%d", i);
+		int rank = db.ZRank(dbid, "bigzset", member);
+		CHECK_FATAL(rank != (i * 7919) % count, "Fail:%d", rank);
+		rank = db.ZRevRank(dbid, "bigzset", member);
+		CHECK_FATAL(rank != count - 1 - (i * 7919) % count, "Fail:%d", rank);
+	}
+	QueryOptions options;
+	options.withscores = true;
+	ValueArray values;
+	db.ZRange(dbid, "bigzset", 1500, 1502, values, options);
+	CHECK_FATAL(values.size() != 6 || values[1].v.double_v != 1500
+			|| values[5].v.double_v != 1502, "Fail:%zu", values.size());
+	values.clear();
+	db.ZRevRange(dbid, "bigzset", 10, 10, values, options);
+	CHECK_FATAL(values.size() != 2 || values[1].v.double_v != count - 11,
+			"Fail:%zu", values.size());
+	int ret = db.ZRemRangeByScore(dbid, "bigzset", "-inf", "(1000");
+	CHECK_FATAL(ret != 1000, "Fail:%d", ret);
+	ret = db.ZRemRangeByRank(dbid, "bigzset", 0, 99);
+	CHECK_FATAL(ret != 100, "Fail:%d", ret);
+	for (int i = 0; i < count; i += 89)
+	{
+		sprintf(member, "m%d", i);
+		int score = (i * 7919) % count;
+		int rank = db.ZRank(dbid, "bigzset", member);
+		CHECK_FATAL(rank != (score < 1100 ? ERR_NOT_EXIST : score - 1100),
+				"Fail:%d", rank);
+	}
+	double score = 0;
+	for (int i = 0; i < count; i++)
+	{
+		sprintf(member, "m%d", i);
+		if ((i * 7919) % count == count - 1)
+		{
+			db.ZIncrby(dbid, "bigzset", -(double) count, member, score);
+			break;
+		}
+	}
+	CHECK_FATAL(db.ZRank(dbid, "bigzset", member) != 0, "Fail:%d",
+			db.ZRank(dbid, "bigzset", member));
+	db.ZClear(dbid, "bigzset");
+}
+
 void test_zsets(Ardb& db)
 {
 	test_zsets_addrem(db);
@@ -240,4 +300,5 @@ void test_zsets(Ardb& db)
 	test_zsets_incr(db);
 	test_zsets_inter(db);
 	test_zsets_union(db);
+	test_zsets_rank_index(db);
 }